@@ -88,6 +88,7 @@ HEADERS += include/SApp.h \
            include/core/SHostMsgDef.h \
            include/core/SHostWnd.h \
            include/core/SItemPanel.h \
+           include/core/SIdleScheduler.h \
            include/core/SMsgLoop.h \
            include/core/SNativeWnd.h \
            include/core/SObjectFactory.h \
@@ -111,6 +112,7 @@ HEADERS += include/SApp.h \
            include/event/SEventSet.h \
            include/event/SEventSubscriber.h \
            include/event/SNotifyCenter.h \
+           include/event/STaskQueue.h \
            include/helper/SAdapterBase.h \
            include/helper/SAppDir.h \
            include/helper/SAssertFmt.h \
@@ -121,12 +123,17 @@ HEADERS += include/SApp.h \
            include/helper/SDpiScale.h \
            include/helper/SDragWnd.h \
            include/helper/SFunctor.hpp \
+           include/helper/SHitTestGrid.h \
            include/helper/SHostMgr.h \
            include/helper/SIpcParamHelper.hpp \
            include/helper/SListViewItemLocator.h \
+           include/helper/SListViewRangeUpdater.h \
            include/helper/slog.h \
            include/helper/SLogDef.h \
            include/helper/SMemDC.h \
+           include/helper/SFrameProfiler.h \
+           include/helper/SRenderCacheMgr.h \
+           include/helper/SDisplayList.h \
            include/helper/SMenu.h \
            include/helper/SMenuEx.h \
            include/helper/SMenuWndHook.h \
@@ -242,6 +249,7 @@ SOURCES += src/SApp.cpp \
            src/core/SHostDialog.cpp \
            src/core/shostwnd.cpp \
            src/core/SItemPanel.cpp \
+           src/core/SIdleScheduler.cpp \
            src/core/SMsgLoop.cpp \
            src/core/SNativeWnd.cpp \
            src/core/SObjectFactory.cpp \
@@ -257,13 +265,18 @@ SOURCES += src/SApp.cpp \
            src/core/SwndStyle.cpp \
            src/event/SEventSet.cpp \
            src/event/SNotifyCenter.cpp \
+           src/event/STaskQueue.cpp \
            src/helper/SAppDir.cpp \
            src/helper/SDIBHelper.cpp \
            src/helper/SDpiScale.cpp \
            src/helper/SDragWnd.cpp \
+           src/helper/SHitTestGrid.cpp \
            src/helper/SHostMgr.cpp \
            src/helper/SListViewItemLocator.cpp \
            src/helper/SMemDC.cpp \
+           src/helper/SFrameProfiler.cpp \
+           src/helper/SRenderCacheMgr.cpp \
+           src/helper/SDisplayList.cpp \
            src/helper/SMenu.cpp \
            src/helper/SMenuEx.cpp \
            src/helper/SMenuWndHook.cpp \
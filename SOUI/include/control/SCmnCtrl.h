@@ -213,6 +213,9 @@ protected:
 
     BOOL OnEraseBkgnd(IRenderTarget * pRT){return TRUE;}
 
+    //背景皮肤在OnPaint中按状态及动画透明度绘制，不声明为不透明
+    virtual BOOL IsOpaque(){return FALSE;}
+
     HRESULT OnAttrAccel(SStringW strAccel,BOOL bLoading);
 
 protected:
@@ -360,6 +363,17 @@ protected:
      */
     virtual CSize GetDesiredSize(int wid, int hei) ;
 
+    /**
+     * SImageWnd::LoadSrcImage
+     * @param    SIZE szDecode -- 期望的显示大小,{0,0}表示原始大小
+     * @return   void
+     *
+     * Describe  按显示大小加载src属性指定的图片, 大图在解码时就缩小
+     */
+    void LoadSrcImage(SIZE szDecode);
+
+    HRESULT OnAttrSrc(const SStringW& strValue, BOOL bLoading);
+
 	int m_iTile;		/**<绘制是否平铺,0--位伸（默认），1--不变常规绘制, 2--平铺 */
     BOOL m_bManaged;	/**< 是否要自动释放当前的m_pSkin对象 */
     int m_iIcon;		/**< 绘制状态索引 */
@@ -367,9 +381,12 @@ protected:
     SAutoRefPtr<IBitmap>    m_pImg;/**<使用代码设定的图片*/
     FilterLevel             m_fl;/**<绘制图片的放大精度*/
 	bool m_bKeepAspect; /**< keep aspect ratio */
+    SStringW                m_strSrc;/**<src属性指定的图片,绘制时按窗口大小加载*/
+    CSize                   m_szDecode;/**<m_pImg解码时使用的期望大小*/
 
     SOUI_ATTRS_BEGIN()
         ATTR_SKIN(L"skin", m_pSkin, TRUE)
+        ATTR_CUSTOM(L"src", OnAttrSrc)
         ATTR_INT(L"iconIndex", m_iIcon, FALSE)
 		ATTR_INT(L"tile", m_iTile, TRUE)
 		ATTR_BOOL(L"keepAspect",m_bKeepAspect,TRUE)
@@ -1,8 +1,10 @@
 ﻿#pragma once
 
 #include "core/SItemPanel.h"
+#include "helper/SListViewRangeUpdater.h"
 #include "interface/SAdapter-i.h"
 #include "interface/SListViewItemLocator-i.h"
+#include "interface/STaskLoop-i.h"
 namespace SOUI
 {
     
@@ -12,6 +14,7 @@ namespace SOUI
         SOUI_CLASS_NAME(SListView,L"listview")
 
         friend class SListViewDataSetObserver;
+        friend class SListViewPrepareTask;
     public:
         SListView();
         ~SListView();
@@ -28,6 +31,18 @@ namespace SOUI
         
         void SetItemLocator(IListViewItemLocator *pItemLocator);
         void EnsureVisible( int iItem );
+
+        /**
+        * SetAsyncAdapter
+        * @brief    开启表项数据的异步准备
+        * @param    ILvAsyncAdapter * pAsyncAdapter -- 当前adapter实现的异步扩展接口, NULL关闭
+        * @param    ITaskLoop * pWorker -- 执行prepareItem的工作线程
+        * @param    int nPrefetch -- 在可见区前后预先准备的表项数量
+        *
+        * Describe  数据没有准备好的可见表项先绑定占位视图, 准备完成后在UI线程中重新绑定。
+        *           重新设置adapter后需要重新调用
+        */
+        void SetAsyncAdapter(ILvAsyncAdapter *pAsyncAdapter, ITaskLoop *pWorker, int nPrefetch=5);
         
         void SetSel(int iItem,BOOL bNotify=FALSE);
         int  GetSel()const{return m_iSelItem;}
@@ -43,6 +58,10 @@ namespace SOUI
         void onDataSetChanged();
         void onDataSetInvalidated();
 		void onItemDataChanged(int iItem);
+		void onItemRangeInserted(int iItem,int nCount);
+		void onItemRangeRemoved(int iItem,int nCount);
+		void onItemRangeChanged(int iItem,int nCount);
+		void onItemRangeMoved(int iFrom,int iTo,int nCount);
     protected:
         bool OnItemClick(EventArgs *pEvt);
         
@@ -68,6 +87,13 @@ namespace SOUI
         
         void UpdateVisibleItems();
         void UpdateVisibleItem(int iItem);
+        void UpdateItemRange();
+
+        void BindItemView(int iItem,SItemPanel *pItem);
+        void RequestPrepare(int iItem,bool bVisible);
+        void PrefetchItems(int iFirst,int iLast);
+        void CancelPrepare();
+        void OnItemPrepared(int iItem,int nGeneration);
 
         void OnPaint(IRenderTarget *pRT);
         void OnSize(UINT nType, CSize size);
@@ -125,6 +151,7 @@ namespace SOUI
 
         int                             m_iFirstVisible;//第一个显示项索引
         SList<ItemInfo>                 m_lstItems; //当前正在显示的项
+        typedef SListViewRangeUpdater<IListViewItemLocator,SList<ItemInfo> > RangeUpdater;
         SItemPanel*                     m_itemCapture;//The item panel that has been set capture.
         
         int                             m_iSelItem;
@@ -137,5 +164,12 @@ namespace SOUI
         SAutoRefPtr<ISkinObj>           m_pSkinDivider;
         SLayoutSize                     m_nDividerSize;
         BOOL                            m_bWantTab;
+
+        ILvAsyncAdapter *               m_asyncAdapter;     //表项数据异步准备接口, 由m_adapter实现
+        SAutoRefPtr<ITaskLoop>          m_prepareWorker;    //执行prepareItem的工作线程
+        SAutoRefPtr<ITaskLoop>          m_prepareNotifier;  //把准备完成通知投递回UI线程
+        SMap<int,long>                  m_pendingPrepare;   //正在准备的表项 -> 任务ID
+        int                             m_nPrefetch;        //可见区前后预先准备的表项数量
+        int                             m_nPrepareGen;      //表项索引失效时递增, 丢弃过期的完成通知
     };
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #pragma once
 #include "core/SPanel.h"
 #include "core/SItemPanel.h"
+#include "helper/SListViewRangeUpdater.h"
 #include "SHeaderCtrl.h"
 
 namespace SOUI
@@ -89,6 +90,11 @@ namespace SOUI
         void onDataSetChanged();
         void onDataSetInvalidated();
         void onItemDataChanged(int iItem);
+        void onItemRangeInserted(int iItem,int nCount);
+        void onItemRangeRemoved(int iItem,int nCount);
+        void onItemRangeChanged(int iItem,int nCount);
+        void onItemRangeMoved(int iFrom,int iTo,int nCount);
+        void UpdateItemRange();
     protected:
         bool OnItemClick(EventArgs *pEvt);
 
@@ -168,6 +174,7 @@ namespace SOUI
 
         int                             m_iFirstVisible;//第一个显示项索引
         SList<ItemInfo>                 m_lstItems; //当前正在显示的项
+        typedef SListViewRangeUpdater<IListViewItemLocator,SList<ItemInfo> > RangeUpdater;
         SItemPanel*                     m_itemCapture;//The item panel that has been set capture.
 
         int                             m_iSelItem;
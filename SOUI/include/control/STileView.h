@@ -2,6 +2,7 @@
 
 #include "core/SWnd.h"
 #include "core/SItemPanel.h"
+#include "helper/SListViewRangeUpdater.h"
 #include "interface/SAdapter-i.h"
 #include "helper/STileViewItemLocator.h"
 
@@ -51,6 +52,11 @@ protected:
     void onDataSetChanged();
     void onDataSetInvalidated();
     void onItemDataChanged(int iItem);
+    void onItemRangeInserted(int iItem, int nCount);
+    void onItemRangeRemoved(int iItem, int nCount);
+    void onItemRangeChanged(int iItem, int nCount);
+    void onItemRangeMoved(int iFrom, int iTo, int nCount);
+    void UpdateItemRange();
 protected:
     bool OnItemClick(EventArgs *pEvt);
 
@@ -134,6 +140,7 @@ protected:
 
     int                             m_iFirstVisible;//第一个显示项索引
     SList<ItemInfo>                 m_lstItems; //当前正在显示的项
+    typedef SListViewRangeUpdater<STileViewItemLocator,SList<ItemInfo> > RangeUpdater;
     SItemPanel                     *m_itemCapture;//The item panel that has been set capture.
     
     int                             m_iSelItem;
@@ -41,9 +41,18 @@ typedef struct tagTVITEM {
     int            nLevel;
     int            nCheckBoxValue;
     int         nContentWidth;
+    int         nChildRows;     //子孙节点在本节点展开时占用的行数，用于快速定位显示行
     DWORD        dwToggleState;
     DWORD       dwCheckBoxState;
 
+    //同一父节点的子节点按兄弟顺序组成一棵treap(树堆)，按行号定位时每层只需O(logN)
+    tagTVITEM * pSibParent;     //treap中的父节点
+    tagTVITEM * pSibLeft;       //treap中的左子节点
+    tagTVITEM * pSibRight;      //treap中的右子节点
+    tagTVITEM * pSibRoot;       //本节点的子节点组成的treap的根
+    UINT        uSibPriority;   //treap优先级
+    int         nSibRows;       //treap子树中所有兄弟节点占用的行数之和
+
     tagTVITEM()
     {
         nImage = -1;
@@ -57,8 +66,12 @@ typedef struct tagTVITEM {
         nLevel = 0;
         nCheckBoxValue = STVICheckBox_UnChecked;
         nContentWidth = 0;
+        nChildRows = 0;
         dwToggleState = WndState_Normal;
         dwCheckBoxState = WndState_Normal;
+        pSibParent = pSibLeft = pSibRight = pSibRoot = NULL;
+        uSibPriority = 0;
+        nSibRows = 1;
     }
 
 } TVITEM, *LPTVITEM;
@@ -141,6 +154,12 @@ protected:
     virtual int  GetMaxItemWidth();
     virtual int  GetMaxItemWidth(HSTREEITEM hItem);
     int  GetItemShowIndex(HSTREEITEM hItemObj);
+    HSTREEITEM GetItemByShowIndex(int iShowIndex) const;
+    HSTREEITEM GetNextShowItem(HSTREEITEM hItem) const;
+    void UpdateChildRows(HSTREEITEM hParent,int nDelta);
+    static int GetItemRows(const LPTVITEM pItem);
+    LPTVITEM & GetSibRoot(HSTREEITEM hParent);
+    void RebuildSibIndex(HSTREEITEM hParent);
     BOOL GetItemRect( LPTVITEM pItem,CRect &rcItem );
 
     void RedrawItem(HSTREEITEM hItem);
@@ -186,6 +205,8 @@ protected:
 
     int            m_nVisibleItems;
     int         m_nMaxItemWidth;
+    LPTVITEM    m_pSibRoot;     //根节点的子节点组成的treap
+    UINT        m_uSibSeed;     //生成treap优先级的随机种子
 
     UINT        m_uItemMask;
     int         m_nItemOffset;
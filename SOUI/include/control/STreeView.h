@@ -21,6 +21,10 @@ namespace SOUI
 
         virtual void OnBranchExpandedChanged(HTREEITEM hItem,BOOL bExpandedOld,BOOL bExpandedNew);
 
+        virtual void OnItemInserted(HTREEITEM hParent,HTREEITEM hItem);
+
+        virtual void OnItemRemoved(HTREEITEM hParent);
+
         virtual int GetTotalHeight() const;
 
         virtual int GetTotalWidth() const;
@@ -82,6 +86,9 @@ namespace SOUI
 
         void _InitBranch(HTREEITEM hItem);
 
+        //hParent的子节点发生增删后重新统计其直接子节点的偏移及分枝尺寸，并向上更新
+        void _UpdateChildren(HTREEITEM hParent);
+
 
         SAutoRefPtr<ITvAdapter> m_adapter;
         int                     m_nLineHeight;
@@ -124,6 +131,8 @@ namespace SOUI
 		void onBranchChanged(HTREEITEM hBranch);
 		void onBranchInvalidated(HTREEITEM hBranch,bool bInvalidParents, bool bInvalidChildren);
 		void onBranchExpandedChanged(HTREEITEM hBranch,BOOL bExpandedOld,BOOL bExpandedNew);
+		void onItemInserted(HTREEITEM hParent,HTREEITEM hItem);
+		void onItemRemoved(HTREEITEM hParent,HTREEITEM hItem);
 
     protected:
 		void OnPaint(IRenderTarget * pRT);
@@ -17,6 +17,7 @@
 #include <helper/SplitString.h>
 #include <helper/SWndSpy.h>
 #include <helper/SScriptTimer.h>
+#include <helper/SFrameProfiler.h>
 namespace SOUI
 {
     class SHostWndAttr : public SObject, public ITrCtxProvider
@@ -64,6 +65,12 @@ namespace SOUI
             ATTR_ICON(L"smallIcon",m_hAppIconSmall,FALSE)
             ATTR_ICON(L"bigIcon",m_hAppIconBig,FALSE)
             ATTR_INT(L"allowSpy",m_bAllowSpy,FALSE)
+            ATTR_INT(L"partialPresent",m_bPartialPresent,FALSE)
+            ATTR_INT(L"skipOpaqueBkgnd",m_bSkipOpaqueBkgnd,FALSE)
+            ATTR_INT(L"profile",m_bProfile,FALSE)
+            ATTR_INT(L"profileOverlay",m_bProfileOverlay,FALSE)
+            ATTR_INT(L"hitTestGrid",m_nHitTestGrid,FALSE)
+            ATTR_INT(L"occlusionCulling",m_bOcclusionCulling,FALSE)
             ATTR_ENUM_BEGIN(L"wndType",DWORD,FALSE)
                 ATTR_ENUM_VALUE(L"undefine",WT_UNDEFINE)
                 ATTR_ENUM_VALUE(L"appMain",WT_APPMAIN)
@@ -83,9 +90,15 @@ namespace SOUI
         DWORD m_bTranslucent:1;     //窗口的半透明属性
         DWORD m_bAllowSpy:1;        //允许spy
         DWORD m_bSendWheel2Hover:1; //将滚轮消息发送到hover窗口
+        DWORD m_bPartialPresent:1;  //脏矩形分散时逐个更新到屏幕
+        DWORD m_bSkipOpaqueBkgnd:1; //脏矩形被不透明窗口(SWindow::IsOpaque)完全覆盖时，不绘制该窗口下面的窗口
+        DWORD m_bProfile:1;         //开启刷新性能分析
+        DWORD m_bProfileOverlay:1;  //在窗口上显示性能浮层
+        DWORD m_bOcclusionCulling:1;//绘制时跳过被不透明兄弟窗口完全覆盖的窗口
 
         DWORD m_dwStyle;
         DWORD m_dwExStyle;
+        int   m_nHitTestGrid;       //命中测试网格索引的单元格大小，0表示不使用索引
 
         SStringW m_strTrCtx;     //在语言翻译时作为context使用
         STrText  m_strTitle;
@@ -93,6 +106,24 @@ namespace SOUI
         HICON   m_hAppIconBig;
     };
 
+    /**
+    * @struct     SFrameStats
+    * @brief      宿主窗口的刷新统计
+    *
+    * Describe    时间单位为微秒，调用SHostWnd::ResetFrameStats清零
+    */
+    struct SFrameStats
+    {
+        DWORD   nFrames;            /**<刷新次数 */
+        UINT64  nPaintedPixels;     /**<重绘到缓存的像素数 */
+        UINT64  nPresentedPixels;   /**<更新到屏幕的像素数 */
+        DWORD   nPresentRects;      /**<更新到屏幕的矩形数 */
+        DWORD   nOpaqueRects;       /**<跳过背景绘制的脏矩形数 */
+        UINT64  usLayout;           /**<布局耗时 */
+        UINT64  usPaint;            /**<绘制耗时 */
+        UINT64  usPresent;          /**<更新到屏幕耗时 */
+    };
+
 class SOUI_EXP SHostWnd
     : public SwndContainerImpl
     , public SNativeWnd
@@ -113,6 +144,11 @@ protected:
     IToolTip *              m_pTipCtrl;         /**<tip接口*/
 
     SAutoRefPtr<IRegion>    m_rgnInvalidate;    /**<脏区域*/
+    SArray<CRect>           m_arrDirtyRect;     /**<互不相交的脏矩形，和m_rgnInvalidate同步更新*/
+    BOOL                    m_bDirtyOverflow;   /**<脏矩形太多，只使用m_rgnInvalidate*/
+    SArray<CRect>           m_arrSysPaintRect;  /**<WM_PAINT时系统的更新区域*/
+    SFrameStats             m_frameStats;       /**<刷新统计*/
+    SFrameProfiler *        m_pProfiler;        /**<刷新性能分析，没有开启时为NULL*/
     SAutoRefPtr<IRenderTarget> m_memRT;         /**<绘制缓存*/
     SAutoRefPtr<SStylePool> m_privateStylePool; /**<局部style pool*/
     SAutoRefPtr<SSkinPool>  m_privateSkinPool;  /**<局部skin pool*/
@@ -182,6 +218,21 @@ public:
 		return m_pTipCtrl;
 	}
 
+	const SFrameStats & GetFrameStats() const{
+		return m_frameStats;
+	}
+	void ResetFrameStats();
+
+	/**
+	 * EnableProfiler
+	 * @brief    开启或者关闭刷新性能分析
+	 * @param    BOOL bEnable --  开启
+	 * @param    BOOL bOverlay --  在窗口右上角显示性能浮层
+	 * @return   void
+	 * Describe  关闭时丢弃已经记录的数据，对应XML中的profile和profileOverlay属性
+	 */
+	void EnableProfiler(BOOL bEnable,BOOL bOverlay=FALSE);
+
 	bool StartHostAnimation(IAnimation *pAni);
 	bool StopHostAnimation();
 	void UpdateAutoSizeCount(bool bInc);
@@ -207,6 +258,9 @@ protected://辅助函数
     void _UpdateNonBkgndBlendSwnd();
     void _RestoreClickState();
 	void _Invalidate(LPCRECT prc);
+    void _AddDirtyRect(const CRect & rc);
+    void _ClearDirtyRect();
+    SWindow * _GetOpaqueCover(const CRect & rc);
 
 protected:
     //////////////////////////////////////////////////////////////////////////
@@ -254,6 +308,7 @@ protected:
     void OnKillFocus(HWND wndFocus);
         
     void UpdateHost(HDC dc,const CRect &rc,BYTE byAlpha=255);
+    void UpdateHostRects(HDC dc,const SArray<CRect> & arrRc);
     void UpdateLayerFromRenderTarget(IRenderTarget *pRT,BYTE byAlpha, LPCRECT prcDirty=NULL);
 
     void OnCaptureChanged(HWND wnd);
@@ -324,6 +379,8 @@ protected:// IContainer
 	virtual void OnCavasInvalidate(SWND swnd);
 
 	virtual void EnableIME(BOOL bEnable);
+
+	virtual SFrameProfiler * GetProfiler();
 protected://Swindow 虚方法
     virtual void BeforePaint(IRenderTarget *pRT, SPainter &painter);
     virtual void AfterPaint(IRenderTarget *pRT, SPainter &painter);
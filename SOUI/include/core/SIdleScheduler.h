@@ -0,0 +1,127 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SIdleScheduler.h
+* @brief      空闲任务调度
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/17
+*
+* Describe    在消息循环空闲时分段执行可中断的任务，如布局预热、列表预取、皮肤预缩放等。
+*             每次空闲处理有时间片，线程消息队列中有输入消息时任务应该尽快让出。
+*             设置了超时的任务即使一直不空闲，也会在超时后执行一次。
+*/
+
+#pragma once
+
+namespace SOUI
+{
+    /**
+    * @class     SIdleDeadline
+    * @brief     一次空闲执行的截止时间
+    */
+    class SOUI_EXP SIdleDeadline
+    {
+    public:
+        SIdleDeadline(DWORD dwBudget,BOOL bTimeout);
+
+        //剩余时间，毫秒
+        DWORD TimeRemaining() const;
+
+        //任务是因为超时而不是空闲被执行的，此时TimeRemaining为0
+        BOOL DidTimeout() const {return m_bTimeout;}
+
+        //线程消息队列中是否有输入消息
+        BOOL HasPendingInput() const;
+
+        //时间用完或者有输入消息时返回TRUE，任务应该保存进度并返回
+        BOOL ShouldYield() const;
+
+    protected:
+        LONGLONG    m_llEnd;
+        LONGLONG    m_llFreq;
+        BOOL        m_bTimeout;
+    };
+
+    struct IIdleTask
+    {
+        /**
+         * RunIdle
+         * @brief    执行一段工作
+         * @param    const SIdleDeadline & deadline --  截止时间
+         * @return   BOOL -- TRUE表示还有工作，下次空闲时继续；FALSE表示任务完成，任务被移出调度器
+         */
+        virtual BOOL RunIdle(const SIdleDeadline & deadline) = 0;
+    };
+
+    //调度器没有加锁，只能在消息循环线程中访问
+    class SOUI_EXP SIdleScheduler
+    {
+    public:
+        struct IdleStats
+        {
+            DWORD       nSlices;        /**<执行空闲任务的次数 */
+            DWORD       nRuns;          /**<任务被调用的次数 */
+            DWORD       nTimeouts;      /**<因超时在非空闲时调用任务的次数 */
+            DWORD       nInputYields;   /**<因输入消息提前结束的空闲处理次数 */
+            ULONGLONG   ullGranted;     /**<分配给空闲任务的时间，微秒 */
+            ULONGLONG   ullUsed;        /**<空闲任务实际使用的时间，微秒 */
+        };
+
+        SIdleScheduler();
+
+        /**
+         * AddTask
+         * @brief    添加空闲任务
+         * @param    IIdleTask * pTask --  任务，调度器不管理任务的生命周期
+         * @param    DWORD dwTimeout --  超时，毫秒。INFINITE表示只在空闲时执行
+         * @return   BOOL -- 任务已经在调度器中时返回FALSE
+         * Describe  超时只保证任务在添加后dwTimeout毫秒内至少被调用一次
+         */
+        BOOL AddTask(IIdleTask *pTask,DWORD dwTimeout = INFINITE);
+
+        BOOL RemoveTask(IIdleTask *pTask);
+
+        BOOL HasTask() const {return !m_arrTasks.IsEmpty();}
+
+        //在空闲时调用，返回TRUE表示还有任务
+        BOOL RunIdle();
+
+        //调用已经超时的任务
+        void RunExpired();
+
+        /**
+         * GetNextTimeout
+         * @brief    获取最早的超时时刻
+         * @param    DWORD & dwTimeoutAt --  超时的时刻(GetTickCount)
+         * @return   BOOL -- 没有设置了超时的任务时返回FALSE
+         * Describe  消息循环用它设置定时器，保证队列中没有消息时超时任务也能按时执行
+         */
+        BOOL GetNextTimeout(DWORD & dwTimeoutAt) const;
+
+        //设置每次空闲处理的时间片，毫秒，默认50
+        void SetSliceTime(DWORD dwMs) {m_dwSliceTime = dwMs;}
+
+        const IdleStats & GetStats() const {return m_stats;}
+
+        void ResetStats();
+
+    protected:
+        struct TaskInfo
+        {
+            IIdleTask * pTask;
+            DWORD       dwTimeoutAt;    //超时的时刻(GetTickCount)，0表示没有超时
+        };
+
+        int FindTask(IIdleTask *pTask) const;
+        //调用任务并处理返回值，返回任务是否还在调度器中
+        BOOL RunTask(int iTask,const SIdleDeadline & deadline);
+
+        SArray<TaskInfo>    m_arrTasks;
+        int                 m_iNext;        //下次空闲时首先调用的任务
+        int                 m_nTimeouts;    //设置了超时的任务数
+        DWORD               m_dwSliceTime;
+        IdleStats           m_stats;
+    };
+}
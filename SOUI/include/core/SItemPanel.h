@@ -69,6 +69,10 @@ public://SwndContainerImpl
 	virtual int GetScale() const;
 
 	virtual void EnableIME(BOOL bEnable);
+
+	virtual SFrameProfiler * GetProfiler();
+
+	virtual BOOL IsOcclusionCulling();
 public://SWindow
     virtual void ModifyItemState(DWORD dwStateAdd, DWORD dwStateRemove);
 
@@ -2,6 +2,7 @@
 
 #include <interface/STaskLoop-i.h>
 #include <helper/SCriticalSection.h>
+#include <core/SIdleScheduler.h>
 
 #ifndef WM_SYSTIMER
 #define WM_SYSTIMER 0x0118   //(caret blink)
@@ -42,6 +43,14 @@ namespace SOUI
 
         BOOL RemoveIdleHandler(IIdleHandler* pIdleHandler);
 
+        // Idle task operations, see SIdleScheduler::AddTask
+        // must be called on the message loop thread, use PostTask from other threads
+        BOOL AddIdleTask(IIdleTask* pTask, DWORD dwTimeout = INFINITE);
+
+        BOOL RemoveIdleTask(IIdleTask* pTask);
+
+        SIdleScheduler & GetIdleScheduler() {return m_idleScheduler;}
+
         static BOOL IsIdleMessage(MSG* pMsg);
 
         // Overrideables
@@ -62,6 +71,13 @@ namespace SOUI
 		virtual BOOL PostTask(const IRunnable & runable);
 		virtual int  RemoveTasksForObject(void *pObj);
     protected:
+        //空闲任务还有工作时投递消息，让消息循环处理完队列中的消息后继续空闲处理
+        void PostIdleResume();
+        //按最早的超时时刻设置定时器，没有超时任务时删除定时器
+        void UpdateIdleTimer();
+        //是否是空闲调度自己投递的消息或者定时器消息，这些消息不开始新的空闲期
+        BOOL IsIdleSchedulerMsg(const MSG *pMsg) const;
+
         BOOL m_bRunning;
 		BOOL m_bQuit;
 		SCriticalSection m_cs;
@@ -69,6 +85,10 @@ namespace SOUI
 		SCriticalSection m_csRunningQueue;
 		SList<IRunnable*>	m_runningQueue;
 		DWORD  m_tid;
+		SIdleScheduler m_idleScheduler;
+		BOOL     m_bIdleResumePosted;
+		UINT_PTR m_uIdleTimer;
+		DWORD    m_dwIdleTimerAt;
     };
 
 
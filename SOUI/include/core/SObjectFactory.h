@@ -20,14 +20,23 @@ namespace SOUI
 	class SOUI_EXP SObjectInfo
 	{
 	public:
-		SObjectInfo(const SStringW & name = L"", int type = None) :mName(name), mType(type)
+		//默认只查找已有的原子，用于查询，不会让驻留表随查询的名字增长. 注册时由Intern创建原子
+		SObjectInfo(const SStringW & name = L"", int type = None, bool bIntern = false) :mName(name), mType(type)
 		{
 			mName.MakeLower();
+			mAtom = bIntern?SStringPool::Intern(mName,mName.GetLength()):SStringPool::Find(mName,mName.GetLength());
+		}
+
+		void Intern()
+		{
+			if(!mAtom) mAtom = SStringPool::Intern(mName,mName.GetLength());
 		}
 
 		bool operator == (const SObjectInfo & src) const
 		{
-			return src.mType == mType && src.mName.Compare(mName) == 0;
+			if(src.mType != mType) return false;
+			if(src.mAtom && mAtom) return src.mAtom == mAtom;
+			return src.mName == mName;//没有原子的查询key按字符串比较
 		}
 
 		bool IsValid() const
@@ -37,7 +46,8 @@ namespace SOUI
 
 		ULONG Hash() const
 		{
-			ULONG uRet = CElementTraits<SStringW>::Hash(mName);
+			//原子的哈希和字符串的哈希一致，有没有原子的key都落在同一个桶中
+			ULONG uRet = mAtom?mAtom->nHash:CElementTraits<SStringW>::Hash(mName);
 			uRet = (uRet << 5) + mType;
 			return uRet;
 		}
@@ -52,6 +62,7 @@ namespace SOUI
 
 		SStringW mName;
 		int      mType;
+		SATOM    mAtom;	//mName的驻留原子，查询用的key为NULL表示名字从未被注册
 	};
 
 	/**
@@ -41,6 +41,7 @@ public:\
 		SINGLETON_RICHEDITMENUDEF,
 		SINGLETON_SIMPLEWNDHELPER,
 		SINGLETON_HOSTMGR,
+		SINGLETON_RENDERCACHEMGR,
 
 		SINGLETON_COUNT,
 	};
@@ -36,6 +36,8 @@ public:
     
     virtual void OnColorize(COLORREF cr);
 
+    virtual BOOL IsOpaque(int iState) const;
+
 protected:
 	virtual void OnInitFinished(pugi::xml_node xmlNode);
 	virtual void _DrawByIndex(IRenderTarget *pRT, LPCRECT rcDraw, int iState, BYTE byAlpha) const;
@@ -53,6 +55,10 @@ private:
 	mutable SAutoRefPtr<IBitmap> m_pImg;
 	mutable SStringW m_strSrc;
 	BOOL m_bLazyLoad;
+	SIZE m_szDecode;	//单个子图的显示大小,用于在解码时缩小大图,{0,0}表示原始大小
+	mutable int m_nOpaque;	//位图是否没有透明像素，-1表示还没有检查
+
+	IBitmap * _LoadImage() const;
 protected:
 	LRESULT OnAttrSrc(const SStringW& value, BOOL bLoading);
 
@@ -63,6 +69,7 @@ protected:
 		ATTR_BOOL(L"vertical", m_bVertical, FALSE)//子图是否垂直排列，0--水平排列(默认), 其它--垂直排列
         ATTR_INT(L"states",m_nStates, FALSE)  //子图数量,默认为1
 		ATTR_BOOL(L"lazyLoad",m_bLazyLoad,FALSE)
+		ATTR_SIZE(L"decodeSize",m_szDecode,FALSE)//子图的显示大小,大图按整数倍缩小后解码,图片不会小于该大小
         ATTR_ENUM_BEGIN(L"filterLevel",FilterLevel,FALSE)
             ATTR_ENUM_VALUE(L"none",kNone_FilterLevel)
             ATTR_ENUM_VALUE(L"low",kLow_FilterLevel)
@@ -78,6 +85,9 @@ class SOUI_EXP SSkinImgCenter : public SSkinImgList
 public:
 	SSkinImgCenter() {}
 
+	//居中绘制不能覆盖整个绘制区
+	virtual BOOL IsOpaque(int iState) const {return FALSE;}
+
 protected:
 	virtual void _DrawByIndex(IRenderTarget *pRT, LPCRECT rcDraw, int iState, BYTE byAlpha);
 };
@@ -211,6 +221,7 @@ protected:
 	virtual void _DrawByIndex(IRenderTarget *pRT, LPCRECT prcDraw, int iState,BYTE byAlpha) const;
     virtual void OnColorize(COLORREF cr);
 	virtual ISkinObj * Scale(int nScale);
+	virtual BOOL IsOpaque(int iState) const;
 
     COLORREF m_crFrom;
     COLORREF m_crTo;
@@ -258,6 +269,8 @@ public:
     
     virtual int GetIdealSize()  const;
 
+    virtual BOOL IsOpaque(int iState) const {return FALSE;}
+
 protected:
 	virtual void _DrawByIndex(IRenderTarget *pRT, LPCRECT prcDraw, DWORD dwState,BYTE byAlpha) const {}
 	virtual void _DrawByState(IRenderTarget *pRT, LPCRECT prcDraw, DWORD dwState,BYTE byAlpha) const;
@@ -289,6 +302,7 @@ protected:
 	virtual void _DrawByIndex(IRenderTarget *pRT, LPCRECT prcDraw, int iState,BYTE byAlpha) const;
 	virtual int GetStates() const;
 	virtual ISkinObj * Scale(int nScale);
+	virtual BOOL IsOpaque(int iState) const;
 
     SOUI_ATTRS_BEGIN()
         ATTR_COLOR(L"normal",m_crStates[0],FALSE)
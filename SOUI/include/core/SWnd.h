@@ -28,6 +28,7 @@
 #include "SSkin.h"
 #include <OCIdl.h>
 #include <animation/SAnimation.h>
+#include "helper/SDisplayList.h"
 
 #define SC_WANTARROWS     0x0001      /* Control wants arrow keys         */
 #define SC_WANTTAB        0x0002      /* Control wants tab keys           */
@@ -224,6 +225,8 @@ namespace SOUI
         friend class SHostWnd;
         friend class SwndContainerImpl;
         friend class FocusSearch;
+        friend class SRenderCacheMgr;
+        friend class SHitTestGrid;
 
 		class SAnimationHandler : public ITimelineHandler{
 		private:
@@ -1261,6 +1264,15 @@ namespace SOUI
          * Describe  
          */    
         virtual BOOL IsLayeredWindow() const;
+
+        /**
+         * IsOpaque
+         * @brief    查询窗口的客户区是否被不透明地完全绘制
+         * @return   BOOL -- TRUE表示不透明
+         * Describe  默认由blendBackground样式、背景皮肤和背景色的透明度决定。
+         *           开启遮挡剔除时，被不透明兄弟窗口完全覆盖的窗口不再绘制
+         */
+        virtual BOOL IsOpaque();
     
 		/**
 		* DispatchPaint
@@ -1304,11 +1316,28 @@ namespace SOUI
         void _PaintRegion(IRenderTarget *pRT, IRegion *pRgn,UINT iZorderBegin,UINT iZorderEnd);
 		
 		void _PaintChildren(IRenderTarget *pRT, IRegion *pRgn, UINT iBeginZorder, UINT iEndZorder);
+		//从上到下查找被不透明兄弟窗口完全覆盖的子窗口，按从上到下的顺序输出
+		void _GetOccludedChildren(IRegion *pRgn, UINT iBeginZorder, UINT iEndZorder, SArray<SWindow*> & arrOccluded);
 
         void DrawDefFocusRect(IRenderTarget *pRT,CRect rc);
         
         void UpdateCacheMode();
 
+        //按需创建缓存RT，创建失败返回false
+        bool _PrepareCacheRT();
+        //释放缓存RT并从缓存管理器中移除
+        void _ReleaseCacheRT();
+        //被缓存管理器淘汰时调用
+        void _DropCacheRT();
+
+        //使用录制的绘制命令绘制整个子树，返回false时需要直接绘制
+        bool _PaintDisplayList(IRenderTarget *pRT,UINT iZorderBegin,UINT iZorderEnd);
+        bool _CanRecordDisplayList();
+        //子树内容变化，本窗口及所有父窗口的录制命令失效
+        void _MarkDisplayListDirty(BOOL bSelf);
+        //只有变换矩阵或透明度变化的刷新，本窗口的录制命令仍然有效
+        void _InvalidateXform();
+
         void TestMainThread();
         
 		void GetScaleSkin(SAutoRefPtr<ISkinObj> &pSkin,int nScale);
@@ -1401,6 +1430,7 @@ namespace SOUI
         HRESULT OnAttrEnable(const SStringW& strValue, BOOL bLoading);
         HRESULT OnAttrDisplay(const SStringW& strValue, BOOL bLoading);
         HRESULT OnAttrCache(const SStringW& strValue, BOOL bLoading);
+        HRESULT OnAttrDisplayList(const SStringW& strValue, BOOL bLoading);
         HRESULT OnAttrAlpha(const SStringW& strValue, BOOL bLoading);
         HRESULT OnAttrSkin(const SStringW& strValue, BOOL bLoading);
         HRESULT OnAttrLayout(const SStringW& strValue, BOOL bLoading);
@@ -1430,6 +1460,7 @@ namespace SOUI
             ATTR_CUSTOM(L"show", OnAttrVisible)
             ATTR_CUSTOM(L"display", OnAttrDisplay)
             ATTR_CUSTOM(L"cache", OnAttrCache)
+            ATTR_CUSTOM(L"displayList", OnAttrDisplayList)
             ATTR_CUSTOM(L"alpha",OnAttrAlpha)
             ATTR_BOOL(L"layeredWindow",m_bLayeredWindow, TRUE)
             ATTR_CUSTOM(L"trackMouseEvent",OnAttrTrackMouseEvent)
@@ -1507,9 +1538,15 @@ namespace SOUI
         DWORD               m_bCacheDraw:1;     /**< 支持窗口内容的Cache标志 */
         DWORD               m_bCacheDirty:1;    /**< 缓存窗口脏标志 */
         DWORD               m_bLayeredWindow:1; /**< 指示是否是一个分层窗口 */
+        DWORD               m_bDisplayList:1;   /**< 录制子树的绘制命令，内容不变时直接回放 */
+        DWORD               m_bDisplayListDirty:1;/**< 录制命令脏标志 */
+        DWORD               m_bDisplayListFailed:1;/**< 上次录制失败，内容改变后再重试 */
+        DWORD               m_bRecording:1;     /**< 正在录制绘制命令 */
+        DWORD               m_bXformInvalidating:1;/**< 正在处理变换矩阵或透明度变化引起的刷新 */
 
 		LayoutDirtyType     m_layoutDirty;      /**< 布局脏标志 参见LayoutDirtyType */
         SAutoRefPtr<IRenderTarget> m_cachedRT;  /**< 缓存窗口绘制的RT */
+        SAutoRefPtr<SDisplayList>  m_displayList;/**< 子树的绘制命令 */
         SAutoRefPtr<IRegion>       m_clipRgn;    /**< 窗口Region */
 		SAutoRefPtr<IPath>		   m_clipPath;  /**< 窗口Path */
         SAutoRefPtr<ISkinObj>      m_pBgSkin;          /**< 背景skin */
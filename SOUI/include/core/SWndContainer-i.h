@@ -23,10 +23,18 @@ namespace SOUI
 {
 
     struct IAcceleratorMgr;
+    class SFrameProfiler;
     
     enum{
     ZORDER_MIN  = 0,
     ZORDER_MAX  = (UINT)-1,
+    };
+
+    //影响窗口命中测试的变化
+    enum HitTestChange{
+    HITCHANGE_RECT = 0,     //窗口位置变化
+    HITCHANGE_XFORM,        //变换矩阵或者窗口区域变化
+    HITCHANGE_TREE,         //窗口可见性变化
     };
 
 	enum GrtFlag;
@@ -102,6 +110,15 @@ namespace SOUI
 		virtual void OnCavasInvalidate(SWND swnd) = 0;
 
 		virtual void EnableIME(BOOL bEnable) = 0;
+
+		//获取刷新性能分析器，没有开启时返回NULL
+		virtual SFrameProfiler * GetProfiler() {return NULL;}
+
+		//窗口位置、可见性、变换等影响命中测试的状态变化时调用
+		virtual void OnSwndHitTestChanged(SWindow *pWnd,HitTestChange change) {}
+
+		//绘制时是否跳过被不透明兄弟窗口完全覆盖的窗口
+		virtual BOOL IsOcclusionCulling() {return FALSE;}
     };
 
 
@@ -17,6 +17,7 @@
 #include <core/SFocusManager.h>
 #include <core/SCaret.h>
 #include <core/STimerlineHandlerMgr.h>
+#include <helper/SHitTestGrid.h>
 
 namespace SOUI
 {
@@ -43,9 +44,32 @@ namespace SOUI
         SOUI_CLASS_NAME(SwndContainerImpl,L"SwndContainerImpl")
     public:
         SwndContainerImpl();
+        virtual ~SwndContainerImpl();
         
         IDropTarget * GetDropTarget(){return &m_dropTarget;}
 
+        /**
+         * EnableHitTestGrid
+         * @brief    开启命中测试的网格索引
+         * @param    int nCellSize --  单元格大小(像素)，0表示关闭，使用遍历窗口树的方式
+         * @return   void
+         * Describe  窗口数量很多时减少鼠标移动时SwndFromPoint的开销
+         */
+        void EnableHitTestGrid(int nCellSize);
+
+        SHitTestGrid * GetHitTestGrid() {return m_pHitTestGrid;}
+
+        /**
+         * EnableOcclusionCulling
+         * @brief    开启遮挡剔除
+         * @param    BOOL bEnable --  TRUE时绘制跳过被不透明兄弟窗口完全覆盖的窗口
+         * @return   void
+         * Describe  窗口是否不透明由SWindow::IsOpaque决定
+         */
+        void EnableOcclusionCulling(BOOL bEnable) {m_bOcclusionCulling = bEnable;}
+
+        virtual SWND SwndFromPoint(CPoint &pt,bool bIncludeMsgTransparent=false);
+
         SFocusManager * GetFocusManager() {return &m_focusMgr;}
     protected:
         //ISwndContainer
@@ -86,6 +110,12 @@ namespace SOUI
 
 		virtual void OnCavasInvalidate(SWND swnd) {}
 
+		virtual SFrameProfiler * GetProfiler() {return NULL;}
+
+		virtual void OnSwndHitTestChanged(SWindow *pWnd,HitTestChange change);
+
+		virtual BOOL IsOcclusionCulling() {return m_bOcclusionCulling;}
+
     public://ITimelineHandler
         virtual void OnNextFrame();
     protected:
@@ -125,6 +155,10 @@ namespace SOUI
 		SAutoRefPtr<ICaret>			m_caret;
 
 		STimerlineHandlerMgr	    m_timelineHandlerMgr;
+
+		SHitTestGrid *				m_pHitTestGrid;	//命中测试索引，没有开启时为NULL
+
+		BOOL						m_bOcclusionCulling;	//遮挡剔除标志
     };
 
 }//namespace SOUI
@@ -36,6 +36,8 @@ namespace SOUI
         SArray<ISlotFunctor *> m_evtSlots;
     };
 
+    class SEventIdSet;
+
     class SOUI_EXP SEventSet
     {
         friend class SWindow;
@@ -167,8 +169,11 @@ namespace SOUI
 	void    setMutedState(bool setting);
 
     protected:
-        SEvent * GetEventObject(const DWORD dwEventID);
-        SArray<SEvent *> m_evtArr;
+        //bCreate为TRUE时为已注册但还没有订阅的事件创建SEvent对象
+        SEvent * GetEventObject(const DWORD dwEventID,BOOL bCreate=FALSE);
+
+        const SEventIdSet * m_pIdSet;   //注册的事件ID，注册顺序相同的对象共享
+        SArray<SEvent *> m_evtArr;      //有订阅者或者脚本的事件
         int      m_nMuted;
     };
 
@@ -2,6 +2,7 @@
 
 #include <core/SSingleton.h>
 #include <helper/SCriticalSection.h>
+#include "STaskQueue.h"
 
 #if _MSC_VER >= 1700	//VS2012
 #define ENABLE_RUNONUI
@@ -17,6 +18,10 @@
 // PostMessage [=] 中的 等号 是指 fn里调用的变量 都是 值拷贝的
 #define SRUNONUI(fn)		SNotifyCenter::getSingletonPtr()->RunOnUIAsync([=](){fn})
 
+// 指定通道的异步调用，见RunOnUILane
+#define SRUNONUI_INPUT(fn)	SNotifyCenter::getSingletonPtr()->RunOnUIAsync([=](){fn},RUNONUI_INPUT)
+#define SRUNONUI_IDLE(fn)	SNotifyCenter::getSingletonPtr()->RunOnUIAsync([=](){fn},RUNONUI_IDLE)
+
 #endif
 
 namespace SOUI
@@ -63,6 +68,7 @@ namespace SOUI
 						, protected INotifyCallback
 	{
 	public:
+		//nIntervel: 保留参数，异步事件不再通过定时器派发
 		SNotifyCenter(int nIntervel=20);
 		~SNotifyCenter(void);
 
@@ -83,9 +89,21 @@ namespace SOUI
         * @return    
         *
         * Describe  可以在非UI线程中调用，EventArgs *e必须是从堆上分配的内存，调用后使用Release释放引用计数
+        *           事件进入无锁队列，队列由空变为非空时才唤醒UI线程
         */
 		void FireEventAsync(EventArgs *e);
 
+        /**
+        * SetEventCoalescing
+        * @brief    设置异步事件是否合并
+        * @param    DWORD dwEventID -- 事件ID
+        * @param    BOOL bCoalesce -- TRUE:同一批派发的多个该类事件只派发最后一个
+        * @return    
+        *
+        * Describe  只能在UI线程中调用，用于进度等只关心最新值的通知
+        */
+		void SetEventCoalescing(DWORD dwEventID,BOOL bCoalesce);
+
         /**
         * RegisterEventMap
         * @brief    注册一个处理通知的对象
@@ -115,15 +133,60 @@ namespace SOUI
 
 		SNotifyReceiver	 *  m_pReceiver;
 
-		SCriticalSection	m_cs;
-		SList<EventArgs *> m_ayncEvent;
-		BOOL				m_bRunning;
-		int					m_nInterval;
-#ifdef ENABLE_RUNONUI
-		SList < std::function<void(void)> * > m_asyncFuns;
+		SLIST_HEADER		m_evtInbox;		//异步事件队列，多个线程写入，UI线程批量取出
+		SLIST_HEADER		m_evtNodePool;	//回收的队列节点
+		volatile LONG		m_lWakeupPending;//UI线程有未处理的唤醒消息
+		SArray<DWORD>		m_arrCoalesceEvt;//需要合并的事件ID
+
+		STaskQueue			m_taskQueue;	//RunOnUIAsync投递的任务
+		DWORD				m_dwTaskBudget;	//每轮执行普通及空闲任务的时间预算，毫秒
+
+		//没有待处理的唤醒消息时投递一个，投递失败时清除标志，下一次投递事件或任务时重试
+		void WakeupAsync();
+		void RunOnUISync(void (*pfnInvoke)(void*),void *pObj);
+
+		template<class Fn>
+		struct SyncThunk
+		{
+			static void Invoke(void *pObj) { (*(Fn*)pObj)(); }
+		};
 	public:
-		void RunOnUISync(std::function<void(void)> fn);
-		void RunOnUIAsync(std::function<void(void)> fn);
-#endif
+        /**
+        * RunOnUISync
+        * @brief    在UI线程中同步执行
+        * @param    Fn fn -- 可调用对象，无参数
+        * @return    
+        *
+        * Describe  调用线程等待执行完成，fn不被复制
+        */
+		template<class Fn>
+		void RunOnUISync(const Fn & fn)
+		{
+			RunOnUISync(&SyncThunk<Fn>::Invoke,(void*)&fn);
+		}
+
+        /**
+        * RunOnUIAsync
+        * @brief    投递到UI线程异步执行
+        * @param    Fn fn -- 可调用对象，无参数
+        * @param    RunOnUILane lane -- 执行通道
+        * @return    
+        *
+        * Describe  可以在任意线程调用，不超过STaskQueue::KInlineSize的闭包不分配内存
+        */
+		template<class Fn>
+		void RunOnUIAsync(const Fn & fn,RunOnUILane lane = RUNONUI_NORMAL)
+		{
+			m_taskQueue.Post(fn,lane);
+			WakeupAsync();
+		}
+
+        /**
+        * SetTaskBudget
+        * @brief    设置每轮执行普通及空闲任务的时间预算
+        * @param    DWORD dwMs -- 毫秒，每轮至少执行一个任务
+        * @return    
+        */
+		void SetTaskBudget(DWORD dwMs) {m_dwTaskBudget = dwMs;}
 	};
 }
@@ -0,0 +1,145 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       STaskQueue.h
+* @brief      投递到UI线程执行的任务队列
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/17
+*
+* Describe    任务分为输入、普通、空闲三个通道。闭包直接构造在队列的任务槽中，
+*             不超过KInlineSize的闭包不需要分配内存，任务槽按块分配并循环使用。
+*             可以在任意线程投递，只能在一个线程(UI线程)执行。
+*/
+
+#pragma once
+#include <helper/SCriticalSection.h>
+#include <new>
+
+namespace SOUI
+{
+    enum RunOnUILane
+    {
+        RUNONUI_INPUT = 0,  //和输入响应相关的任务，每轮全部执行
+        RUNONUI_NORMAL,     //普通任务，受每轮的时间预算限制
+        RUNONUI_IDLE,       //前两个通道都为空时才执行
+        RUNONUI_LANES,
+    };
+
+    class SOUI_EXP STaskQueue
+    {
+    public:
+        enum
+        {
+            KInlineSize = 64,   //可以直接保存在任务槽中的闭包大小
+            KChunkTasks = 32,   //每个内存块的任务槽数
+        };
+
+        STaskQueue();
+        ~STaskQueue();
+
+        /**
+         * Post
+         * @brief    投递一个任务
+         * @param    const Fn & fn --  可调用对象，无参数
+         * @param    int nLane --  通道，见RunOnUILane
+         * @return   BOOL -- 投递前队列为空时返回TRUE，调用者需要唤醒执行线程
+         */
+        template<class Fn>
+        BOOL Post(const Fn & fn, int nLane)
+        {
+            SASSERT(nLane >= 0 && nLane < RUNONUI_LANES);
+            SAutoLock lock(m_cs);
+            STask *pTask = AllocTask(nLane);
+            if(!pTask) return FALSE;
+            pTask->pfnInvoke = &TaskThunk<Fn>::Invoke;
+            pTask->pfnDestroy = &TaskThunk<Fn>::Destroy;
+            if(sizeof(Fn) <= KInlineSize && __alignof(Fn) <= __alignof(TaskStorage))
+            {
+                new(pTask->storage.byBuf) Fn(fn);
+                pTask->pfnRelocate = &TaskThunk<Fn>::Relocate;
+                pTask->pObj = NULL;
+            }else
+            {
+                pTask->pObj = new Fn(fn);
+                pTask->pfnRelocate = NULL;
+            }
+            return ++m_nTotal == 1;
+        }
+
+        /**
+         * Run
+         * @brief    执行队列中的任务
+         * @param    DWORD dwBudget --  普通及空闲通道的时间预算，毫秒
+         * @return   BOOL -- 还有任务没有执行时返回TRUE
+         * Describe  输入通道执行调用时已经在队列中的全部任务；普通和空闲通道在超出预算
+         *           或者线程消息队列中有输入消息时停止
+         */
+        BOOL Run(DWORD dwBudget);
+
+        int GetCount() const {return m_nTotal;}
+
+    protected:
+        union TaskStorage
+        {
+            void *  pAlign;
+            double  dAlign;
+            __int64 nAlign;
+            BYTE    byBuf[KInlineSize];
+        };
+
+        struct STask
+        {
+            void (*pfnInvoke)(void *pObj);
+            void (*pfnDestroy)(void *pObj, BOOL bHeap);
+            void (*pfnRelocate)(void *pDst, void *pSrc);//NULL表示闭包在堆上
+            void *      pObj;
+            TaskStorage storage;
+
+            void * GetObj() {return pfnRelocate?storage.byBuf:pObj;}
+        };
+
+        template<class Fn>
+        struct TaskThunk
+        {
+            static void Invoke(void *pObj) { (*(Fn*)pObj)(); }
+            static void Destroy(void *pObj, BOOL bHeap)
+            {
+                if(bHeap) delete (Fn*)pObj;
+                else ((Fn*)pObj)->~Fn();
+            }
+            static void Relocate(void *pDst, void *pSrc)
+            {
+                new(pDst) Fn(*(Fn*)pSrc);
+                ((Fn*)pSrc)->~Fn();
+            }
+        };
+
+        struct STaskChunk
+        {
+            STaskChunk *pNext;
+            STask       tasks[KChunkTasks];
+        };
+
+        struct SLane
+        {
+            STaskChunk *pHead;
+            STaskChunk *pTail;
+            int         iHead;
+            int         iTail;
+            int         nCount;
+        };
+
+        //需要持有m_cs
+        STask * AllocTask(int nLane);
+        //取出通道头部的任务，闭包移动到task中
+        BOOL PopTask(int nLane, STask & task);
+        void DestroyTask(STask & task);
+
+        SCriticalSection    m_cs;
+        SLane               m_lanes[RUNONUI_LANES];
+        STaskChunk *        m_pFreeChunks;
+        volatile LONG       m_nTotal;
+    };
+}
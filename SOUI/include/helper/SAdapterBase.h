@@ -72,6 +72,46 @@ namespace SOUI
 			}
 		}
 
+        void notifyItemRangeInserted(int iItem,int nCount)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ILvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemRangeInserted(iItem,nCount);
+            }
+        }
+
+        void notifyItemRangeRemoved(int iItem,int nCount)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ILvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemRangeRemoved(iItem,nCount);
+            }
+        }
+
+        void notifyItemRangeChanged(int iItem,int nCount)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ILvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemRangeChanged(iItem,nCount);
+            }
+        }
+
+        void notifyItemRangeMoved(int iFrom,int iTo,int nCount)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ILvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemRangeMoved(iFrom,iTo,nCount);
+            }
+        }
+
     protected:
         SList<ILvDataSetObserver *> m_lstObserver;
     };
@@ -97,6 +137,26 @@ namespace SOUI
 			m_obzMgr.notifyItemChanged(iItem);
 		}
 
+        /**
+        * 通知数据集中部分表项发生变化, 视图只更新受影响的表项, 保持滚动位置及已创建的表项窗口
+        * 调用前数据集应该已经完成修改
+        */
+        void notifyItemRangeInserted(int iItem,int nCount){
+            m_obzMgr.notifyItemRangeInserted(iItem,nCount);
+        }
+
+        void notifyItemRangeRemoved(int iItem,int nCount){
+            m_obzMgr.notifyItemRangeRemoved(iItem,nCount);
+        }
+
+        void notifyItemRangeChanged(int iItem,int nCount){
+            m_obzMgr.notifyItemRangeChanged(iItem,nCount);
+        }
+
+        void notifyItemRangeMoved(int iFrom,int iTo,int nCount){
+            m_obzMgr.notifyItemRangeMoved(iFrom,iTo,nCount);
+        }
+
         virtual void registerDataSetObserver(ILvDataSetObserver * observer)
         {
             m_obzMgr.registerObserver(observer);
@@ -259,6 +319,36 @@ namespace SOUI
                 pObserver->onBranchExpandedChanged(hBranch,bExpandedOld,bExpandedNew);
             }
         }
+
+        void notifyItemInserted(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ITvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemInserted(hParent,hItem);
+            }
+        }
+
+        void notifyItemRemoved(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ITvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemRemoved(hParent,hItem);
+            }
+        }
+
+        void notifyItemChanged(HTREEITEM hItem)
+        {
+            SPOSITION pos = m_lstObserver.GetHeadPosition();
+            while(pos)
+            {
+                ITvDataSetObserver *pObserver = m_lstObserver.GetNext(pos);
+                pObserver->onItemChanged(hItem);
+            }
+        }
     protected:
         SList<ITvDataSetObserver *> m_lstObserver;
     };
@@ -285,6 +375,21 @@ namespace SOUI
             m_obzMgr.notifyExpandChanged(hBranch,bExpandedOld,bExpandedNew);
         }
 
+        //hItem插入到hParent后调用，只更新hParent的直接子节点布局，不重建整个分枝
+        void notifyItemInserted(HTREEITEM hParent,HTREEITEM hItem) {
+            m_obzMgr.notifyItemInserted(hParent,hItem);
+        }
+
+        //hItem从hParent中删除后调用，hItem已经失效，只用来标识被删除的节点
+        void notifyItemRemoved(HTREEITEM hParent,HTREEITEM hItem) {
+            m_obzMgr.notifyItemRemoved(hParent,hItem);
+        }
+
+        //hItem的数据变化，不影响子节点
+        void notifyItemChanged(HTREEITEM hItem) {
+            m_obzMgr.notifyItemChanged(hItem);
+        }
+
         virtual void registerDataSetObserver(ITvDataSetObserver * observer)
         {
             m_obzMgr.registerObserver(observer);
@@ -0,0 +1,207 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SDisplayList.h
+* @brief      绘制命令的录制和回放
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/16
+*
+* Describe    SDisplayListRecorder实现IRenderTarget接口，把绘制调用录制到SDisplayList的命令缓冲区中，
+*             SDisplayList可以在任意RenderTarget上回放。回放时录制内容的变换矩阵、视口原点都相对于目标RT的当前状态。
+*/
+
+#pragma once
+#include <matrix/SMatrix.h>
+
+namespace SOUI
+{
+    class SOUI_EXP SDisplayList : public TObjRefImpl<IObjRef>
+    {
+        friend class SDisplayListRecorder;
+    public:
+        SDisplayList();
+        ~SDisplayList();
+
+        /**
+         * Replay
+         * @brief    在目标RT上回放录制的命令
+         * @param    IRenderTarget * pRT --  目标RT
+         * @param    BYTE byAlpha --  整体透明度
+         * @param    LPCRECT pRcBound --  录制内容的范围，用于透明度图层
+         * @return   void
+         * Describe  回放结束后目标RT的剪裁区、变换矩阵、视口原点和绘图对象都恢复到回放前的状态
+         */
+        void Replay(IRenderTarget *pRT,BYTE byAlpha,LPCRECT pRcBound) const;
+
+        /**
+         * GetMemSize
+         * @brief    获取命令缓冲区占用的内存
+         * @return   size_t -- 字节数
+         */
+        size_t GetMemSize() const;
+
+        BOOL IsEmpty() const {return m_nSize == 0;}
+
+        /**
+         * IsStale
+         * @brief    检查录制时引用的位图内容是否已经改变
+         * @return   BOOL -- TRUE表示需要重新录制
+         */
+        BOOL IsStale() const;
+
+    protected:
+        void Write(const void *pData,size_t nLen);
+        template<class T>
+        void Write(const T & v){ Write(&v,sizeof(T)); }
+        void WriteString(LPCTSTR pszText,int nLen);
+        //引用对象，返回对象的索引. dwVersion不为0时对象是位图，回放前检查内容版本
+        int AddObject(IObjRef *pObj,DWORD dwVersion=0);
+        //复制一份图标，列表销毁时释放. 失败返回NULL
+        HICON AddIcon(HICON hIcon);
+
+        BYTE *  m_pBuf;
+        size_t  m_nSize;
+        size_t  m_nCapacity;
+        BOOL    m_bOOM;     //命令缓冲区分配失败，录制结果不完整
+        SArray<IObjRef*> m_arrObjs;
+        SArray<DWORD>    m_arrObjVer;   //录制时位图的内容版本号，和m_arrObjs一一对应
+        SArray<HICON>    m_arrIcons;
+    };
+
+    /**
+    * @class     SDisplayListRecorder
+    * @brief     录制绘制命令的RenderTarget
+    *
+    * Describe   查询类接口(GetClipBox,GetTransform等)返回录制过程中跟踪的状态；
+    *            GetDC,GetPixel以及选入位图等依赖目标像素的调用无法录制，调用后IsValid返回FALSE。
+    *            绘制源RT及图标在录制时复制，位图按内容版本引用，内容改变后SDisplayList::IsStale返回TRUE。
+    */
+    class SOUI_EXP SDisplayListRecorder : public TObjRefImpl<IRenderTarget>
+    {
+        SOUI_CLASS_NAME(SDisplayListRecorder,L"displayListRecorder")
+    public:
+        /**
+         * SDisplayListRecorder
+         * @brief    构造函数
+         * @param    IRenderTarget * pRTRef --  参考RT，录制的初始绘图对象从这里获取
+         * @param    LPCRECT pRcBound --  录制范围
+         */
+        SDisplayListRecorder(IRenderTarget *pRTRef,LPCRECT pRcBound);
+        ~SDisplayListRecorder();
+
+        BOOL IsValid() const {return !m_bFailed && !m_list->m_bOOM;}
+
+        SDisplayList * GetDisplayList() {return m_list;}
+
+    public:
+        virtual HRESULT CreateCompatibleRenderTarget(SIZE szTarget,IRenderTarget **ppRenderTarget);
+        virtual HRESULT CreatePen(int iStyle,COLORREF cr,int cWidth,IPen ** ppPen);
+        virtual HRESULT CreateSolidColorBrush(COLORREF cr,IBrush ** ppBrush);
+        virtual HRESULT CreateBitmapBrush( IBitmap *pBmp,IBrush ** ppBrush );
+        virtual HRESULT CreateRegion( IRegion ** ppRegion );
+
+        virtual HRESULT Resize(SIZE sz);
+
+        virtual HRESULT OffsetViewportOrg(int xOff, int yOff, LPPOINT lpPoint=NULL);
+        virtual HRESULT GetViewportOrg(LPPOINT lpPoint);
+        virtual HRESULT SetViewportOrg(POINT pt);
+
+        virtual HRESULT PushClipRect(LPCRECT pRect,UINT mode=RGN_AND);
+        virtual HRESULT PushClipRegion(IRegion *pRegion,UINT mode=RGN_AND);
+        virtual HRESULT PopClip();
+
+        virtual HRESULT ExcludeClipRect(LPCRECT pRc);
+        virtual HRESULT IntersectClipRect(LPCRECT pRc);
+
+        virtual HRESULT SaveClip(int *pnState);
+        virtual HRESULT RestoreClip(int nState=-1);
+
+        virtual HRESULT GetClipRegion(IRegion **ppRegion);
+        virtual HRESULT GetClipBox(LPRECT prc);
+
+        virtual HRESULT DrawText(LPCTSTR pszText,int cchLen,LPRECT pRc,UINT uFormat);
+        virtual HRESULT MeasureText(LPCTSTR pszText,int cchLen, SIZE *psz);
+        virtual HRESULT TextOut(int x,int y, LPCTSTR lpszString,int nCount);
+
+        virtual HRESULT DrawRectangle(LPCRECT pRect);
+        virtual HRESULT FillRectangle(LPCRECT pRect);
+        virtual HRESULT FillSolidRect(LPCRECT pRect,COLORREF cr);
+        virtual HRESULT DrawRoundRect(LPCRECT pRect,POINT pt);
+        virtual HRESULT FillRoundRect(LPCRECT pRect,POINT pt);
+        virtual HRESULT FillSolidRoundRect(LPCRECT pRect,POINT pt,COLORREF cr);
+        virtual HRESULT ClearRect(LPCRECT pRect,COLORREF cr);
+        virtual HRESULT InvertRect(LPCRECT pRect);
+        virtual HRESULT DrawEllipse(LPCRECT pRect);
+        virtual HRESULT FillEllipse(LPCRECT pRect);
+        virtual HRESULT FillSolidEllipse(LPCRECT pRect,COLORREF cr);
+
+        virtual HRESULT DrawArc(LPCRECT pRect,float startAngle,float sweepAngle,bool useCenter);
+        virtual HRESULT FillArc(LPCRECT pRect,float startAngle,float sweepAngle);
+
+        virtual HRESULT DrawLines(LPPOINT pPt,size_t nCount);
+        virtual HRESULT GradientFill(LPCRECT pRect,BOOL bVert,COLORREF crBegin,COLORREF crEnd,BYTE byAlpha=0xFF);
+        virtual HRESULT GradientFillEx( LPCRECT pRect,const POINT* pts,COLORREF *colors,float *pos,int nCount,BYTE byAlpha=0xFF );
+        virtual HRESULT GradientFill2(LPCRECT pRect,GradientType type,COLORREF crStart,COLORREF crCenter,COLORREF crEnd,float fLinearAngle,float fCenterX,float fCenterY,int nRadius,BYTE byAlpha=0xff);
+        virtual HRESULT DrawIconEx(int xLeft, int yTop, HICON hIcon, int cxWidth,int cyWidth,UINT diFlags);
+        virtual HRESULT DrawBitmap(LPCRECT pRcDest,IBitmap *pBitmap,int xSrc,int ySrc,BYTE byAlpha=0xFF);
+        virtual HRESULT DrawBitmapEx(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha=0xFF);
+        virtual HRESULT DrawBitmap9Patch(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha=0xFF);
+        virtual HRESULT BitBlt(LPCRECT pRcDest,IRenderTarget *pRTSour,int xSrc,int ySrc,DWORD dwRop=kSrcCopy);
+        virtual HRESULT AlphaBlend(LPCRECT pRcDest,IRenderTarget *pRTSrc,LPCRECT pRcSrc,BYTE byAlpha);
+        virtual IRenderObj * GetCurrentObject(OBJTYPE uType);
+
+        virtual HRESULT SelectDefaultObject(OBJTYPE objType, IRenderObj ** pOldObj = NULL);
+        virtual HRESULT SelectObject(IRenderObj *pObj,IRenderObj ** pOldObj = NULL);
+        virtual COLORREF GetTextColor();
+        virtual COLORREF SetTextColor(COLORREF color);
+        virtual void SetMaskFilter(IMaskFilter *pMaskFilter);
+        virtual IMaskFilter *GetMaskFilter();
+
+        virtual HDC GetDC(UINT uFlag=0);
+        virtual void ReleaseDC(HDC hdc);
+
+        virtual HRESULT SetTransform(const float matrix[9], float oldMatrix[9]=NULL);
+        virtual HRESULT GetTransform(float matrix[9]) const;
+
+        virtual COLORREF GetPixel(int x, int y);
+        virtual COLORREF SetPixel(int x, int y, COLORREF cr);
+
+        virtual HRESULT PushClipPath(const IPath * path, UINT mode, bool doAntiAlias = false);
+        virtual HRESULT DrawPath(const IPath * path,IPathEffect * pathEffect=NULL);
+        virtual HRESULT FillPath(const IPath * path);
+
+        virtual HRESULT PushLayer(const RECT * pRect,BYTE byAlpha=0xff);
+        virtual HRESULT PopLayer();
+
+        virtual HRESULT SetXfermode(int mode,int *pOldMode=NULL);
+        virtual BOOL SetAntiAlias(BOOL bAntiAlias);
+
+    protected:
+        void WriteCmd(int nCmd);
+        void WriteRect(LPCRECT pRect);
+        void PushClipBox(const CRect & rc);
+        //引用位图，内容随时可能改变的位图保存一份副本. 失败返回-1
+        int AddBitmap(IBitmap *pBitmap);
+        //把源RT中的指定区域复制到一个新RT中，回放时不受源RT后续绘制的影响
+        IRenderTarget * SnapshotRT(IRenderTarget *pRTSrc,LPCRECT pRcSrc,int xSrc,int ySrc);
+
+        SAutoRefPtr<SDisplayList>   m_list;
+        SAutoRefPtr<IRenderTarget>  m_rtMeasure;    //测量文字及创建绘图对象使用的RT
+        SAutoRefPtr<IPen>           m_curPen;
+        SAutoRefPtr<IBrush>         m_curBrush;
+        SAutoRefPtr<IFont>          m_curFont;
+        SAutoRefPtr<IMaskFilter>    m_curMaskFilter;
+        COLORREF                    m_crText;
+        int                         m_nXferMode;
+        BOOL                        m_bAntiAlias;
+
+        CPoint                      m_ptOrg;
+        SMatrix                     m_mtx;
+        CRect                       m_rcBound;
+        SArray<CRect>               m_arrClipBox;   //剪裁区的外接矩形栈，不含视口偏移
+        SArray<int>                 m_arrSaveDepth; //SaveClip时的剪裁栈深度
+        BOOL                        m_bFailed;
+    };
+}
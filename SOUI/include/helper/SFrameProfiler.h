@@ -0,0 +1,189 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SFrameProfiler.h
+* @brief      宿主窗口的刷新性能分析
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/17
+*
+* Describe    记录最近若干帧的动画、布局、绘制、更新到屏幕各阶段耗时，以及每个窗口的绘制耗时。
+*             数据可以通过接口读取、导出为JSON，也可以作为浮层绘制在宿主窗口上。时间单位为微秒。
+*             同时统计窗口客户区绘制的像素数和遮挡剔除跳过的窗口，用于观察过度绘制。
+*/
+
+#pragma once
+
+namespace SOUI
+{
+    class SWindow;
+
+    class SOUI_EXP SFrameProfiler
+    {
+    public:
+        enum {
+            kMaxFrames = 120,   //保留的帧记录数
+            kOverlayWnds = 5,   //浮层中显示的窗口数
+        };
+
+        struct FrameRecord
+        {
+            DWORD   dwTime;         /**<帧结束时的GetTickCount */
+            UINT64  usAnimation;    /**<OnNextFrame动画耗时，累计自上一帧 */
+            UINT64  usLayout;       /**<布局耗时 */
+            UINT64  usPaint;        /**<绘制耗时 */
+            UINT64  usPresent;      /**<更新到屏幕耗时 */
+            int     nDirtyRects;    /**<更新到屏幕的脏矩形数 */
+            int     nPaintedWnds;   /**<本帧绘制过的窗口数 */
+            BOOL    bFullPaint;     /**<整窗重绘 */
+            BOOL    bDirtyOverflow; /**<脏矩形太多，使用了外接矩形 */
+            UINT64  nDirtyPixels;   /**<重绘区域的像素数 */
+            UINT64  nWndPixels;     /**<各窗口绘制客户区的像素数之和 */
+            int     nCulledWnds;    /**<被遮挡剔除的窗口数 */
+            UINT64  nCulledPixels;  /**<被遮挡剔除的窗口在重绘区域内的像素数 */
+
+            UINT64 Total() const {return usAnimation + usLayout + usPaint + usPresent;}
+            //过度绘制倍数，1表示每个像素只绘制一次
+            double Overdraw() const {return nDirtyPixels ? (double)nWndPixels/nDirtyPixels : 0.0;}
+        };
+
+        struct WndCost
+        {
+            SWND        swnd;
+            SStringW    strClass;
+            SStringW    strName;
+            DWORD       nFrames;    /**<有绘制的帧数 */
+            UINT64      usTotal;    /**<累计绘制耗时 */
+            UINT64      usMax;      /**<单帧最大绘制耗时 */
+            DWORD       dwSerial;   /**<最后一次绘制所在帧的序号 */
+            UINT64      usFrame;    /**<最后一次绘制所在帧的累计耗时 */
+        };
+
+        SFrameProfiler();
+        ~SFrameProfiler();
+
+        //性能计数和微秒转换
+        static LONGLONG Now();
+        static UINT64 ToUs(LONGLONG llCount);
+
+        /**
+         * BeginFrame
+         * @brief    开始一帧，之后的窗口绘制耗时计入该帧
+         * @return   void
+         */
+        void BeginFrame();
+
+        /**
+         * EndFrame
+         * @brief    结束一帧并记录各阶段耗时
+         * @param    UINT64 usLayout --  布局耗时
+         * @param    UINT64 usPaint --  绘制耗时
+         * @param    UINT64 usPresent --  更新到屏幕耗时
+         * @param    int nDirtyRects --  脏矩形数
+         * @param    UINT64 nDirtyPixels --  重绘区域的像素数
+         * @param    BOOL bFullPaint --  整窗重绘
+         * @param    BOOL bDirtyOverflow --  脏矩形溢出
+         * @return   void
+         */
+        void EndFrame(UINT64 usLayout,UINT64 usPaint,UINT64 usPresent,int nDirtyRects,UINT64 nDirtyPixels,BOOL bFullPaint,BOOL bDirtyOverflow);
+
+        //动画耗时累计到下一次EndFrame
+        void AddAnimationTime(UINT64 us){ m_usPendingAnim += us;}
+
+        //窗口绘制自身(客户区或非客户区)后调用，同一帧内多次调用时累加
+        void OnWndPainted(SWindow *pWnd,UINT64 us);
+
+        //窗口销毁时调用，删除窗口的绘制统计
+        void OnWndDestroyed(SWND swnd){ m_mapWndCost.RemoveKey(swnd);}
+
+        //窗口绘制客户区时调用，nPixels为客户区在重绘区域内的像素数
+        void AddWndPixels(UINT64 nPixels){ m_nFrameWndPixels += nPixels;}
+
+        //窗口被不透明兄弟窗口完全覆盖而跳过绘制时调用
+        void OnWndCulled(UINT64 nPixels){ m_nFrameCulledWnds++; m_nFrameCulledPixels += nPixels;}
+
+        int GetFrameCount() const {return m_nFrames;}
+
+        /**
+         * GetFrame
+         * @brief    获取帧记录
+         * @param    int iBack --  0表示最近一帧，1表示上一帧，依此类推
+         * @return   const FrameRecord * -- 超出范围时返回NULL
+         */
+        const FrameRecord * GetFrame(int iBack) const;
+
+        /**
+         * GetWndCosts
+         * @brief    按累计绘制耗时从大到小获取窗口绘制统计
+         * @param    SArray<WndCost> & arrCost --  输出
+         * @param    int nTop --  最多返回的窗口数，-1表示全部
+         * @return   void
+         */
+        void GetWndCosts(SArray<WndCost> & arrCost,int nTop = -1) const;
+
+        /**
+         * ToJson
+         * @brief    导出帧记录和窗口绘制统计
+         * @param    int nTop --  导出的窗口数，-1表示全部
+         * @return   SStringW -- JSON字符串
+         */
+        SStringW ToJson(int nTop = -1) const;
+
+        void Reset();
+
+        void SetOverlay(BOOL bOverlay){m_bOverlay = bOverlay;}
+        BOOL IsOverlay() const {return m_bOverlay;}
+
+        //浮层位于宿主窗口右上角
+        CRect GetOverlayRect(const CRect & rcHost,int nScale) const;
+
+        /**
+         * DrawOverlay
+         * @brief    绘制性能浮层
+         * @param    IRenderTarget * pRT --  目标RT
+         * @param    const CRect & rcHost --  宿主窗口的矩形
+         * @param    int nScale --  缩放比例
+         * @return   void
+         * Describe  显示最近一秒的帧数、最后一帧的各阶段耗时、帧耗时曲线和绘制最耗时的窗口
+         */
+        void DrawOverlay(IRenderTarget *pRT,const CRect & rcHost,int nScale) const;
+
+    protected:
+        FrameRecord             m_frames[kMaxFrames];
+        int                     m_iNext;            //下一帧记录的位置
+        int                     m_nFrames;          //有效的帧记录数
+        DWORD                   m_dwSerial;         //当前帧的序号
+        int                     m_nFrameWnds;       //当前帧绘制的窗口数
+        UINT64                  m_nFrameWndPixels;  //当前帧窗口绘制的像素数
+        int                     m_nFrameCulledWnds; //当前帧被剔除的窗口数
+        UINT64                  m_nFrameCulledPixels;//当前帧被剔除的像素数
+        UINT64                  m_usPendingAnim;    //还没有计入帧记录的动画耗时
+        SMap<SWND,WndCost>      m_mapWndCost;
+        BOOL                    m_bOverlay;
+    };
+
+    /**
+    * @class     SWndPaintProfile
+    * @brief     统计窗口一次绘制的耗时
+    *
+    * Describe   pProfiler为NULL时不做任何事
+    */
+    class SWndPaintProfile
+    {
+    public:
+        SWndPaintProfile(SFrameProfiler *pProfiler,SWindow *pWnd)
+            :m_pProfiler(pProfiler),m_pWnd(pWnd),m_llBegin(pProfiler?SFrameProfiler::Now():0)
+        {
+        }
+
+        ~SWndPaintProfile()
+        {
+            if(m_pProfiler) m_pProfiler->OnWndPainted(m_pWnd,SFrameProfiler::ToUs(SFrameProfiler::Now()-m_llBegin));
+        }
+    protected:
+        SFrameProfiler *m_pProfiler;
+        SWindow        *m_pWnd;
+        LONGLONG        m_llBegin;
+    };
+}
@@ -0,0 +1,101 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SHitTestGrid.h
+* @brief      窗口命中测试的网格索引
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/17
+*
+* Describe    把窗口矩形登记到均匀网格中，命中测试时只检查鼠标所在单元格里的窗口，
+*             不再遍历整个窗口树。有变换矩阵或者窗口区域的窗口不登记它的子树，命中测试时从该窗口开始遍历。
+*             索引中保存的是SWND，被销毁的窗口在查询时自动忽略。
+*/
+
+#pragma once
+#include <core/SWndContainer-i.h>
+
+namespace SOUI
+{
+    class SWindow;
+
+    class SOUI_EXP SHitTestGrid
+    {
+    public:
+        struct HitStats
+        {
+            DWORD   nQueries;       /**<查询次数 */
+            DWORD   nRebuilds;      /**<重建索引的次数 */
+            UINT64  nCandidates;    /**<查询时检查的窗口数 */
+            DWORD   nTreeWalks;     /**<从有变换的窗口开始遍历的次数 */
+        };
+
+        /**
+         * SHitTestGrid
+         * @brief    构造函数
+         * @param    SWindow * pRoot --  根窗口，一般是窗口容器
+         * @param    int nCellSize --  单元格大小，像素
+         */
+        SHitTestGrid(SWindow *pRoot,int nCellSize);
+        ~SHitTestGrid();
+
+        int GetCellSize() const {return m_nCellSize;}
+
+        //标记索引失效，下次查询时重建
+        void MarkDirty(){m_bDirty = TRUE;}
+
+        /**
+         * OnWndChanged
+         * @brief    窗口变化通知
+         * @param    SWindow * pWnd --  发生变化的窗口
+         * @param    HitTestChange change --  变化类型
+         * @return   void
+         * Describe  位置变化时只更新该窗口的登记，其它变化标记索引失效
+         */
+        void OnWndChanged(SWindow *pWnd,HitTestChange change);
+
+        /**
+         * HitTest
+         * @brief    查找包含指定点的窗口
+         * @param    CPoint & pt --  根窗口坐标，返回时转换到命中窗口的坐标系
+         * @param    bool bIncludeMsgTransparent --  包含不接收消息的窗口
+         * @return   SWND -- 和SWindow::SwndFromPoint的结果相同
+         * Describe  调用前需要保证窗口树的zorder是有效的
+         */
+        SWND HitTest(CPoint &pt,bool bIncludeMsgTransparent);
+
+        const HitStats & GetStats() const {return m_stats;}
+        void ResetStats();
+
+    protected:
+        struct WndEntry
+        {
+            CRect   rcCells;    //占用的单元格范围，右下边界不包含，空矩形表示在网格外
+            BOOL    bLarge;     //占用的单元格太多，登记在m_arrLarge中
+        };
+
+        static BOOL _IsComplex(SWindow *pWnd);
+
+        void Rebuild();
+        void _AddSubtree(SWindow *pParent);
+        void _Insert(SWindow *pWnd);
+        void _Remove(SWND swnd,const WndEntry & entry);
+        BOOL _GetCellRange(const CRect & rcWnd,CRect & rcCells) const;
+        //检查从pParent到根窗口的路径是否允许pt命中到下层窗口
+        BOOL _CheckAncestors(SWindow *pParent,const CPoint & pt,bool bIncludeMsgTransparent) const;
+        void _HitCandidate(SWND swnd,const CPoint & pt,bool bIncludeMsgTransparent,SWindow * & pBest);
+
+        SWindow *           m_pRoot;
+        int                 m_nCellSize;
+        CRect               m_rcBound;      //网格覆盖的范围，即根窗口的矩形
+        int                 m_nCols;
+        int                 m_nRows;
+        SArray<SWND> *      m_pCells;
+        SArray<SWND>        m_arrLarge;     //大窗口，每次查询都检查
+        SArray<SWND>        m_arrComplex;   //有变换矩阵或者窗口区域的窗口，它们的子树不登记
+        SMap<SWND,WndEntry> m_mapEntry;     //已登记的窗口
+        BOOL                m_bDirty;
+        HitStats            m_stats;
+    };
+}
@@ -1,6 +1,5 @@
 ﻿#pragma once
 #include "interface/SListViewItemLocator-i.h"
-#include "control/STree.h"
 
 namespace SOUI
 {
@@ -30,6 +29,12 @@ namespace SOUI
 		virtual int GetDividerSize() const;
 
 		virtual void SetScale(int nScale);
+
+		virtual void OnItemRangeInserted(int iItem,int nCount){}
+
+		virtual void OnItemRangeRemoved(int iItem,int nCount){}
+
+		virtual void OnItemRangeMoved(int iFrom,int iTo,int nCount){}
     protected:
 		int GetFixItemHeight() const;
 
@@ -68,44 +73,51 @@ namespace SOUI
 		virtual int GetDividerSize() const;
 
 		virtual void SetScale(int nScale);
+
+		virtual void OnItemRangeInserted(int iItem,int nCount);
+
+		virtual void OnItemRangeRemoved(int iItem,int nCount);
+
+		virtual void OnItemRangeMoved(int iFrom,int iTo,int nCount);
+
+		virtual void OnItemRangeChanged(int iItem,int nCount);
     protected:
-        void InitIndex(HSTREEITEM hParent,int nItems,int nSubBranchSize);
 		int GetFixItemHeight() const;
-        int GetIndexDeep() const;
         void Clear();
-        int Branch2Offset(HSTREEITEM hBranch) const;
-        int Branch2Index(HSTREEITEM hBranch) const;
-        HSTREEITEM Offset2Branch(HSTREEITEM hParent,int nOffset);
 
-        SLayoutSize m_nItemHeight;  //默认表项高度
-        SLayoutSize m_nDividerSize;
-		int m_nScale;
-        struct BranchInfo
-        {
-            int nBranchHei; //分枝高度
-            int nBranchSize;//分枝中包含的节点数量
-        };
+        /**
+        * 高度索引操作
+        * 表项按顺序分成若干块, 块内保存表项高度(含分隔线)与默认高度的差值, 未测量的表项差值为0。
+        * 块之间用两个树状数组(Fenwick tree)分别索引各块的表项数量和差值之和, 查询/修改为O(logM+B),
+        * M为块数量, B为块大小。中间插入/删除只移动一个块内的数据, 块分裂/合并时才O(M)重建块索引。
+        */
+        enum {BLOCK_SIZE = 512};
 
-        CSTree<BranchInfo>    m_itemPosIndex;//记录分枝高度
-        class SegmentInfo
+        struct HEIGHTBLOCK
         {
-        public:
-            SegmentInfo(int nItems,HSTREEITEM hBranch):hItem(hBranch){
-                this->nItems = nItems;
-                pItemHeight = new int[nItems];
-                memset(pItemHeight,0xff,nItems*sizeof(int));
-            }
-            ~SegmentInfo()
-            {
-                if(pItemHeight) delete[] pItemHeight;
-            }
-
-            HSTREEITEM hItem;
-            int        nItems;
-            int*       pItemHeight;//段中每一个表项的高度
+            int nItems;                 //块内表项数量, 不为0
+            int nSum;                   //块内差值之和
+            int nDelta[BLOCK_SIZE];     //块内各表项的差值
         };
 
-        SArray<SegmentInfo*>     m_segments;
+        void InitIndex(int nItems);
+        void InsertIndex(int iItem,int nCount);
+        void RemoveIndex(int iItem,int nCount);
+        int  IndexSum(int nItems) const;            //前nItems个表项的高度差值之和
+        int  IndexValue(int iItem) const;           //iItem的高度差值
+        void IndexAdd(int iItem,int nDelta);        //修改iItem的高度差值
+        int  FindBlock(int iItem,int & iOffset,int *pSumBefore=NULL) const;//iItem所在的块及块内偏移
+        BOOL MergeBlock(int iBlock);                //表项过少的块和相邻块合并
+        void RebuildBlockIndex();                   //块结构变化后重建块索引, O(M)
+
+        SLayoutSize m_nItemHeight;  //默认表项高度
+        SLayoutSize m_nDividerSize;
+		int m_nScale;
+
+        SArray<HEIGHTBLOCK*>     m_heightBlocks;//表项高度块
+        SArray<int>              m_blockItems;  //各块表项数量的树状数组
+        SArray<int>              m_blockSums;   //各块差值之和的树状数组
+        int                      m_nItems;      //表项数量
         SAutoRefPtr<ILvAdapter>   m_adapter;
     };
 
@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include "core/SItemPanel.h"
+
+namespace SOUI
+{
+    /**
+    * @class     SListViewRangeUpdater
+    * @brief     SListView, SMCListView, STileView处理表项范围变化的公共逻辑
+    * 
+    * Describe   构造时记录第一个可见表项的位置, 定位器更新之后调用OnInserted/OnRemoved/OnMoved:
+    *            保持第一个可见表项在视图中的位置不变, 并调整可见表项面板及选中项的索引。
+    *            TLocator需要提供Item2Position, TItemList为保存ItemInfo(含pItem成员)的SList
+    */
+    template<class TLocator,class TItemList>
+    class SListViewRangeUpdater
+    {
+    public:
+        SListViewRangeUpdater(TLocator *pLocator,TItemList & lstItems,int & iFirstVisible,int & nScrollPos,int & iSelItem)
+            :m_pLocator(pLocator)
+            ,m_lstItems(lstItems)
+            ,m_iFirstVisible(iFirstVisible)
+            ,m_nScrollPos(nScrollPos)
+            ,m_iSelItem(iSelItem)
+        {
+            m_nAnchorPos = m_iFirstVisible!=-1?m_pLocator->Item2Position(m_iFirstVisible):0;
+        }
+
+        //表项移动后原索引为iItem的表项的新索引
+        static int MoveItemIndex(int iItem,int iFrom,int iTo,int nCount)
+        {
+            if(iItem>=iFrom && iItem<iFrom+nCount)
+                return iTo + (iItem-iFrom);
+            if(iItem>=iFrom+nCount) iItem -= nCount;
+            if(iItem>=iTo) iItem += nCount;
+            return iItem;
+        }
+
+        void OnInserted(int iItem,int nCount)
+        {
+            if(m_nScrollPos>0 && m_iFirstVisible!=-1 && iItem<=m_iFirstVisible)
+            {//在第一个可见表项前插入, 保持它在视图中的位置不变
+                m_iFirstVisible += nCount;
+                m_nScrollPos += m_pLocator->Item2Position(m_iFirstVisible) - m_nAnchorPos;
+            }
+
+            SPOSITION pos = m_lstItems.GetHeadPosition();
+            while(pos)
+            {
+                SItemPanel *pItem = m_lstItems.GetNext(pos).pItem;
+                int idx = (int)pItem->GetItemIndex();
+                if(idx>=iItem) pItem->SetItemIndex(idx+nCount);
+            }
+            if(m_iSelItem>=iItem) m_iSelItem += nCount;
+        }
+
+        void OnRemoved(int iItem,int nCount)
+        {
+            if(m_iFirstVisible!=-1 && iItem<=m_iFirstVisible)
+            {
+                if(m_iFirstVisible>=iItem+nCount)
+                {//保持第一个可见表项在视图中的位置不变
+                    m_iFirstVisible -= nCount;
+                    m_nScrollPos += m_pLocator->Item2Position(m_iFirstVisible) - m_nAnchorPos;
+                }else
+                {//第一个可见表项被删除, 从删除位置开始显示
+                    m_iFirstVisible = iItem;
+                    m_nScrollPos = m_pLocator->Item2Position(iItem);
+                }
+            }
+
+            SPOSITION pos = m_lstItems.GetHeadPosition();
+            while(pos)
+            {
+                SItemPanel *pItem = m_lstItems.GetNext(pos).pItem;
+                int idx = (int)pItem->GetItemIndex();
+                if(idx>=iItem+nCount) pItem->SetItemIndex(idx-nCount);
+                else if(idx>=iItem) pItem->SetItemIndex(-1);//被删除的表项在刷新时回收
+            }
+            if(m_iSelItem>=iItem+nCount) m_iSelItem -= nCount;
+            else if(m_iSelItem>=iItem) m_iSelItem = -1;
+        }
+
+        void OnMoved(int iFrom,int iTo,int nCount)
+        {
+            SPOSITION pos = m_lstItems.GetHeadPosition();
+            while(pos)
+            {
+                SItemPanel *pItem = m_lstItems.GetNext(pos).pItem;
+                pItem->SetItemIndex(MoveItemIndex((int)pItem->GetItemIndex(),iFrom,iTo,nCount));
+            }
+            if(m_iSelItem!=-1) m_iSelItem = MoveItemIndex(m_iSelItem,iFrom,iTo,nCount);
+        }
+
+    protected:
+        TLocator  * m_pLocator;
+        TItemList & m_lstItems;
+        int       & m_iFirstVisible;
+        int       & m_nScrollPos;
+        int       & m_iSelItem;
+        int         m_nAnchorPos;   //更新前第一个可见表项的位置
+    };
+}
@@ -37,6 +37,9 @@ namespace SOUI
 
         BOOL OnEraseBkgnd(IRenderTarget *pRT);
 
+        //背景皮肤的状态索引与默认规则不同
+        virtual BOOL IsOpaque(){return FALSE;}
+
         void OnPaint(IRenderTarget *pRT);
 
         SOUI_MSG_MAP_BEGIN()
@@ -0,0 +1,96 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SRenderCacheMgr.h
+* @brief      窗口绘制缓存管理
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/16
+*
+* Describe    管理所有窗口的m_cachedRT，按最近绘制顺序淘汰超出内存预算的缓存。
+*             被淘汰的窗口在下次绘制时重新创建缓存。
+*             多个界面线程共享同一个管理器，内部由锁保护；缓存只会被创建它的线程淘汰或释放，
+*             其它线程的缓存只计入预算。
+*/
+
+#pragma once
+#include <core/SSingleton2.h>
+#include <helper/SCriticalSection.h>
+
+namespace SOUI
+{
+    class SWindow;
+    struct ISwndContainer;
+
+    class SOUI_EXP SRenderCacheMgr : public SSingleton2<SRenderCacheMgr>
+    {
+        SINGLETON2_TYPE(SINGLETON_RENDERCACHEMGR)
+        friend class SWindow;
+    public:
+        struct CacheStats
+        {
+            DWORD   nHits;          /**<直接使用缓存的次数 */
+            DWORD   nMisses;        /**<需要重绘缓存的次数 */
+            DWORD   nCreates;       /**<创建缓存的次数 */
+            DWORD   nEvictions;     /**<因超出预算被淘汰的缓存数 */
+            DWORD   nCaches;        /**<当前缓存数 */
+            size_t  nBytes;         /**<当前缓存占用的内存 */
+            size_t  nPeakBytes;     /**<缓存占用内存的峰值 */
+        };
+
+        SRenderCacheMgr(void);
+        ~SRenderCacheMgr(void);
+
+        /**
+         * SetBudget
+         * @brief    设置缓存的内存预算
+         * @param    size_t nBytes --  字节数，0表示不限制
+         * @return   void
+         * Describe  预算减小时立即淘汰超出预算的缓存
+         */
+        void SetBudget(size_t nBytes);
+
+        size_t GetBudget() const {return m_nBudget;}
+
+        CacheStats GetStats() const;
+
+        void ResetStats();
+
+        /**
+         * ReleaseCaches
+         * @brief    释放窗口缓存
+         * @param    ISwndContainer * pContainer --  只释放宿主为该容器宿主的窗口缓存(包括列表项中的窗口)，NULL时释放调用线程的全部缓存
+         * @return   void
+         * Describe  只释放调用线程创建的缓存
+         */
+        void ReleaseCaches(ISwndContainer *pContainer = NULL);
+
+    protected:
+        //新建缓存后调用，可能淘汰其它窗口的缓存
+        void OnCacheCreated(SWindow *pWnd,size_t nBytes);
+        //缓存尺寸变化
+        void OnCacheResized(SWindow *pWnd,size_t nBytes);
+        //窗口绘制时调用，bHit表示缓存内容有效
+        void OnCachePainted(SWindow *pWnd,bool bHit);
+        //窗口主动释放缓存
+        void OnCacheReleased(SWindow *pWnd);
+
+        //淘汰调用线程的缓存直到满足预算
+        void EvictToBudget(SWindow *pExclude);
+        void EvictEntry(SPOSITION pos);
+
+        struct CacheEntry
+        {
+            SWindow *pWnd;
+            size_t   nBytes;
+            DWORD    dwThreadId;    //创建缓存的线程，窗口只能在该线程中访问
+        };
+
+        SList<CacheEntry>           m_lstLru;   //表头是最久未绘制的缓存
+        SMap<SWindow*,SPOSITION>    m_mapEntry;
+        size_t                      m_nBudget;
+        CacheStats                  m_stats;
+        mutable SCriticalSection    m_cs;
+    };
+}
@@ -21,6 +21,53 @@ namespace SOUI
         virtual void onInvalidated()  PURE;
 
 		virtual void OnItemChanged(int iItem) PURE;
+
+        /**
+        * This method is called when nCount items have been inserted at iItem.
+        * Items previously located at and after iItem now start at iItem+nCount.
+        * The default implementation treats it as a change of the entire data set.
+        */
+        virtual void onItemRangeInserted(int iItem,int nCount)
+        {
+            (iItem);
+            (nCount);
+            onChanged();
+        }
+
+        /**
+        * This method is called when nCount items starting at iItem have been removed.
+        * Items previously located after the range now start at iItem.
+        * The default implementation treats it as a change of the entire data set.
+        */
+        virtual void onItemRangeRemoved(int iItem,int nCount)
+        {
+            (iItem);
+            (nCount);
+            onChanged();
+        }
+
+        /**
+        * This method is called when the data of nCount items starting at iItem has changed.
+        * The default implementation notifies each item by OnItemChanged.
+        */
+        virtual void onItemRangeChanged(int iItem,int nCount)
+        {
+            for(int i=0;i<nCount;i++)
+                OnItemChanged(iItem+i);
+        }
+
+        /**
+        * This method is called when nCount items starting at iFrom have been moved,
+        * iTo is the index of the first moved item after the move.
+        * The default implementation treats it as a change of the entire data set.
+        */
+        virtual void onItemRangeMoved(int iFrom,int iTo,int nCount)
+        {
+            (iFrom);
+            (iTo);
+            (nCount);
+            onChanged();
+        }
     };
     
     interface ILvAdapter : public IObjRef{
@@ -125,6 +172,30 @@ namespace SOUI
         virtual void InitByTemplate(pugi::xml_node xmlTemplate) PURE;
         
     };
+
+    /**
+    * ILvAsyncAdapter
+    * ILvAdapter的可选扩展: 把耗时的数据准备(如解码图片)从视图绑定中分离出来.
+    * 由设置给列表的adapter对象同时实现, 通过SListView::SetAsyncAdapter开启.
+    * prepareItem在工作线程中执行, 其它方法在UI线程中执行, adapter需要自己保证数据访问的同步.
+    */
+    interface ILvAsyncAdapter
+    {
+        /**
+        * 表项数据是否已经准备好, 准备好的表项通过ILvAdapter::getView绑定
+        */
+        virtual bool isItemPrepared(int position) PURE;
+
+        /**
+        * 在工作线程中准备表项数据, 不能访问任何窗口对象
+        */
+        virtual void prepareItem(int position) PURE;
+
+        /**
+        * 数据还没有准备好时为表项绑定占位视图
+        */
+        virtual void getPlaceholderView(int position, SWindow * pItem, pugi::xml_node xmlTemplate) PURE;
+    };
  
     enum SHDSORTFLAG;
     interface IMcAdapter : public ILvAdapter
@@ -165,6 +236,36 @@ namespace SOUI
         virtual void onBranchInvalidated(HTREEITEM hBranch,bool bInvalidParents,bool bInvalidChildren)  PURE;
         
         virtual void onBranchExpandedChanged(HTREEITEM hBranch,BOOL bExpandedOld,BOOL bExpandedNew) PURE;
+
+        /**
+        * This method is called when hItem has been inserted under hParent.
+        * The default implementation treats it as a change of the branch hParent.
+        */
+        virtual void onItemInserted(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            (hItem);
+            onBranchChanged(hParent);
+        }
+
+        /**
+        * This method is called when hItem and its children have been removed from hParent.
+        * hItem is no longer valid and can only be used to identify the removed item.
+        * The default implementation treats it as a change of the branch hParent.
+        */
+        virtual void onItemRemoved(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            (hItem);
+            onBranchChanged(hParent);
+        }
+
+        /**
+        * This method is called when the data of hItem has changed, its children are not affected.
+        * The default implementation invalidates hItem only.
+        */
+        virtual void onItemChanged(HTREEITEM hItem)
+        {
+            onBranchInvalidated(hItem,false,false);
+        }
     };
    
 	interface ITvAdapter : public IObjRef{
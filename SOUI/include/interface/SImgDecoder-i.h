@@ -111,6 +111,61 @@ namespace SOUI
          * Describe  
          */    
         virtual IImgFrame * GetFrame(UINT iFrame)=0;
+
+        /**
+         * DecodeInto
+         * @brief    decode a frame into the caller's buffer directly
+         * @param [in] UINT iFrame --  the target frame index
+         * @param [in] UINT cbStride --  The stride of the bitmap
+         * @param [in] UINT cbBufferSize --  The size of the buffer.
+         * @param [out] BYTE * pbBuffer --  A pointer to the buffer, receives premultiplied BGRA pixels
+         * @return   BOOL -- TRUE: succeed; FALSE: failed or not supported
+         * Describe  decoder can write pixels to the target bitmap without an intermediate copy, 
+         *           caller should fall back to IImgFrame::CopyPixels when it returns FALSE.
+         *           there is no target format parameter: the bitmaps of both render-gdi (32bit DIB)
+         *           and render-skia (kPMColor) store premultiplied BGRA, the same as CopyPixels,
+         *           so it is the only format a caller can decode into
+         */    
+        virtual BOOL DecodeInto(UINT iFrame,UINT cbStride,UINT cbBufferSize,BYTE *pbBuffer)
+        {
+            (iFrame);
+            (cbStride);
+            (cbBufferSize);
+            (pbBuffer);
+            return FALSE;
+        }
+
+        /**
+         * SetDecodeSize
+         * @brief    hint the size the image will be displayed at, must be called before LoadFromXXX
+         * @param [in] UINT cx --  the expected width, 0 means the original size
+         * @param [in] UINT cy --  the expected height, 0 means the original size
+         * @return   void
+         * Describe  decoder may shrink a large image while decoding, the decoded frame is never smaller
+         *           than the hint, so check the frame size after loading. decoders without
+         *           support ignore the hint
+         */    
+        virtual void SetDecodeSize(UINT cx,UINT cy)
+        {
+            (cx);
+            (cy);
+        }
+
+        /**
+         * LoadFromSharedMemory
+         * @brief    load image data from a buffer shared with other decoders
+         * @param [in] IObjRef * pOwner --  the owner of the buffer, decoder holds a reference while it uses the buffer
+         * @param [in] const void * pBuf --  point of buffer, must stay unchanged while pOwner is alive
+         * @param [in] size_t bufLen --  size of buffer
+         * @return   int -- frame count, 0: failed
+         * Describe  decoders with lazy decoding can read the buffer in place instead of keeping a private copy,
+         *           the default implementation copies the data by LoadFromMemory
+         */
+        virtual int LoadFromSharedMemory(IObjRef *pOwner,const void *pBuf,size_t bufLen)
+        {
+            (pOwner);
+            return LoadFromMemory((void*)pBuf,bufLen);
+        }
     };
 
     struct IBitmap;
@@ -18,5 +18,33 @@ namespace SOUI
         virtual int GetScrollLineSize() const PURE;
         virtual int GetDividerSize() const PURE;
 		virtual void SetScale(int nScale) PURE;
+
+        //表项范围变化, 只调整受影响的表项, 其它表项已测量的高度保持不变
+        //默认按整个数据集变化处理, 兼容没有实现这些方法的定位器
+        virtual void OnItemRangeInserted(int iItem,int nCount)
+        {
+            (iItem);
+            (nCount);
+            OnDataSetChanged();
+        }
+        virtual void OnItemRangeRemoved(int iItem,int nCount)
+        {
+            (iItem);
+            (nCount);
+            OnDataSetChanged();
+        }
+        virtual void OnItemRangeMoved(int iFrom,int iTo,int nCount)
+        {
+            (iFrom);
+            (iTo);
+            (nCount);
+            OnDataSetChanged();
+        }
+        //表项内容变化, 这些表项已测量的高度失效, 需要在可见时重新测量。默认不处理
+        virtual void OnItemRangeChanged(int iItem,int nCount)
+        {
+            (iItem);
+            (nCount);
+        }
     };
 }
\ No newline at end of file
@@ -364,6 +364,14 @@ namespace SOUI
          * Describe  
          */    
         inline virtual HRESULT Save(LPCWSTR pszFileName,const LPVOID pFormat);
+
+        /**
+         * GetContentVersion
+         * @brief    获取位图内容的版本号
+         * @return   DWORD -- 像素被修改后版本号改变, 0表示内容随时可能改变(如已被选入渲染目标)
+         * Describe  默认返回0, 长期引用位图内容的调用者(如SDisplayList)需要复制一份位图
+         */
+        virtual DWORD GetContentVersion() const {return 0;}
     };
 
     /**
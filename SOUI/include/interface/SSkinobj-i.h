@@ -121,6 +121,15 @@ namespace SOUI
         */ 
         virtual void OnColorize(COLORREF cr) {}
 
+        /**
+        * IsOpaque
+        * @brief    查询指定状态绘制时是否不透明地覆盖整个绘制区
+        * @param    int iState -- 状态索引
+        * @return   BOOL -- TRUE表示不透明
+        * Describe  默认返回FALSE，用于绘制时跳过被完全遮挡的窗口
+        */
+        virtual BOOL IsOpaque(int iState) const {return FALSE;}
+
 		virtual int GetScale() const = 0;
 
 		virtual ISkinObj * Scale(int nScale) = 0;
@@ -11,6 +11,10 @@ namespace SOUI
         virtual void SetAdapter(ITvAdapter *pAdapter) PURE;
         virtual void OnBranchChanged(HTREEITEM hItem) PURE;
         virtual void OnBranchExpandedChanged(HTREEITEM hItem,BOOL bExpandedOld,BOOL bExpandedNew) PURE;
+        //hItem插入到hParent后调用，缺省按hParent分枝变化处理
+        virtual void OnItemInserted(HTREEITEM hParent,HTREEITEM hItem){(hItem);OnBranchChanged(hParent);}
+        //hParent的某个子节点被删除后调用，缺省按hParent分枝变化处理
+        virtual void OnItemRemoved(HTREEITEM hParent){OnBranchChanged(hParent);}
 
         virtual int GetTotalHeight() const PURE;
         virtual int GetTotalWidth() const PURE;
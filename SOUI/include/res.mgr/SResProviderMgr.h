@@ -35,6 +35,9 @@ namespace SOUI
         
         IBitmap * LoadImage(LPCTSTR pszType,LPCTSTR pszResName);
 
+        //按显示大小szDecode解码图片, 大图在解码时就缩小, 得到的图片不小于szDecode
+        IBitmap * LoadImage(LPCTSTR pszType,LPCTSTR pszResName,SIZE szDecode);
+
         IImgX * LoadImgX(LPCTSTR pszType,LPCTSTR pszResName);
 
         size_t GetRawBufferSize(LPCTSTR pszType,LPCTSTR pszResName);
@@ -61,6 +64,7 @@ namespace SOUI
 
         //使用type:name形式的字符串加载图片
         IBitmap * LoadImage2(const SStringW & strImgID);
+        IBitmap * LoadImage2(const SStringW & strImgID,SIZE szDecode);
         
         //使用name:size形式的字符串加载图标，如果没有size,则默认系统图标SIZE
         HICON     LoadIcon2(const SStringW & strIconID);
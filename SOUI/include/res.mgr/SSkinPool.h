@@ -74,8 +74,15 @@ typedef ISkinObj * SSkinPtr;
 class SkinKey
 {
 public:
+	SkinKey():scale(100),atom(NULL){}
+	//bIntern为false时只查找已有的原子，用于查询，不会让驻留表随查询的名字增长
+	SkinKey(const SStringW & name,int nScale,bool bIntern=true)
+		:strName(name),scale(nScale)
+		,atom(bIntern?SStringPool::Intern(name,name.GetLength()):SStringPool::Find(name,name.GetLength())){}
+
 	SStringW strName;
 	int		 scale;
+	SATOM	 atom;	//strName的驻留原子，哈希和比较只使用原子. 查询用的key为NULL表示名字从未被加入任何皮肤池
 };
 
 template<>
@@ -85,7 +92,7 @@ class CElementTraits<SkinKey > :
 public:
 	static ULONG Hash(INARGTYPE skinKey)
 	{
-		ULONG nHash = CElementTraits<SStringW>::Hash(skinKey.strName);
+		ULONG nHash = skinKey.atom?skinKey.atom->nHash:0;
 
 		nHash <<= 5;
 		nHash += skinKey.scale;
@@ -94,7 +101,7 @@ public:
 
 	static bool CompareElements(INARGTYPE element1, INARGTYPE element2)
 	{
-		return element1.strName == element2.strName
+		return element1.atom == element2.atom
 			&& element1.scale == element2.scale;
 	}
 
@@ -60,6 +60,7 @@
 #include <atl.mini/scomcli.h>
 #include <string/tstring.h>
 #include <string/strcpcvt.h>
+#include <string/sstringpool.h>
 #include <pugixml/pugixml.hpp>
 
 
@@ -13,6 +13,7 @@
 #include "helper/SAppDir.h"
 #include "helper/SwndFinder.h"
 #include "helper/SHostMgr.h"
+#include "helper/SRenderCacheMgr.h"
 
 #include "control/Smessagebox.h"
 #include "updatelayeredwindow/SUpdateLayeredWindow.h"
@@ -259,6 +260,7 @@ void SApplication::_CreateSingletons(HINSTANCE hInst,LPCTSTR pszHostClassName,BO
 	m_pSingletons[SRicheditMenuDef::GetType()] = new SRicheditMenuDef();
 	m_pSingletons[SNativeWndHelper::GetType()] =   new SNativeWndHelper(hInst, pszHostClassName, bImeApp);
 	m_pSingletons[SHostMgr::GetType()] =   new SHostMgr();
+	m_pSingletons[SRenderCacheMgr::GetType()] = new SRenderCacheMgr();
 }
 
 #define DELETE_SINGLETON(x) \
@@ -267,6 +269,7 @@ void SApplication::_CreateSingletons(HINSTANCE hInst,LPCTSTR pszHostClassName,BO
 
 void SApplication::_DestroySingletons()
 {
+	DELETE_SINGLETON(SRenderCacheMgr);
 	DELETE_SINGLETON(SHostMgr);
 	DELETE_SINGLETON(SNativeWndHelper);
 	DELETE_SINGLETON(SRicheditMenuDef);
@@ -558,6 +558,7 @@ CSize SImageButton::GetDesiredSize( int wid, int hei )
 // Use src attribute specify a resource id
 //
 // Usage: <img skin="skin" sub="0"/>
+//        <img src="img:photo"/>
 //
 SImageWnd::SImageWnd()
     : m_iIcon(0)
@@ -584,6 +585,11 @@ void SImageWnd::OnPaint(IRenderTarget *pRT)
     CRect rcWnd = GetWindowRect();
 	if (rcWnd.IsRectEmpty())
 		return;
+	if (!m_strSrc.IsEmpty() && m_iTile == 0
+		&& (!m_pImg || (m_szDecode.cx > 0 && (rcWnd.Width() > m_szDecode.cx || rcWnd.Height() > m_szDecode.cy))))
+	{//拉伸绘制时按窗口大小解码, 窗口变大后重新解码
+		LoadSrcImage(rcWnd.Size());
+	}
 	if (m_bKeepAspect)
 	{
 		CSize szImg;
@@ -635,6 +641,7 @@ BOOL SImageWnd::SetSkin(ISkinObj *pSkin,int iFrame/*=0*/,BOOL bAutoFree/*=TRUE*/
     m_pSkin=pSkin;
     m_iIcon=iFrame;
 	m_pImg = NULL;
+	m_strSrc.Empty();
     if(bAutoFree)
     {
         m_pSkin->AddRef();
@@ -659,9 +666,25 @@ void SImageWnd::SetImage(IBitmap * pBitmap,FilterLevel fl)
 {
     m_pImg = pBitmap;
     m_fl = fl;
+	m_strSrc.Empty();
 	OnContentChanged();
 }
 
+void SImageWnd::LoadSrcImage(SIZE szDecode)
+{
+	m_pImg.Attach(SApplication::getSingleton().LoadImage2(m_strSrc, szDecode));
+	m_szDecode = szDecode;
+}
+
+HRESULT SImageWnd::OnAttrSrc(const SStringW& strValue, BOOL bLoading)
+{
+	m_strSrc = strValue;
+	m_pImg = NULL;
+	m_szDecode.cx = m_szDecode.cy = 0;
+	if (!bLoading) OnContentChanged();
+	return S_FALSE;
+}
+
 IBitmap* SImageWnd::GetImage()
 {
 	return m_pImg;
@@ -679,6 +702,10 @@ BOOL SImageWnd::SetIcon( int nSubID )
 CSize SImageWnd::GetDesiredSize(int wid,int hei)
 {
     CSize szRet;
+    if(!m_pImg && !m_strSrc.IsEmpty())
+    {//自适应大小需要原始图片大小
+        LoadSrcImage(CSize());
+    }
     if(m_pImg) szRet = m_pImg->Size();
     else if(m_pSkin) szRet=m_pSkin->GetSkinSize();
     return szRet;
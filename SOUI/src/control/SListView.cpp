@@ -1,6 +1,8 @@
 ﻿#include "souistd.h"
 #include "control/SListView.h"
 #include "helper/SListViewItemLocator.h"
+#include "helper/SFunctor.hpp"
+#include "helper/STaskHandler.h"
 
 namespace SOUI
 {
@@ -16,6 +18,11 @@ namespace SOUI
         virtual void onInvalidated();
 
 		virtual void OnItemChanged(int iItem);
+
+        virtual void onItemRangeInserted(int iItem,int nCount);
+        virtual void onItemRangeRemoved(int iItem,int nCount);
+        virtual void onItemRangeChanged(int iItem,int nCount);
+        virtual void onItemRangeMoved(int iFrom,int iTo,int nCount);
     protected:
         SListView * m_pOwner;
     };
@@ -36,6 +43,62 @@ namespace SOUI
 		m_pOwner->onItemDataChanged(iItem);
 	}
 
+    void SListViewDataSetObserver::onItemRangeInserted(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeInserted(iItem,nCount);
+    }
+
+    void SListViewDataSetObserver::onItemRangeRemoved(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeRemoved(iItem,nCount);
+    }
+
+    void SListViewDataSetObserver::onItemRangeChanged(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeChanged(iItem,nCount);
+    }
+
+    void SListViewDataSetObserver::onItemRangeMoved(int iFrom,int iTo,int nCount)
+    {
+        m_pOwner->onItemRangeMoved(iFrom,iTo,nCount);
+    }
+
+    //在工作线程中准备表项数据, 完成后把通知投递回UI线程
+    class SListViewPrepareTask : public SRunnable
+    {
+        IMPL_GETCLASSINFO
+    public:
+        SListViewPrepareTask(SListView *pOwner,int iItem,int nGeneration)
+            :SRunnable(pOwner)
+            ,m_adapter(pOwner->m_adapter)
+            ,m_asyncAdapter(pOwner->m_asyncAdapter)
+            ,m_notifier(pOwner->m_prepareNotifier)
+            ,m_iItem(iItem)
+            ,m_nGeneration(nGeneration)
+        {
+        }
+
+        virtual IRunnable * clone() const
+        {
+            return new SListViewPrepareTask(*this);
+        }
+
+        virtual void run()
+        {
+            m_asyncAdapter->prepareItem(m_iItem);
+            //工作线程中不访问列表对象, 只投递通知
+            SFunctor2<SListView,void (SListView::*)(int,int),int,int> notify((SListView*)getObject(),&SListView::OnItemPrepared,m_iItem,m_nGeneration);
+            m_notifier->postTask(&notify,false);
+        }
+
+    protected:
+        SAutoRefPtr<ILvAdapter> m_adapter;  //保证准备期间adapter有效
+        ILvAsyncAdapter *       m_asyncAdapter;
+        SAutoRefPtr<ITaskLoop>  m_notifier;
+        int                     m_iItem;
+        int                     m_nGeneration;
+    };
+
 
 
     //////////////////////////////////////////////////////////////////////////
@@ -49,6 +112,9 @@ namespace SOUI
         ,m_bDataSetInvalidated(FALSE)
 		,m_bPendingUpdate(false)
 		,m_iPendingUpdateItem(-2)
+		,m_asyncAdapter(NULL)
+		,m_nPrefetch(5)
+		,m_nPrepareGen(0)
     {
         m_bFocusable = TRUE;
         m_observer.Attach(new SListViewDataSetObserver(this));
@@ -83,6 +149,8 @@ namespace SOUI
         if(m_adapter)
         {
             m_adapter->unregisterDataSetObserver(m_observer);
+            CancelPrepare();
+            m_asyncAdapter = NULL;
 
             //free all itemPanels in recycle
             for(size_t i=0;i<m_itemRecycle.GetCount();i++)
@@ -164,6 +232,7 @@ namespace SOUI
     void SListView::onDataSetChanged()
     {
         if(!m_adapter) return;
+        CancelPrepare();
 		if(!IsVisible(TRUE))
 		{
 			m_bPendingUpdate = true;
@@ -187,6 +256,7 @@ namespace SOUI
 	void SListView::onItemDataChanged(int iItem)
 	{
 		if(!m_adapter) return;
+		m_lvItemLocator->OnItemRangeChanged(iItem,1);
 		if(!IsVisible(TRUE))
 		{
 			m_bPendingUpdate = true;
@@ -202,6 +272,149 @@ namespace SOUI
 			UpdateVisibleItems();
 	}
 
+	void SListView::onItemRangeInserted(int iItem,int nCount)
+	{
+		if(!m_adapter || nCount<=0) return;
+		CancelPrepare();
+		RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+		m_lvItemLocator->OnItemRangeInserted(iItem,nCount);
+		updater.OnInserted(iItem,nCount);
+		UpdateItemRange();
+	}
+
+	void SListView::onItemRangeRemoved(int iItem,int nCount)
+	{
+		if(!m_adapter || nCount<=0) return;
+		CancelPrepare();
+		RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+		m_lvItemLocator->OnItemRangeRemoved(iItem,nCount);
+		updater.OnRemoved(iItem,nCount);
+		UpdateItemRange();
+	}
+
+	void SListView::onItemRangeChanged(int iItem,int nCount)
+	{
+		if(!m_adapter || nCount<=0) return;
+		m_lvItemLocator->OnItemRangeChanged(iItem,nCount);
+		if(!IsVisible(TRUE))
+		{
+			m_bPendingUpdate = true;
+			m_iPendingUpdateItem = (nCount==1 && m_iPendingUpdateItem==-2)?iItem:-1;
+			return;
+		}
+
+		int iFirst = smax(iItem,m_iFirstVisible);
+		int iLast = smin(iItem+nCount,m_iFirstVisible + (int)m_lstItems.GetCount());
+		if(iFirst>=iLast) return;
+		if(m_lvItemLocator->IsFixHeight())
+		{
+			for(int i=iFirst;i<iLast;i++)
+				UpdateVisibleItem(i);
+		}else
+		{
+			UpdateVisibleItems();
+		}
+	}
+
+	void SListView::onItemRangeMoved(int iFrom,int iTo,int nCount)
+	{
+		if(!m_adapter || nCount<=0 || iFrom==iTo) return;
+		CancelPrepare();
+		RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+		m_lvItemLocator->OnItemRangeMoved(iFrom,iTo,nCount);
+		updater.OnMoved(iFrom,iTo,nCount);
+		UpdateItemRange();
+	}
+
+	void SListView::UpdateItemRange()
+	{
+		if(!IsVisible(TRUE))
+		{
+			m_bPendingUpdate = true;
+			m_iPendingUpdateItem = -1;
+			return;
+		}
+		UpdateScrollBar();
+		UpdateVisibleItems();
+	}
+
+	void SListView::SetAsyncAdapter(ILvAsyncAdapter *pAsyncAdapter, ITaskLoop *pWorker, int nPrefetch)
+	{
+		CancelPrepare();
+		if(!pWorker) pAsyncAdapter = NULL;
+		m_asyncAdapter = pAsyncAdapter;
+		m_prepareWorker = pAsyncAdapter?pWorker:NULL;
+		m_nPrefetch = smax(nPrefetch,0);
+		if(m_asyncAdapter && !m_prepareNotifier)
+		{
+			STaskHandler *pNotifier = new STaskHandler();
+			pNotifier->start("listview_prepare",ITaskLoop::Normal);
+			m_prepareNotifier.Attach(pNotifier);
+		}
+		onDataSetChanged();
+	}
+
+	void SListView::BindItemView(int iItem,SItemPanel *pItem)
+	{
+		if(m_asyncAdapter && !m_asyncAdapter->isItemPrepared(iItem))
+		{//数据没有准备好时先绑定占位视图
+			m_asyncAdapter->getPlaceholderView(iItem,pItem,m_xmlTemplate.first_child());
+			RequestPrepare(iItem,true);
+		}else
+		{
+			m_adapter->getView(iItem,pItem,m_xmlTemplate.first_child());
+		}
+	}
+
+	void SListView::RequestPrepare(int iItem,bool bVisible)
+	{
+		if(!m_asyncAdapter || !m_prepareWorker) return;
+		if(iItem<0 || iItem>=m_adapter->getCount()) return;
+		if(m_pendingPrepare.Lookup(iItem)) return;
+		if(m_asyncAdapter->isItemPrepared(iItem)) return;
+
+		SListViewPrepareTask task(this,iItem,m_nPrepareGen);
+		long nTaskID = m_prepareWorker->postTask(&task,false,bVisible?ITaskLoop::High:ITaskLoop::Low);
+		if(nTaskID != -1) m_pendingPrepare[iItem] = nTaskID;
+	}
+
+	void SListView::PrefetchItems(int iFirst,int iLast)
+	{
+		if(!m_asyncAdapter || iFirst==-1) return;
+		int iMin = iFirst - m_nPrefetch;
+		int iMax = iLast + m_nPrefetch;
+
+		//快速滚动时取消已经远离可见区的准备任务
+		SPOSITION pos = m_pendingPrepare.GetStartPosition();
+		while(pos)
+		{
+			SPOSITION posCur = pos;
+			const SMap<int,long>::CPair *p = m_pendingPrepare.GetNext(pos);
+			if(p->m_key>=iMin && p->m_key<iMax) continue;
+			if(m_prepareWorker->cancelTask(p->m_value))
+				m_pendingPrepare.RemoveAtPos(posCur);
+		}
+
+		for(int i=iLast;i<iMax;i++)
+			RequestPrepare(i,false);
+		for(int i=iFirst-1;i>=iMin;i--)
+			RequestPrepare(i,false);
+	}
+
+	void SListView::CancelPrepare()
+	{
+		if(m_prepareWorker) m_prepareWorker->cancelTasksForObject(this);
+		m_pendingPrepare.RemoveAll();
+		m_nPrepareGen++;
+	}
+
+	void SListView::OnItemPrepared(int iItem,int nGeneration)
+	{
+		if(nGeneration != m_nPrepareGen) return;//表项索引已经失效
+		m_pendingPrepare.RemoveKey(iItem);
+		onItemDataChanged(iItem);
+	}
+
 
     void SListView::OnPaint(IRenderTarget *pRT)
     {
@@ -282,8 +495,7 @@ namespace SOUI
     void SListView::UpdateVisibleItems()
     {
         if(!m_adapter) return;
-        int iOldFirstVisible = m_iFirstVisible;
-        int iOldLastVisible = m_iFirstVisible + (int)m_lstItems.GetCount();
+        int nOldCount = (int)m_lstItems.GetCount();
         int nOldTotalHeight = m_lvItemLocator->GetTotalHeight();
 
         int iNewFirstVisible = m_lvItemLocator->Position2Item(m_siVer.nPos);
@@ -300,6 +512,14 @@ namespace SOUI
             pItemInfos[i++]=m_lstItems.GetNext(spos);
         }
 
+        //按表项索引建立旧显示项的索引, 表项范围变化后旧的显示项不一定连续
+        SMap<int,int> mapOldItems;
+        for(i=0;i<nOldCount;i++)
+        {
+            int idx = (int)pItemInfos[i].pItem->GetItemIndex();
+            if(idx!=-1 && !mapOldItems.Lookup(idx)) mapOldItems[idx] = i;
+        }
+
         m_lstItems.RemoveAll();
 
         if(iNewFirstVisible!=-1)
@@ -312,15 +532,11 @@ namespace SOUI
 
                 ItemInfo ii={NULL,-1};
                 ii.nType = m_adapter->getItemViewType(iNewLastVisible,dwState);
-                if(iNewLastVisible>=iOldFirstVisible && iNewLastVisible < iOldLastVisible)
-                {//use the old visible item
-                    int iItem = iNewLastVisible-iOldFirstVisible;//(iNewLastVisible-iNewFirstVisible) + (iNewFirstVisible-iOldFirstVisible);
-                    SASSERT(iItem>=0 && iItem <= (iOldLastVisible-iOldFirstVisible));
-                    if(ii.nType == pItemInfos[iItem].nType)
-                    {
-                        ii = pItemInfos[iItem];
-                        pItemInfos[iItem].pItem = NULL;//标记该行已经被重用
-                    }
+                SMap<int,int>::CPair *pOld = mapOldItems.Lookup(iNewLastVisible);
+                if(pOld && pItemInfos[pOld->m_value].nType == ii.nType)
+                {//use the old visible item.
+                    ii = pItemInfos[pOld->m_value];
+                    pItemInfos[pOld->m_value].pItem = NULL;//标记该行已经被重用
                 }
 				BOOL bNewItem=FALSE;
                 if(!ii.pItem)
@@ -353,7 +569,7 @@ namespace SOUI
                 if(dwState & WndState_Hover)
                     m_pHoverItem = ii.pItem;
 
-                m_adapter->getView(iNewLastVisible,ii.pItem,m_xmlTemplate.first_child());
+                BindItemView(iNewLastVisible,ii.pItem);
 				if(bNewItem)
 				{
 					ii.pItem->SDispatchMessage(UM_SETSCALE, GetScale(), 0);
@@ -378,7 +594,7 @@ namespace SOUI
         }
 
         //move old visible items which were not reused to recycle
-        for(int i=0;i<(iOldLastVisible-iOldFirstVisible);i++)
+        for(int i=0;i<nOldCount;i++)
         {
             ItemInfo ii = pItemInfos[i];
             if(!ii.pItem) continue;
@@ -399,6 +615,7 @@ namespace SOUI
         delete [] pItemInfos;
 
         m_iFirstVisible = iNewFirstVisible;
+        PrefetchItems(iNewFirstVisible,iNewLastVisible);
 
         if(!m_lvItemLocator->IsFixHeight() && m_lvItemLocator->GetTotalHeight() != nOldTotalHeight)
         {//update scroll range
@@ -413,7 +630,7 @@ namespace SOUI
 		SASSERT(m_lvItemLocator->IsFixHeight());
 		SItemPanel * pItem = GetItemPanel(iItem);
 		if(pItem)
-			m_adapter->getView(iItem,pItem,m_xmlTemplate.first_child());
+			BindItemView(iItem,pItem);
 	}
 
 
@@ -443,6 +660,12 @@ namespace SOUI
 		{
 			m_adapter->unregisterDataSetObserver(m_observer);
 		}
+		CancelPrepare();
+		if(m_prepareNotifier)
+		{
+			m_prepareNotifier->cancelTasksForObject(this);
+			m_prepareNotifier->stop();
+		}
 
         //destroy all itempanel
         SPOSITION pos = m_lstItems.GetHeadPosition();
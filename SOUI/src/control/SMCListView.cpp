@@ -17,6 +17,11 @@ namespace SOUI
         virtual void onInvalidated();
 
 		virtual void OnItemChanged(int iItem);
+
+        virtual void onItemRangeInserted(int iItem,int nCount);
+        virtual void onItemRangeRemoved(int iItem,int nCount);
+        virtual void onItemRangeChanged(int iItem,int nCount);
+        virtual void onItemRangeMoved(int iFrom,int iTo,int nCount);
     protected:
         SMCListView * m_pOwner;
     };
@@ -37,6 +42,27 @@ namespace SOUI
 		m_pOwner->onItemDataChanged(iItem);
 	}
 
+    void SMCListViewDataSetObserver::onItemRangeInserted(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeInserted(iItem,nCount);
+    }
+
+    void SMCListViewDataSetObserver::onItemRangeRemoved(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeRemoved(iItem,nCount);
+    }
+
+    void SMCListViewDataSetObserver::onItemRangeChanged(int iItem,int nCount)
+    {
+        m_pOwner->onItemRangeChanged(iItem,nCount);
+    }
+
+    void SMCListViewDataSetObserver::onItemRangeMoved(int iFrom,int iTo,int nCount)
+    {
+        m_pOwner->onItemRangeMoved(iFrom,iTo,nCount);
+    }
+
+
 //////////////////////////////////////////////////////////////////////////
 //  SMCListView
 
@@ -444,6 +470,7 @@ void SMCListView::onDataSetInvalidated()
 void SMCListView::onItemDataChanged(int iItem)
 {
 	if(!m_adapter) return;
+	m_lvItemLocator->OnItemRangeChanged(iItem,1);
 	if(!IsVisible(TRUE))
 	{
 		m_bPendingUpdate = true;
@@ -459,6 +486,69 @@ void SMCListView::onItemDataChanged(int iItem)
 		UpdateVisibleItems();
 }
 
+void SMCListView::onItemRangeInserted(int iItem,int nCount)
+{
+    if(!m_adapter || nCount<=0) return;
+    RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+    m_lvItemLocator->OnItemRangeInserted(iItem,nCount);
+    updater.OnInserted(iItem,nCount);
+    UpdateItemRange();
+}
+
+void SMCListView::onItemRangeRemoved(int iItem,int nCount)
+{
+    if(!m_adapter || nCount<=0) return;
+    RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+    m_lvItemLocator->OnItemRangeRemoved(iItem,nCount);
+    updater.OnRemoved(iItem,nCount);
+    UpdateItemRange();
+}
+
+void SMCListView::onItemRangeChanged(int iItem,int nCount)
+{
+    if(!m_adapter || nCount<=0) return;
+    m_lvItemLocator->OnItemRangeChanged(iItem,nCount);
+    if(!IsVisible(TRUE))
+    {
+        m_bPendingUpdate = true;
+        m_iPendingUpdateItem = (nCount==1 && m_iPendingUpdateItem==-2)?iItem:-1;
+        return;
+    }
+
+    int iFirst = smax(iItem,m_iFirstVisible);
+    int iLast = smin(iItem+nCount,m_iFirstVisible + (int)m_lstItems.GetCount());
+    if(iFirst>=iLast) return;
+    if(m_lvItemLocator->IsFixHeight())
+    {
+        for(int i=iFirst;i<iLast;i++)
+            UpdateVisibleItem(i);
+    }else
+    {
+        UpdateVisibleItems();
+    }
+}
+
+void SMCListView::onItemRangeMoved(int iFrom,int iTo,int nCount)
+{
+    if(!m_adapter || nCount<=0 || iFrom==iTo) return;
+    RangeUpdater updater(m_lvItemLocator,m_lstItems,m_iFirstVisible,m_siVer.nPos,m_iSelItem);
+    m_lvItemLocator->OnItemRangeMoved(iFrom,iTo,nCount);
+    updater.OnMoved(iFrom,iTo,nCount);
+    UpdateItemRange();
+}
+
+void SMCListView::UpdateItemRange()
+{
+    if(!IsVisible(TRUE))
+    {
+        m_bPendingUpdate = true;
+        m_iPendingUpdateItem = -1;
+        return;
+    }
+    UpdateScrollBar();
+    UpdateVisibleItems();
+}
+
 void SMCListView::OnPaint(IRenderTarget *pRT)
 {
     if(m_bDatasetInvalidated)
@@ -574,8 +664,7 @@ BOOL SMCListView::OnScroll(BOOL bVertical,UINT uCode,int nPos)
 void SMCListView::UpdateVisibleItems()
 {
     if(!m_adapter) return;
-    int iOldFirstVisible = m_iFirstVisible;
-    int iOldLastVisible = m_iFirstVisible + m_lstItems.GetCount();
+    int nOldCount = (int)m_lstItems.GetCount();
     int nOldTotalHeight = m_lvItemLocator->GetTotalHeight();
 
     int iNewFirstVisible = m_lvItemLocator->Position2Item(m_siVer.nPos);
@@ -592,6 +681,14 @@ void SMCListView::UpdateVisibleItems()
         pItemInfos[i++]=m_lstItems.GetNext(spos);
     }
 
+    //按表项索引建立旧显示项的索引, 表项范围变化后旧的显示项不一定连续
+    SMap<int,int> mapOldItems;
+    for(i=0;i<nOldCount;i++)
+    {
+        int idx = (int)pItemInfos[i].pItem->GetItemIndex();
+        if(idx!=-1 && !mapOldItems.Lookup(idx)) mapOldItems[idx] = i;
+    }
+
     m_lstItems.RemoveAll();
 
     if(iNewFirstVisible!=-1)
@@ -605,15 +702,11 @@ void SMCListView::UpdateVisibleItems()
             ItemInfo ii={NULL,-1};
             ii.nType = m_adapter->getItemViewType(iNewLastVisible,dwState);
 
-            if(iNewLastVisible>=iOldFirstVisible && iNewLastVisible < iOldLastVisible)
-            {//use the old visible item
-                int iItem = iNewLastVisible-iOldFirstVisible;//(iNewLastVisible-iNewFirstVisible) + (iNewFirstVisible-iOldFirstVisible);
-                SASSERT(iItem>=0 && iItem <= (iOldLastVisible-iOldFirstVisible));
-                if(pItemInfos[iItem].nType == ii.nType)
-                {//类型相同才能重用
-                    ii = pItemInfos[iItem];
-                    pItemInfos[iItem].pItem = NULL;//标记该行已经被重用
-                }
+            SMap<int,int>::CPair *pOld = mapOldItems.Lookup(iNewLastVisible);
+            if(pOld && pItemInfos[pOld->m_value].nType == ii.nType)
+            {//use the old visible item. 类型相同才能重用
+                ii = pItemInfos[pOld->m_value];
+                pItemInfos[pOld->m_value].pItem = NULL;//标记该行已经被重用
             }
 			BOOL bNewItem = FALSE;
             if(!ii.pItem)
@@ -693,7 +786,7 @@ void SMCListView::UpdateVisibleItems()
     }
 
     //move old visible items which were not reused to recycle
-    for(int i=0;i<(iOldLastVisible-iOldFirstVisible);i++)
+    for(int i=0;i<nOldCount;i++)
     {
         ItemInfo ii = pItemInfos[i];
         if(!ii.pItem) continue;
@@ -15,6 +15,10 @@ public:
 
 	virtual void OnItemChanged(int iItem);
 
+    virtual void onItemRangeInserted(int iItem, int nCount);
+    virtual void onItemRangeRemoved(int iItem, int nCount);
+    virtual void onItemRangeChanged(int iItem, int nCount);
+    virtual void onItemRangeMoved(int iFrom, int iTo, int nCount);
 
 protected:
     STileView *m_pOwner;
@@ -36,6 +40,26 @@ void STileViewDataSetObserver::OnItemChanged(int iItem)
 	m_pOwner->onItemDataChanged(iItem);
 }
 
+void STileViewDataSetObserver::onItemRangeInserted(int iItem, int nCount)
+{
+    m_pOwner->onItemRangeInserted(iItem, nCount);
+}
+
+void STileViewDataSetObserver::onItemRangeRemoved(int iItem, int nCount)
+{
+    m_pOwner->onItemRangeRemoved(iItem, nCount);
+}
+
+void STileViewDataSetObserver::onItemRangeChanged(int iItem, int nCount)
+{
+    m_pOwner->onItemRangeChanged(iItem, nCount);
+}
+
+void STileViewDataSetObserver::onItemRangeMoved(int iFrom, int iTo, int nCount)
+{
+    m_pOwner->onItemRangeMoved(iFrom, iTo, nCount);
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 STileView::STileView()
@@ -206,6 +230,72 @@ void STileView::onItemDataChanged(int iItem)
 	UpdateVisibleItem(iItem);
 }
 
+void STileView::onItemRangeInserted(int iItem, int nCount)
+{
+    if(!m_adapter || nCount <= 0)
+    {
+        return;
+    }
+    //平铺定位器按索引直接计算位置, 不需要更新
+    RangeUpdater updater(m_tvItemLocator, m_lstItems, m_iFirstVisible, m_siVer.nPos, m_iSelItem);
+    updater.OnInserted(iItem, nCount);
+    UpdateItemRange();
+}
+
+void STileView::onItemRangeRemoved(int iItem, int nCount)
+{
+    if(!m_adapter || nCount <= 0)
+    {
+        return;
+    }
+    RangeUpdater updater(m_tvItemLocator, m_lstItems, m_iFirstVisible, m_siVer.nPos, m_iSelItem);
+    updater.OnRemoved(iItem, nCount);
+    UpdateItemRange();
+}
+
+void STileView::onItemRangeChanged(int iItem, int nCount)
+{
+    if(!m_adapter || nCount <= 0)
+    {
+        return;
+    }
+    if(!IsVisible(TRUE))
+    {
+        m_bPendingUpdate = true;
+        m_iPendingUpdateItem = (nCount == 1 && m_iPendingUpdateItem == -2) ? iItem : -1;
+        return;
+    }
+    int iFirst = smax(iItem, m_iFirstVisible);
+    int iLast = smin(iItem + nCount, m_iFirstVisible + (int)m_lstItems.GetCount());
+    for(int i = iFirst; i < iLast; i++)
+    {
+        UpdateVisibleItem(i);
+    }
+}
+
+void STileView::onItemRangeMoved(int iFrom, int iTo, int nCount)
+{
+    if(!m_adapter || nCount <= 0 || iFrom == iTo)
+    {
+        return;
+    }
+    RangeUpdater updater(m_tvItemLocator, m_lstItems, m_iFirstVisible, m_siVer.nPos, m_iSelItem);
+    updater.OnMoved(iFrom, iTo, nCount);
+    UpdateItemRange();
+}
+
+void STileView::UpdateItemRange()
+{
+    if(!IsVisible(TRUE))
+    {
+        m_bPendingUpdate = true;
+        m_iPendingUpdateItem = -1;
+        return;
+    }
+    UpdateScrollBar();
+    UpdateVisibleItems();
+}
+
 void STileView::OnPaint(IRenderTarget *pRT)
 {
     if(m_bDatasetInvalidated)
@@ -284,8 +374,7 @@ void STileView::UpdateVisibleItems()
     {
         return;
     }
-    int iOldFirstVisible = m_iFirstVisible;
-    int iOldLastVisible = m_iFirstVisible + (int)m_lstItems.GetCount();
+    int nOldCount = (int)m_lstItems.GetCount();
     
     int iNewFirstVisible = m_tvItemLocator->Position2Item(m_siVer.nPos);
     int iNewLastVisible = iNewFirstVisible;
@@ -300,6 +389,14 @@ void STileView::UpdateVisibleItems()
     {
         pItemInfos[i++] = m_lstItems.GetNext(spos);
     }
+
+    //按表项索引建立旧显示项的索引, 表项范围变化后旧的显示项不一定连续
+    SMap<int, int> mapOldItems;
+    for(i = 0; i < nOldCount; i++)
+    {
+        int idx = (int)pItemInfos[i].pItem->GetItemIndex();
+        if(idx != -1 && !mapOldItems.Lookup(idx)) mapOldItems[idx] = i;
+    }
     
     m_lstItems.RemoveAll();
     
@@ -313,16 +410,12 @@ void STileView::UpdateVisibleItems()
 
             ItemInfo ii = {NULL, -1};
             ii.nType = m_adapter->getItemViewType(iNewLastVisible,dwState);
-            if(iNewLastVisible >= iOldFirstVisible && iNewLastVisible < iOldLastVisible)
+            SMap<int, int>::CPair *pOld = mapOldItems.Lookup(iNewLastVisible);
+            if(pOld && ii.nType == pItemInfos[pOld->m_value].nType)
             {
-                //use the old visible item
-                int iItem = iNewLastVisible - iOldFirstVisible;
-                SASSERT(iItem >= 0 && iItem <= (iOldLastVisible - iOldFirstVisible));
-                if(ii.nType == pItemInfos[iItem].nType)
-                {
-                    ii = pItemInfos[iItem];
-                    pItemInfos[iItem].pItem = NULL;//标记该行已经被重用
-                }
+                //use the old visible item.
+                ii = pItemInfos[pOld->m_value];
+                pItemInfos[pOld->m_value].pItem = NULL;//标记该行已经被重用
             }
 			BOOL bNewItem=FALSE;
             if(!ii.pItem)
@@ -380,7 +473,7 @@ void STileView::UpdateVisibleItems()
     }
     
     //move old visible items which were not reused to recycle
-    for(int i = 0; i < (iOldLastVisible - iOldFirstVisible); i++)
+    for(int i = 0; i < nOldCount; i++)
     {
         ItemInfo ii = pItemInfos[i];
         if(!ii.pItem)
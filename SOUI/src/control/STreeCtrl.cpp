@@ -9,6 +9,141 @@
 
 namespace SOUI{
 
+//////////////////////////////////////////////////////////////////////////
+//  兄弟节点的treap: 中序遍历即兄弟顺序, nSibRows为子树中兄弟节点的行数之和
+static inline int SibRows(const LPTVITEM pItem)
+{
+    return pItem?pItem->nSibRows:0;
+}
+
+static inline void SibPull(LPTVITEM pItem)
+{
+    pItem->nSibRows = SibRows(pItem->pSibLeft) + SibRows(pItem->pSibRight)
+        + 1 + (pItem->bCollapsed?0:pItem->nChildRows);
+}
+
+static void SibPullTree(LPTVITEM pItem)
+{
+    if(!pItem) return;
+    SibPullTree(pItem->pSibLeft);
+    SibPullTree(pItem->pSibRight);
+    SibPull(pItem);
+}
+
+//节点行数变化后沿treap向上更新
+static void SibUpdate(LPTVITEM pItem)
+{
+    while(pItem)
+    {
+        SibPull(pItem);
+        pItem = pItem->pSibParent;
+    }
+}
+
+//把pItem旋转到其父节点的位置
+static void SibRotateUp(LPTVITEM & pRoot,LPTVITEM pItem)
+{
+    LPTVITEM pParent = pItem->pSibParent;
+    LPTVITEM pGrand = pParent->pSibParent;
+    if(pParent->pSibLeft == pItem)
+    {
+        pParent->pSibLeft = pItem->pSibRight;
+        if(pItem->pSibRight) pItem->pSibRight->pSibParent = pParent;
+        pItem->pSibRight = pParent;
+    }else
+    {
+        pParent->pSibRight = pItem->pSibLeft;
+        if(pItem->pSibLeft) pItem->pSibLeft->pSibParent = pParent;
+        pItem->pSibLeft = pParent;
+    }
+    pParent->pSibParent = pItem;
+    pItem->pSibParent = pGrand;
+    if(!pGrand) pRoot = pItem;
+    else if(pGrand->pSibLeft == pParent) pGrand->pSibLeft = pItem;
+    else pGrand->pSibRight = pItem;
+    SibPull(pParent);
+    SibPull(pItem);
+}
+
+//把pNew插入到pAfter之后, pAfter为NULL时插入到最前面
+static void SibInsert(LPTVITEM & pRoot,LPTVITEM pAfter,LPTVITEM pNew)
+{
+    pNew->pSibParent = pNew->pSibLeft = pNew->pSibRight = NULL;
+    SibPull(pNew);
+    if(!pRoot)
+    {
+        pRoot = pNew;
+        return;
+    }
+    //pAfter的中序后继位置: pAfter的右子节点为空时挂在右边, 否则挂在右子树最左节点的左边
+    LPTVITEM pAttach = pAfter?pAfter->pSibRight:pRoot;
+    if(pAfter && !pAttach)
+    {
+        pAfter->pSibRight = pNew;
+        pNew->pSibParent = pAfter;
+    }else
+    {
+        while(pAttach->pSibLeft) pAttach = pAttach->pSibLeft;
+        pAttach->pSibLeft = pNew;
+        pNew->pSibParent = pAttach;
+    }
+    SibUpdate(pNew->pSibParent);
+    while(pNew->pSibParent && pNew->pSibParent->uSibPriority < pNew->uSibPriority)
+    {
+        SibRotateUp(pRoot,pNew);
+    }
+}
+
+static void SibRemove(LPTVITEM & pRoot,LPTVITEM pItem)
+{
+    //把节点旋转到叶子位置后摘除
+    while(pItem->pSibLeft || pItem->pSibRight)
+    {
+        LPTVITEM pChild = pItem->pSibLeft;
+        if(!pChild || (pItem->pSibRight && pItem->pSibRight->uSibPriority > pChild->uSibPriority))
+            pChild = pItem->pSibRight;
+        SibRotateUp(pRoot,pChild);
+    }
+    LPTVITEM pParent = pItem->pSibParent;
+    if(!pParent) pRoot = NULL;
+    else if(pParent->pSibLeft == pItem) pParent->pSibLeft = NULL;
+    else pParent->pSibRight = NULL;
+    pItem->pSibParent = NULL;
+    SibUpdate(pParent);
+}
+
+//同一层中排在pItem前面的兄弟节点占用的行数
+static int SibRowsBefore(LPTVITEM pItem)
+{
+    int nRows = SibRows(pItem->pSibLeft);
+    for(LPTVITEM pParent = pItem->pSibParent; pParent; pItem = pParent, pParent = pParent->pSibParent)
+    {
+        if(pParent->pSibRight == pItem)
+            nRows += pParent->nSibRows - SibRows(pItem);//父节点的左子树及父节点自身
+    }
+    return nRows;
+}
+
+//查找iRow行所在的兄弟节点, 返回时iRow为该行相对于节点自身的偏移
+static LPTVITEM SibFind(LPTVITEM pItem,int & iRow)
+{
+    while(pItem)
+    {
+        int nLeft = SibRows(pItem->pSibLeft);
+        if(iRow < nLeft)
+        {
+            pItem = pItem->pSibLeft;
+            continue;
+        }
+        iRow -= nLeft;
+        int nSelf = pItem->nSibRows - nLeft - SibRows(pItem->pSibRight);
+        if(iRow < nSelf) return pItem;
+        iRow -= nSelf;
+        pItem = pItem->pSibRight;
+    }
+    return NULL;
+}
+
 STreeCtrl::STreeCtrl()
 : m_nItemHei(20)
 , m_nIndent(18)
@@ -28,6 +163,8 @@ STreeCtrl::STreeCtrl()
 , m_crItemSelText(RGBA(255,255,255,255))
 , m_nVisibleItems(0)
 , m_nMaxItemWidth(0)
+, m_pSibRoot(NULL)
+, m_uSibSeed(0x9E3779B9)
 , m_bCheckBox(FALSE)
 , m_bRightClickSel(FALSE)
 , m_uItemMask(0)
@@ -86,6 +223,8 @@ BOOL STreeCtrl::RemoveItem(HSTREEITEM hItem)
     BOOL bVisible=pItem->bVisible;
     int nItemWidth =GetMaxItemWidth(hItem);
     int nCheckBoxValue = pItem->nCheckBoxValue;
+    SibRemove(GetSibRoot(hParent),pItem);
+    UpdateChildRows(hParent,-GetItemRows(pItem));
     if(bVisible)
     {
         if(GetChildItem(hItem) && pItem->bCollapsed==FALSE)
@@ -134,6 +273,7 @@ BOOL STreeCtrl::RemoveItem(HSTREEITEM hItem)
 void STreeCtrl::RemoveAllItems()
 {
     DeleteAllItems();
+    m_pSibRoot=NULL;
     m_nVisibleItems=0;
     m_hSelItem=NULL;
     m_hHoverItem=NULL;
@@ -326,6 +466,9 @@ BOOL STreeCtrl::Expand(HSTREEITEM hItem , UINT nCode)
         }
         if(bRet)
         {
+            SibUpdate(pItem);
+            UpdateChildRows(GetParentItem(hItem),pItem->bCollapsed?-pItem->nChildRows:pItem->nChildRows);
+
             EventTCExpand evt(this);
             evt.hItem=hItem;
             evt.bCollapsed=pItem->bCollapsed;
@@ -455,6 +598,17 @@ HSTREEITEM STreeCtrl::InsertItem(LPTVITEM pItemObj,HSTREEITEM hParent,HSTREEITEM
 
     HSTREEITEM hRet= CSTree<LPTVITEM>::InsertItem(pItemObj,hParent,hInsertAfter);
     pItemObj->hItem = hRet;
+    if(hRet)
+    {
+        //xorshift生成随机优先级
+        m_uSibSeed ^= m_uSibSeed<<13;
+        m_uSibSeed ^= m_uSibSeed>>17;
+        m_uSibSeed ^= m_uSibSeed<<5;
+        pItemObj->uSibPriority = m_uSibSeed;
+        HSTREEITEM hPrev = GetPrevSiblingItem(hRet);
+        SibInsert(GetSibRoot(hParent),hPrev?GetItem(hPrev):NULL,pItemObj);
+    }
+    UpdateChildRows(hParent,GetItemRows(pItemObj));
     OnInsertItem(pItemObj);
     
     if(pItemObj->bVisible)
@@ -689,30 +843,108 @@ int  STreeCtrl::GetMaxItemWidth()
     return m_nMaxItemWidth;
 }
 
-int STreeCtrl::GetItemShowIndex(HSTREEITEM hItemObj)
+int STreeCtrl::GetItemRows(const LPTVITEM pItem)
 {
-    int iVisible=-1;
-    HSTREEITEM hItem=GetNextItem(STVI_ROOT);
-    while(hItem)
+    return 1 + (pItem->bCollapsed?0:pItem->nChildRows);
+}
+
+//节点的行数变化后更新祖先节点的nChildRows,遇到折叠的祖先即可停止
+void STreeCtrl::UpdateChildRows(HSTREEITEM hParent,int nDelta)
+{
+    while(nDelta && hParent && hParent!=STVI_ROOT)
     {
-        LPTVITEM pItem=GetItem(hItem);
-        if(pItem->bVisible) iVisible++;
-        if(hItem==hItemObj)
+        LPTVITEM pParent=GetItem(hParent);
+        pParent->nChildRows += nDelta;
+        if(pParent->bCollapsed) break;
+        SibUpdate(pParent);//展开的祖先节点自身的行数也随之变化
+        hParent=GetParentItem(hParent);
+    }
+}
+
+LPTVITEM & STreeCtrl::GetSibRoot(HSTREEITEM hParent)
+{
+    if(!hParent || hParent==STVI_ROOT) return m_pSibRoot;
+    return GetItem(hParent)->pSibRoot;
+}
+
+//按兄弟顺序重建hParent下所有层次的treap, 用于排序之后, O(N)
+void STreeCtrl::RebuildSibIndex(HSTREEITEM hParent)
+{
+    SArray<LPTVITEM> stack;
+    HSTREEITEM hChild=GetChildItem(hParent);
+    while(hChild)
+    {//按顺序插入笛卡尔树: 保持原有优先级, 右链上优先级较低的节点成为新节点的左子树
+        LPTVITEM pItem=GetItem(hChild);
+        pItem->pSibParent=pItem->pSibLeft=pItem->pSibRight=NULL;
+        LPTVITEM pLast=NULL;
+        while(!stack.IsEmpty() && stack[stack.GetCount()-1]->uSibPriority < pItem->uSibPriority)
         {
-            return iVisible;
+            pLast=stack[stack.GetCount()-1];
+            stack.RemoveAt(stack.GetCount()-1);
         }
-        if(pItem->bCollapsed)
-        {//跳过被折叠的项
-            HSTREEITEM hChild= GetChildItem(hItem,FALSE);
-            while(hChild)
-            {
-                hItem=hChild;
-                hChild= GetChildItem(hItem,FALSE);
-            }
+        pItem->pSibLeft=pLast;
+        if(pLast) pLast->pSibParent=pItem;
+        if(!stack.IsEmpty())
+        {
+            LPTVITEM pTop=stack[stack.GetCount()-1];
+            pTop->pSibRight=pItem;
+            pItem->pSibParent=pTop;
         }
-        hItem=GetNextItem(hItem);
+        stack.Add(pItem);
+        if(GetChildItem(hChild)) RebuildSibIndex(hChild);
+        hChild=GetNextSiblingItem(hChild);
+    }
+    LPTVITEM pRoot=stack.IsEmpty()?NULL:stack[0];
+    SibPullTree(pRoot);
+    GetSibRoot(hParent)=pRoot;
+}
+
+int STreeCtrl::GetItemShowIndex(HSTREEITEM hItemObj)
+{
+    if(!hItemObj || !GetItem(hItemObj)->bVisible) return -1;
+    //累加每一层前面兄弟节点的行数, 每层在treap中向上回溯
+    int iVisible=0;
+    HSTREEITEM hItem=hItemObj;
+    while(hItem)
+    {
+        iVisible += SibRowsBefore(GetItem(hItem));
+        hItem=GetParentItem(hItem);
+        if(hItem) iVisible++;
     }
-    return -1;
+    return iVisible;
+}
+
+HSTREEITEM STreeCtrl::GetItemByShowIndex(int iShowIndex) const
+{
+    if(iShowIndex<0 || iShowIndex>=m_nVisibleItems) return NULL;
+    LPTVITEM pRoot=m_pSibRoot;
+    while(pRoot)
+    {
+        LPTVITEM pItem=SibFind(pRoot,iShowIndex);
+        if(!pItem) break;
+        if(iShowIndex==0) return pItem->hItem;
+        //目标在当前节点的子树中
+        iShowIndex--;
+        pRoot=pItem->pSibRoot;
+    }
+    return NULL;
+}
+
+HSTREEITEM STreeCtrl::GetNextShowItem(HSTREEITEM hItem) const
+{
+    LPTVITEM pItem=CSTree<LPTVITEM>::GetItem(hItem);
+    if(!pItem->bCollapsed)
+    {
+        HSTREEITEM hChild=GetChildItem(hItem);
+        if(hChild) return hChild;
+    }
+    while(hItem)
+    {
+        HSTREEITEM hNext=GetNextSiblingItem(hItem);
+        if(hNext) return hNext;
+        hItem=GetParentItem(hItem);
+    }
+    return NULL;
 }
 
 BOOL STreeCtrl::GetItemRect( LPTVITEM pItemObj,CRect &rcItem )
@@ -724,32 +956,13 @@ BOOL STreeCtrl::GetItemRect( LPTVITEM pItemObj,CRect &rcItem )
     int iFirstVisible=m_ptOrigin.y/m_nItemHei;
     int nPageItems=(rcClient.Height()+m_nItemHei-1)/m_nItemHei+1;
 
-    int iVisible=-1;
-    HSTREEITEM hItem=CSTree<LPTVITEM>::GetNextItem(STVI_ROOT);
-    while(hItem)
-    {
-        LPTVITEM pItem=CSTree<LPTVITEM>::GetItem(hItem);
-        if(pItem->bVisible) iVisible++;
-        if(iVisible > iFirstVisible+nPageItems) break;
-        if(iVisible>=iFirstVisible && pItem==pItemObj)
-        {
-            CRect rcRet(m_nIndent*pItemObj->nLevel,0,rcClient.Width(),m_nItemHei);
-            rcRet.OffsetRect(rcClient.left-m_ptOrigin.x,rcClient.top-m_ptOrigin.y+iVisible*m_nItemHei);
-            rcItem=rcRet;
-            return TRUE;
-        }
-        if(pItem->bCollapsed)
-        {//跳过被折叠的项
-            HSTREEITEM hChild= GetChildItem(hItem,FALSE);
-            while(hChild)
-            {
-                hItem=hChild;
-                hChild= GetChildItem(hItem,FALSE);
-            }
-        }
-        hItem=CSTree<LPTVITEM>::GetNextItem(hItem);
-    }
-    return FALSE;
+    int iVisible=GetItemShowIndex(pItemObj->hItem);
+    if(iVisible<iFirstVisible || iVisible>iFirstVisible+nPageItems) return FALSE;
+
+    CRect rcRet(m_nIndent*pItemObj->nLevel,0,rcClient.Width(),m_nItemHei);
+    rcRet.OffsetRect(rcClient.left-m_ptOrigin.x,rcClient.top-m_ptOrigin.y+iVisible*m_nItemHei);
+    rcItem=rcRet;
+    return TRUE;
 }
 
 //自动修改pt的位置为相对当前项的偏移量
@@ -762,33 +975,14 @@ HSTREEITEM STreeCtrl::HitTest(CPoint &pt)
     int iItem=pt2.y/m_nItemHei;
     if( iItem >= m_nVisibleItems) return NULL;
 
-    HSTREEITEM hRet=NULL;
-
-    int iVisible=-1;
-    HSTREEITEM hItem=CSTree<LPTVITEM>::GetNextItem(STVI_ROOT);
-    while(hItem)
+    HSTREEITEM hRet=GetItemByShowIndex(iItem);
+    if(hRet)
     {
-        LPTVITEM pItem=CSTree<LPTVITEM>::GetItem(hItem);
-        if(pItem->bVisible) iVisible++;
-        if(iVisible == iItem)
-        {
-            CRect rcItem(m_nIndent*pItem->nLevel,0,rcClient.Width(),m_nItemHei);
-            rcItem.OffsetRect(rcClient.left-m_ptOrigin.x,rcClient.top-m_ptOrigin.y+iVisible*m_nItemHei);
-            pt-=rcItem.TopLeft();
-            hRet=hItem;
-            break;
-        }
-        if(pItem->bCollapsed)
-        {//跳过被折叠的项
-            HSTREEITEM hChild= GetChildItem(hItem,FALSE);
-            while(hChild)
-            {
-                hItem=hChild;
-                hChild= GetChildItem(hItem,FALSE);
-            }
-        }
-        hItem=CSTree<LPTVITEM>::GetNextItem(hItem);
-    }        
+        LPTVITEM pItem=CSTree<LPTVITEM>::GetItem(hRet);
+        CRect rcItem(m_nIndent*pItem->nLevel,0,rcClient.Width(),m_nItemHei);
+        rcItem.OffsetRect(rcClient.left-m_ptOrigin.x,rcClient.top-m_ptOrigin.y+iItem*m_nItemHei);
+        pt-=rcItem.TopLeft();
+    }
     return hRet;
 }
 
@@ -1173,31 +1367,19 @@ void STreeCtrl::OnPaint(IRenderTarget *pRT)
     int iFirstVisible=m_ptOrigin.y/m_nItemHei;
     int nPageItems=(m_rcClient.Height()+m_nItemHei-1)/m_nItemHei+1;
 
-    int iVisible=-1;
-    HSTREEITEM hItem=CSTree<LPTVITEM>::GetNextItem(STVI_ROOT);
-    while(hItem)
+    //直接定位第一个可见行，只遍历可见的节点
+    int iVisible=iFirstVisible;
+    HSTREEITEM hItem=GetItemByShowIndex(iFirstVisible);
+    while(hItem && iVisible <= iFirstVisible+nPageItems)
     {
         LPTVITEM pItem=CSTree<LPTVITEM>::GetItem(hItem);
-        if(pItem->bVisible) iVisible++;
-        if(iVisible > iFirstVisible+nPageItems) break;
-        if(iVisible>=iFirstVisible)
-        {
-            CRect rcItem(0,0,CalcItemWidth(pItem),m_nItemHei);
-            rcItem.OffsetRect(rcClient.left-m_ptOrigin.x,
-                rcClient.top-m_ptOrigin.y+iVisible*m_nItemHei);
-			DrawLines(pRT, rcItem, hItem);
-            DrawItem(pRT,rcItem,hItem);
-        }
-        if(pItem->bCollapsed)
-        {//跳过被折叠的项
-            HSTREEITEM hChild= GetChildItem(hItem,FALSE);
-            while(hChild)
-            {
-                hItem=hChild;
-                hChild= GetChildItem(hItem,FALSE);
-            }
-        }
-        hItem=CSTree<LPTVITEM>::GetNextItem(hItem);
+        CRect rcItem(0,0,CalcItemWidth(pItem),m_nItemHei);
+        rcItem.OffsetRect(rcClient.left-m_ptOrigin.x,
+            rcClient.top-m_ptOrigin.y+iVisible*m_nItemHei);
+		DrawLines(pRT, rcItem, hItem);
+        DrawItem(pRT,rcItem,hItem);
+        iVisible++;
+        hItem=GetNextShowItem(hItem);
     }
     AfterPaint(pRT,painter);
 }
@@ -1326,6 +1508,7 @@ void STreeCtrl::SortChildren(HSTREEITEM hItem,FunSortCallback sortFunc,void *pCt
     m_hHoverItem = NULL;
     m_hCaptureItem = NULL;
     CSTree<LPTVITEM>::SortChildren(hItem,sortFunc,pCtx);
+    RebuildSibIndex(hItem);
 }
 
 BOOL STreeCtrl::VerifyItem(HSTREEITEM hItem) const
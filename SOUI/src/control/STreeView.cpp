@@ -23,6 +23,16 @@ namespace SOUI
         {
             m_pOwner->onBranchExpandedChanged(hBranch,bExpandedOld,bExpandedNew);
         }
+
+        virtual void onItemInserted(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            m_pOwner->onItemInserted(hParent,hItem);
+        }
+
+        virtual void onItemRemoved(HTREEITEM hParent,HTREEITEM hItem)
+        {
+            m_pOwner->onItemRemoved(hParent,hItem);
+        }
 	protected:
 		STreeView * m_pOwner;
 	};
@@ -382,6 +392,59 @@ namespace SOUI
         _UpdateSiblingsOffset(hItem);
     }
 
+    void STreeViewItemLocator::OnItemInserted(HTREEITEM hParent,HTREEITEM hItem)
+    {
+        //只初始化新节点自身的分枝，兄弟节点的数据保持不变
+        _InitBranch(hItem);
+        _UpdateChildren(hParent);
+    }
+
+    void STreeViewItemLocator::OnItemRemoved(HTREEITEM hParent)
+    {
+        _UpdateChildren(hParent);
+    }
+
+    void STreeViewItemLocator::_UpdateChildren(HTREEITEM hParent)
+    {
+        int nIndent = hParent==ITvAdapter::ITEM_ROOT?0:m_nIndent;
+        int nBranchWidOld = _GetBranchWidth(hParent);
+        int nVisibleHeiOld = _GetItemVisibleHeight(hParent);
+        int nVisibleWidOld = GetItemWidth(hParent);
+        if(nBranchWidOld != 0) nVisibleWidOld = smax(nVisibleWidOld,nBranchWidOld + nIndent);
+
+        //重新计算直接子节点的偏移，子节点内部的数据不受影响
+        int nBranchHei = 0, nBranchWid = 0;
+        HTREEITEM hChild = m_adapter->GetFirstChildItem(hParent);
+        while(hChild != ITvAdapter::ITEM_NULL)
+        {
+            _SetItemOffset(hChild,nBranchHei);
+            nBranchHei += _GetItemVisibleHeight(hChild);
+            nBranchWid = smax(nBranchWid,_GetItemVisibleWidth(hChild));
+            hChild = m_adapter->GetNextSiblingItem(hChild);
+        }
+        _SetBranchHeight(hParent,nBranchHei);
+        _SetBranchWidth(hParent,nBranchWid==0?0:nBranchWid + nIndent);
+
+        if(hParent == ITvAdapter::ITEM_ROOT || !IsItemExpanded(hParent))
+            return;//折叠的节点显示尺寸不变
+
+        int nDiff = _GetItemVisibleHeight(hParent) - nVisibleHeiOld;
+        if(nDiff != 0)
+        {
+            HTREEITEM hAncestor = m_adapter->GetParentItem(hParent);
+            while(hAncestor != ITvAdapter::ITEM_NULL)
+            {
+                _SetBranchHeight(hAncestor,_GetBranchHeight(hAncestor)+nDiff);
+                if(!IsItemExpanded(hAncestor)) break;
+                hAncestor = m_adapter->GetParentItem(hAncestor);
+            }
+            _UpdateSiblingsOffset(hParent);
+        }
+        int nVisibleWidNew = _GetItemVisibleWidth(hParent);
+        if(nVisibleWidNew != nVisibleWidOld)
+            _UpdateBranchWidth(hParent,nVisibleWidOld,nVisibleWidNew);
+    }
+
 	//////////////////////////////////////////////////////////////////////////
 	STreeView::STreeView()
 		: m_itemCapture(NULL)
@@ -1034,6 +1097,29 @@ namespace SOUI
         UpdateVisibleItems();
     }
 
+    void STreeView::onItemInserted(HTREEITEM hParent,HTREEITEM hItem)
+    {
+        if (m_adapter == NULL)
+        {
+            return; 
+        }
+        if(m_tvItemLocator) m_tvItemLocator->OnItemInserted(hParent,hItem);
+        UpdateScrollBar();
+        UpdateVisibleItems();
+    }
+
+    void STreeView::onItemRemoved(HTREEITEM hParent,HTREEITEM hItem)
+    {
+        if (m_adapter == NULL)
+        {
+            return; 
+        }
+        if(m_hSelected == hItem) m_hSelected = ITvAdapter::ITEM_NULL;
+        if(m_tvItemLocator) m_tvItemLocator->OnItemRemoved(hParent);
+        UpdateScrollBar();
+        UpdateVisibleItems();
+    }
+
 	
 	LRESULT STreeView::OnMouseEvent( UINT uMsg,WPARAM wParam,LPARAM lParam )
 	{
@@ -0,0 +1,168 @@
+﻿#include "souistd.h"
+#include "core/SIdleScheduler.h"
+
+namespace SOUI
+{
+    static const DWORD KDefSliceTime = 50;
+
+    //////////////////////////////////////////////////////////////////////////
+    SIdleDeadline::SIdleDeadline(DWORD dwBudget,BOOL bTimeout):m_bTimeout(bTimeout)
+    {
+        LARGE_INTEGER freq,now;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&now);
+        m_llFreq = freq.QuadPart;
+        m_llEnd = now.QuadPart + m_llFreq * dwBudget / 1000;
+    }
+
+    DWORD SIdleDeadline::TimeRemaining() const
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        if(now.QuadPart >= m_llEnd) return 0;
+        return (DWORD)((m_llEnd - now.QuadPart) * 1000 / m_llFreq);
+    }
+
+    BOOL SIdleDeadline::HasPendingInput() const
+    {
+        return HIWORD(GetQueueStatus(QS_INPUT)) != 0;
+    }
+
+    BOOL SIdleDeadline::ShouldYield() const
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return now.QuadPart >= m_llEnd || HasPendingInput();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    SIdleScheduler::SIdleScheduler():m_iNext(0),m_nTimeouts(0),m_dwSliceTime(KDefSliceTime)
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    void SIdleScheduler::ResetStats()
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    int SIdleScheduler::FindTask(IIdleTask *pTask) const
+    {
+        for(UINT i=0;i<m_arrTasks.GetCount();i++)
+        {
+            if(m_arrTasks[i].pTask == pTask) return i;
+        }
+        return -1;
+    }
+
+    BOOL SIdleScheduler::AddTask(IIdleTask *pTask,DWORD dwTimeout)
+    {
+        if(FindTask(pTask) != -1) return FALSE;
+        TaskInfo info = {pTask,0};
+        if(dwTimeout != INFINITE)
+        {
+            info.dwTimeoutAt = GetTickCount() + dwTimeout;
+            if(info.dwTimeoutAt == 0) info.dwTimeoutAt = 1;
+            m_nTimeouts ++;
+        }
+        m_arrTasks.Add(info);
+        return TRUE;
+    }
+
+    BOOL SIdleScheduler::RemoveTask(IIdleTask *pTask)
+    {
+        int idx = FindTask(pTask);
+        if(idx == -1) return FALSE;
+        if(m_arrTasks[idx].dwTimeoutAt) m_nTimeouts --;
+        m_arrTasks.RemoveAt(idx);
+        if(idx < m_iNext) m_iNext --;
+        return TRUE;
+    }
+
+    BOOL SIdleScheduler::RunTask(int iTask,const SIdleDeadline & deadline)
+    {
+        IIdleTask *pTask = m_arrTasks[iTask].pTask;
+        if(m_arrTasks[iTask].dwTimeoutAt)
+        {//任务已经被调用，超时不再有效
+            m_arrTasks[iTask].dwTimeoutAt = 0;
+            m_nTimeouts --;
+        }
+        m_stats.nRuns ++;
+        BOOL bMore = pTask->RunIdle(deadline);
+        //任务执行时可能增删了任务，重新查找
+        if(!bMore) RemoveTask(pTask);
+        return bMore && FindTask(pTask) != -1;
+    }
+
+    BOOL SIdleScheduler::RunIdle()
+    {
+        if(m_arrTasks.IsEmpty()) return FALSE;
+
+        LARGE_INTEGER freq,start,end;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
+        SIdleDeadline deadline(m_dwSliceTime,FALSE);
+        m_stats.nSlices ++;
+        m_stats.ullGranted += (ULONGLONG)m_dwSliceTime * 1000;
+
+        //轮流调用各个任务直到时间片用完或者有输入
+        while(!m_arrTasks.IsEmpty())
+        {
+            if(deadline.HasPendingInput())
+            {
+                m_stats.nInputYields ++;
+                break;
+            }
+            if(deadline.TimeRemaining() == 0) break;
+            if(m_iNext >= (int)m_arrTasks.GetCount()) m_iNext = 0;
+            IIdleTask *pTask = m_arrTasks[m_iNext].pTask;
+            if(RunTask(m_iNext,deadline))
+                m_iNext = FindTask(pTask) + 1;
+        }
+
+        QueryPerformanceCounter(&end);
+        m_stats.ullUsed += (ULONGLONG)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart);
+        return !m_arrTasks.IsEmpty();
+    }
+
+    void SIdleScheduler::RunExpired()
+    {
+        if(m_nTimeouts == 0) return;
+        DWORD dwNow = GetTickCount();
+        SIdleDeadline deadline(0,TRUE);
+        for(int i=0;i<(int)m_arrTasks.GetCount();)
+        {
+            DWORD dwTimeoutAt = m_arrTasks[i].dwTimeoutAt;
+            //GetTickCount回绕后用差值比较
+            if(dwTimeoutAt == 0 || (LONG)(dwNow - dwTimeoutAt) < 0)
+            {
+                i++;
+                continue;
+            }
+            IIdleTask *pTask = m_arrTasks[i].pTask;
+            m_stats.nTimeouts ++;
+            if(RunTask(i,deadline))
+                i = FindTask(pTask) + 1;
+            else
+                i = 0;//任务列表已经变化，从头检查
+            if(m_nTimeouts == 0) break;
+        }
+    }
+
+    BOOL SIdleScheduler::GetNextTimeout(DWORD & dwTimeoutAt) const
+    {
+        if(m_nTimeouts == 0) return FALSE;
+        BOOL bFound = FALSE;
+        for(UINT i=0;i<m_arrTasks.GetCount();i++)
+        {
+            DWORD dwAt = m_arrTasks[i].dwTimeoutAt;
+            if(dwAt == 0) continue;
+            if(!bFound || (LONG)(dwAt - dwTimeoutAt) < 0)
+            {
+                dwTimeoutAt = dwAt;
+                bFound = TRUE;
+            }
+        }
+        return bFound;
+    }
+}
@@ -338,6 +338,16 @@ IScriptModule * SItemPanel::GetScriptModule()
     return m_pFrmHost->GetContainer()->GetScriptModule();
 }
 
+SFrameProfiler * SItemPanel::GetProfiler()
+{
+    return m_pFrmHost->GetContainer()->GetProfiler();
+}
+
+BOOL SItemPanel::IsOcclusionCulling()
+{
+    return m_pFrmHost->GetContainer()->IsOcclusionCulling();
+}
+
 void SItemPanel::FrameToHost(RECT & rc) const
 {
     CRect rcItem = GetItemRect();
@@ -18,6 +18,7 @@ namespace SOUI
 	}
 
 	SMessageLoop::SMessageLoop() :m_bRunning(FALSE),m_tid(0)
+		,m_bIdleResumePosted(FALSE),m_uIdleTimer(0),m_dwIdleTimerAt(0)
 	{
 
 	}
@@ -65,12 +66,14 @@ namespace SOUI
 					pRunnable->destroy();
 				}
 			}
+			m_idleScheduler.RunExpired();
             while(bDoIdle && !::PeekMessage(&m_msg, NULL, 0, 0, PM_NOREMOVE))
             {
                 if(!OnIdle(nIdleCount++))
                     bDoIdle = FALSE;
 				if (m_bQuit) goto exit_loop;
             }
+            UpdateIdleTimer();
 
             bRet = ::GetMessage(&m_msg, NULL, 0, 0);
 
@@ -85,17 +88,31 @@ namespace SOUI
                 break;   // WM_QUIT, exit message loop
             }
             
-            OnMsg(&m_msg);
-
-            if(IsIdleMessage(&m_msg))
-            {
+            if(IsIdleSchedulerMsg(&m_msg))
+            {//继续上次的空闲处理，不重置nIdleCount
+                if(m_msg.message == WM_NULL) m_bIdleResumePosted = FALSE;
                 bDoIdle = TRUE;
-                nIdleCount = 0;
+            }
+            else
+            {
+                OnMsg(&m_msg);
+
+                if(IsIdleMessage(&m_msg))
+                {
+                    bDoIdle = TRUE;
+                    nIdleCount = 0;
+                }
             }
 			if (m_bQuit) break;
         }
 
 	exit_loop:
+		if(m_uIdleTimer)
+		{
+			::KillTimer(NULL,m_uIdleTimer);
+			m_uIdleTimer = 0;
+		}
+		m_bIdleResumePosted = FALSE;
 		{
 			SAutoLock lock(m_cs);
 			SPOSITION pos = m_runnables.GetHeadPosition();
@@ -110,15 +127,59 @@ namespace SOUI
         return (int)m_msg.wParam;
     }
 
-    BOOL SMessageLoop::OnIdle( int /*nIdleCount*/ )
+    BOOL SMessageLoop::OnIdle( int nIdleCount )
+    {
+        //空闲调度的消息不重置nIdleCount，idle handler每次空闲只调用一次
+        if(nIdleCount == 0)
+        {
+            for(size_t i = 0; i < m_aIdleHandler.GetCount(); i++)
+            {
+                IIdleHandler* pIdleHandler = m_aIdleHandler[i];
+                if(pIdleHandler != NULL)
+                    pIdleHandler->OnIdle();
+            }
+        }
+        //每次只执行一个时间片，还有任务时投递消息，消息循环先处理队列中已有的消息再继续
+        if(m_idleScheduler.RunIdle())
+            PostIdleResume();
+        return FALSE;
+    }
+
+    void SMessageLoop::PostIdleResume()
+    {
+        if(m_bIdleResumePosted || m_tid == 0) return;
+        //lParam为消息循环对象，用来区分其它的WM_NULL
+        if(PostThreadMessage(m_tid,WM_NULL,0,(LPARAM)this))
+            m_bIdleResumePosted = TRUE;
+    }
+
+    void SMessageLoop::UpdateIdleTimer()
     {
-        for(size_t i = 0; i < m_aIdleHandler.GetCount(); i++)
+        DWORD dwTimeoutAt = 0;
+        if(m_idleScheduler.GetNextTimeout(dwTimeoutAt))
+        {
+            if(m_uIdleTimer && dwTimeoutAt == m_dwIdleTimerAt) return;
+            DWORD dwWait = dwTimeoutAt - GetTickCount();
+            if((LONG)dwWait < USER_TIMER_MINIMUM) dwWait = USER_TIMER_MINIMUM;
+            //定时器是周期的，时钟精度导致触发时任务还没有超时的话下个周期会再次触发
+            m_uIdleTimer = ::SetTimer(NULL,m_uIdleTimer,dwWait,NULL);
+            m_dwIdleTimerAt = dwTimeoutAt;
+        }
+        else if(m_uIdleTimer)
         {
-            IIdleHandler* pIdleHandler = m_aIdleHandler[i];
-            if(pIdleHandler != NULL)
-                pIdleHandler->OnIdle();
+            ::KillTimer(NULL,m_uIdleTimer);
+            m_uIdleTimer = 0;
         }
-        return FALSE;   // don't continue
+    }
+
+    BOOL SMessageLoop::IsIdleSchedulerMsg(const MSG *pMsg) const
+    {
+        if(pMsg->hwnd != NULL) return FALSE;
+        if(pMsg->message == WM_NULL)
+            return pMsg->lParam == (LPARAM)this;
+        if(pMsg->message == WM_TIMER)
+            return m_uIdleTimer != 0 && pMsg->wParam == m_uIdleTimer;
+        return FALSE;
     }
 
     BOOL SMessageLoop::PreTranslateMessage( MSG* pMsg )
@@ -164,6 +225,23 @@ namespace SOUI
         return RemoveElementFromArray(m_aMsgFilter,pMessageFilter);
     }
 
+    BOOL SMessageLoop::AddIdleTask( IIdleTask* pTask, DWORD dwTimeout )
+    {
+        //调度器没有加锁，只能在消息循环线程中访问，其它线程请用PostTask转到消息循环线程
+        SASSERT(m_tid == 0 || m_tid == GetCurrentThreadId());
+        if(!m_idleScheduler.AddTask(pTask,dwTimeout))
+            return FALSE;
+        //消息循环可能已经停止空闲处理，投递一个消息重新开始
+        PostIdleResume();
+        return TRUE;
+    }
+
+    BOOL SMessageLoop::RemoveIdleTask( IIdleTask* pTask )
+    {
+        SASSERT(m_tid == 0 || m_tid == GetCurrentThreadId());
+        return m_idleScheduler.RemoveTask(pTask);
+    }
+
     BOOL SMessageLoop::AddMessageFilter( IMessageFilter* pMessageFilter )
     {
         m_aMsgFilter.Add(pMessageFilter);
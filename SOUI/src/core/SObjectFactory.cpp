@@ -20,12 +20,15 @@ SObjectFactoryMgr::SObjectFactoryMgr(void)
 //************************************
 bool SObjectFactoryMgr::RegisterFactory(SObjectFactory & objFactory, bool bReplace)
 {
-	if (HasKey(objFactory.GetObjectInfo()))
+	SObjectInfo objInfo = objFactory.GetObjectInfo();
+	if (HasKey(objInfo))
 	{
 		if (!bReplace) return false;
-		RemoveKeyObject(objFactory.GetObjectInfo());
+		RemoveKeyObject(objInfo);
 	}
-	AddKeyObject(objFactory.GetObjectInfo(), objFactory.Clone());
+	//只有注册的类名进入驻留表
+	objInfo.Intern();
+	AddKeyObject(objInfo, objFactory.Clone());
 	return true;
 }
 
@@ -20,8 +20,9 @@ SSkinImgList::SSkinImgList()
 	, m_filterLevel(kNone_FilterLevel)
 	, m_bAutoFit(TRUE)
 	, m_bLazyLoad(FALSE)
+	, m_nOpaque(-1)
 {
-	
+	m_szDecode.cx = m_szDecode.cy = 0;
 }
 
 SSkinImgList::~SSkinImgList()
@@ -49,10 +50,23 @@ void SSkinImgList::OnInitFinished(pugi::xml_node xmlNode)
 {
 	if (!m_bLazyLoad && !m_strSrc.IsEmpty())
 	{
-		m_pImg.Attach(LOADIMAGE2(m_strSrc));
+		m_pImg.Attach(_LoadImage());
 	}
 }
 
+IBitmap * SSkinImgList::_LoadImage() const
+{
+	if (m_szDecode.cx <= 0 || m_szDecode.cy <= 0)
+		return LOADIMAGE2(m_strSrc);
+	//decodeSize是单个子图的大小
+	SIZE szDecode = m_szDecode;
+	if (m_bVertical)
+		szDecode.cy *= m_nStates;
+	else
+		szDecode.cx *= m_nStates;
+	return SApplication::getSingleton().LoadImage2(m_strSrc, szDecode);
+}
+
 void SSkinImgList::_DrawByIndex(IRenderTarget *pRT, LPCRECT rcDraw, int iState, BYTE byAlpha) const
 {
 	if(!GetImage()) return;
@@ -76,9 +90,10 @@ UINT SSkinImgList::GetExpandMode() const
 LRESULT SSkinImgList::OnAttrSrc(const SStringW& value, BOOL bLoading)
 {
 	m_strSrc = value;
+	m_nOpaque = -1;
 	if (!bLoading)
 	{
-		m_pImg.Attach(LOADIMAGE2(m_strSrc));
+		m_pImg.Attach(_LoadImage());
 	}
 	return S_OK;
 }
@@ -88,6 +103,7 @@ bool SSkinImgList::SetImage(IBitmap* pImg)
 	m_pImg = pImg;
 	m_strSrc.Empty();
 	m_bLazyLoad = FALSE;
+	m_nOpaque = -1;
 	return true;
 }
 
@@ -97,7 +113,7 @@ IBitmap* SSkinImgList::GetImage() const
 		return m_pImg;
 	if (m_bLazyLoad && !m_strSrc.IsEmpty())
 	{
-		m_pImg.Attach(LOADIMAGE2(m_strSrc));
+		m_pImg.Attach(_LoadImage());
 		m_strSrc.Empty();
 	}
 	return m_pImg;
@@ -129,6 +145,31 @@ void SSkinImgList::OnColorize(COLORREF cr)
 		m_imgBackup = NULL;//free backup
 }
 
+static BOOL _IsBitmapOpaque(IBitmap *pImg)
+{
+	const BYTE *pBits = (const BYTE*)pImg->GetPixelBits();
+	if(!pBits) return FALSE;
+	int nPixels = pImg->Width() * pImg->Height();
+	for(int i=0;i<nPixels;i++)
+	{
+		if(pBits[i*4+3] != 0xFF) return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL SSkinImgList::IsOpaque(int iState) const
+{
+	//不拉伸也不平铺时不能覆盖整个绘制区
+	if(GetAlpha() != 0xFF || LOWORD(GetExpandMode()) == EM_NULL) return FALSE;
+	IBitmap *pImg = GetImage();
+	if(!pImg) return FALSE;
+	if(m_nOpaque == -1)
+	{//只检查一次，图片变化时重置
+		m_nOpaque = _IsBitmapOpaque(pImg)?1:0;
+	}
+	return m_nOpaque == 1;
+}
+
 void SSkinImgList::_Scale(ISkinObj * skinObj, int nScale)
 {
 	__super::_Scale(skinObj,nScale);
@@ -376,6 +417,11 @@ ISkinObj * SSkinGradation::Scale(int nScale)
 	return NULL;
 }
 
+BOOL SSkinGradation::IsOpaque(int iState) const
+{
+    return GetAlpha() == 0xFF && GetAValue(m_crFrom) == 0xFF && GetAValue(m_crTo) == 0xFF;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // SScrollbarSkin
 SSkinScrollbar::SSkinScrollbar():m_nMargin(0),m_bHasGripper(FALSE),m_bHasInactive(FALSE)
@@ -537,6 +583,16 @@ ISkinObj * SSkinColorRect::Scale(int nScale)
 	return NULL;
 }
 
+BOOL SSkinColorRect::IsOpaque(int iState) const
+{
+	if(iState < 0 || iState > 3 || GetAlpha() != 0xFF) return FALSE;
+	//圆角之外的区域没有绘制
+	if(m_nRadius > 0 || m_fCornerPercent > 0.0) return FALSE;
+	if(m_crStates[iState] == CR_INVALID)
+		iState = 0;
+	return GetAValue(m_crStates[iState]) == 0xFF;
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -7,6 +7,8 @@
 #include "helper/SwndFinder.h"
 #include "helper/STime.h"
 #include "animation/STransformation.h"
+#include "helper/SRenderCacheMgr.h"
+#include "helper/SFrameProfiler.h"
 
 namespace SOUI
 {
@@ -64,6 +66,11 @@ namespace SOUI
 		, m_bCacheDirty(TRUE)
 		, m_layoutDirty(dirty_self)
 		, m_bLayeredWindow(FALSE)
+		, m_bDisplayList(FALSE)
+		, m_bDisplayListDirty(TRUE)
+		, m_bDisplayListFailed(FALSE)
+		, m_bRecording(FALSE)
+		, m_bXformInvalidating(FALSE)
 		, m_uData(0)
 		, m_pOwner(NULL)
 		, m_pCurMsg(NULL)
@@ -123,6 +130,7 @@ namespace SOUI
 			}
 		}
 #endif
+		_ReleaseCacheRT();
 		SWindowMgr::DestroyWindow(m_swnd);
 	}
 
@@ -942,33 +950,33 @@ namespace SOUI
 			CRect & rcRT = m_pGetRTData->rcRT;
 			pRT->AlphaBlend(rcRT,m_pGetRTData->rt,rcRT,255);
 		}
-		else if(IsDrawToCache())
+		else if(IsDrawToCache() && _PrepareCacheRT())
 		{
-			IRenderTarget *pRTCache=m_cachedRT;
-			if(pRTCache)
-			{//在窗口正在创建的时候进来pRTCache可能为NULL
-				CRect rcWnd=GetWindowRect();
-				pRTCache->SetViewportOrg(-rcWnd.TopLeft());
-				if(IsCacheDirty())
-				{
-					pRTCache->ClearRect(&rcWnd,0);
-					pRTCache->AlphaBlend(rcWnd,pRT,rcWnd,255);
+			//绘制过程中缓存可能被缓存管理器淘汰，保持一个引用
+			SAutoRefPtr<IRenderTarget> pRTCache=m_cachedRT;
+			CRect rcWnd=GetWindowRect();
+			pRTCache->SetViewportOrg(-rcWnd.TopLeft());
+			bool bDirty = IsCacheDirty();
+			SRenderCacheMgr::getSingleton().OnCachePainted(this,!bDirty);
+			if(bDirty)
+			{
+				pRTCache->ClearRect(&rcWnd,0);
+				pRTCache->AlphaBlend(rcWnd,pRT,rcWnd,255);
 
-					SAutoRefPtr<IFont> oldFont;
-					COLORREF crOld=pRT->GetTextColor();
-					pRTCache->SelectObject(pRT->GetCurrentObject(OT_FONT),(IRenderObj**)&oldFont);
-					pRTCache->SetTextColor(crOld);
+				SAutoRefPtr<IFont> oldFont;
+				COLORREF crOld=pRT->GetTextColor();
+				pRTCache->SelectObject(pRT->GetCurrentObject(OT_FONT),(IRenderObj**)&oldFont);
+				pRTCache->SetTextColor(crOld);
 
-					SSendMessage(WM_ERASEBKGND, (WPARAM)pRTCache);
-					SSendMessage(WM_PAINT, (WPARAM)pRTCache);
+				SSendMessage(WM_ERASEBKGND, (WPARAM)pRTCache);
+				SSendMessage(WM_PAINT, (WPARAM)pRTCache);
 
-					pRTCache->SelectObject(oldFont);
-					pRTCache->SetTextColor(crOld);
+				pRTCache->SelectObject(oldFont);
+				pRTCache->SetTextColor(crOld);
 
-					MarkCacheDirty(false);
-				}
-				pRT->AlphaBlend(rcWnd, pRTCache, rcWnd, 255);
+				MarkCacheDirty(false);
 			}
+			pRT->AlphaBlend(rcWnd, pRTCache, rcWnd, 255);
 		}else
 		{
 			SSendMessage(WM_ERASEBKGND, (WPARAM)pRT);
@@ -986,16 +994,13 @@ namespace SOUI
 		{
 			CRect & rcRT = m_pGetRTData->rcRT;
 			pRT->AlphaBlend(rcRT,m_pGetRTData->rt,rcRT,255);
-		}else if(IsDrawToCache())
+		}else if(IsDrawToCache() && m_cachedRT)
 		{
 			IRenderTarget *pRTCache=m_cachedRT;
-			if(pRTCache)
-			{
-				SSendMessage(WM_NCPAINT, (WPARAM)pRTCache);
-				pRT->PushClipRect(&rcClient,RGN_DIFF);
-				pRT->AlphaBlend(rcWnd,pRTCache,rcWnd,255);
-				pRT->PopClip();
-			}
+			SSendMessage(WM_NCPAINT, (WPARAM)pRTCache);
+			pRT->PushClipRect(&rcClient,RGN_DIFF);
+			pRT->AlphaBlend(rcWnd,pRTCache,rcWnd,255);
+			pRT->PopClip();
 		}else
 		{
 			SSendMessage(WM_NCPAINT, (WPARAM)pRT);
@@ -1084,11 +1089,100 @@ namespace SOUI
 	}
 
 
+	static inline bool RectContains(const CRect & rcOuter, const CRect & rcInner)
+	{
+		return rcInner.left >= rcOuter.left && rcInner.top >= rcOuter.top
+			&& rcInner.right <= rcOuter.right && rcInner.bottom <= rcOuter.bottom;
+	}
+
+	void SWindow::_GetOccludedChildren(IRegion *pRgn, UINT iBeginZorder, UINT iEndZorder, SArray<SWindow*> & arrOccluded)
+	{
+		//有变换时重绘区域和窗口坐标不一致，只比较兄弟窗口之间的覆盖关系
+		CRect rcBox;
+		BOOL bRgn = pRgn && !pRgn->IsEmpty() && _GetMatrixEx().isIdentity();
+		if(bRgn) pRgn->GetRgnBox(&rcBox);
+
+		SFrameProfiler *pProfiler = GetContainer()->GetProfiler();
+		//上面的不透明窗口的客户区及其外接矩形。大多数窗口不在外接矩形内或者被一个窗口完全覆盖，
+		//只用矩形就能判断，只有被几个窗口合起来覆盖时才需要区域运算，区域在第一次需要时创建
+		SArray<CRect> arrCover;
+		CRect rcCoverBox;
+		SAutoRefPtr<IRegion> rgnCover, rgnVisible;
+		for(SWindow *pChild = GetWindow(GSW_LASTCHILD); pChild; pChild = pChild->GetWindow(GSW_PREVSIBLING))
+		{
+			if(pChild->m_uZorder >= iEndZorder || !pChild->IsVisible(FALSE)) continue;
+			//变换后的位置和rect不一致，既不遮挡其它窗口也不被遮挡
+			if(pChild->GetTransformation().hasMatrix()) continue;
+			CRect rcWnd = pChild->GetWindowRect();
+			if(bRgn) rcWnd.IntersectRect(rcWnd,rcBox);
+			if(rcWnd.IsRectEmpty()) continue;
+
+			if(!arrCover.IsEmpty() && RectContains(rcCoverBox,rcWnd))
+			{
+				BOOL bOccluded = FALSE;
+				for(size_t i = 0; i < arrCover.GetCount() && !bOccluded; i++)
+				{
+					bOccluded = RectContains(arrCover[i],rcWnd);
+				}
+				if(!bOccluded && arrCover.GetCount() > 1)
+				{
+					if(!rgnCover)
+					{
+						GETRENDERFACTORY->CreateRegion(&rgnCover);
+						GETRENDERFACTORY->CreateRegion(&rgnVisible);
+						for(size_t i = 0; i < arrCover.GetCount(); i++)
+							rgnCover->CombineRect(&arrCover[i],RGN_OR);
+					}
+					rgnVisible->CombineRect(&rcWnd,RGN_COPY);
+					rgnVisible->CombineRgn(rgnCover,RGN_DIFF);
+					bOccluded = rgnVisible->IsEmpty();
+				}
+				if(bOccluded)
+				{
+					arrOccluded.Add(pChild);
+					if(pProfiler) pProfiler->OnWndCulled((UINT64)rcWnd.Width()*rcWnd.Height());
+					continue;
+				}
+			}
+			//客户区在本次绘制范围内且不透明地完全绘制时才能遮挡下面的窗口
+			if(pChild->m_uZorder >= iBeginZorder
+				&& !pChild->IsLayeredWindow()
+				&& !pChild->m_clipRgn && !pChild->m_clipPath
+				&& !pChild->m_pGetRTData
+				&& pChild->IsOpaque())
+			{
+				CRect rcClient = pChild->GetClientRect();
+				if(!rcClient.IsRectEmpty())
+				{
+					if(arrCover.IsEmpty())
+						rcCoverBox = rcClient;
+					else
+						rcCoverBox.UnionRect(rcCoverBox,rcClient);
+					arrCover.Add(rcClient);
+					if(rgnCover) rgnCover->CombineRect(&rcClient,RGN_OR);
+				}
+			}
+		}
+	}
+
 	void SWindow::_PaintChildren(IRenderTarget * pRT, IRegion *pRgn, UINT iBeginZorder, UINT iEndZorder) {
+		SArray<SWindow*> arrOccluded;
+		if(GetChildrenCount() > 1 && GetContainer()->IsOcclusionCulling())
+		{
+			_GetOccludedChildren(pRgn,iBeginZorder,iEndZorder,arrOccluded);
+		}
+		//arrOccluded是从上到下的顺序，从尾部开始匹配
+		int iOccluded = (int)arrOccluded.GetCount() - 1;
 		SWindow *pChild = GetWindow(GSW_FIRSTCHILD);
 		while (pChild)
 		{
 			if (pChild->m_uZorder >= iEndZorder) break;
+			if (iOccluded >= 0 && arrOccluded[iOccluded] == pChild)
+			{//被上面的不透明窗口完全覆盖，整个分枝都不用绘制
+				iOccluded--;
+				pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+				continue;
+			}
 			if (pChild->m_uZorder< iBeginZorder)
 			{//看整个分枝的zorder是不是在绘制范围内
 				SWindow *pNextChild = pChild->GetWindow(GSW_NEXTSIBLING);
@@ -1126,9 +1220,15 @@ namespace SOUI
 			return;
 
 		SMatrix oriMtx;
-		bool bMtx = _ApplyMatrix(pRT, oriMtx);
+		//录制时变换矩阵和透明度在回放时处理
+		bool bMtx = !m_bRecording && _ApplyMatrix(pRT, oriMtx);
+
+		if(m_bDisplayList && !m_bRecording && _PaintDisplayList(pRT,iZorderBegin,iZorderEnd))
+		{
+			if(bMtx) pRT->SetTransform(oriMtx.GetData());
+			return;
+		}
 
-		
 		CRect rcWnd = GetWindowRect();
 		CRect rcClient = GetClientRect();
 		float fMat[9];
@@ -1149,8 +1249,9 @@ namespace SOUI
 
 
 		IRenderTarget * pRTBackup;//backup current RT
+		BOOL bLayered = IsLayeredWindow() && !m_bRecording;
 
-		if(IsLayeredWindow())
+		if(bLayered)
 		{//获得当前LayeredWindow RT来绘制内容
 			pRTBackup = pRT;
 			
@@ -1189,6 +1290,19 @@ namespace SOUI
 			&& m_uZorder < iZorderEnd 
 			&& (!pRgn || pRgn->IsEmpty() || _WndRectInRgn(rcClient, pRgn)))
 		{//paint client
+			SFrameProfiler *pProfiler = GetContainer()->GetProfiler();
+			SWndPaintProfile profile(pProfiler,this);
+			if(pProfiler)
+			{//统计过度绘制
+				CRect rcPaint = rcClient;
+				if(pRgn && !pRgn->IsEmpty())
+				{
+					CRect rcBox;
+					pRgn->GetRgnBox(&rcBox);
+					rcPaint.IntersectRect(rcPaint,rcBox);
+				}
+				pProfiler->AddWndPixels((UINT64)rcPaint.Width()*rcPaint.Height());
+			}
 			_PaintClient(pRT);
 			if (IsFocused())
 			{//draw caret
@@ -1216,12 +1330,13 @@ namespace SOUI
 			&& (!pRgn ||  pRgn->IsEmpty() || _WndRectInRgn(rcWnd,pRgn))
 			)
 		{//paint nonclient
+			SWndPaintProfile profile(GetContainer()->GetProfiler(),this);
 			_PaintNonClient(pRT);
 		}
 		//restore clip state.
 		pRT->RestoreClip(nSave1);
 
-		if(IsLayeredWindow())
+		if(bLayered)
 		{//将绘制到窗口的缓存上的图像返回到上一级RT
 			SASSERT(pRTBackup);
 			pRTBackup->AlphaBlend(&rcWnd, pRT, &rcWnd, GetAlpha());
@@ -1313,6 +1428,8 @@ namespace SOUI
 	void SWindow::InvalidateRect(const CRect & rect,BOOL bFromThis/*=TRUE*/)
 	{
 		ASSERT_UI_THREAD();
+		//隐藏及锁定更新时内容也可能变化，先让录制命令失效
+		_MarkDisplayListDirty(!m_bXformInvalidating);
 		if(!IsVisible(TRUE) || IsUpdateLocked()) return ;
 
 		//只能更新窗口有效区域
@@ -1440,6 +1557,7 @@ namespace SOUI
 				m_rcWindow.bottom = m_rcWindow.top;
 
 			InvalidateRect(m_rcWindow);
+			GetContainer()->OnSwndHitTestChanged(this,HITCHANGE_RECT);
 			
 			SSendMessage(WM_NCCALCSIZE);//计算非客户区大小
 		}
@@ -1505,6 +1623,11 @@ namespace SOUI
 		EventSwndDestroy evt(this);
 		FireEvent(evt);
 		accNotifyEvent(EVENT_OBJECT_DESTROY);
+		if(GetContainer())
+		{//SWND不会复用，销毁后的统计不再更新，不删除的话会一直累积
+			SFrameProfiler *pProfiler = GetContainer()->GetProfiler();
+			if(pProfiler) pProfiler->OnWndDestroyed(m_swnd);
+		}
 
 #ifdef SOUI_ENABLE_ACC
 		if(m_pAcc)
@@ -1544,6 +1667,20 @@ namespace SOUI
 		return TRUE;
 	}
 
+	//与OnEraseBkgnd的绘制方式保持一致
+	BOOL SWindow::IsOpaque()
+	{
+		//非背景混合窗口保证绘制整个客户区
+		if(!GetStyle().m_bBlendBackground) return TRUE;
+		if(m_pBgSkin)
+		{
+			int idx = SState2Index::GetDefIndex(GetState(),true);
+			if (idx >= m_pBgSkin->GetStates()) idx = 0;
+			return m_pBgSkin->IsOpaque(idx);
+		}
+		return GetAValue(GetBkgndColor()) == 0xFF;
+	}
+
 	void SWindow::BeforePaint(IRenderTarget *pRT, SPainter &painter)
 	{
 		int iState = SState2Index::GetDefIndex(GetState(),true);
@@ -1782,6 +1919,10 @@ namespace SOUI
 			ModifyState(WndState_Invisible, 0);
 			accNotifyEvent(EVENT_OBJECT_HIDE);
 		}
+		if(nStatus != ParentShow)
+		{//子窗口的可见性随之变化，只需要通知一次
+			GetContainer()->OnSwndHitTestChanged(this,HITCHANGE_TREE);
+		}
 
 		SWindow *pChild=m_pFirstChild;
 		while(pChild)
@@ -1794,6 +1935,7 @@ namespace SOUI
 		}
 		if(!IsVisible(TRUE))
 		{
+			_ReleaseCacheRT();  //隐藏窗口不保留绘制缓存
 			if(IsFocused()) GetContainer()->OnSetSwndFocus(NULL);   //窗口隐藏时自动失去焦点
 			if(GetCapture() == m_swnd) ReleaseCapture();//窗口隐藏时自动失去Capture
 		}
@@ -2304,15 +2446,23 @@ namespace SOUI
 
 	void SWindow::SetMatrix(const SMatrix & mtx)
 	{
-		InvalidateRect(NULL);
+		_InvalidateXform();
 		m_transform.setMatrix(mtx);
-		InvalidateRect(NULL);
+		_InvalidateXform();
 	}
 
 	void SWindow::SetAlpha(BYTE byAlpha)
 	{
 		m_transform.setAlpha(byAlpha);
+		_InvalidateXform();
+	}
+
+	void SWindow::_InvalidateXform()
+	{
+		m_bXformInvalidating = TRUE;
 		InvalidateRect(NULL);
+		m_bXformInvalidating = FALSE;
+		if(GetContainer()) GetContainer()->OnSwndHitTestChanged(this,HITCHANGE_XFORM);
 	}
 
 	BYTE SWindow::GetAlpha() const
@@ -2548,16 +2698,14 @@ namespace SOUI
 	void SWindow::OnSize( UINT nType, CSize size )
 	{
 		if(IsDrawToCache())
-		{
-			if(!m_cachedRT)
+		{//缓存RT在绘制时才创建
+			if(m_cachedRT)
 			{
-				GETRENDERFACTORY->CreateRenderTarget(&m_cachedRT,GetWindowRect().Width(),GetWindowRect().Height());
-			}else
-			{
-				m_cachedRT->Resize(GetWindowRect().Size());
+				CRect rcWnd = GetWindowRect();
+				m_cachedRT->Resize(rcWnd.Size());
+				m_cachedRT->SetViewportOrg(-rcWnd.TopLeft());
+				SRenderCacheMgr::getSingleton().OnCacheResized(this,rcWnd.Width()*rcWnd.Height()*4);
 			}
-			m_cachedRT->SetViewportOrg(-GetWindowRect().TopLeft());
-
 			MarkCacheDirty(true);
 		}
 
@@ -2570,15 +2718,42 @@ namespace SOUI
 	{
 		if(IsDrawToCache() && !m_cachedRT)
 		{
-			GETRENDERFACTORY->CreateRenderTarget(&m_cachedRT,GetWindowRect().Width(),GetWindowRect().Height());
 			MarkCacheDirty(true);
 		}
 		if(!IsDrawToCache() && m_cachedRT)
 		{
-			m_cachedRT=NULL;
+			_ReleaseCacheRT();
 		}
 	}
 
+	bool SWindow::_PrepareCacheRT()
+	{
+		if(m_cachedRT) return true;
+		CRect rcWnd = GetWindowRect();
+		if(rcWnd.IsRectEmpty()) return false;
+		GETRENDERFACTORY->CreateRenderTarget(&m_cachedRT,rcWnd.Width(),rcWnd.Height());
+		if(!m_cachedRT) return false;
+		MarkCacheDirty(true);
+		SRenderCacheMgr::getSingleton().OnCacheCreated(this,rcWnd.Width()*rcWnd.Height()*4);
+		return true;
+	}
+
+	void SWindow::_ReleaseCacheRT()
+	{
+		if(m_cachedRT)
+		{
+			SRenderCacheMgr::getSingleton().OnCacheReleased(this);
+			m_cachedRT = NULL;
+		}
+		MarkCacheDirty(true);
+	}
+
+	void SWindow::_DropCacheRT()
+	{
+		m_cachedRT = NULL;
+		MarkCacheDirty(true);
+	}
+
 	HRESULT SWindow::OnAttrCache( const SStringW& strValue, BOOL bLoading )
 	{
 		m_bCacheDraw = STRINGASBOOL(strValue);
@@ -2591,6 +2766,87 @@ namespace SOUI
 		return S_FALSE;
 	}
 
+	HRESULT SWindow::OnAttrDisplayList( const SStringW& strValue, BOOL bLoading )
+	{
+		m_bDisplayList = STRINGASBOOL(strValue);
+		m_displayList = NULL;
+		m_bDisplayListDirty = TRUE;
+		m_bDisplayListFailed = FALSE;
+
+		if(!bLoading)
+		{
+			UpdateCacheMode();
+			InvalidateRect(NULL);
+		}
+		return S_FALSE;
+	}
+
+	void SWindow::_MarkDisplayListDirty(BOOL bSelf)
+	{
+		if(bSelf) m_bDisplayListDirty = TRUE;
+		SWindow *pParent = GetParent();
+		while(pParent)
+		{
+			pParent->m_bDisplayListDirty = TRUE;
+			pParent = pParent->GetParent();
+		}
+	}
+
+	bool SWindow::_CanRecordDisplayList()
+	{
+		//缓存RT及GetRenderTarget都直接读写像素，不能录制
+		if(IsDrawToCache() || m_pGetRTData) return false;
+		SWindow *pChild = GetWindow(GSW_FIRSTCHILD);
+		while(pChild)
+		{
+			if(!pChild->_CanRecordDisplayList()) return false;
+			pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+		}
+		return true;
+	}
+
+	bool SWindow::_PaintDisplayList(IRenderTarget *pRT,UINT iZorderBegin,UINT iZorderEnd)
+	{
+		//只有整个子树都在绘制范围内时才能回放
+		SWindow *pLast = this;
+		while(pLast->GetWindow(GSW_LASTCHILD))
+			pLast = pLast->GetWindow(GSW_LASTCHILD);
+		if(m_uZorder < iZorderBegin || pLast->m_uZorder >= iZorderEnd)
+			return false;
+
+		CRect rcWnd = GetWindowRect();
+		//录制时引用的位图内容改变后需要重新录制
+		if(m_displayList && m_displayList->IsStale())
+			m_bDisplayListDirty = TRUE;
+		if(!m_displayList || m_bDisplayListDirty)
+		{
+			m_displayList = NULL;
+			//上次录制失败，内容改变前不再重试
+			if(m_bDisplayListFailed && !m_bDisplayListDirty)
+				return false;
+			m_bDisplayListDirty = FALSE;
+			if(!_CanRecordDisplayList())
+			{
+				m_bDisplayListFailed = TRUE;
+				return false;
+			}
+			SDisplayListRecorder *pRecorder = new SDisplayListRecorder(pRT,rcWnd);
+			m_bRecording = TRUE;
+			DispatchPaint(pRecorder,NULL,ZORDER_MIN,ZORDER_MAX);
+			m_bRecording = FALSE;
+			if(pRecorder->IsValid())
+			{
+				m_displayList = pRecorder->GetDisplayList();
+			}
+			//子树中有无法录制的绘制或内存不足时本次直接绘制，内容改变后重新尝试录制
+			m_bDisplayListFailed = !m_displayList;
+			pRecorder->Release();
+			if(!m_displayList) return false;
+		}
+		m_displayList->Replay(pRT,IsLayeredWindow()?GetAlpha():0xFF,&rcWnd);
+		return true;
+	}
+
 	HRESULT SWindow::OnAttrAlpha( const SStringW& strValue, BOOL bLoading )
 	{
 		BYTE byAlpha = _wtoi(strValue);
@@ -2745,7 +3001,8 @@ namespace SOUI
 
 	bool SWindow::IsDrawToCache() const
 	{
-		return m_bCacheDraw || m_isAnimating;
+		//使用录制命令时动画只改变回放的变换，不需要缓存
+		return m_bCacheDraw || (m_isAnimating && !m_bDisplayList);
 	}
 
 	void SWindow::OnStateChanging( DWORD dwOldState,DWORD dwNewState )
@@ -2849,6 +3106,7 @@ namespace SOUI
 			GETRENDERFACTORY->CreateRegion(&m_clipRgn);
 			m_clipRgn->CombineRgn(pRgn,RGN_COPY);
 		}
+		if(GetContainer()) GetContainer()->OnSwndHitTestChanged(this,HITCHANGE_XFORM);
 		if(bRedraw) InvalidateRect(NULL);
 	}
 
@@ -3066,7 +3324,7 @@ namespace SOUI
 
 	void SWindow::OnAnimationInvalidate(IAnimation *pAni,bool bErase)
 	{
-		InvalidateRect(NULL);
+		_InvalidateXform();
 	}
 
 	void SWindow::OnAnimationUpdate(IAnimation *pAni)
@@ -24,16 +24,49 @@ SwndContainerImpl::SwndContainerImpl()
     ,m_dropTarget(this)
     ,m_focusMgr(this)
     ,m_bZorderDirty(TRUE)
+    ,m_pHitTestGrid(NULL)
+    ,m_bOcclusionCulling(FALSE)
 {
     SWindow::SetContainer(this);
 	m_caret.Attach(new SCaret(this));
-	pugi::xml_node xmlCaret = SUiDef::getSingletonPtr()->GetUiDef()->GetCaretInfo();
+	//没有加载uidef时使用默认的光标
+	IUiDefInfo *pUiDef = SUiDef::getSingletonPtr()->GetUiDef();
+	pugi::xml_node xmlCaret = pUiDef ? pUiDef->GetCaretInfo() : pugi::xml_node();
 	if (xmlCaret)
 	{
 		m_caret->InitFromXml(xmlCaret);
 	}
 }
 
+SwndContainerImpl::~SwndContainerImpl()
+{
+    delete m_pHitTestGrid;
+}
+
+void SwndContainerImpl::EnableHitTestGrid(int nCellSize)
+{
+    if(m_pHitTestGrid && m_pHitTestGrid->GetCellSize() == nCellSize)
+        return;
+    delete m_pHitTestGrid;
+    m_pHitTestGrid = NULL;
+    if(nCellSize > 0)
+        m_pHitTestGrid = new SHitTestGrid(this,nCellSize);
+}
+
+SWND SwndContainerImpl::SwndFromPoint(CPoint &pt,bool bIncludeMsgTransparent)
+{
+    if(!m_pHitTestGrid)
+        return SWindow::SwndFromPoint(pt,bIncludeMsgTransparent);
+    //网格索引使用zorder比较窗口的上下关系
+    BuildWndTreeZorder();
+    return m_pHitTestGrid->HitTest(pt,bIncludeMsgTransparent);
+}
+
+void SwndContainerImpl::OnSwndHitTestChanged(SWindow *pWnd,HitTestChange change)
+{
+    if(m_pHitTestGrid) m_pHitTestGrid->OnWndChanged(pWnd,change);
+}
+
 LRESULT SwndContainerImpl::DoFrameEvent(UINT uMsg,WPARAM wParam,LPARAM lParam)
 {
     LRESULT lRet=0;
@@ -436,6 +469,8 @@ BOOL SwndContainerImpl::UnregisterTrackMouseEvent( SWND swnd )
 void SwndContainerImpl::MarkWndTreeZorderDirty()
 {
     m_bZorderDirty = TRUE;
+    //插入了新窗口
+    if(m_pHitTestGrid) m_pHitTestGrid->MarkDirty();
 }
 
 void SwndContainerImpl::BuildWndTreeZorder()
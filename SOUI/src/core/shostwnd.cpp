@@ -8,6 +8,7 @@
 #include "helper/STime.h"
 #include "../updatelayeredwindow/SUpdateLayeredWindow.h"
 #include <helper/SHostMgr.h>
+#include <helper/SRenderCacheMgr.h>
 #include <Imm.h>
 #pragma comment(lib,"imm32.lib")
 
@@ -15,6 +16,50 @@ namespace SOUI
 {
 
 #define KConstDummyPaint    0x80000000
+#define KMaxDirtyRects      16      //脏矩形数量上限，超过后只使用脏区域的外接矩形
+
+	static LONGLONG _PerfCounter()
+	{
+		LARGE_INTEGER li;
+		::QueryPerformanceCounter(&li);
+		return li.QuadPart;
+	}
+
+	//性能计数转换为微秒
+	static UINT64 _PerfToUs(LONGLONG llCount)
+	{
+		static LONGLONG s_llFreq = 0;
+		if(s_llFreq == 0)
+		{
+			LARGE_INTEGER li;
+			::QueryPerformanceFrequency(&li);
+			s_llFreq = li.QuadPart;
+		}
+		return (UINT64)(llCount*1000000/s_llFreq);
+	}
+
+	//获取窗口的系统更新区域包含的矩形
+	static void _GetUpdateRects(HWND hWnd,SArray<CRect> & arrRc)
+	{
+		arrRc.RemoveAll();
+		HRGN hRgn = ::CreateRectRgn(0,0,0,0);
+		int nType = ::GetUpdateRgn(hWnd,hRgn,FALSE);
+		if(nType == SIMPLEREGION || nType == COMPLEXREGION)
+		{
+			DWORD dwSize = ::GetRegionData(hRgn,0,NULL);
+			SAutoBuf buf(dwSize);
+			RGNDATA *pData = (RGNDATA*)(char*)buf;
+			if(::GetRegionData(hRgn,dwSize,pData))
+			{
+				const RECT *pRc = (const RECT*)pData->Buffer;
+				for(DWORD i=0;i<pData->rdh.nCount;i++)
+				{
+					arrRc.Add(pRc[i]);
+				}
+			}
+		}
+		::DeleteObject(hRgn);
+	}
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -81,6 +126,12 @@ void SHostWndAttr::Init()
 	m_byWndType = WT_UNDEFINE;
 	m_bAllowSpy = TRUE;
 	m_bSendWheel2Hover = FALSE;
+	m_bPartialPresent = FALSE;
+	m_bSkipOpaqueBkgnd = FALSE;
+	m_bProfile = FALSE;
+	m_bProfileOverlay = FALSE;
+	m_nHitTestGrid = 0;
+	m_bOcclusionCulling = FALSE;
 	m_dwStyle = (0);
 	m_dwExStyle = (0);
 	if (m_hAppIconSmall) DestroyIcon(m_hAppIconSmall);
@@ -130,6 +181,7 @@ SHostWnd::SHostWnd( LPCTSTR pszResName /*= NULL*/ )
 , m_bTrackFlag(FALSE)
 , m_bNeedRepaint(FALSE)
 , m_bNeedAllRepaint(TRUE)
+, m_bDirtyOverflow(FALSE)
 , m_pTipCtrl(NULL)
 , m_dummyWnd(NULL)
 , m_bRendering(FALSE)
@@ -139,6 +191,7 @@ SHostWnd::SHostWnd( LPCTSTR pszResName /*= NULL*/ )
 , m_bResizing(false)
 , m_AniState(Ani_none)
 , m_dwThreadID(0)
+, m_pProfiler(NULL)
 {
     m_msgMouse.message = 0;
     m_privateStylePool.Attach(new SStylePool);
@@ -146,6 +199,7 @@ SHostWnd::SHostWnd( LPCTSTR pszResName /*= NULL*/ )
 	m_privateTemplatePool.Attach(new STemplatePool);
     SetContainer(this);
 	m_hostAnimationHandler.m_pHostWnd=this;
+	ResetFrameStats();
     m_evtSet.addEvent(EVENTID(EventInit));
     m_evtSet.addEvent(EVENTID(EventExit));
 }
@@ -155,6 +209,7 @@ SHostWnd::~SHostWnd()
     GETSTYLEPOOLMGR->PopStylePool(m_privateStylePool);
     GETSKINPOOLMGR->PopSkinPool(m_privateSkinPool);
 	GETTEMPLATEPOOLMR->PopTemplatePool(m_privateTemplatePool);
+    delete m_pProfiler;
 }
 
 HWND SHostWnd::Create(HWND hWndParent,DWORD dwStyle,DWORD dwExStyle, int x, int y, int nWidth, int nHeight)
@@ -223,6 +278,15 @@ BOOL SHostWnd::InitFromXml(pugi::xml_node xmlNode)
     
 	m_hostAttr.Init();
 	m_hostAttr.InitFromXml(xmlNode);
+    if(m_hostAttr.m_bProfile)
+    {
+        EnableProfiler(TRUE,m_hostAttr.m_bProfileOverlay);
+    }
+    if(m_hostAttr.m_nHitTestGrid > 0)
+    {
+        EnableHitTestGrid(m_hostAttr.m_nHitTestGrid);
+    }
+    EnableOcclusionCulling(m_hostAttr.m_bOcclusionCulling);
     if(m_privateStylePool->GetCount())
     {
         m_privateStylePool->RemoveAll();
@@ -417,6 +481,7 @@ BOOL SHostWnd::InitFromXml(pugi::xml_node xmlNode)
     m_bNeedAllRepaint = TRUE;
     m_bNeedRepaint = TRUE;
     m_rgnInvalidate->Clear();
+    _ClearDirtyRect();
     
     EventInit evt(this);
     FireEvent(evt);
@@ -441,27 +506,124 @@ void SHostWnd::_Redraw()
 {
     m_bNeedAllRepaint = TRUE;
     m_rgnInvalidate->Clear();
+    _ClearDirtyRect();
 	_Invalidate(NULL);
 }
 
+void SHostWnd::_AddDirtyRect(const CRect & rc)
+{
+    if(m_bDirtyOverflow || rc.IsRectEmpty()) return;
+    CRect rcAdd = rc;
+    //和相交的脏矩形合并，保证列表中的矩形互不相交
+    for(int i=(int)m_arrDirtyRect.GetCount()-1;i>=0;i--)
+    {
+        CRect rcInter;
+        if(rcInter.IntersectRect(rcAdd,m_arrDirtyRect[i]))
+        {
+            rcAdd.UnionRect(rcAdd,m_arrDirtyRect[i]);
+            m_arrDirtyRect.RemoveAt(i);
+            i = (int)m_arrDirtyRect.GetCount();//合并后的矩形可能和其它矩形相交，重新检查
+        }
+    }
+    if(m_arrDirtyRect.GetCount() >= KMaxDirtyRects)
+    {
+        m_bDirtyOverflow = TRUE;
+        m_arrDirtyRect.RemoveAll();
+        return;
+    }
+    m_arrDirtyRect.Add(rcAdd);
+}
+
+void SHostWnd::_ClearDirtyRect()
+{
+    m_arrDirtyRect.RemoveAll();
+    m_bDirtyOverflow = FALSE;
+}
+
+//查找完全覆盖rc的不透明窗口，该窗口下面的窗口不需要重绘
+SWindow * SHostWnd::_GetOpaqueCover(const CRect & rc)
+{
+    CPoint pt = rc.CenterPoint();
+    SWindow *pWnd = SWindowMgr::getSingleton().GetWindow(SwndFromPoint(pt,true));
+    SWindow *pCover = NULL;
+    while(pWnd && pWnd != this)
+    {
+        if(pWnd->IsOpaque() && (pWnd->GetClientRect() & rc) == rc)
+        {
+            pCover = pWnd;
+            break;
+        }
+        pWnd = pWnd->GetParent();
+    }
+    if(!pCover) return NULL;
+
+    //窗口及其父窗口有变换，裁剪或者透明度时，覆盖关系不成立
+    for(SWindow *p = pCover; p; p = p->GetParent())
+    {
+        if(p->GetTransformation().hasMatrix() || p->m_clipRgn || p->m_clipPath || p->IsLayeredWindow())
+            return NULL;
+        if(p != pCover && (p->GetClientRect() & rc) != rc)
+            return NULL;
+    }
+    return pCover;
+}
+
+void SHostWnd::ResetFrameStats()
+{
+    memset(&m_frameStats,0,sizeof(m_frameStats));
+}
+
+void SHostWnd::EnableProfiler(BOOL bEnable,BOOL bOverlay)
+{
+    if(bEnable)
+    {
+        if(!m_pProfiler) m_pProfiler = new SFrameProfiler;
+        m_pProfiler->SetOverlay(bOverlay);
+    }else if(m_pProfiler)
+    {
+        delete m_pProfiler;
+        m_pProfiler = NULL;
+    }
+    //显示或者清除性能浮层
+    if(IsWindow()) SWindow::InvalidateRect(NULL);
+}
+
+SFrameProfiler * SHostWnd::GetProfiler()
+{
+    return m_pProfiler;
+}
+
 void SHostWnd::OnPrint(HDC dc, UINT uFlags)
 {
+    LONGLONG llBegin = _PerfCounter();
+    UINT64 nPaintedPixels = m_frameStats.nPaintedPixels;
+    if(m_pProfiler) m_pProfiler->BeginFrame();
 	SMatrix mtx = _GetMatrixEx();
     //刷新前重新布局，会自动检查布局脏标志
 	UpdateLayout();
+    LONGLONG llLayout = _PerfCounter();
     
     if (m_bNeedAllRepaint)
     {
         m_rgnInvalidate->Clear();
+        _ClearDirtyRect();
         m_bNeedAllRepaint = FALSE;
         m_bNeedRepaint=TRUE;
     }
 
-    CRect rcInvalid;
 	CRect rcWnd = SWindow::GetWindowRect();
+    SArray<CRect> arrPresent;//需要更新到屏幕的矩形
+    BOOL bFullPaint = FALSE, bDirtyOverflow = FALSE;
+    int nDirtyRects = 0;
     if (m_bNeedRepaint)
     {
         m_bNeedRepaint = FALSE;
+        if(m_pProfiler && m_pProfiler->IsOverlay() && !m_rgnInvalidate->IsEmpty())
+        {//性能浮层的内容每帧都在变化，随其它脏区域一起重绘
+            CRect rcOverlay = m_pProfiler->GetOverlayRect(rcWnd,GetScale());
+            m_rgnInvalidate->CombineRect(&rcOverlay,RGN_OR);
+            _AddDirtyRect(rcOverlay);
+        }
 
         SPainter painter;
         BeforePaint(m_memRT,painter);
@@ -470,36 +632,120 @@ void SHostWnd::OnPrint(HDC dc, UINT uFlags)
         SAutoRefPtr<IRegion> pRgnUpdate=m_rgnInvalidate;
         m_rgnInvalidate=NULL;
         GETRENDERFACTORY->CreateRegion(&m_rgnInvalidate);
+        SArray<CRect> arrDirty(m_arrDirtyRect);
+        bDirtyOverflow = m_bDirtyOverflow;
+        _ClearDirtyRect();
+
+        BuildWndTreeZorder();
 
-        if (!pRgnUpdate->IsEmpty())
+        CRect rcInvalid;
+        bFullPaint = pRgnUpdate->IsEmpty();
+        if(bFullPaint)
+        {
+            arrPresent.Add(rcWnd);
+        }else if(bDirtyOverflow)
         {
             pRgnUpdate->GetRgnBox(&rcInvalid);
-			rcInvalid.IntersectRect(rcInvalid, rcWnd);
-            m_memRT->PushClipRegion(pRgnUpdate,RGN_COPY);
+            arrPresent.Add(rcInvalid & rcWnd);
         }else
         {
-            rcInvalid= rcWnd;
-            m_memRT->PushClipRect(&rcInvalid,RGN_COPY);
+            for(UINT i=0;i<arrDirty.GetCount();i++)
+            {
+                arrDirty[i] &= rcWnd;
+                if(!arrDirty[i].IsRectEmpty()) arrPresent.Add(arrDirty[i]);
+            }
+            if(m_hostAttr.m_bSkipOpaqueBkgnd)
+            {//被不透明窗口完全覆盖的脏矩形，从该窗口开始绘制
+                SAutoRefPtr<IRegion> rgnDirty;//所有矩形共用一个区域对象
+                for(UINT i=0;i<arrDirty.GetCount();i++)
+                {
+                    CRect rcDirty = arrDirty[i];
+                    if(rcDirty.IsRectEmpty()) continue;
+                    SWindow *pCover = _GetOpaqueCover(rcDirty);
+                    if(!pCover) continue;
+
+                    if(!rgnDirty) GETRENDERFACTORY->CreateRegion(&rgnDirty);
+                    rgnDirty->CombineRect(&rcDirty,RGN_COPY);
+                    m_memRT->PushClipRect(&rcDirty,RGN_COPY);
+                    //和完整重绘一样先清除旧内容，防止覆盖窗口没有画满时残留上一帧的像素
+                    m_memRT->ClearRect(&rcDirty,0);
+                    _PaintRegion(m_memRT,rgnDirty,pCover->m_uZorder,(UINT)ZORDER_MAX);
+                    m_memRT->PopClip();
+
+                    pRgnUpdate->CombineRect(&rcDirty,RGN_DIFF);
+                    m_frameStats.nOpaqueRects++;
+                    m_frameStats.nPaintedPixels += (UINT64)rcDirty.Width()*rcDirty.Height();
+                    arrDirty[i].SetRectEmpty();
+                }
+            }
         }
-        //清除残留的alpha值
-        m_memRT->ClearRect(rcInvalid,0);
+        nDirtyRects = (int)arrPresent.GetCount();
 
-        BuildWndTreeZorder();
-        RedrawRegion(m_memRT, pRgnUpdate);
-        
-        m_memRT->PopClip();
+        if(bFullPaint || !pRgnUpdate->IsEmpty())
+        {
+            if (!bFullPaint)
+            {
+                pRgnUpdate->GetRgnBox(&rcInvalid);
+                rcInvalid.IntersectRect(rcInvalid, rcWnd);
+                int nRemain = 0;
+                for(UINT i=0;i<arrDirty.GetCount() && !bDirtyOverflow;i++)
+                {
+                    if(!arrDirty[i].IsRectEmpty()) nRemain++;
+                }
+                if(nRemain == 1)//只剩一个脏矩形时区域就是外接矩形，矩形剪裁比区域剪裁开销小
+                    m_memRT->PushClipRect(&rcInvalid,RGN_COPY);
+                else
+                    m_memRT->PushClipRegion(pRgnUpdate,RGN_COPY);
+            }else
+            {
+                rcInvalid= rcWnd;
+                m_memRT->PushClipRect(&rcInvalid,RGN_COPY);
+            }
+            //清除残留的alpha值
+            m_memRT->ClearRect(rcInvalid,0);
+
+            RedrawRegion(m_memRT, pRgnUpdate);
+            
+            m_memRT->PopClip();
+
+            if(bFullPaint || bDirtyOverflow)
+            {
+                m_frameStats.nPaintedPixels += (UINT64)rcInvalid.Width()*rcInvalid.Height();
+            }else for(UINT i=0;i<arrDirty.GetCount();i++)
+            {
+                m_frameStats.nPaintedPixels += (UINT64)arrDirty[i].Width()*arrDirty[i].Height();
+            }
+        }
         
         AfterPaint(m_memRT,painter);
-        
+
+        if(m_pProfiler && m_pProfiler->IsOverlay())
+        {
+            m_pProfiler->DrawOverlay(m_memRT,rcWnd,GetScale());
+        }
     }else
     {//缓存已经更新好了，只需要重新更新到窗口
+        CRect rcInvalid;
         m_rgnInvalidate->GetRgnBox(&rcInvalid);
         m_rgnInvalidate->Clear();
+        if(m_bDirtyOverflow)
+            arrPresent.Add(rcInvalid);
+        else
+            arrPresent.Copy(m_arrDirtyRect);
+        _ClearDirtyRect();
     }
     
     if(uFlags != KConstDummyPaint) //由系统发的WM_PAINT或者WM_PRINT产生的重绘请求
     {
-        rcInvalid = rcWnd;
+        arrPresent.RemoveAll();
+        if(m_arrSysPaintRect.GetCount())
+        {//WM_PAINT，只更新系统的更新区域
+            arrPresent.Copy(m_arrSysPaintRect);
+            m_arrSysPaintRect.RemoveAll();
+        }else
+        {
+            arrPresent.Add(rcWnd);
+        }
     }
     
     //渲染非背景混合窗口,设置m_bRending=TRUE以保证只执行一次UpdateHost
@@ -508,16 +754,32 @@ void SHostWnd::OnPrint(HDC dc, UINT uFlags)
     SPOSITION pos = m_lstUpdatedRect.GetHeadPosition();
     while(pos)
     {
-        rcInvalid = rcInvalid | m_lstUpdatedRect.GetNext(pos);
+        arrPresent.Add(m_lstUpdatedRect.GetNext(pos));
     }
     m_lstUpdatedRect.RemoveAll();
     m_bRendering = FALSE;
+    LONGLONG llPaint = _PerfCounter();
 
-    UpdateHost(dc,rcInvalid);
+    UpdateHostRects(dc,arrPresent);
+    LONGLONG llPresent = _PerfCounter();
+
+    m_frameStats.nFrames++;
+    m_frameStats.usLayout += _PerfToUs(llLayout - llBegin);
+    m_frameStats.usPaint += _PerfToUs(llPaint - llLayout);
+    m_frameStats.usPresent += _PerfToUs(llPresent - llPaint);
+    if(m_pProfiler)
+    {
+        m_pProfiler->EndFrame(_PerfToUs(llLayout - llBegin),_PerfToUs(llPaint - llLayout),_PerfToUs(llPresent - llPaint),
+            nDirtyRects,m_frameStats.nPaintedPixels - nPaintedPixels,bFullPaint,bDirtyOverflow);
+    }
 }
 
 void SHostWnd::OnPaint(HDC dc)
 {
+    if(!m_hostAttr.m_bTranslucent && m_hostAttr.m_bPartialPresent)
+    {
+        _GetUpdateRects(m_hWnd,m_arrSysPaintRect);
+    }
     PAINTSTRUCT ps;
     dc=::BeginPaint(m_hWnd, &ps);
     OnPrint(m_hostAttr.m_bTranslucent?NULL:dc, 0);
@@ -601,6 +863,10 @@ void SHostWnd::OnDestroy()
 
 void SHostWnd::OnSize(UINT nType, CSize size)
 {
+    if(nType == SIZE_MINIMIZED)
+    {//最小化时释放窗口内容缓存
+        SRenderCacheMgr::getSingleton().ReleaseCaches(this);
+    }
     if(IsIconic()) return;
 
     if (size.cx==0 || size.cy==0)
@@ -659,7 +925,9 @@ void SHostWnd::OnTimer(UINT_PTR idEvent)
 	{
 		if (!IsIconic())
 		{
+			LONGLONG llBegin = m_pProfiler?_PerfCounter():0;
 			SwndContainerImpl::OnNextFrame();
+			if(m_pProfiler) m_pProfiler->AddAnimationTime(_PerfToUs(_PerfCounter() - llBegin));
 		}
 		return;
 	}
@@ -831,11 +1099,40 @@ void SHostWnd::UpdateHost(HDC dc, const CRect &rcInvalid, BYTE byAlpha)
     }
 }
 
+void SHostWnd::UpdateHostRects(HDC dc,const SArray<CRect> & arrRc)
+{
+    if(arrRc.IsEmpty()) return;//没有需要更新到屏幕的内容
+    CRect rcBox;
+    UINT64 nArea = 0;
+    for(UINT i=0;i<arrRc.GetCount();i++)
+    {
+        rcBox.UnionRect(rcBox,arrRc[i]);
+        nArea += (UINT64)arrRc[i].Width()*arrRc[i].Height();
+    }
+    UINT64 nBoxArea = (UINT64)rcBox.Width()*rcBox.Height();
+    //脏矩形分散时逐个更新，减少更新到屏幕的像素
+    if(m_hostAttr.m_bPartialPresent && arrRc.GetCount()>1 && arrRc.GetCount()<=KMaxDirtyRects && nArea*2 < nBoxArea)
+    {
+        for(UINT i=0;i<arrRc.GetCount();i++)
+        {
+            UpdateHost(dc,arrRc[i]);
+        }
+        m_frameStats.nPresentRects += (DWORD)arrRc.GetCount();
+        m_frameStats.nPresentedPixels += nArea;
+    }else
+    {
+        UpdateHost(dc,rcBox);
+        m_frameStats.nPresentRects ++;
+        m_frameStats.nPresentedPixels += nBoxArea;
+    }
+}
+
 void SHostWnd::OnRedraw(const CRect &rc)
 {
     if(!IsWindow()) return;
     
     m_rgnInvalidate->CombineRect(&rc,RGN_OR);
+    _AddDirtyRect(rc);
     
     m_bNeedRepaint = TRUE;
 
@@ -1749,6 +2046,10 @@ BOOL SHostWnd::ShowWindow(int nCmdShow)
 
 void SHostWnd::OnHostShowWindow(BOOL bShow, UINT nStatus)
 {
+	if(!bShow)
+	{//宿主隐藏时释放窗口内容缓存
+		SRenderCacheMgr::getSingleton().ReleaseCaches(this);
+	}
 	if(bShow && m_aniEnter)
 	{
 		if(m_aniEnter)
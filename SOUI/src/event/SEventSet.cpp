@@ -1,5 +1,6 @@
 ﻿#include "souistd.h"
 #include <event/SEventSet.h>
+#include <helper/SCriticalSection.h>
 
 namespace SOUI
 {
@@ -85,9 +86,153 @@ namespace SOUI
         return m_dwEventID;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    // SEventIdSet
+    // 同一个类的对象按相同的顺序注册相同的事件，这些对象共享同一个只读的事件ID集合。
+    // 集合按内容驻留在全局注册表中，addEvent沿着缓存的转移边从一个集合走到下一个集合，
+    // 对象自身只保存集合指针，SEvent在第一次订阅或者设置脚本时才创建。
+
+    struct SEventEntry
+    {
+        DWORD   dwEventID;
+        SATOM   name;
+    };
+
+    class SEventIdSet
+    {
+    public:
+        SEventIdSet():m_nHash(0),m_pNext(NULL){}
+
+        const SEventEntry * Find(DWORD dwEventID) const
+        {
+            int lo = 0, hi = (int)m_entries.GetCount() - 1;
+            while(lo <= hi)
+            {
+                int mid = (lo + hi)/2;
+                DWORD dwID = m_entries[mid].dwEventID;
+                if(dwID == dwEventID) return &m_entries[mid];
+                if(dwID < dwEventID) lo = mid + 1;
+                else hi = mid - 1;
+            }
+            return NULL;
+        }
+
+        const SEventEntry * FindByName(SATOM name) const
+        {
+            for(UINT i=0;i<m_entries.GetCount();i++)
+            {
+                if(m_entries[i].name == name) return &m_entries[i];
+            }
+            return NULL;
+        }
+
+        SArray<SEventEntry>     m_entries;  //按事件ID排序，创建后不再修改
+        ULONG                   m_nHash;
+        SEventIdSet *           m_pNext;    //注册表中哈希相同的集合
+        mutable SMap<DWORD,const SEventIdSet*> m_mapAdd;//addEvent的转移缓存，由注册表的锁保护
+    };
+
+    class SEventIdRegistry
+    {
+    public:
+        const SEventIdSet * Add(const SEventIdSet *pSet, DWORD dwEventID, SATOM name)
+        {
+            SAutoLock lock(m_cs);
+            if(!pSet) pSet = &m_root;
+            if(pSet->Find(dwEventID)) return pSet;
+            const SMap<DWORD,const SEventIdSet*>::CPair *p = pSet->m_mapAdd.Lookup(dwEventID);
+            if(p && p->m_value->Find(dwEventID)->name == name) return p->m_value;
+            SArray<SEventEntry> entries;
+            SEventEntry entry = {dwEventID,name};
+            bool bAdded = false;
+            for(UINT i=0;i<pSet->m_entries.GetCount();i++)
+            {
+                if(!bAdded && pSet->m_entries[i].dwEventID > dwEventID)
+                {
+                    entries.Add(entry);
+                    bAdded = true;
+                }
+                entries.Add(pSet->m_entries[i]);
+            }
+            if(!bAdded) entries.Add(entry);
+            const SEventIdSet *pRet = Intern(entries);
+            pSet->m_mapAdd[dwEventID] = pRet;
+            return pRet;
+        }
+
+        const SEventIdSet * Remove(const SEventIdSet *pSet, DWORD dwEventID)
+        {
+            if(!pSet || !pSet->Find(dwEventID)) return pSet;
+            SAutoLock lock(m_cs);
+            SArray<SEventEntry> entries;
+            for(UINT i=0;i<pSet->m_entries.GetCount();i++)
+            {
+                if(pSet->m_entries[i].dwEventID != dwEventID)
+                    entries.Add(pSet->m_entries[i]);
+            }
+            if(entries.IsEmpty()) return NULL;
+            return Intern(entries);
+        }
+
+    protected:
+        static bool IsEqual(const SArray<SEventEntry> & entries1,const SArray<SEventEntry> & entries2)
+        {
+            if(entries1.GetCount() != entries2.GetCount()) return false;
+            for(UINT i=0;i<entries1.GetCount();i++)
+            {
+                if(entries1[i].dwEventID != entries2[i].dwEventID
+                    || entries1[i].name != entries2[i].name)
+                    return false;
+            }
+            return true;
+        }
+
+        const SEventIdSet * Intern(const SArray<SEventEntry> & entries)
+        {
+            ULONG nHash = 0;
+            for(UINT i=0;i<entries.GetCount();i++)
+            {
+                nHash = (nHash << 5) + nHash + entries[i].dwEventID;
+                nHash = (nHash << 5) + nHash + (ULONG)(ULONG_PTR)entries[i].name;
+            }
+            SEventIdSet * & pHead = m_mapSets[nHash];
+            for(SEventIdSet *pSet = pHead; pSet; pSet = pSet->m_pNext)
+            {
+                if(IsEqual(pSet->m_entries,entries)) return pSet;
+            }
+            SEventIdSet *pSet = new SEventIdSet;
+            pSet->m_entries.Copy(entries);
+            pSet->m_nHash = nHash;
+            pSet->m_pNext = pHead;
+            pHead = pSet;
+            return pSet;
+        }
+
+        SCriticalSection            m_cs;
+        SMap<ULONG,SEventIdSet*>    m_mapSets;
+        SEventIdSet                 m_root;     //空集合，对象用NULL表示
+    };
+
+    static SEventIdRegistry * volatile s_pEventIdRegistry = NULL;
+
+    //事件集合可能在全局对象中构造，注册表在第一次使用时创建，进程退出前不释放
+    static SEventIdRegistry * GetEventIdRegistry()
+    {
+        SEventIdRegistry *pRegistry = s_pEventIdRegistry;
+        if(pRegistry) return pRegistry;
+        pRegistry = new SEventIdRegistry;
+        SEventIdRegistry *pOld = (SEventIdRegistry*)InterlockedCompareExchangePointer((PVOID volatile*)&s_pEventIdRegistry,pRegistry,NULL);
+        if(pOld)
+        {
+            delete pRegistry;
+            pRegistry = pOld;
+        }
+        return pRegistry;
+    }
+
     //////////////////////////////////////////////////////////////////////////
     // SEventSet
-    SEventSet::SEventSet(void):m_nMuted(0)
+    SEventSet::SEventSet(void):m_pIdSet(NULL),m_nMuted(0)
     {
     }
 
@@ -95,7 +240,7 @@ namespace SOUI
     {
         removeAllEvents();
     }
-
+
 	void SEventSet::setMutedState(bool setting)
 	{
 		if (setting)
@@ -105,22 +250,27 @@ namespace SOUI
 		SASSERT(m_nMuted >= 0);
 	}
 
-	SEvent * SEventSet::GetEventObject(const DWORD dwEventID )
+	SEvent * SEventSet::GetEventObject(const DWORD dwEventID,BOOL bCreate)
     {
         for(UINT i=0;i<m_evtArr.GetCount();i++)
         {
             if(m_evtArr[i]->GetID()==dwEventID) return m_evtArr[i];
         }
-        return NULL;
+        if(!bCreate || !m_pIdSet) return NULL;
+        const SEventEntry *pEntry = m_pIdSet->Find(dwEventID);
+        if(!pEntry) return NULL;
+        SEvent *pEvent = new SEvent(dwEventID,SStringPool::GetName(pEntry->name));
+        m_evtArr.Add(pEvent);
+        return pEvent;
     }
 
     void SEventSet::FireEvent(EventArgs& args )
     {
-        // find event object
-        SEvent* ev = GetEventObject(args.GetID());
+        //没有订阅者也没有脚本的对象直接返回
+        if(m_evtArr.IsEmpty() || m_nMuted!=0) return;
 
-        // fire the event if present and set is not muted
-        if ((ev != 0) && m_nMuted==0)
+        SEvent* ev = GetEventObject(args.GetID());
+        if (ev != 0)
         {
             (*ev)(args);
         }
@@ -130,12 +280,14 @@ namespace SOUI
     {
         if(!isEventPresent(dwEventID))
         {
-            m_evtArr.Add(new SEvent(dwEventID,pszEventHandlerName));
+            m_pIdSet = GetEventIdRegistry()->Add(m_pIdSet,dwEventID,SStringPool::Intern(pszEventHandlerName));
         }
     }
 
     void SEventSet::removeEvent( const DWORD dwEventID )
     {
+        if(!isEventPresent(dwEventID)) return;
+        m_pIdSet = GetEventIdRegistry()->Remove(m_pIdSet,dwEventID);
         for(UINT i=0;i<m_evtArr.GetCount();i++)
         {
             if(m_evtArr[i]->GetID()==dwEventID)
@@ -149,7 +301,7 @@ namespace SOUI
 
     bool SEventSet::isEventPresent( const DWORD dwEventID )
     {
-        return GetEventObject(dwEventID)!=NULL;
+        return m_pIdSet && m_pIdSet->Find(dwEventID)!=NULL;
     }
 
     void SEventSet::removeAllEvents( void )
@@ -159,39 +311,42 @@ namespace SOUI
             delete m_evtArr[i];
         }
         m_evtArr.RemoveAll();
+        m_pIdSet = NULL;
     }
 
     bool SEventSet::subscribeEvent( const DWORD dwEventID, const ISlotFunctor & subscriber )
     {
-        if(!isEventPresent(dwEventID)) return false;
-        return GetEventObject(dwEventID)->subscribe(subscriber);
+        SEvent *pEvent = GetEventObject(dwEventID,TRUE);
+        if(!pEvent) return false;
+        return pEvent->subscribe(subscriber);
     }
 
     bool SEventSet::unsubscribeEvent( const DWORD dwEventID, const ISlotFunctor & subscriber )
     {
-        if(!isEventPresent(dwEventID)) return false;
-        return GetEventObject(dwEventID)->unsubscribe(subscriber);
+        SEvent *pEvent = GetEventObject(dwEventID);
+        if(!pEvent) return false;
+        return pEvent->unsubscribe(subscriber);
     }
 
 #if _MSC_VER >= 1700	//VS2012
 	bool SEventSet::subscribeEvent(DWORD dwEventID, const EventCallback & eventCallback)
 	{
-		if (!isEventPresent(dwEventID)) return false;
-		return GetEventObject(dwEventID)->subscribe(StdFunctionSlot(eventCallback));
+		SEvent *pEvent = GetEventObject(dwEventID,TRUE);
+		if (!pEvent) return false;
+		return pEvent->subscribe(StdFunctionSlot(eventCallback));
 	}
 #endif
 
     bool SEventSet::setEventScriptHandler( const SStringW & strEventName,const SStringA strScriptHandler )
     {
-        for(UINT i=0;i<m_evtArr.GetCount();i++)
-        {
-            if(m_evtArr[i]->GetName() == strEventName)
-            {
-                m_evtArr[i]->SetScriptHandler(strScriptHandler);
-                return true;
-            }
-        }
-        return false;
+        if(!m_pIdSet) return false;
+        //所有事件名都已经驻留，没有驻留的名字不可能是事件名
+        SATOM name = SStringPool::Find(strEventName,strEventName.GetLength());
+        if(!name) return false;
+        const SEventEntry *pEntry = m_pIdSet->FindByName(name);
+        if(!pEntry) return false;
+        GetEventObject(pEntry->dwEventID,TRUE)->SetScriptHandler(strScriptHandler);
+        return true;
     }
 
     SStringA SEventSet::getEventScriptHandler( const SStringW & strEventName ) const
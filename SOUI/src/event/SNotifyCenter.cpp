@@ -11,7 +11,8 @@ class SNotifyReceiver:public SNativeWnd
 public:
 	enum{
 		UM_RUNONUISYNC = (WM_USER+1000),
-		TIMERID_ASYNC = 100,
+		UM_FIREEVTS,
+		TIMERID_RESUME = 100,
 	};
 
 	SNotifyReceiver(INotifyCallback * pCallback) :m_pCallback(pCallback)
@@ -26,11 +27,14 @@ public:
 
 	LRESULT OnRunOnUISync(UINT uMsg,WPARAM wParam,LPARAM lParam);
 
+	LRESULT OnFireEvts(UINT uMsg,WPARAM wParam,LPARAM lParam);
+
 	void OnTimer(UINT_PTR uID);
 
 	BEGIN_MSG_MAP_EX(SNotifyReceiver)
 		MSG_WM_TIMER(OnTimer)
 		MESSAGE_HANDLER_EX(UM_RUNONUISYNC, OnRunOnUISync)
+		MESSAGE_HANDLER_EX(UM_FIREEVTS, OnFireEvts)
 	END_MSG_MAP()
 
 protected:
@@ -40,29 +44,54 @@ protected:
 
 LRESULT SNotifyReceiver::OnRunOnUISync(UINT uMsg,WPARAM wParam,LPARAM lParam)
 {
-#ifdef ENABLE_RUNONUI
-	std::function<void(void)>* f = (std::function<void(void)>*)lParam;
-	(*f)();
-#endif//_MSC_VER >= 1700	//VS2012
+	void (*pfnInvoke)(void*) = (void (*)(void*))wParam;
+	pfnInvoke((void*)lParam);
+	return 0;
+}
+
+LRESULT SNotifyReceiver::OnFireEvts(UINT uMsg,WPARAM wParam,LPARAM lParam)
+{
+	m_pCallback->OnFireEvts();
 	return 0;
 }
 
 void SNotifyReceiver::OnTimer(UINT_PTR uID)
 {
-	if(uID==TIMERID_ASYNC)
+	if(uID==TIMERID_RESUME)
 	{
 		KillTimer(uID);
 		m_pCallback->OnFireEvts();
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+//异步事件队列节点，SLIST_ENTRY要求按MEMORY_ALLOCATION_ALIGNMENT对齐
+struct AsyncEvtNode
+{
+	SLIST_ENTRY	entry;
+	EventArgs *	e;
+};
+
+static void FreeEvtNodes(PSLIST_ENTRY pEntry,BOOL bReleaseEvt)
+{
+	while(pEntry)
+	{
+		AsyncEvtNode *pNode = (AsyncEvtNode*)pEntry;
+		pEntry = pEntry->Next;
+		if(bReleaseEvt) pNode->e->Release();
+		_aligned_free(pNode);
+	}
+}
 
 //////////////////////////////////////////////////////////////////////////
 SNotifyCenter::SNotifyCenter(int nInterval)
 :m_pReceiver(NULL)
-,m_bRunning(FALSE)
-,m_nInterval(nInterval)
+,m_lWakeupPending(0)
+,m_dwTaskBudget(8)
 {
+	UNREFERENCED_PARAMETER(nInterval);
+	InitializeSListHead(&m_evtInbox);
+	InitializeSListHead(&m_evtNodePool);
 	m_dwMainTrdID = GetCurrentThreadId();
 	m_pReceiver = new SNotifyReceiver(this);
 	m_pReceiver->Create(_T("NotifyReceiver"),WS_POPUP,0,0,0,0,0,HWND_MESSAGE,0);
@@ -75,12 +104,8 @@ SNotifyCenter::~SNotifyCenter(void)
 	delete m_pReceiver;
 	m_pReceiver = NULL;
 
-	SPOSITION pos = m_ayncEvent.GetTailPosition();
-	while (pos)
-	{
-		EventArgs *e = m_ayncEvent.GetNext(pos);
-		e->Release();
-	}
+	FreeEvtNodes(InterlockedFlushSList(&m_evtInbox),TRUE);
+	FreeEvtNodes(InterlockedFlushSList(&m_evtNodePool),FALSE);
 }
 
 void SNotifyCenter::FireEventSync( EventArgs *e )
@@ -92,20 +117,33 @@ void SNotifyCenter::FireEventSync( EventArgs *e )
 //把事件抛到事件队列，不检查事件是否注册，执行事件时再检查。
 void SNotifyCenter::FireEventAsync( EventArgs *e )
 {
-	SAutoLock lock(m_cs);
-	e->AddRef();
-	if(!m_bRunning)
+	AsyncEvtNode *pNode = (AsyncEvtNode*)InterlockedPopEntrySList(&m_evtNodePool);
+	if(!pNode)
 	{
-		m_pReceiver->SetTimer(SNotifyReceiver::TIMERID_ASYNC,m_nInterval,NULL);
-		m_bRunning = TRUE;
+		pNode = (AsyncEvtNode*)_aligned_malloc(sizeof(AsyncEvtNode),MEMORY_ALLOCATION_ALIGNMENT);
+		if(!pNode) return;
 	}
-	m_ayncEvent.AddTail(e);
+	e->AddRef();
+	pNode->e = e;
+	InterlockedPushEntrySList(&m_evtInbox,&pNode->entry);
+	//不能只在队列由空变为非空时唤醒: 那次唤醒投递失败后队列一直非空，事件再也不会被派发
+	WakeupAsync();
+}
+
+void SNotifyCenter::SetEventCoalescing(DWORD dwEventID,BOOL bCoalesce)
+{
+	SASSERT(m_dwMainTrdID == GetCurrentThreadId());
+	int idx = m_arrCoalesceEvt.Find(dwEventID);
+	if(bCoalesce && idx==-1)
+		m_arrCoalesceEvt.Add(dwEventID);
+	else if(!bCoalesce && idx!=-1)
+		m_arrCoalesceEvt.RemoveAt(idx);
 }
 
 
 void SNotifyCenter::OnFireEvent( EventArgs *e )
 {
-	if(!GetEventObject(e->GetID())) return;//确保事件是已经注册过的已经事件。
+	if(!isEventPresent(e->GetID())) return;//确保事件是已经注册过的已经事件。
 
 	FireEvent(*e);
 	if(!e->bubbleUp) return ;
@@ -122,40 +160,50 @@ void SNotifyCenter::OnFireEvent( EventArgs *e )
 
 void SNotifyCenter::OnFireEvts()
 {
-	SList<EventArgs *> evts;
-#ifdef ENABLE_RUNONUI
-	SList< std::function<void(void)> *> cbs;
-#endif
+	//先清除唤醒标志再取队列，之后投递的事件或任务会重新唤醒
+	InterlockedExchange(&m_lWakeupPending,0);
+
+	//一次取出队列中的全部事件，队列中是后进先出的顺序，反转后按投递顺序派发。
+	//反转时最先遇到的是最新的事件，需要合并的事件只保留第一次遇到的那个。
+	PSLIST_ENTRY pEntry = InterlockedFlushSList(&m_evtInbox);
+	AsyncEvtNode *pFifo = NULL;
+	SArray<DWORD> arrSeen;
+	while(pEntry)
 	{
-		SAutoLock lock(m_cs);
-		evts = m_ayncEvent;
-		m_ayncEvent.RemoveAll();
-#ifdef ENABLE_RUNONUI
-		cbs = m_asyncFuns;
-		m_asyncFuns.RemoveAll();
-#endif
-		m_bRunning = FALSE;
-	}
-	{
-		SPOSITION pos = evts.GetHeadPosition();
-		while (pos)
+		AsyncEvtNode *pNode = (AsyncEvtNode*)pEntry;
+		pEntry = pEntry->Next;
+		DWORD dwEventID = pNode->e->GetID();
+		if(!m_arrCoalesceEvt.IsEmpty() && m_arrCoalesceEvt.Find(dwEventID)!=-1)
 		{
-			EventArgs *e = evts.GetNext(pos);
-			OnFireEvent(e);
-			e->Release();
+			if(arrSeen.Find(dwEventID)!=-1)
+			{
+				pNode->e->Release();
+				InterlockedPushEntrySList(&m_evtNodePool,&pNode->entry);
+				continue;
+			}
+			arrSeen.Add(dwEventID);
 		}
+		pNode->entry.Next = (PSLIST_ENTRY)pFifo;
+		pFifo = pNode;
 	}
-#ifdef ENABLE_RUNONUI
+	while(pFifo)
 	{
-		SPOSITION pos = cbs.GetHeadPosition();
-		while (pos)
-		{
-			std::function<void(void)>* f = cbs.GetNext(pos);
-			(*f)();
-			delete f;
-		}
+		AsyncEvtNode *pNode = pFifo;
+		pFifo = (AsyncEvtNode*)pNode->entry.Next;
+		EventArgs *e = pNode->e;
+		InterlockedPushEntrySList(&m_evtNodePool,&pNode->entry);
+		OnFireEvent(e);
+		e->Release();
+	}
+
+	if(m_taskQueue.Run(m_dwTaskBudget))
+	{//预算用完或者有输入消息时还有任务没有执行。
+	 //投递的消息比输入消息优先取出，有输入时改用定时器，等输入处理完再继续。
+		if(HIWORD(GetQueueStatus(QS_INPUT)))
+			m_pReceiver->SetTimer(SNotifyReceiver::TIMERID_RESUME,USER_TIMER_MINIMUM,NULL);
+		else
+			WakeupAsync();
 	}
-#endif
 }
 
 
@@ -186,24 +234,20 @@ bool SNotifyCenter::UnregisterEventMap( const ISlotFunctor &slot )
 	return false;
 }
 
-#ifdef ENABLE_RUNONUI
-void SNotifyCenter::RunOnUISync(std::function<void(void)> fn)
+void SNotifyCenter::RunOnUISync(void (*pfnInvoke)(void*),void *pObj)
 {
-	m_pReceiver->SendMessage(SNotifyReceiver::UM_RUNONUISYNC, 0, (LPARAM)&fn);
+	m_pReceiver->SendMessage(SNotifyReceiver::UM_RUNONUISYNC, (WPARAM)pfnInvoke, (LPARAM)pObj);
 }
 
-void SNotifyCenter::RunOnUIAsync(std::function<void(void)> fn)
+void SNotifyCenter::WakeupAsync()
 {
-	SAutoLock lock(m_cs);
-	if(!m_bRunning)
-	{
-		m_pReceiver->SetTimer(SNotifyReceiver::TIMERID_ASYNC,m_nInterval,NULL);
-		m_bRunning = TRUE;
+	if(InterlockedCompareExchange(&m_lWakeupPending,1,0) != 0)
+		return;
+	if(!m_pReceiver->PostMessage(SNotifyReceiver::UM_FIREEVTS))
+	{//消息队列已满等原因投递失败
+		InterlockedExchange(&m_lWakeupPending,0);
 	}
-	std::function<void(void)>* f = new std::function<void()>(std::move(fn));
-	m_asyncFuns.AddTail(f);
 }
-#endif
 
 
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+﻿#include "souistd.h"
+#include "event/STaskQueue.h"
+
+namespace SOUI
+{
+    STaskQueue::STaskQueue():m_pFreeChunks(NULL),m_nTotal(0)
+    {
+        memset(m_lanes,0,sizeof(m_lanes));
+    }
+
+    STaskQueue::~STaskQueue()
+    {
+        for(int i=0;i<RUNONUI_LANES;i++)
+        {
+            STask task;
+            while(PopTask(i,task))
+            {
+                DestroyTask(task);
+            }
+            if(m_lanes[i].pHead)
+            {
+                m_lanes[i].pHead->pNext = m_pFreeChunks;
+                m_pFreeChunks = m_lanes[i].pHead;
+            }
+        }
+        while(m_pFreeChunks)
+        {
+            STaskChunk *pNext = m_pFreeChunks->pNext;
+            soui_mem_wrapper::SouiFree(m_pFreeChunks);
+            m_pFreeChunks = pNext;
+        }
+    }
+
+    STaskQueue::STask * STaskQueue::AllocTask(int nLane)
+    {
+        SLane & lane = m_lanes[nLane];
+        if(!lane.pTail || lane.iTail == KChunkTasks)
+        {
+            STaskChunk *pChunk = m_pFreeChunks;
+            if(pChunk)
+                m_pFreeChunks = pChunk->pNext;
+            else
+                pChunk = (STaskChunk*)soui_mem_wrapper::SouiMalloc(sizeof(STaskChunk));
+            if(!pChunk) return NULL;
+            pChunk->pNext = NULL;
+            if(lane.pTail)
+                lane.pTail->pNext = pChunk;
+            else
+                lane.pHead = pChunk;
+            lane.pTail = pChunk;
+            lane.iTail = 0;
+        }
+        lane.nCount++;
+        return &lane.pTail->tasks[lane.iTail++];
+    }
+
+    BOOL STaskQueue::PopTask(int nLane, STask & task)
+    {
+        SAutoLock lock(m_cs);
+        SLane & lane = m_lanes[nLane];
+        if(lane.nCount == 0) return FALSE;
+        STask & src = lane.pHead->tasks[lane.iHead];
+        task.pfnInvoke = src.pfnInvoke;
+        task.pfnDestroy = src.pfnDestroy;
+        task.pfnRelocate = src.pfnRelocate;
+        task.pObj = src.pObj;
+        if(src.pfnRelocate)
+            src.pfnRelocate(task.storage.byBuf,src.storage.byBuf);
+        lane.nCount--;
+        m_nTotal--;
+        if(++lane.iHead == KChunkTasks && lane.pHead != lane.pTail)
+        {
+            STaskChunk *pChunk = lane.pHead;
+            lane.pHead = pChunk->pNext;
+            lane.iHead = 0;
+            pChunk->pNext = m_pFreeChunks;
+            m_pFreeChunks = pChunk;
+        }
+        if(lane.nCount == 0)
+        {//通道已空，从块的起始位置重新使用
+            lane.iHead = lane.iTail = 0;
+        }
+        return TRUE;
+    }
+
+    void STaskQueue::DestroyTask(STask & task)
+    {
+        task.pfnDestroy(task.GetObj(),task.pfnRelocate == NULL);
+    }
+
+    BOOL STaskQueue::Run(DWORD dwBudget)
+    {
+        LARGE_INTEGER freq,start,now;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
+        LONGLONG llBudget = freq.QuadPart * dwBudget / 1000;
+
+        STask task;
+        //输入通道: 只执行进入时已经在队列中的任务，任务中再投递的留到下一轮
+        int nInput = 0;
+        {
+            SAutoLock lock(m_cs);
+            nInput = m_lanes[RUNONUI_INPUT].nCount;
+        }
+        while(nInput-- > 0 && PopTask(RUNONUI_INPUT,task))
+        {
+            task.pfnInvoke(task.GetObj());
+            DestroyTask(task);
+        }
+
+        for(int nLane = RUNONUI_NORMAL; nLane < RUNONUI_LANES; nLane++)
+        {
+            for(int nRun = 0;;nRun++)
+            {
+                if(nRun > 0)
+                {//每轮至少执行一个任务，保证在输入很多时任务仍然能够推进
+                    QueryPerformanceCounter(&now);
+                    if(now.QuadPart - start.QuadPart >= llBudget) return m_nTotal > 0;
+                    //每执行几个任务检查一次输入消息，有输入时让出
+                    if((nRun & 7) == 0 && HIWORD(GetQueueStatus(QS_INPUT))) return m_nTotal > 0;
+                }
+                if(nLane == RUNONUI_IDLE)
+                {//普通或者输入通道在执行过程中又有了任务
+                    SAutoLock lock(m_cs);
+                    if(m_lanes[RUNONUI_INPUT].nCount || m_lanes[RUNONUI_NORMAL].nCount) return TRUE;
+                }
+                if(!PopTask(nLane,task)) break;
+                task.pfnInvoke(task.GetObj());
+                DestroyTask(task);
+            }
+        }
+        return m_nTotal > 0;
+    }
+}
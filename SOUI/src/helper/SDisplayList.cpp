@@ -0,0 +1,1286 @@
+﻿#include "souistd.h"
+#include "helper/SDisplayList.h"
+
+namespace SOUI
+{
+    enum DLCMD
+    {
+        DL_OFFSETORG = 1,
+        DL_PUSHCLIPRECT,
+        DL_PUSHCLIPREGION,
+        DL_PUSHCLIPPATH,
+        DL_POPCLIP,
+        DL_EXCLUDECLIPRECT,
+        DL_INTERSECTCLIPRECT,
+        DL_SAVECLIP,
+        DL_RESTORECLIP,
+        DL_DRAWTEXT,
+        DL_TEXTOUT,
+        DL_DRAWRECTANGLE,
+        DL_FILLRECTANGLE,
+        DL_FILLSOLIDRECT,
+        DL_DRAWROUNDRECT,
+        DL_FILLROUNDRECT,
+        DL_FILLSOLIDROUNDRECT,
+        DL_CLEARRECT,
+        DL_INVERTRECT,
+        DL_DRAWELLIPSE,
+        DL_FILLELLIPSE,
+        DL_FILLSOLIDELLIPSE,
+        DL_DRAWARC,
+        DL_FILLARC,
+        DL_DRAWLINES,
+        DL_GRADIENTFILL,
+        DL_GRADIENTFILLEX,
+        DL_GRADIENTFILL2,
+        DL_DRAWICONEX,
+        DL_DRAWBITMAP,
+        DL_DRAWBITMAPEX,
+        DL_DRAWBITMAP9PATCH,
+        DL_BITBLT,
+        DL_ALPHABLEND,
+        DL_SELECTOBJECT,
+        DL_SETTEXTCOLOR,
+        DL_SETMASKFILTER,
+        DL_SETTRANSFORM,
+        DL_SETPIXEL,
+        DL_DRAWPATH,
+        DL_FILLPATH,
+        DL_PUSHLAYER,
+        DL_POPLAYER,
+        DL_SETXFERMODE,
+        DL_SETANTIALIAS,
+    };
+
+    //命令缓冲区中的数据都按4字节对齐写入，回放时字符串可以直接使用
+    class SDLReader
+    {
+    public:
+        SDLReader(const BYTE *pBuf,size_t nSize):m_p(pBuf),m_pEnd(pBuf+nSize){}
+
+        bool IsEnd() const {return m_p >= m_pEnd;}
+
+        int ReadInt() {return Read<int>();}
+        float ReadFloat() {return Read<float>();}
+        RECT ReadRect() {return Read<RECT>();}
+        POINT ReadPoint() {return Read<POINT>();}
+
+        const void * ReadBuf(size_t nLen)
+        {
+            const BYTE *p = m_p;
+            m_p += (nLen+3)&~3;
+            return p;
+        }
+
+        template<class T>
+        T Read()
+        {
+            T v;
+            memcpy(&v,m_p,sizeof(T));
+            m_p += sizeof(T);
+            return v;
+        }
+    protected:
+        const BYTE *m_p;
+        const BYTE *m_pEnd;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    SDisplayList::SDisplayList():m_pBuf(NULL),m_nSize(0),m_nCapacity(0),m_bOOM(FALSE)
+    {
+    }
+
+    SDisplayList::~SDisplayList()
+    {
+        for(UINT i=0;i<m_arrObjs.GetCount();i++)
+        {
+            m_arrObjs[i]->Release();
+        }
+        for(UINT i=0;i<m_arrIcons.GetCount();i++)
+        {
+            DestroyIcon(m_arrIcons[i]);
+        }
+        if(m_pBuf) free(m_pBuf);
+    }
+
+    void SDisplayList::Write(const void *pData,size_t nLen)
+    {
+        //缓冲区分配失败后命令流已经不完整，丢弃后续写入，由录制者放弃本次录制
+        if(m_bOOM) return;
+        size_t nLen4 = (nLen+3)&~3;
+        if(m_nSize + nLen4 > m_nCapacity)
+        {
+            size_t nNewCap = m_nCapacity?m_nCapacity*2:256;
+            while(nNewCap < m_nSize + nLen4) nNewCap *= 2;
+            BYTE *pNew = (BYTE*)realloc(m_pBuf,nNewCap);
+            if(!pNew)
+            {
+                m_bOOM = TRUE;
+                return;
+            }
+            m_pBuf = pNew;
+            m_nCapacity = nNewCap;
+        }
+        memcpy(m_pBuf+m_nSize,pData,nLen);
+        if(nLen4 > nLen) memset(m_pBuf+m_nSize+nLen,0,nLen4-nLen);
+        m_nSize += nLen4;
+    }
+
+    void SDisplayList::WriteString(LPCTSTR pszText,int nLen)
+    {
+        Write(nLen);
+        Write(pszText,nLen*sizeof(TCHAR));
+    }
+
+    int SDisplayList::AddObject(IObjRef *pObj,DWORD dwVersion)
+    {
+        if(!pObj) return -1;
+        //同一个对象通常被连续使用，只检查最近的几个对象
+        int nCount = (int)m_arrObjs.GetCount();
+        for(int i=nCount-1;i>=0 && i>=nCount-8;i--)
+        {
+            if(m_arrObjs[i] == pObj) return i;
+        }
+        pObj->AddRef();
+        m_arrObjs.Add(pObj);
+        m_arrObjVer.Add(dwVersion);
+        return nCount;
+    }
+
+    HICON SDisplayList::AddIcon(HICON hIcon)
+    {
+        //调用者可能在绘制后销毁图标，保存一份副本
+        HICON hCopy = CopyIcon(hIcon);
+        if(hCopy) m_arrIcons.Add(hCopy);
+        return hCopy;
+    }
+
+    BOOL SDisplayList::IsStale() const
+    {
+        for(UINT i=0;i<m_arrObjs.GetCount();i++)
+        {
+            if(m_arrObjVer[i] == 0) continue;
+            const IBitmap *pBmp = static_cast<const IBitmap*>(m_arrObjs[i]);
+            if(pBmp->GetContentVersion() != m_arrObjVer[i]) return TRUE;
+        }
+        return FALSE;
+    }
+
+    size_t SDisplayList::GetMemSize() const
+    {
+        return m_nCapacity + m_arrObjs.GetCount()*(sizeof(IObjRef*)+sizeof(DWORD)) + m_arrIcons.GetCount()*sizeof(HICON);
+    }
+
+    void SDisplayList::Replay(IRenderTarget *pRT,BYTE byAlpha,LPCRECT pRcBound) const
+    {
+        //保存目标RT的状态，回放结束后恢复
+        int nBase = 0;
+        pRT->SaveClip(&nBase);
+        if(byAlpha != 0xFF)
+        {
+            pRT->PushLayer(pRcBound,byAlpha);
+        }
+        SMatrix mtxBase;
+        pRT->GetTransform(mtxBase.GetData());
+        CPoint ptOrg;
+        pRT->GetViewportOrg(&ptOrg);
+        SAutoRefPtr<IRenderObj> oldFont = pRT->GetCurrentObject(OT_FONT);
+        SAutoRefPtr<IRenderObj> oldPen = pRT->GetCurrentObject(OT_PEN);
+        SAutoRefPtr<IRenderObj> oldBrush = pRT->GetCurrentObject(OT_BRUSH);
+        SAutoRefPtr<IMaskFilter> oldMaskFilter = pRT->GetMaskFilter();
+        COLORREF crOld = pRT->GetTextColor();
+        bool bMtx = false, bXfer = false, bAntiAlias = false;
+        int nXferOld = 0;
+        BOOL bAntiAliasOld = TRUE;
+        int nLayers = 0;
+        SArray<int> arrStates;  //录制时SaveClip返回的索引到目标RT状态的映射
+
+        SDLReader reader(m_pBuf,m_nSize);
+        while(!reader.IsEnd())
+        {
+            int nCmd = reader.ReadInt();
+            switch(nCmd)
+            {
+            case DL_OFFSETORG:
+                {
+                    POINT pt = reader.ReadPoint();
+                    pRT->OffsetViewportOrg(pt.x,pt.y);
+                }
+                break;
+            case DL_PUSHCLIPRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->PushClipRect(&rc,reader.ReadInt());
+                }
+                break;
+            case DL_PUSHCLIPREGION:
+                {
+                    IRegion *pRgn = static_cast<IRegion*>(m_arrObjs[reader.ReadInt()]);
+                    pRT->PushClipRegion(pRgn,reader.ReadInt());
+                }
+                break;
+            case DL_PUSHCLIPPATH:
+                {
+                    IPath *pPath = static_cast<IPath*>(m_arrObjs[reader.ReadInt()]);
+                    int nMode = reader.ReadInt();
+                    pRT->PushClipPath(pPath,nMode,reader.ReadInt()!=0);
+                }
+                break;
+            case DL_POPCLIP:
+                pRT->PopClip();
+                break;
+            case DL_EXCLUDECLIPRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->ExcludeClipRect(&rc);
+                }
+                break;
+            case DL_INTERSECTCLIPRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->IntersectClipRect(&rc);
+                }
+                break;
+            case DL_SAVECLIP:
+                {
+                    int nId = reader.ReadInt();
+                    int nState = 0;
+                    pRT->SaveClip(&nState);
+                    arrStates.SetAtGrow(nId,nState);
+                }
+                break;
+            case DL_RESTORECLIP:
+                {
+                    int nId = reader.ReadInt();
+                    if(nId>=0 && nId<(int)arrStates.GetCount())
+                    {
+                        pRT->RestoreClip(arrStates[nId]);
+                    }else
+                    {//恢复到回放开始时的状态
+                        pRT->RestoreClip(nBase);
+                        pRT->SaveClip(&nBase);
+                    }
+                }
+                break;
+            case DL_DRAWTEXT:
+                {
+                    RECT rc = reader.ReadRect();
+                    UINT uFormat = reader.ReadInt();
+                    int nLen = reader.ReadInt();
+                    LPCTSTR pszText = (LPCTSTR)reader.ReadBuf(nLen*sizeof(TCHAR));
+                    pRT->DrawText(pszText,nLen,&rc,uFormat);
+                }
+                break;
+            case DL_TEXTOUT:
+                {
+                    POINT pt = reader.ReadPoint();
+                    int nLen = reader.ReadInt();
+                    LPCTSTR pszText = (LPCTSTR)reader.ReadBuf(nLen*sizeof(TCHAR));
+                    pRT->TextOut(pt.x,pt.y,pszText,nLen);
+                }
+                break;
+            case DL_DRAWRECTANGLE:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->DrawRectangle(&rc);
+                }
+                break;
+            case DL_FILLRECTANGLE:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->FillRectangle(&rc);
+                }
+                break;
+            case DL_FILLSOLIDRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->FillSolidRect(&rc,reader.ReadInt());
+                }
+                break;
+            case DL_DRAWROUNDRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->DrawRoundRect(&rc,reader.ReadPoint());
+                }
+                break;
+            case DL_FILLROUNDRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->FillRoundRect(&rc,reader.ReadPoint());
+                }
+                break;
+            case DL_FILLSOLIDROUNDRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    POINT pt = reader.ReadPoint();
+                    pRT->FillSolidRoundRect(&rc,pt,reader.ReadInt());
+                }
+                break;
+            case DL_CLEARRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->ClearRect(&rc,reader.ReadInt());
+                }
+                break;
+            case DL_INVERTRECT:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->InvertRect(&rc);
+                }
+                break;
+            case DL_DRAWELLIPSE:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->DrawEllipse(&rc);
+                }
+                break;
+            case DL_FILLELLIPSE:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->FillEllipse(&rc);
+                }
+                break;
+            case DL_FILLSOLIDELLIPSE:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->FillSolidEllipse(&rc,reader.ReadInt());
+                }
+                break;
+            case DL_DRAWARC:
+                {
+                    RECT rc = reader.ReadRect();
+                    float fStart = reader.ReadFloat();
+                    float fSweep = reader.ReadFloat();
+                    pRT->DrawArc(&rc,fStart,fSweep,reader.ReadInt()!=0);
+                }
+                break;
+            case DL_FILLARC:
+                {
+                    RECT rc = reader.ReadRect();
+                    float fStart = reader.ReadFloat();
+                    pRT->FillArc(&rc,fStart,reader.ReadFloat());
+                }
+                break;
+            case DL_DRAWLINES:
+                {
+                    int nCount = reader.ReadInt();
+                    POINT *pts = (POINT*)reader.ReadBuf(nCount*sizeof(POINT));
+                    pRT->DrawLines(pts,nCount);
+                }
+                break;
+            case DL_GRADIENTFILL:
+                {
+                    RECT rc = reader.ReadRect();
+                    BOOL bVert = reader.ReadInt();
+                    COLORREF crBegin = reader.ReadInt();
+                    COLORREF crEnd = reader.ReadInt();
+                    pRT->GradientFill(&rc,bVert,crBegin,crEnd,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_GRADIENTFILLEX:
+                {
+                    RECT rc = reader.ReadRect();
+                    BYTE byAlpha2 = (BYTE)reader.ReadInt();
+                    int nCount = reader.ReadInt();
+                    const POINT *pts = (const POINT*)reader.ReadBuf(2*sizeof(POINT));
+                    COLORREF *colors = (COLORREF*)reader.ReadBuf(nCount*sizeof(COLORREF));
+                    float *pos = (float*)reader.ReadBuf(nCount*sizeof(float));
+                    pRT->GradientFillEx(&rc,pts,colors,pos,nCount,byAlpha2);
+                }
+                break;
+            case DL_GRADIENTFILL2:
+                {
+                    RECT rc = reader.ReadRect();
+                    GradientType type = (GradientType)reader.ReadInt();
+                    COLORREF crStart = reader.ReadInt();
+                    COLORREF crCenter = reader.ReadInt();
+                    COLORREF crEnd = reader.ReadInt();
+                    float fAngle = reader.ReadFloat();
+                    float fCenterX = reader.ReadFloat();
+                    float fCenterY = reader.ReadFloat();
+                    int nRadius = reader.ReadInt();
+                    pRT->GradientFill2(&rc,type,crStart,crCenter,crEnd,fAngle,fCenterX,fCenterY,nRadius,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_DRAWICONEX:
+                {
+                    RECT rc = reader.ReadRect();
+                    HICON hIcon = reader.Read<HICON>();
+                    pRT->DrawIconEx(rc.left,rc.top,hIcon,rc.right-rc.left,rc.bottom-rc.top,reader.ReadInt());
+                }
+                break;
+            case DL_DRAWBITMAP:
+                {
+                    RECT rc = reader.ReadRect();
+                    IBitmap *pBmp = static_cast<IBitmap*>(m_arrObjs[reader.ReadInt()]);
+                    POINT pt = reader.ReadPoint();
+                    pRT->DrawBitmap(&rc,pBmp,pt.x,pt.y,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_DRAWBITMAPEX:
+                {
+                    RECT rc = reader.ReadRect();
+                    IBitmap *pBmp = static_cast<IBitmap*>(m_arrObjs[reader.ReadInt()]);
+                    RECT rcSrc = reader.ReadRect();
+                    UINT uMode = reader.ReadInt();
+                    pRT->DrawBitmapEx(&rc,pBmp,&rcSrc,uMode,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_DRAWBITMAP9PATCH:
+                {
+                    RECT rc = reader.ReadRect();
+                    IBitmap *pBmp = static_cast<IBitmap*>(m_arrObjs[reader.ReadInt()]);
+                    RECT rcSrc = reader.ReadRect();
+                    RECT rcMargin = reader.ReadRect();
+                    UINT uMode = reader.ReadInt();
+                    pRT->DrawBitmap9Patch(&rc,pBmp,&rcSrc,&rcMargin,uMode,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_BITBLT:
+                {
+                    RECT rc = reader.ReadRect();
+                    IRenderTarget *pSrc = static_cast<IRenderTarget*>(m_arrObjs[reader.ReadInt()]);
+                    POINT pt = reader.ReadPoint();
+                    pRT->BitBlt(&rc,pSrc,pt.x,pt.y,reader.ReadInt());
+                }
+                break;
+            case DL_ALPHABLEND:
+                {
+                    RECT rc = reader.ReadRect();
+                    IRenderTarget *pSrc = static_cast<IRenderTarget*>(m_arrObjs[reader.ReadInt()]);
+                    RECT rcSrc = reader.ReadRect();
+                    pRT->AlphaBlend(&rc,pSrc,&rcSrc,(BYTE)reader.ReadInt());
+                }
+                break;
+            case DL_SELECTOBJECT:
+                pRT->SelectObject(static_cast<IRenderObj*>(m_arrObjs[reader.ReadInt()]));
+                break;
+            case DL_SETTEXTCOLOR:
+                pRT->SetTextColor(reader.ReadInt());
+                break;
+            case DL_SETMASKFILTER:
+                {
+                    int iObj = reader.ReadInt();
+                    pRT->SetMaskFilter(iObj<0?NULL:static_cast<IMaskFilter*>(m_arrObjs[iObj]));
+                }
+                break;
+            case DL_SETTRANSFORM:
+                {//录制的矩阵相对于回放开始时的矩阵
+                    SMatrix mtx = mtxBase;
+                    mtx.preConcat(SMatrix((const float*)reader.ReadBuf(9*sizeof(float))));
+                    pRT->SetTransform(mtx.GetData());
+                    bMtx = true;
+                }
+                break;
+            case DL_SETPIXEL:
+                {
+                    POINT pt = reader.ReadPoint();
+                    pRT->SetPixel(pt.x,pt.y,reader.ReadInt());
+                }
+                break;
+            case DL_DRAWPATH:
+                {
+                    IPath *pPath = static_cast<IPath*>(m_arrObjs[reader.ReadInt()]);
+                    int iEffect = reader.ReadInt();
+                    pRT->DrawPath(pPath,iEffect<0?NULL:static_cast<IPathEffect*>(m_arrObjs[iEffect]));
+                }
+                break;
+            case DL_FILLPATH:
+                pRT->FillPath(static_cast<IPath*>(m_arrObjs[reader.ReadInt()]));
+                break;
+            case DL_PUSHLAYER:
+                {
+                    RECT rc = reader.ReadRect();
+                    pRT->PushLayer(&rc,(BYTE)reader.ReadInt());
+                    nLayers++;
+                }
+                break;
+            case DL_POPLAYER:
+                pRT->PopLayer();
+                nLayers--;
+                break;
+            case DL_SETXFERMODE:
+                {
+                    int nMode = reader.ReadInt();
+                    if(!bXfer)
+                    {
+                        pRT->SetXfermode(nMode,&nXferOld);
+                        bXfer = true;
+                    }else
+                    {
+                        pRT->SetXfermode(nMode);
+                    }
+                }
+                break;
+            case DL_SETANTIALIAS:
+                {
+                    BOOL bOld = pRT->SetAntiAlias(reader.ReadInt());
+                    if(!bAntiAlias)
+                    {
+                        bAntiAliasOld = bOld;
+                        bAntiAlias = true;
+                    }
+                }
+                break;
+            default:
+                SASSERT(FALSE);
+                return;
+            }
+        }
+
+        for(;nLayers>0;nLayers--)
+        {
+            pRT->PopLayer();
+        }
+        if(byAlpha != 0xFF)
+        {
+            pRT->PopLayer();
+        }
+        pRT->RestoreClip(nBase);
+        pRT->SetViewportOrg(ptOrg);
+        if(bMtx) pRT->SetTransform(mtxBase.GetData());
+        if(bXfer) pRT->SetXfermode(nXferOld);
+        if(bAntiAlias) pRT->SetAntiAlias(bAntiAliasOld);
+        if(oldFont) pRT->SelectObject(oldFont);
+        if(oldPen) pRT->SelectObject(oldPen);
+        if(oldBrush) pRT->SelectObject(oldBrush);
+        pRT->SetMaskFilter(oldMaskFilter);
+        pRT->SetTextColor(crOld);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    SDisplayListRecorder::SDisplayListRecorder(IRenderTarget *pRTRef,LPCRECT pRcBound)
+        :m_crText(0)
+        ,m_nXferMode(kSrcOver_Mode)
+        ,m_bAntiAlias(TRUE)
+        ,m_rcBound(pRcBound)
+        ,m_bFailed(FALSE)
+    {
+        m_list.Attach(new SDisplayList);
+        pRTRef->CreateCompatibleRenderTarget(CSize(1,1),&m_rtMeasure);
+        SASSERT(m_rtMeasure);
+
+        //录制参考RT的当前绘图对象，保证回放效果和直接绘制一致
+        IRenderObj *pObj = pRTRef->GetCurrentObject(OT_FONT);
+        if(pObj) SelectObject(pObj);
+        pObj = pRTRef->GetCurrentObject(OT_PEN);
+        if(pObj) SelectObject(pObj);
+        pObj = pRTRef->GetCurrentObject(OT_BRUSH);
+        if(pObj) SelectObject(pObj);
+        SetTextColor(pRTRef->GetTextColor());
+        if(pRTRef->GetMaskFilter()) SetMaskFilter(pRTRef->GetMaskFilter());
+        //查询参考RT的混合模式和反走样状态，回放时直接继承目标RT的状态，不需要录制
+        pRTRef->SetXfermode(kSrcOver_Mode,&m_nXferMode);
+        pRTRef->SetXfermode(m_nXferMode);
+        m_bAntiAlias = pRTRef->SetAntiAlias(TRUE);
+        pRTRef->SetAntiAlias(m_bAntiAlias);
+
+        m_arrClipBox.Add(m_rcBound);
+    }
+
+    SDisplayListRecorder::~SDisplayListRecorder()
+    {
+    }
+
+    void SDisplayListRecorder::WriteCmd(int nCmd)
+    {
+        m_list->Write(nCmd);
+    }
+
+    int SDisplayListRecorder::AddBitmap(IBitmap *pBitmap)
+    {
+        DWORD dwVer = pBitmap->GetContentVersion();
+        if(dwVer) return m_list->AddObject(pBitmap,dwVer);
+        //位图没有版本号(如渲染目标的位图)，复制当前内容
+        SAutoRefPtr<IBitmap> pSnap;
+        if(pBitmap->Clone(&pSnap) != S_OK)
+        {
+            m_bFailed = TRUE;
+            return -1;
+        }
+        return m_list->AddObject(pSnap);
+    }
+
+    IRenderTarget * SDisplayListRecorder::SnapshotRT(IRenderTarget *pRTSrc,LPCRECT pRcSrc,int xSrc,int ySrc)
+    {
+        CSize szSnap = CRect(pRcSrc).Size();
+        IRenderTarget *pSnap = NULL;
+        if(m_rtMeasure->CreateCompatibleRenderTarget(szSnap,&pSnap) != S_OK || !pSnap)
+        {
+            m_bFailed = TRUE;
+            return NULL;
+        }
+        CRect rcSnap(CPoint(0,0),szSnap);
+        pSnap->BitBlt(&rcSnap,pRTSrc,xSrc,ySrc,kSrcCopy);
+        return pSnap;
+    }
+
+    void SDisplayListRecorder::WriteRect(LPCRECT pRect)
+    {
+        RECT rc = {0};
+        if(pRect) rc = *pRect;
+        m_list->Write(rc);
+    }
+
+    void SDisplayListRecorder::PushClipBox(const CRect & rc)
+    {
+        m_arrClipBox.Add(rc);
+    }
+
+    HRESULT SDisplayListRecorder::CreateCompatibleRenderTarget(SIZE szTarget,IRenderTarget **ppRenderTarget)
+    {
+        return m_rtMeasure->CreateCompatibleRenderTarget(szTarget,ppRenderTarget);
+    }
+
+    HRESULT SDisplayListRecorder::CreatePen(int iStyle,COLORREF cr,int cWidth,IPen ** ppPen)
+    {
+        return m_rtMeasure->CreatePen(iStyle,cr,cWidth,ppPen);
+    }
+
+    HRESULT SDisplayListRecorder::CreateSolidColorBrush(COLORREF cr,IBrush ** ppBrush)
+    {
+        return m_rtMeasure->CreateSolidColorBrush(cr,ppBrush);
+    }
+
+    HRESULT SDisplayListRecorder::CreateBitmapBrush( IBitmap *pBmp,IBrush ** ppBrush )
+    {
+        return m_rtMeasure->CreateBitmapBrush(pBmp,ppBrush);
+    }
+
+    HRESULT SDisplayListRecorder::CreateRegion( IRegion ** ppRegion )
+    {
+        return m_rtMeasure->CreateRegion(ppRegion);
+    }
+
+    HRESULT SDisplayListRecorder::Resize(SIZE sz)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT SDisplayListRecorder::OffsetViewportOrg(int xOff, int yOff, LPPOINT lpPoint)
+    {
+        if(lpPoint) *lpPoint = m_ptOrg;
+        m_ptOrg.Offset(xOff,yOff);
+        WriteCmd(DL_OFFSETORG);
+        m_list->Write(CPoint(xOff,yOff));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GetViewportOrg(LPPOINT lpPoint)
+    {
+        if(lpPoint) *lpPoint = m_ptOrg;
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::SetViewportOrg(POINT pt)
+    {//录制为相对偏移，回放时叠加在目标RT的视口原点上
+        return OffsetViewportOrg(pt.x-m_ptOrg.x,pt.y-m_ptOrg.y);
+    }
+
+    HRESULT SDisplayListRecorder::PushClipRect(LPCRECT pRect,UINT mode)
+    {
+        CRect rc(pRect);
+        rc.OffsetRect(m_ptOrg);
+        CRect rcTop = m_arrClipBox[m_arrClipBox.GetCount()-1];
+        switch(mode)
+        {
+        case RGN_AND: rcTop &= rc;break;
+        case RGN_COPY: rcTop = rc & m_rcBound;break;
+        case RGN_OR: rcTop |= rc;break;
+        }
+        PushClipBox(rcTop);
+        WriteCmd(DL_PUSHCLIPRECT);
+        WriteRect(pRect);
+        //录制内容没有外部的剪裁区，回放时RGN_COPY需要和目标RT的剪裁区求交
+        m_list->Write((int)(mode==RGN_COPY?RGN_AND:mode));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::PushClipRegion(IRegion *pRegion,UINT mode)
+    {
+        CRect rc;
+        pRegion->GetRgnBox(&rc);
+        rc.OffsetRect(m_ptOrg);
+        CRect rcTop = m_arrClipBox[m_arrClipBox.GetCount()-1];
+        switch(mode)
+        {
+        case RGN_AND: rcTop &= rc;break;
+        case RGN_COPY: rcTop = rc & m_rcBound;break;
+        case RGN_OR: rcTop |= rc;break;
+        }
+        PushClipBox(rcTop);
+
+        //区域对象可能在录制后被修改，保存一份副本
+        SAutoRefPtr<IRegion> rgn;
+        CreateRegion(&rgn);
+        rgn->CombineRgn(pRegion,RGN_COPY);
+        WriteCmd(DL_PUSHCLIPREGION);
+        m_list->Write(m_list->AddObject(rgn));
+        m_list->Write((int)(mode==RGN_COPY?RGN_AND:mode));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::PopClip()
+    {
+        if(m_arrClipBox.GetCount()>1)
+            m_arrClipBox.RemoveAt(m_arrClipBox.GetCount()-1);
+        WriteCmd(DL_POPCLIP);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::ExcludeClipRect(LPCRECT pRc)
+    {
+        WriteCmd(DL_EXCLUDECLIPRECT);
+        WriteRect(pRc);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::IntersectClipRect(LPCRECT pRc)
+    {
+        CRect rc(pRc);
+        rc.OffsetRect(m_ptOrg);
+        m_arrClipBox[m_arrClipBox.GetCount()-1] &= rc;
+        WriteCmd(DL_INTERSECTCLIPRECT);
+        WriteRect(pRc);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::SaveClip(int *pnState)
+    {
+        int nId = (int)m_arrSaveDepth.GetCount();
+        m_arrSaveDepth.Add((int)m_arrClipBox.GetCount());
+        PushClipBox(m_arrClipBox[m_arrClipBox.GetCount()-1]);
+        if(pnState) *pnState = nId;
+        WriteCmd(DL_SAVECLIP);
+        m_list->Write(nId);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::RestoreClip(int nState)
+    {
+        int nDepth = 1;
+        if(nState>=0 && nState<(int)m_arrSaveDepth.GetCount())
+        {
+            nDepth = m_arrSaveDepth[nState];
+            m_arrSaveDepth.RemoveAt(nState,m_arrSaveDepth.GetCount()-nState);
+        }else
+        {
+            nState = -1;
+            m_arrSaveDepth.RemoveAll();
+        }
+        if((int)m_arrClipBox.GetCount() > nDepth)
+            m_arrClipBox.RemoveAt(nDepth,m_arrClipBox.GetCount()-nDepth);
+        WriteCmd(DL_RESTORECLIP);
+        m_list->Write(nState);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GetClipRegion(IRegion **ppRegion)
+    {
+        HRESULT hr = CreateRegion(ppRegion);
+        if(FAILED(hr)) return hr;
+        CRect rc;
+        GetClipBox(&rc);
+        (*ppRegion)->CombineRect(&rc,RGN_COPY);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GetClipBox(LPRECT prc)
+    {
+        if(!m_mtx.isIdentity())
+        {//有变换时不能确定剪裁区，返回整个录制范围
+            *prc = m_rcBound;
+        }else
+        {
+            *prc = m_arrClipBox[m_arrClipBox.GetCount()-1];
+        }
+        ::OffsetRect(prc,-m_ptOrg.x,-m_ptOrg.y);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawText(LPCTSTR pszText,int cchLen,LPRECT pRc,UINT uFormat)
+    {
+        if(uFormat & DT_CALCRECT)
+        {
+            return m_rtMeasure->DrawText(pszText,cchLen,pRc,uFormat);
+        }
+        if(cchLen < 0) cchLen = (int)_tcslen(pszText);
+        WriteCmd(DL_DRAWTEXT);
+        WriteRect(pRc);
+        m_list->Write((int)uFormat);
+        m_list->WriteString(pszText,cchLen);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::MeasureText(LPCTSTR pszText,int cchLen, SIZE *psz)
+    {
+        return m_rtMeasure->MeasureText(pszText,cchLen,psz);
+    }
+
+    HRESULT SDisplayListRecorder::TextOut(int x,int y, LPCTSTR lpszString,int nCount)
+    {
+        if(nCount < 0) nCount = (int)_tcslen(lpszString);
+        WriteCmd(DL_TEXTOUT);
+        m_list->Write(CPoint(x,y));
+        m_list->WriteString(lpszString,nCount);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawRectangle(LPCRECT pRect)
+    {
+        WriteCmd(DL_DRAWRECTANGLE);
+        WriteRect(pRect);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillRectangle(LPCRECT pRect)
+    {
+        WriteCmd(DL_FILLRECTANGLE);
+        WriteRect(pRect);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillSolidRect(LPCRECT pRect,COLORREF cr)
+    {
+        WriteCmd(DL_FILLSOLIDRECT);
+        WriteRect(pRect);
+        m_list->Write(cr);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawRoundRect(LPCRECT pRect,POINT pt)
+    {
+        WriteCmd(DL_DRAWROUNDRECT);
+        WriteRect(pRect);
+        m_list->Write(pt);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillRoundRect(LPCRECT pRect,POINT pt)
+    {
+        WriteCmd(DL_FILLROUNDRECT);
+        WriteRect(pRect);
+        m_list->Write(pt);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillSolidRoundRect(LPCRECT pRect,POINT pt,COLORREF cr)
+    {
+        WriteCmd(DL_FILLSOLIDROUNDRECT);
+        WriteRect(pRect);
+        m_list->Write(pt);
+        m_list->Write(cr);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::ClearRect(LPCRECT pRect,COLORREF cr)
+    {
+        WriteCmd(DL_CLEARRECT);
+        WriteRect(pRect);
+        m_list->Write(cr);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::InvertRect(LPCRECT pRect)
+    {
+        WriteCmd(DL_INVERTRECT);
+        WriteRect(pRect);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawEllipse(LPCRECT pRect)
+    {
+        WriteCmd(DL_DRAWELLIPSE);
+        WriteRect(pRect);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillEllipse(LPCRECT pRect)
+    {
+        WriteCmd(DL_FILLELLIPSE);
+        WriteRect(pRect);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillSolidEllipse(LPCRECT pRect,COLORREF cr)
+    {
+        WriteCmd(DL_FILLSOLIDELLIPSE);
+        WriteRect(pRect);
+        m_list->Write(cr);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawArc(LPCRECT pRect,float startAngle,float sweepAngle,bool useCenter)
+    {
+        WriteCmd(DL_DRAWARC);
+        WriteRect(pRect);
+        m_list->Write(startAngle);
+        m_list->Write(sweepAngle);
+        m_list->Write((int)useCenter);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillArc(LPCRECT pRect,float startAngle,float sweepAngle)
+    {
+        WriteCmd(DL_FILLARC);
+        WriteRect(pRect);
+        m_list->Write(startAngle);
+        m_list->Write(sweepAngle);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawLines(LPPOINT pPt,size_t nCount)
+    {
+        WriteCmd(DL_DRAWLINES);
+        m_list->Write((int)nCount);
+        m_list->Write(pPt,nCount*sizeof(POINT));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GradientFill(LPCRECT pRect,BOOL bVert,COLORREF crBegin,COLORREF crEnd,BYTE byAlpha)
+    {
+        WriteCmd(DL_GRADIENTFILL);
+        WriteRect(pRect);
+        m_list->Write(bVert);
+        m_list->Write(crBegin);
+        m_list->Write(crEnd);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GradientFillEx( LPCRECT pRect,const POINT* pts,COLORREF *colors,float *pos,int nCount,BYTE byAlpha )
+    {
+        WriteCmd(DL_GRADIENTFILLEX);
+        WriteRect(pRect);
+        m_list->Write((int)byAlpha);
+        m_list->Write(nCount);
+        m_list->Write(pts,2*sizeof(POINT));
+        m_list->Write(colors,nCount*sizeof(COLORREF));
+        m_list->Write(pos,nCount*sizeof(float));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GradientFill2(LPCRECT pRect,GradientType type,COLORREF crStart,COLORREF crCenter,COLORREF crEnd,float fLinearAngle,float fCenterX,float fCenterY,int nRadius,BYTE byAlpha)
+    {
+        WriteCmd(DL_GRADIENTFILL2);
+        WriteRect(pRect);
+        m_list->Write((int)type);
+        m_list->Write(crStart);
+        m_list->Write(crCenter);
+        m_list->Write(crEnd);
+        m_list->Write(fLinearAngle);
+        m_list->Write(fCenterX);
+        m_list->Write(fCenterY);
+        m_list->Write(nRadius);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawIconEx(int xLeft, int yTop, HICON hIcon, int cxWidth,int cyWidth,UINT diFlags)
+    {
+        HICON hCopy = m_list->AddIcon(hIcon);
+        if(!hCopy)
+        {
+            m_bFailed = TRUE;
+            return E_FAIL;
+        }
+        WriteCmd(DL_DRAWICONEX);
+        CRect rc(xLeft,yTop,xLeft+cxWidth,yTop+cyWidth);
+        WriteRect(&rc);
+        m_list->Write(hCopy);
+        m_list->Write((int)diFlags);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawBitmap(LPCRECT pRcDest,IBitmap *pBitmap,int xSrc,int ySrc,BYTE byAlpha)
+    {
+        if(!pBitmap) return E_INVALIDARG;
+        int iBmp = AddBitmap(pBitmap);
+        if(iBmp<0) return E_OUTOFMEMORY;
+        WriteCmd(DL_DRAWBITMAP);
+        WriteRect(pRcDest);
+        m_list->Write(iBmp);
+        m_list->Write(CPoint(xSrc,ySrc));
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawBitmapEx(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha)
+    {
+        if(!pBitmap) return E_INVALIDARG;
+        int iBmp = AddBitmap(pBitmap);
+        if(iBmp<0) return E_OUTOFMEMORY;
+        WriteCmd(DL_DRAWBITMAPEX);
+        WriteRect(pRcDest);
+        m_list->Write(iBmp);
+        WriteRect(pRcSrc);
+        m_list->Write((int)expendMode);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawBitmap9Patch(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha)
+    {
+        if(!pBitmap) return E_INVALIDARG;
+        int iBmp = AddBitmap(pBitmap);
+        if(iBmp<0) return E_OUTOFMEMORY;
+        WriteCmd(DL_DRAWBITMAP9PATCH);
+        WriteRect(pRcDest);
+        m_list->Write(iBmp);
+        WriteRect(pRcSrc);
+        WriteRect(pRcSourMargin);
+        m_list->Write((int)expendMode);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::BitBlt(LPCRECT pRcDest,IRenderTarget *pRTSour,int xSrc,int ySrc,DWORD dwRop)
+    {
+        if(pRTSour->IsClass(GetClassName()))
+        {//源是录制RT，没有像素可以复制
+            m_bFailed = TRUE;
+            return E_NOTIMPL;
+        }
+        if(CRect(pRcDest).IsRectEmpty()) return S_OK;
+        //源RT的内容在录制后还会改变，复制用到的区域
+        SAutoRefPtr<IRenderTarget> pSnap;
+        pSnap.Attach(SnapshotRT(pRTSour,pRcDest,xSrc,ySrc));
+        if(!pSnap) return E_OUTOFMEMORY;
+        WriteCmd(DL_BITBLT);
+        WriteRect(pRcDest);
+        m_list->Write(m_list->AddObject(pSnap));
+        m_list->Write(CPoint(0,0));
+        m_list->Write((int)dwRop);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::AlphaBlend(LPCRECT pRcDest,IRenderTarget *pRTSrc,LPCRECT pRcSrc,BYTE byAlpha)
+    {
+        if(pRTSrc->IsClass(GetClassName()))
+        {
+            m_bFailed = TRUE;
+            return E_NOTIMPL;
+        }
+        if(CRect(pRcSrc).IsRectEmpty()) return S_OK;
+        SAutoRefPtr<IRenderTarget> pSnap;
+        pSnap.Attach(SnapshotRT(pRTSrc,pRcSrc,pRcSrc->left,pRcSrc->top));
+        if(!pSnap) return E_OUTOFMEMORY;
+        WriteCmd(DL_ALPHABLEND);
+        WriteRect(pRcDest);
+        m_list->Write(m_list->AddObject(pSnap));
+        CRect rcSnap(CPoint(0,0),CRect(pRcSrc).Size());
+        WriteRect(&rcSnap);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    IRenderObj * SDisplayListRecorder::GetCurrentObject(OBJTYPE uType)
+    {
+        switch(uType)
+        {
+        case OT_PEN: return m_curPen;
+        case OT_BRUSH: return m_curBrush;
+        case OT_FONT: return m_curFont;
+        case OT_BITMAP:
+            //读取目标位图的像素无法录制
+            m_bFailed = TRUE;
+            return m_rtMeasure->GetCurrentObject(OT_BITMAP);
+        }
+        return NULL;
+    }
+
+    HRESULT SDisplayListRecorder::SelectDefaultObject(OBJTYPE objType, IRenderObj ** pOldObj)
+    {
+        if(objType == OT_BITMAP)
+        {
+            m_bFailed = TRUE;
+            return E_NOTIMPL;
+        }
+        m_rtMeasure->SelectDefaultObject(objType);
+        IRenderObj *pDefObj = m_rtMeasure->GetCurrentObject(objType);
+        if(!pDefObj) return E_INVALIDARG;
+        if(pDefObj == GetCurrentObject(objType)) return S_FALSE;
+        return SelectObject(pDefObj,pOldObj);
+    }
+
+    HRESULT SDisplayListRecorder::SelectObject(IRenderObj *pObj,IRenderObj ** pOldObj)
+    {
+        if(!pObj) return E_INVALIDARG;
+        SAutoRefPtr<IRenderObj> pRet;
+        switch(pObj->ObjectType())
+        {
+        case OT_PEN:
+            pRet = m_curPen;
+            m_curPen = (IPen*)pObj;
+            break;
+        case OT_BRUSH:
+            pRet = m_curBrush;
+            m_curBrush = (IBrush*)pObj;
+            break;
+        case OT_FONT:
+            pRet = m_curFont;
+            m_curFont = (IFont*)pObj;
+            m_rtMeasure->SelectObject(pObj);
+            break;
+        default:
+            //选入位图会改变绘制目标，无法录制
+            m_bFailed = TRUE;
+            return E_NOTIMPL;
+        }
+        WriteCmd(DL_SELECTOBJECT);
+        m_list->Write(m_list->AddObject(pObj));
+        if(pRet && pOldObj)
+        {//由调用者调用Release释放该RenderObj
+            pRet->AddRef();
+            *pOldObj = pRet;
+        }
+        return S_OK;
+    }
+
+    COLORREF SDisplayListRecorder::GetTextColor()
+    {
+        return m_crText;
+    }
+
+    COLORREF SDisplayListRecorder::SetTextColor(COLORREF color)
+    {
+        COLORREF crOld = m_crText;
+        m_crText = color;
+        m_rtMeasure->SetTextColor(color);
+        WriteCmd(DL_SETTEXTCOLOR);
+        m_list->Write(color);
+        return crOld;
+    }
+
+    void SDisplayListRecorder::SetMaskFilter(IMaskFilter *pMaskFilter)
+    {
+        m_curMaskFilter = pMaskFilter;
+        WriteCmd(DL_SETMASKFILTER);
+        m_list->Write(m_list->AddObject(pMaskFilter));
+    }
+
+    IMaskFilter * SDisplayListRecorder::GetMaskFilter()
+    {
+        return m_curMaskFilter;
+    }
+
+    HDC SDisplayListRecorder::GetDC(UINT uFlag)
+    {//GDI绘制无法录制，返回测量RT的DC保证调用者可以正常执行
+        m_bFailed = TRUE;
+        return m_rtMeasure->GetDC(uFlag);
+    }
+
+    void SDisplayListRecorder::ReleaseDC(HDC hdc)
+    {
+        m_rtMeasure->ReleaseDC(hdc);
+    }
+
+    HRESULT SDisplayListRecorder::SetTransform(const float matrix[9], float oldMatrix[9])
+    {
+        if(oldMatrix) memcpy(oldMatrix,m_mtx.GetData(),9*sizeof(float));
+        m_mtx = SMatrix(matrix);
+        WriteCmd(DL_SETTRANSFORM);
+        m_list->Write(matrix,9*sizeof(float));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::GetTransform(float matrix[9]) const
+    {
+        memcpy(matrix,m_mtx.GetData(),9*sizeof(float));
+        return S_OK;
+    }
+
+    COLORREF SDisplayListRecorder::GetPixel(int x, int y)
+    {
+        m_bFailed = TRUE;
+        return 0;
+    }
+
+    COLORREF SDisplayListRecorder::SetPixel(int x, int y, COLORREF cr)
+    {
+        WriteCmd(DL_SETPIXEL);
+        m_list->Write(CPoint(x,y));
+        m_list->Write(cr);
+        return cr;
+    }
+
+    HRESULT SDisplayListRecorder::PushClipPath(const IPath * path, UINT mode, bool doAntiAlias)
+    {
+        CRect rc = path->getBounds();
+        rc.OffsetRect(m_ptOrg);
+        CRect rcTop = m_arrClipBox[m_arrClipBox.GetCount()-1];
+        switch(mode)
+        {
+        case RGN_AND: rcTop &= rc;break;
+        case RGN_COPY: rcTop = rc & m_rcBound;break;
+        case RGN_OR: rcTop |= rc;break;
+        }
+        PushClipBox(rcTop);
+
+        //路径对象可能在录制后被修改(如窗口的clipPath会临时偏移)，保存一份副本
+        SAutoRefPtr<IPath> pathCopy;
+        GETRENDERFACTORY->CreatePath(&pathCopy);
+        pathCopy->addPath(path,0.0f,0.0f);
+        WriteCmd(DL_PUSHCLIPPATH);
+        m_list->Write(m_list->AddObject(pathCopy));
+        m_list->Write((int)(mode==RGN_COPY?RGN_AND:mode));
+        m_list->Write((int)doAntiAlias);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::DrawPath(const IPath * path,IPathEffect * pathEffect)
+    {
+        SAutoRefPtr<IPath> pathCopy;
+        GETRENDERFACTORY->CreatePath(&pathCopy);
+        pathCopy->addPath(path,0.0f,0.0f);
+        WriteCmd(DL_DRAWPATH);
+        m_list->Write(m_list->AddObject(pathCopy));
+        m_list->Write(m_list->AddObject(pathEffect));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::FillPath(const IPath * path)
+    {
+        SAutoRefPtr<IPath> pathCopy;
+        GETRENDERFACTORY->CreatePath(&pathCopy);
+        pathCopy->addPath(path,0.0f,0.0f);
+        WriteCmd(DL_FILLPATH);
+        m_list->Write(m_list->AddObject(pathCopy));
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::PushLayer(const RECT * pRect,BYTE byAlpha)
+    {
+        PushClipBox(m_arrClipBox[m_arrClipBox.GetCount()-1]);
+        WriteCmd(DL_PUSHLAYER);
+        WriteRect(pRect?pRect:&m_rcBound);
+        m_list->Write((int)byAlpha);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::PopLayer()
+    {
+        if(m_arrClipBox.GetCount()>1)
+            m_arrClipBox.RemoveAt(m_arrClipBox.GetCount()-1);
+        WriteCmd(DL_POPLAYER);
+        return S_OK;
+    }
+
+    HRESULT SDisplayListRecorder::SetXfermode(int mode,int *pOldMode)
+    {
+        if(pOldMode) *pOldMode = m_nXferMode;
+        m_nXferMode = mode;
+        WriteCmd(DL_SETXFERMODE);
+        m_list->Write(mode);
+        return S_OK;
+    }
+
+    BOOL SDisplayListRecorder::SetAntiAlias(BOOL bAntiAlias)
+    {
+        BOOL bRet = m_bAntiAlias;
+        m_bAntiAlias = bAntiAlias;
+        WriteCmd(DL_SETANTIALIAS);
+        m_list->Write(bAntiAlias);
+        return bRet;
+    }
+}
@@ -0,0 +1,310 @@
+﻿#include "souistd.h"
+#include "helper/SFrameProfiler.h"
+#include "helper/SColor.h"
+
+namespace SOUI
+{
+    //浮层的尺寸，100%缩放时的像素
+    static const int KOverlayWidth = 260;
+    static const int KOverlayLine = 16;
+    static const int KOverlayGraph = 40;
+    static const int KOverlayPadding = 4;
+    static const int KOverlayLines = 4 + SFrameProfiler::kOverlayWnds;
+    //帧耗时曲线的满刻度: 2帧@60Hz
+    static const UINT64 KGraphFullUs = 33333;
+    static const UINT64 KFrameBudgetUs = 16667;
+
+    LONGLONG SFrameProfiler::Now()
+    {
+        LARGE_INTEGER li;
+        ::QueryPerformanceCounter(&li);
+        return li.QuadPart;
+    }
+
+    UINT64 SFrameProfiler::ToUs(LONGLONG llCount)
+    {
+        static LONGLONG s_llFreq = 0;
+        if(s_llFreq == 0)
+        {
+            LARGE_INTEGER li;
+            ::QueryPerformanceFrequency(&li);
+            s_llFreq = li.QuadPart;
+        }
+        return (UINT64)(llCount*1000000/s_llFreq);
+    }
+
+    SFrameProfiler::SFrameProfiler():m_bOverlay(FALSE)
+    {
+        Reset();
+    }
+
+    SFrameProfiler::~SFrameProfiler()
+    {
+    }
+
+    void SFrameProfiler::Reset()
+    {
+        memset(m_frames,0,sizeof(m_frames));
+        m_iNext = 0;
+        m_nFrames = 0;
+        m_dwSerial = 0;
+        m_nFrameWnds = 0;
+        m_nFrameWndPixels = 0;
+        m_nFrameCulledWnds = 0;
+        m_nFrameCulledPixels = 0;
+        m_usPendingAnim = 0;
+        m_mapWndCost.RemoveAll();
+    }
+
+    void SFrameProfiler::BeginFrame()
+    {
+        m_dwSerial++;
+        m_nFrameWnds = 0;
+        m_nFrameWndPixels = 0;
+        m_nFrameCulledWnds = 0;
+        m_nFrameCulledPixels = 0;
+    }
+
+    void SFrameProfiler::EndFrame(UINT64 usLayout,UINT64 usPaint,UINT64 usPresent,int nDirtyRects,UINT64 nDirtyPixels,BOOL bFullPaint,BOOL bDirtyOverflow)
+    {
+        FrameRecord & rec = m_frames[m_iNext];
+        rec.dwTime = GetTickCount();
+        rec.usAnimation = m_usPendingAnim;
+        rec.usLayout = usLayout;
+        rec.usPaint = usPaint;
+        rec.usPresent = usPresent;
+        rec.nDirtyRects = nDirtyRects;
+        rec.nPaintedWnds = m_nFrameWnds;
+        rec.bFullPaint = bFullPaint;
+        rec.bDirtyOverflow = bDirtyOverflow;
+        rec.nDirtyPixels = nDirtyPixels;
+        rec.nWndPixels = m_nFrameWndPixels;
+        rec.nCulledWnds = m_nFrameCulledWnds;
+        rec.nCulledPixels = m_nFrameCulledPixels;
+
+        m_usPendingAnim = 0;
+        m_iNext = (m_iNext + 1) % kMaxFrames;
+        if(m_nFrames < kMaxFrames) m_nFrames++;
+    }
+
+    void SFrameProfiler::OnWndPainted(SWindow *pWnd,UINT64 us)
+    {
+        SWND swnd = pWnd->GetSwnd();
+        SMap<SWND,WndCost>::CPair *p = m_mapWndCost.Lookup(swnd);
+        if(!p)
+        {
+            WndCost cost;
+            cost.swnd = swnd;
+            cost.strClass = pWnd->GetObjectClass();
+            cost.strName = pWnd->GetName();
+            cost.nFrames = 0;
+            cost.usTotal = cost.usMax = cost.usFrame = 0;
+            cost.dwSerial = m_dwSerial - 1;
+            m_mapWndCost[swnd] = cost;
+            p = m_mapWndCost.Lookup(swnd);
+        }
+        WndCost & cost = p->m_value;
+        if(cost.dwSerial != m_dwSerial)
+        {
+            cost.dwSerial = m_dwSerial;
+            cost.usFrame = 0;
+            cost.nFrames++;
+            m_nFrameWnds++;
+        }
+        cost.usFrame += us;
+        cost.usTotal += us;
+        if(cost.usFrame > cost.usMax) cost.usMax = cost.usFrame;
+    }
+
+    const SFrameProfiler::FrameRecord * SFrameProfiler::GetFrame(int iBack) const
+    {
+        if(iBack < 0 || iBack >= m_nFrames) return NULL;
+        return &m_frames[(m_iNext - 1 - iBack + kMaxFrames) % kMaxFrames];
+    }
+
+    static int __cdecl _CompareWndCost(const void *p1,const void *p2)
+    {
+        const SFrameProfiler::WndCost *c1 = *(const SFrameProfiler::WndCost**)p1;
+        const SFrameProfiler::WndCost *c2 = *(const SFrameProfiler::WndCost**)p2;
+        if(c1->usTotal == c2->usTotal) return 0;
+        return c1->usTotal > c2->usTotal ? -1 : 1;
+    }
+
+    void SFrameProfiler::GetWndCosts(SArray<WndCost> & arrCost,int nTop) const
+    {
+        arrCost.RemoveAll();
+        SArray<const WndCost*> arrSort;
+        SPOSITION pos = m_mapWndCost.GetStartPosition();
+        while(pos)
+        {
+            arrSort.Add(&m_mapWndCost.GetNextValue(pos));
+        }
+        if(arrSort.IsEmpty()) return;
+        qsort(arrSort.GetData(),arrSort.GetCount(),sizeof(const WndCost*),_CompareWndCost);
+        size_t nCount = arrSort.GetCount();
+        if(nTop >= 0 && (size_t)nTop < nCount) nCount = nTop;
+        for(size_t i=0;i<nCount;i++)
+        {
+            arrCost.Add(*arrSort[i]);
+        }
+    }
+
+    static void _JsonAppendString(SStringW & str,const SStringW & strValue)
+    {
+        str += L'"';
+        for(int i=0;i<strValue.GetLength();i++)
+        {
+            wchar_t c = strValue[i];
+            if(c == L'"' || c == L'\\')
+            {
+                str += L'\\';
+                str += c;
+            }else if(c < 0x20)
+            {
+                str.AppendFormat(L"\\u%04x",c);
+            }else
+            {
+                str += c;
+            }
+        }
+        str += L'"';
+    }
+
+    SStringW SFrameProfiler::ToJson(int nTop) const
+    {
+        SStringW str = L"{\"frames\":[";
+        UINT64 usSum = 0, usMax = 0;
+        //从最早的一帧开始输出
+        for(int i=m_nFrames-1;i>=0;i--)
+        {
+            const FrameRecord *pRec = GetFrame(i);
+            if(i != m_nFrames-1) str += L',';
+            str.AppendFormat(L"{\"time\":%u,\"animation\":%I64u,\"layout\":%I64u,\"paint\":%I64u,\"present\":%I64u,\"dirtyRects\":%d,\"paintedWnds\":%d,\"fullPaint\":%s,\"dirtyOverflow\":%s",
+                pRec->dwTime,pRec->usAnimation,pRec->usLayout,pRec->usPaint,pRec->usPresent,
+                pRec->nDirtyRects,pRec->nPaintedWnds,
+                pRec->bFullPaint?L"true":L"false",pRec->bDirtyOverflow?L"true":L"false");
+            str.AppendFormat(L",\"dirtyPixels\":%I64u,\"wndPixels\":%I64u,\"culledWnds\":%d,\"culledPixels\":%I64u}",
+                pRec->nDirtyPixels,pRec->nWndPixels,pRec->nCulledWnds,pRec->nCulledPixels);
+            usSum += pRec->Total();
+            if(pRec->Total() > usMax) usMax = pRec->Total();
+        }
+        str.AppendFormat(L"],\"summary\":{\"frames\":%d,\"avgFrame\":%I64u,\"maxFrame\":%I64u},\"windows\":[",
+            m_nFrames,m_nFrames?usSum/m_nFrames:0,usMax);
+
+        SArray<WndCost> arrCost;
+        GetWndCosts(arrCost,nTop);
+        for(size_t i=0;i<arrCost.GetCount();i++)
+        {
+            const WndCost & cost = arrCost[i];
+            if(i) str += L',';
+            str.AppendFormat(L"{\"swnd\":%u,\"class\":",(UINT)cost.swnd);
+            _JsonAppendString(str,cost.strClass);
+            str += L",\"name\":";
+            _JsonAppendString(str,cost.strName);
+            str.AppendFormat(L",\"frames\":%u,\"total\":%I64u,\"max\":%I64u}",cost.nFrames,cost.usTotal,cost.usMax);
+        }
+        str += L"]}";
+        return str;
+    }
+
+    CRect SFrameProfiler::GetOverlayRect(const CRect & rcHost,int nScale) const
+    {
+        int nWid = KOverlayWidth * nScale / 100;
+        int nHei = (KOverlayPadding*3 + KOverlayLine*KOverlayLines + KOverlayGraph) * nScale / 100;
+        int nMargin = KOverlayPadding * nScale / 100;
+        CRect rc(rcHost.right - nMargin - nWid, rcHost.top + nMargin, rcHost.right - nMargin, rcHost.top + nMargin + nHei);
+        rc.IntersectRect(rc,rcHost);
+        return rc;
+    }
+
+    void SFrameProfiler::DrawOverlay(IRenderTarget *pRT,const CRect & rcHost,int nScale) const
+    {
+        CRect rcOverlay = GetOverlayRect(rcHost,nScale);
+        if(rcOverlay.IsRectEmpty()) return;
+
+        pRT->PushClipRect(&rcOverlay,RGN_AND);
+        pRT->FillSolidRect(&rcOverlay,RGBA(0,0,0,200));
+
+        int nPadding = KOverlayPadding * nScale / 100;
+        int nLine = KOverlayLine * nScale / 100;
+        CRect rcLine = rcOverlay;
+        rcLine.DeflateRect(nPadding,nPadding);
+        rcLine.bottom = rcLine.top + nLine;
+
+        SAutoRefPtr<IFont> oldFont;
+        pRT->SelectObject(SFontPool::getSingleton().GetFont(FF_DEFAULTFONT,nScale),(IRenderObj**)&oldFont);
+        COLORREF crOld = pRT->SetTextColor(RGBA(255,255,255,255));
+        const UINT KTextFmt = DT_SINGLELINE|DT_VCENTER|DT_LEFT|DT_NOPREFIX|DT_END_ELLIPSIS;
+
+        //最近一秒的帧数
+        int nFps = 0;
+        DWORD dwNow = GetTickCount();
+        for(int i=0;i<m_nFrames;i++)
+        {
+            if(dwNow - GetFrame(i)->dwTime > 1000) break;
+            nFps++;
+        }
+        SStringT str;
+        const FrameRecord *pLast = GetFrame(0);
+        if(pLast)
+            str.Format(_T("fps %d  frame %.2fms"),nFps,pLast->Total()/1000.0);
+        else
+            str = _T("fps 0");
+        pRT->DrawText(str,str.GetLength(),&rcLine,KTextFmt);
+        rcLine.OffsetRect(0,nLine);
+
+        if(pLast)
+        {
+            str.Format(_T("anim %.2f layout %.2f paint %.2f present %.2f"),
+                pLast->usAnimation/1000.0,pLast->usLayout/1000.0,pLast->usPaint/1000.0,pLast->usPresent/1000.0);
+            pRT->DrawText(str,str.GetLength(),&rcLine,KTextFmt);
+            rcLine.OffsetRect(0,nLine);
+            str.Format(_T("dirty %d%s  painted wnds %d"),pLast->nDirtyRects,
+                pLast->bFullPaint?_T("(full)"):(pLast->bDirtyOverflow?_T("(overflow)"):_T("")),pLast->nPaintedWnds);
+            pRT->DrawText(str,str.GetLength(),&rcLine,KTextFmt);
+            rcLine.OffsetRect(0,nLine);
+            str.Format(_T("overdraw %.2fx  culled wnds %d"),pLast->Overdraw(),pLast->nCulledWnds);
+            pRT->DrawText(str,str.GetLength(),&rcLine,KTextFmt);
+        }else
+        {
+            rcLine.OffsetRect(0,nLine*2);
+        }
+        rcLine.OffsetRect(0,nLine + nPadding);
+
+        //帧耗时曲线，最新的一帧在右边
+        CRect rcGraph(rcLine.left,rcLine.top,rcLine.right,rcLine.top + KOverlayGraph * nScale / 100);
+        pRT->FillSolidRect(&rcGraph,RGBA(255,255,255,40));
+        int nBarWid = smax(rcGraph.Width() / (int)kMaxFrames,1);
+        int xBar = rcGraph.right;
+        for(int i=0;i<m_nFrames && xBar > rcGraph.left;i++)
+        {
+            UINT64 usFrame = GetFrame(i)->Total();
+            int nHei = (int)(smin(usFrame,KGraphFullUs) * rcGraph.Height() / KGraphFullUs);
+            COLORREF cr = usFrame <= KFrameBudgetUs ? RGBA(0,200,0,255) : (usFrame <= KGraphFullUs ? RGBA(230,200,0,255) : RGBA(230,0,0,255));
+            CRect rcBar(xBar - nBarWid,rcGraph.bottom - smax(nHei,1),xBar,rcGraph.bottom);
+            pRT->FillSolidRect(&rcBar,cr);
+            xBar -= nBarWid;
+        }
+        //一帧的预算线
+        int yBudget = rcGraph.bottom - (int)(KFrameBudgetUs * rcGraph.Height() / KGraphFullUs);
+        CRect rcBudget(rcGraph.left,yBudget,rcGraph.right,yBudget+1);
+        pRT->FillSolidRect(&rcBudget,RGBA(255,255,255,160));
+
+        //绘制最耗时的窗口
+        rcLine.OffsetRect(0,rcGraph.Height() + nPadding);
+        SArray<WndCost> arrCost;
+        GetWndCosts(arrCost,kOverlayWnds);
+        for(size_t i=0;i<arrCost.GetCount();i++)
+        {
+            const WndCost & cost = arrCost[i];
+            str.Format(_T("%s[%s] %.2fms max %.2fms"),(LPCTSTR)S_CW2T(cost.strClass),(LPCTSTR)S_CW2T(cost.strName),
+                cost.usTotal/1000.0/smax(cost.nFrames,(DWORD)1),cost.usMax/1000.0);
+            pRT->DrawText(str,str.GetLength(),&rcLine,KTextFmt);
+            rcLine.OffsetRect(0,nLine);
+        }
+
+        pRT->SetTextColor(crOld);
+        pRT->SelectObject(oldFont);
+        pRT->PopClip();
+    }
+}
@@ -0,0 +1,248 @@
+﻿#include "souistd.h"
+#include "helper/SHitTestGrid.h"
+
+namespace SOUI
+{
+    //占用超过这个数量单元格的窗口登记为大窗口
+    static const int KMaxCellsPerWnd = 16;
+
+    SHitTestGrid::SHitTestGrid(SWindow *pRoot,int nCellSize)
+        :m_pRoot(pRoot)
+        ,m_nCellSize(smax(nCellSize,8))
+        ,m_nCols(0)
+        ,m_nRows(0)
+        ,m_pCells(NULL)
+        ,m_bDirty(TRUE)
+    {
+        ResetStats();
+    }
+
+    SHitTestGrid::~SHitTestGrid()
+    {
+        delete []m_pCells;
+    }
+
+    void SHitTestGrid::ResetStats()
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    BOOL SHitTestGrid::_IsComplex(SWindow *pWnd)
+    {
+        return pWnd->m_clipRgn || pWnd->GetTransformation().hasMatrix();
+    }
+
+    void SHitTestGrid::OnWndChanged(SWindow *pWnd,HitTestChange change)
+    {
+        if(m_bDirty) return;
+        if(pWnd == m_pRoot)
+        {//根窗口变化需要重新划分网格
+            m_bDirty = TRUE;
+            return;
+        }
+        SWND swnd = pWnd->GetSwnd();
+        const SMap<SWND,WndEntry>::CPair *p = m_mapEntry.Lookup(swnd);
+        switch(change)
+        {
+        case HITCHANGE_RECT:
+            //没有登记的窗口是隐藏的或者在有变换的子树中，不需要更新
+            if(p)
+            {
+                WndEntry entry = p->m_value;
+                _Remove(swnd,entry);
+                _Insert(pWnd);
+            }
+            break;
+        case HITCHANGE_XFORM:
+            {//动画每帧都会通知，变换状态没有改变时保持索引
+                BOOL bComplex = _IsComplex(pWnd);
+                if(p && !bComplex) break;
+                if(!p && bComplex && m_arrComplex.Find(swnd) != -1) break;
+                m_bDirty = TRUE;
+            }
+            break;
+        default:
+            m_bDirty = TRUE;
+            break;
+        }
+    }
+
+    void SHitTestGrid::Rebuild()
+    {
+        m_stats.nRebuilds++;
+        m_rcBound = m_pRoot->GetWindowRect();
+        int nCols = (m_rcBound.Width() + m_nCellSize - 1) / m_nCellSize;
+        int nRows = (m_rcBound.Height() + m_nCellSize - 1) / m_nCellSize;
+        if(nCols != m_nCols || nRows != m_nRows)
+        {
+            delete []m_pCells;
+            m_pCells = NULL;
+            m_nCols = nCols;
+            m_nRows = nRows;
+            if(m_nCols > 0 && m_nRows > 0)
+                m_pCells = new SArray<SWND>[m_nCols*m_nRows];
+        }else
+        {
+            for(int i=0;i<m_nCols*m_nRows;i++)
+                m_pCells[i].RemoveAll();
+        }
+        m_arrLarge.RemoveAll();
+        m_arrComplex.RemoveAll();
+        m_mapEntry.RemoveAll();
+
+        _AddSubtree(m_pRoot);
+        m_bDirty = FALSE;
+    }
+
+    void SHitTestGrid::_AddSubtree(SWindow *pParent)
+    {
+        SWindow *pChild = pParent->GetWindow(GSW_FIRSTCHILD);
+        while(pChild)
+        {
+            if(pChild->IsVisible(TRUE))
+            {
+                if(_IsComplex(pChild))
+                {
+                    m_arrComplex.Add(pChild->GetSwnd());
+                }else
+                {
+                    _Insert(pChild);
+                    _AddSubtree(pChild);
+                }
+            }
+            pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+        }
+    }
+
+    BOOL SHitTestGrid::_GetCellRange(const CRect & rcWnd,CRect & rcCells) const
+    {
+        CRect rc = rcWnd & m_rcBound;
+        if(rc.IsRectEmpty() || !m_pCells) return FALSE;
+        rcCells.left = (rc.left - m_rcBound.left) / m_nCellSize;
+        rcCells.top = (rc.top - m_rcBound.top) / m_nCellSize;
+        rcCells.right = (rc.right - 1 - m_rcBound.left) / m_nCellSize + 1;
+        rcCells.bottom = (rc.bottom - 1 - m_rcBound.top) / m_nCellSize + 1;
+        return TRUE;
+    }
+
+    void SHitTestGrid::_Insert(SWindow *pWnd)
+    {
+        SWND swnd = pWnd->GetSwnd();
+        WndEntry entry;
+        entry.bLarge = FALSE;
+        if(!_GetCellRange(pWnd->GetWindowRect(),entry.rcCells))
+        {//在网格外，仍然登记，以便移动到网格内时更新
+            entry.rcCells.SetRectEmpty();
+        }else if(entry.rcCells.Width()*entry.rcCells.Height() > KMaxCellsPerWnd)
+        {
+            entry.bLarge = TRUE;
+            m_arrLarge.Add(swnd);
+        }else
+        {
+            for(int y=entry.rcCells.top;y<entry.rcCells.bottom;y++)
+            for(int x=entry.rcCells.left;x<entry.rcCells.right;x++)
+            {
+                m_pCells[y*m_nCols+x].Add(swnd);
+            }
+        }
+        m_mapEntry[swnd] = entry;
+    }
+
+    void SHitTestGrid::_Remove(SWND swnd,const WndEntry & entry)
+    {
+        if(entry.bLarge)
+        {
+            int idx = m_arrLarge.Find(swnd);
+            if(idx != -1) m_arrLarge.RemoveAt(idx);
+        }else
+        {
+            for(int y=entry.rcCells.top;y<entry.rcCells.bottom;y++)
+            for(int x=entry.rcCells.left;x<entry.rcCells.right;x++)
+            {
+                SArray<SWND> & cell = m_pCells[y*m_nCols+x];
+                int idx = cell.Find(swnd);
+                if(idx != -1) cell.RemoveAt(idx);
+            }
+        }
+        m_mapEntry.RemoveKey(swnd);
+    }
+
+    BOOL SHitTestGrid::_CheckAncestors(SWindow *pParent,const CPoint & pt,bool bIncludeMsgTransparent) const
+    {
+        //和SWindow::SwndFromPoint一样: 只有点在父窗口客户区内才继续测试子窗口
+        while(pParent && pParent != m_pRoot)
+        {
+            if(!bIncludeMsgTransparent && pParent->IsMsgTransparent())
+                return FALSE;
+            if(!pParent->IsContainPoint(pt,TRUE))
+                return FALSE;
+            pParent = pParent->GetParent();
+        }
+        //已经从窗口树中移除的窗口不会到达根窗口
+        return pParent == m_pRoot;
+    }
+
+    void SHitTestGrid::_HitCandidate(SWND swnd,const CPoint & pt,bool bIncludeMsgTransparent,SWindow * & pBest)
+    {
+        SWindow *pWnd = SWindowMgr::GetWindow(swnd);
+        if(!pWnd) return;
+        m_stats.nCandidates++;
+        //zorder按先序遍历分配，命中的窗口中zorder最大的就是遍历窗口树的结果
+        if(pBest && pWnd->m_uZorder <= pBest->m_uZorder) return;
+        if(!pWnd->IsVisible(TRUE)) return;
+        if(!bIncludeMsgTransparent && pWnd->IsMsgTransparent()) return;
+        if(!pWnd->IsContainPoint(pt,FALSE)) return;
+        if(!_CheckAncestors(pWnd->GetParent(),pt,bIncludeMsgTransparent)) return;
+        pBest = pWnd;
+    }
+
+    SWND SHitTestGrid::HitTest(CPoint &pt,bool bIncludeMsgTransparent)
+    {
+        if(_IsComplex(m_pRoot))
+        {
+            m_stats.nTreeWalks++;
+            return m_pRoot->SWindow::SwndFromPoint(pt,bIncludeMsgTransparent);
+        }
+        m_stats.nQueries++;
+        if(!m_pRoot->IsContainPoint(pt,FALSE))
+            return NULL;
+        if(!m_pRoot->IsContainPoint(pt,TRUE))
+            return m_pRoot->GetSwnd();
+        if(m_bDirty) Rebuild();
+
+        SWindow *pBest = NULL;
+        if(m_pCells)
+        {
+            int x = smin((pt.x - m_rcBound.left) / m_nCellSize,m_nCols-1);
+            int y = smin((pt.y - m_rcBound.top) / m_nCellSize,m_nRows-1);
+            const SArray<SWND> & cell = m_pCells[y*m_nCols+x];
+            for(size_t i=0;i<cell.GetCount();i++)
+            {
+                _HitCandidate(cell[i],pt,bIncludeMsgTransparent,pBest);
+            }
+        }
+        for(size_t i=0;i<m_arrLarge.GetCount();i++)
+        {
+            _HitCandidate(m_arrLarge[i],pt,bIncludeMsgTransparent,pBest);
+        }
+
+        CPoint ptRet = pt;
+        for(size_t i=0;i<m_arrComplex.GetCount();i++)
+        {//有变换的窗口从该窗口开始遍历子树
+            SWindow *pWnd = SWindowMgr::GetWindow(m_arrComplex[i]);
+            if(!pWnd || !pWnd->IsVisible(TRUE)) continue;
+            if(!bIncludeMsgTransparent && pWnd->IsMsgTransparent()) continue;
+            if(!_CheckAncestors(pWnd->GetParent(),pt,bIncludeMsgTransparent)) continue;
+            m_stats.nTreeWalks++;
+            CPoint pt2 = pt;
+            SWindow *pHit = SWindowMgr::GetWindow(pWnd->SwndFromPoint(pt2,bIncludeMsgTransparent));
+            if(pHit && (!pBest || pHit->m_uZorder > pBest->m_uZorder))
+            {
+                pBest = pHit;
+                ptRet = pt2;
+            }
+        }
+        pt = ptRet;
+        return pBest ? pBest->GetSwnd() : m_pRoot->GetSwnd();
+    }
+}
@@ -1,11 +1,6 @@
 ﻿#include "souistd.h"
 #include "helper/SListViewItemLocator.h"
 
-#pragma warning (push)
-#pragma warning (disable: 4985) // disable the warning message during the include
-#include <math.h>               // this is where I would normally get the warning message
-#pragma warning (pop)
-
 namespace SOUI
 {
     //////////////////////////////////////////////////////////////////////////
@@ -82,18 +77,11 @@ namespace SOUI
 
     //////////////////////////////////////////////////////////////////////////
     //  SListViewItemLocatorFlex
-    double logbase(double a, double base)
-    {
-        return log(a) / log(base);
-    }
-
-#define SEGMENT_SIZE    50  //数据分组最大长度
-#define INDEX_WIDTH     10  //索引表一级最大节点数
-
     SListViewItemLocatorFlex::SListViewItemLocatorFlex(SLayoutSize nItemHei,SLayoutSize nDividerSize) 
         :m_nItemHeight(nItemHei)
         ,m_nDividerSize(nDividerSize)
 		,m_nScale(100)
+        ,m_nItems(0)
     {
 
     }
@@ -106,7 +94,8 @@ namespace SOUI
 	void SListViewItemLocatorFlex::SetScale(int nScale)
 	{
 		m_nScale = nScale;
-		OnDataSetChanged();
+		//缩放后已测量的高度失效, 全部恢复为默认高度
+		InitIndex(m_adapter?m_adapter->getCount():0);
 	}
 
 	int SListViewItemLocatorFlex::GetScrollLineSize() const
@@ -124,87 +113,72 @@ namespace SOUI
         if(!m_adapter) return -1;
         if(position<0 || position>=GetTotalHeight()) 
             return -1;
-        HSTREEITEM hItem = Offset2Branch(STVI_ROOT,position);
-        SASSERT(hItem);
-        int idx = Branch2Index(hItem);
-        int offset = Branch2Offset(hItem);
-        BranchInfo &bi = m_itemPosIndex.GetItemRef(hItem);
-		(void)bi;
-        SASSERT(bi.nBranchHei>=position-offset);
-
-        int iSeg = idx/SEGMENT_SIZE;
-        int nRemain = position - offset;
-
-        SegmentInfo *psi = m_segments[iSeg];
-
-        for(int i=0;i<psi->nItems;i++)
+        //在块索引上从高位到低位逐级二分, 找出结束位置不超过position的块, 再在块内查找
+        int nBlocks = (int)m_heightBlocks.GetCount();
+        int nFixHei = GetFixItemHeight();
+        int nStep = 1;
+        while(nStep <= nBlocks/2) nStep <<= 1;
+
+        int iBlock = 0;
+        int iItem = 0;
+        int nRemain = position;
+        for(;nStep>0;nStep>>=1)
+        {
+            int iNext = iBlock + nStep;
+            if(iNext > nBlocks) continue;
+            int nBranchHei = m_blockSums[iNext-1] + m_blockItems[iNext-1]*nFixHei;
+            if(nBranchHei <= nRemain)
+            {
+                iBlock = iNext;
+                iItem += m_blockItems[iNext-1];
+                nRemain -= nBranchHei;
+            }
+        }
+        SASSERT(iBlock<nBlocks);
+        const HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+        for(int i=0;i<pBlock->nItems;i++)
         {
-            int nItemHei = psi->pItemHeight[i]==-1?GetFixItemHeight():psi->pItemHeight[i];
-            if(nRemain<=nItemHei) return idx + i;
-            nRemain -= nItemHei;
+            int nHei = nFixHei + pBlock->nDelta[i];
+            if(nRemain < nHei) return iItem + i;
+            nRemain -= nHei;
         }
-
         SASSERT(FALSE);
-        return -1;
+        return m_nItems-1;
     }
 
     int SListViewItemLocatorFlex::Item2Position(int iItem)
     {
         if(!m_adapter) return 0;
-        int iSeg = iItem/SEGMENT_SIZE;
-        int iSubItem = iItem%SEGMENT_SIZE;
-        SegmentInfo *psi = m_segments[iSeg];
-
-        int nPos = Branch2Offset(psi->hItem);
-        for(int i=0;i<iSubItem;i++)
-        {
-            nPos += psi->pItemHeight[i]==-1?GetFixItemHeight():psi->pItemHeight[i];
-        }
-        return nPos;
+        SASSERT(iItem>=0 && iItem<=m_nItems);
+        return iItem*GetFixItemHeight() + IndexSum(iItem);
     }
 
     int SListViewItemLocatorFlex::GetTotalHeight()
     {
         if(!m_adapter) return 0;
-        HSTREEITEM hItem = m_itemPosIndex.GetRootItem();
-        int nRet = m_itemPosIndex.GetItem(hItem).nBranchHei;
-        if(m_adapter->getCount()>0) nRet -= GetDividerSize();
+        int nRet = m_nItems*GetFixItemHeight() + IndexSum(m_nItems);
+        if(m_nItems>0) nRet -= GetDividerSize();
         return nRet;
     }
 
     void SListViewItemLocatorFlex::SetItemHeight(int iItem,int nHeight)
     {
         if(!m_adapter) return;
+        SASSERT(iItem>=0 && iItem<m_nItems);
 
-        int iSeg = iItem/SEGMENT_SIZE;
-        int iSubItem = iItem%SEGMENT_SIZE;
-        SegmentInfo *psi = m_segments[iSeg];
-        int nOldHei = psi->pItemHeight[iSubItem];
-        if(nOldHei==-1) nOldHei = GetFixItemHeight();
-
+        int nOldHei = GetFixItemHeight() + IndexValue(iItem);
         nHeight += GetDividerSize();
-        psi->pItemHeight[iSubItem] = nHeight;
         if(nOldHei != nHeight)
         {
-            int nHeiDif = nHeight - nOldHei;
-            HSTREEITEM hBranch = psi->hItem;
-            while(hBranch)
-            {
-                BranchInfo & bi = m_itemPosIndex.GetItemRef(hBranch);
-                bi.nBranchHei += nHeiDif;
-                hBranch = m_itemPosIndex.GetParentItem(hBranch);
-            }
+            IndexAdd(iItem,nHeight - nOldHei);
         }
     }
 
     int SListViewItemLocatorFlex::GetItemHeight(int iItem) const
     {
         if(!m_adapter) return 0;
-        int iSeg = iItem/SEGMENT_SIZE;
-        int iSubItem = iItem%SEGMENT_SIZE;
-        SegmentInfo *psi = m_segments[iSeg];
-        int nRet = psi->pItemHeight[iSubItem];
-        if(nRet == -1) nRet = GetFixItemHeight();
+        SASSERT(iItem>=0 && iItem<m_nItems);
+        int nRet = GetFixItemHeight() + IndexValue(iItem);
         nRet -= GetDividerSize();
         return nRet;
     }
@@ -217,44 +191,60 @@ namespace SOUI
     void SListViewItemLocatorFlex::SetAdapter(ILvAdapter *pAdapter)
     {
         m_adapter = pAdapter;
-        OnDataSetChanged();
+        InitIndex(m_adapter?m_adapter->getCount():0);
     }
 
     void SListViewItemLocatorFlex::OnDataSetChanged()
     {
-        Clear();
-        if(m_adapter)
+        //保留已有的高度索引, 只在尾部追加或截断表项, 避免O(n)重建。
+        //可见表项在刷新时会重新测量, 内容变化的表项由OnItemRangeChanged恢复为默认高度
+        int nCount = m_adapter?m_adapter->getCount():0;
+        if(nCount > m_nItems)
+            InsertIndex(m_nItems,nCount - m_nItems);
+        else if(nCount < m_nItems)
+            RemoveIndex(nCount,m_nItems - nCount);
+    }
+
+    void SListViewItemLocatorFlex::OnItemRangeInserted(int iItem,int nCount)
+    {
+        if(!m_adapter) return;
+        InsertIndex(iItem,nCount);
+    }
+
+    void SListViewItemLocatorFlex::OnItemRangeRemoved(int iItem,int nCount)
+    {
+        if(!m_adapter) return;
+        RemoveIndex(iItem,nCount);
+    }
+
+    void SListViewItemLocatorFlex::OnItemRangeMoved(int iFrom,int iTo,int nCount)
+    {
+        if(!m_adapter || nCount<=0 || iFrom==iTo) return;
+        SASSERT(iFrom>=0 && iFrom+nCount<=m_nItems && iTo>=0 && iTo+nCount<=m_nItems);
+        //表项高度随表项一起移动
+        int *pMoved = new int[nCount];
+        for(int i=0;i<nCount;i++)
+        {
+            pMoved[i] = IndexValue(iFrom+i);
+        }
+        RemoveIndex(iFrom,nCount);
+        InsertIndex(iTo,nCount);
+        for(int i=0;i<nCount;i++)
         {
-            int nTreeSize =  m_adapter->getCount();
-            int nBranchSize = SEGMENT_SIZE;
-            int nTreeDeep = GetIndexDeep();
-            for(int i=0;i<nTreeDeep;i++)
-                nBranchSize *= INDEX_WIDTH;
-            InitIndex(STVI_ROOT,nTreeSize,nBranchSize);
+            if(pMoved[i]) IndexAdd(iTo+i,pMoved[i]);
         }
+        delete []pMoved;
     }
 
-    void SListViewItemLocatorFlex::InitIndex(HSTREEITEM hParent,int nItems,int nBranchSize)
+    void SListViewItemLocatorFlex::OnItemRangeChanged(int iItem,int nCount)
     {
-        BranchInfo bi;
-        bi.nBranchHei = nItems*GetFixItemHeight();
-        bi.nBranchSize = nItems;
-
-        HSTREEITEM hBranch = m_itemPosIndex.InsertItem(bi,hParent);
-        if(nItems > SEGMENT_SIZE)
-        {//插入子节点
-            int nRemain = nItems;
-            int nSubBranchSize = nBranchSize/INDEX_WIDTH;
-            while(nRemain>0)
-            {
-                int nItems2 = nSubBranchSize;
-                if(nItems2>nRemain) nItems2 = nRemain;
-                InitIndex(hBranch,nItems2,nSubBranchSize);
-                nRemain -= nItems2;
-            }
-        }else
+        if(!m_adapter) return;
+        SASSERT(iItem>=0 && iItem+nCount<=m_nItems);
+        //差值为0表示未测量
+        for(int i=iItem;i<iItem+nCount;i++)
         {
-            m_segments.Add(new SegmentInfo(nItems,hBranch));
+            int nDelta = IndexValue(i);
+            if(nDelta) IndexAdd(i,-nDelta);
         }
     }
 
@@ -262,74 +252,251 @@ namespace SOUI
 		return m_nItemHeight.toPixelSize(m_nScale) + m_nDividerSize.toPixelSize(m_nScale);
 	}
 
-    int SListViewItemLocatorFlex::GetIndexDeep() const
+    void SListViewItemLocatorFlex::Clear()
     {
-        if(!m_adapter) return 0;
-        if(m_adapter->getCount()==0) return 0;
-        return (int)ceil(logbase((m_adapter->getCount()+SEGMENT_SIZE-1)/SEGMENT_SIZE,INDEX_WIDTH));
+        for(size_t i=0;i<m_heightBlocks.GetCount();i++)
+        {
+            delete m_heightBlocks[i];
+        }
+        m_heightBlocks.RemoveAll();
+        m_blockItems.RemoveAll();
+        m_blockSums.RemoveAll();
+        m_nItems = 0;
     }
 
-    void SListViewItemLocatorFlex::Clear()
+    void SListViewItemLocatorFlex::InitIndex(int nItems)
     {
-        m_itemPosIndex.DeleteAllItems();
-        for(int i=0;i<(int)m_segments.GetCount();i++)
+        Clear();
+        if(nItems<=0) return;
+        int nBlocks = (nItems + BLOCK_SIZE - 1)/BLOCK_SIZE;
+        m_heightBlocks.SetCount(nBlocks);
+        for(int i=0;i<nBlocks;i++)
         {
-            delete m_segments[i];
+            HEIGHTBLOCK *pBlock = new HEIGHTBLOCK;
+            pBlock->nItems = smin(nItems - i*BLOCK_SIZE,(int)BLOCK_SIZE);
+            pBlock->nSum = 0;
+            memset(pBlock->nDelta,0,pBlock->nItems*sizeof(int));
+            m_heightBlocks[i] = pBlock;
         }
-        m_segments.RemoveAll();
+        m_nItems = nItems;
+        RebuildBlockIndex();
     }
 
-    int SListViewItemLocatorFlex::Branch2Offset(HSTREEITEM hBranch) const
+    void SListViewItemLocatorFlex::InsertIndex(int iItem,int nCount)
     {
-        int nOffset = 0;
-        HSTREEITEM hPrev = m_itemPosIndex.GetPrevSiblingItem(hBranch);
-        while(hPrev)
+        SASSERT(iItem>=0 && iItem<=m_nItems);
+        if(nCount<=0) return;
+        if(m_heightBlocks.IsEmpty())
         {
-            nOffset += m_itemPosIndex.GetItem(hPrev).nBranchHei;
-            hPrev = m_itemPosIndex.GetPrevSiblingItem(hPrev);
+            InitIndex(nCount);
+            return;
+        }
+        int iOffset = 0;
+        int iBlock = FindBlock(iItem,iOffset);
+        if(iBlock == (int)m_heightBlocks.GetCount())
+        {//尾部追加到最后一块
+            iBlock--;
+            iOffset = m_heightBlocks[iBlock]->nItems;
+        }
+        m_nItems += nCount;
+        HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+        int nTail = pBlock->nItems - iOffset;
+        if(pBlock->nItems + nCount <= BLOCK_SIZE)
+        {//块内平移, 只更新块索引, O(B+logM)
+            memmove(pBlock->nDelta+iOffset+nCount,pBlock->nDelta+iOffset,nTail*sizeof(int));
+            memset(pBlock->nDelta+iOffset,0,nCount*sizeof(int));
+            pBlock->nItems += nCount;
+            for(int k=iBlock+1;k<=(int)m_blockItems.GetCount();k += k & -k)
+            {
+                m_blockItems[k-1] += nCount;
+            }
+            return;
         }
-        HSTREEITEM hParent = m_itemPosIndex.GetParentItem(hBranch);
-        if(hParent)
+
+        //块放不下时把原有数据和新表项平均分到若干块中, 第一块复用原来的块
+        int nTailDelta[BLOCK_SIZE];
+        memcpy(nTailDelta,pBlock->nDelta+iOffset,nTail*sizeof(int));
+        int nTotal = pBlock->nItems + nCount;
+        int nBlocks = (nTotal + BLOCK_SIZE - 1)/BLOCK_SIZE;
+        m_heightBlocks.InsertAt(iBlock+1,NULL,nBlocks-1);
+        int iSrc = 0;
+        for(int i=0;i<nBlocks;i++)
         {
-            nOffset += Branch2Offset(hParent);
+            HEIGHTBLOCK *pDst = i==0?pBlock:new HEIGHTBLOCK;
+            int nItems = nTotal/nBlocks + (i < nTotal%nBlocks ? 1 : 0);
+            int nSum = 0;
+            for(int j=0;j<nItems;j++,iSrc++)
+            {//前iOffset项仍在原来的块中, 只会被第一块原位读写
+                int nDelta = 0;
+                if(iSrc < iOffset) nDelta = pBlock->nDelta[iSrc];
+                else if(iSrc >= iOffset + nCount) nDelta = nTailDelta[iSrc - iOffset - nCount];
+                pDst->nDelta[j] = nDelta;
+                nSum += nDelta;
+            }
+            pDst->nItems = nItems;
+            pDst->nSum = nSum;
+            m_heightBlocks[iBlock+i] = pDst;
         }
-        return nOffset;
+        RebuildBlockIndex();
     }
 
-    int SListViewItemLocatorFlex::Branch2Index(HSTREEITEM hBranch) const
+    void SListViewItemLocatorFlex::RemoveIndex(int iItem,int nCount)
     {
-        int iIndex = 0;
-        HSTREEITEM hPrev = m_itemPosIndex.GetPrevSiblingItem(hBranch);
-        while(hPrev)
+        SASSERT(iItem>=0 && iItem+nCount<=m_nItems);
+        if(nCount<=0) return;
+        if(nCount == m_nItems)
         {
-            iIndex += m_itemPosIndex.GetItem(hPrev).nBranchSize;
-            hPrev = m_itemPosIndex.GetPrevSiblingItem(hPrev);
+            Clear();
+            return;
         }
-        HSTREEITEM hParent = m_itemPosIndex.GetParentItem(hBranch);
-        if(hParent)
+        int iOffset = 0;
+        int iBlock = FindBlock(iItem,iOffset);
+        int iFirst = iBlock;
+        BOOL bRebuild = FALSE;
+        m_nItems -= nCount;
+        while(nCount>0)
         {
-            iIndex += Branch2Index(hParent);
+            HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+            int nRemove = smin(nCount,pBlock->nItems - iOffset);
+            nCount -= nRemove;
+            if(nRemove == pBlock->nItems)
+            {//整块删除
+                delete pBlock;
+                m_heightBlocks.RemoveAt(iBlock);
+                bRebuild = TRUE;
+            }else
+            {
+                int nSum = 0;
+                for(int i=iOffset;i<iOffset+nRemove;i++)
+                {
+                    nSum += pBlock->nDelta[i];
+                }
+                memmove(pBlock->nDelta+iOffset,pBlock->nDelta+iOffset+nRemove,(pBlock->nItems-iOffset-nRemove)*sizeof(int));
+                pBlock->nItems -= nRemove;
+                pBlock->nSum -= nSum;
+                if(!bRebuild)
+                {
+                    for(int k=iBlock+1;k<=(int)m_blockItems.GetCount();k += k & -k)
+                    {
+                        m_blockItems[k-1] -= nRemove;
+                        m_blockSums[k-1] -= nSum;
+                    }
+                }
+                iBlock++;
+            }
+            iOffset = 0;
         }
-        return iIndex;
+        //删除范围两端的块可能只剩很少的表项
+        if(MergeBlock(iFirst+1)) bRebuild = TRUE;
+        if(MergeBlock(iFirst)) bRebuild = TRUE;
+        if(bRebuild) RebuildBlockIndex();
     }
 
-    HSTREEITEM SListViewItemLocatorFlex::Offset2Branch(HSTREEITEM hParent,int nOffset)
+    BOOL SListViewItemLocatorFlex::MergeBlock(int iBlock)
     {
-        HSTREEITEM hItem = m_itemPosIndex.GetChildItem(hParent);
-        if(!hItem) return hParent;
+        if(iBlock<0 || iBlock>=(int)m_heightBlocks.GetCount()) return FALSE;
+        HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+        if(pBlock->nItems >= BLOCK_SIZE/4) return FALSE;
+        //合并后最多3/4满, 避免在同一位置反复插入删除时频繁分裂合并
+        int iDst = -1;
+        if(iBlock+1 < (int)m_heightBlocks.GetCount() 
+            && m_heightBlocks[iBlock+1]->nItems + pBlock->nItems <= BLOCK_SIZE*3/4)
+            iDst = iBlock;
+        else if(iBlock > 0 
+            && m_heightBlocks[iBlock-1]->nItems + pBlock->nItems <= BLOCK_SIZE*3/4)
+            iDst = iBlock-1;
+        if(iDst == -1) return FALSE;
+        HEIGHTBLOCK *pDst = m_heightBlocks[iDst];
+        HEIGHTBLOCK *pSrc = m_heightBlocks[iDst+1];
+        memcpy(pDst->nDelta+pDst->nItems,pSrc->nDelta,pSrc->nItems*sizeof(int));
+        pDst->nItems += pSrc->nItems;
+        pDst->nSum += pSrc->nSum;
+        delete pSrc;
+        m_heightBlocks.RemoveAt(iDst+1);
+        return TRUE;
+    }
 
-        while(hItem)
+    void SListViewItemLocatorFlex::RebuildBlockIndex()
+    {
+        int nBlocks = (int)m_heightBlocks.GetCount();
+        m_blockItems.SetCount(nBlocks);
+        m_blockSums.SetCount(nBlocks);
+        for(int i=0;i<nBlocks;i++)
+        {
+            m_blockItems[i] = m_heightBlocks[i]->nItems;
+            m_blockSums[i] = m_heightBlocks[i]->nSum;
+        }
+        //就地建立树状数组, O(M)
+        for(int k=1;k<=nBlocks;k++)
         {
-            BranchInfo bi = m_itemPosIndex.GetItem(hItem);
-            if(nOffset>bi.nBranchHei)
+            int kParent = k + (k & -k);
+            if(kParent<=nBlocks)
             {
-                nOffset -= bi.nBranchHei;
-                hItem = m_itemPosIndex.GetNextSiblingItem(hItem);
-            }else
+                m_blockItems[kParent-1] += m_blockItems[k-1];
+                m_blockSums[kParent-1] += m_blockSums[k-1];
+            }
+        }
+    }
+
+    int SListViewItemLocatorFlex::FindBlock(int iItem,int & iOffset,int *pSumBefore) const
+    {
+        //在块表项数量的树状数组上二分, iItem等于表项数量时返回块数量
+        int nBlocks = (int)m_blockItems.GetCount();
+        int nStep = 1;
+        while(nStep <= nBlocks/2) nStep <<= 1;
+        int iBlock = 0;
+        int nRemain = iItem;
+        int nSum = 0;
+        for(;nStep>0;nStep>>=1)
+        {
+            int iNext = iBlock + nStep;
+            if(iNext > nBlocks) continue;
+            if(m_blockItems[iNext-1] <= nRemain)
+            {
+                iBlock = iNext;
+                nRemain -= m_blockItems[iNext-1];
+                nSum += m_blockSums[iNext-1];
+            }
+        }
+        iOffset = nRemain;
+        if(pSumBefore) *pSumBefore = nSum;
+        return iBlock;
+    }
+
+    int SListViewItemLocatorFlex::IndexSum(int nItems) const
+    {
+        if(nItems<=0) return 0;
+        int iOffset = 0;
+        int nRet = 0;
+        int iBlock = FindBlock(nItems,iOffset,&nRet);
+        if(iOffset>0)
+        {
+            const HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+            for(int i=0;i<iOffset;i++)
             {
-                return Offset2Branch(hItem,nOffset);
+                nRet += pBlock->nDelta[i];
             }
         }
-        return NULL;
+        return nRet;
+    }
+
+    int SListViewItemLocatorFlex::IndexValue(int iItem) const
+    {
+        int iOffset = 0;
+        int iBlock = FindBlock(iItem,iOffset);
+        return m_heightBlocks[iBlock]->nDelta[iOffset];
+    }
+
+    void SListViewItemLocatorFlex::IndexAdd(int iItem,int nDelta)
+    {
+        int iOffset = 0;
+        int iBlock = FindBlock(iItem,iOffset);
+        HEIGHTBLOCK *pBlock = m_heightBlocks[iBlock];
+        pBlock->nDelta[iOffset] += nDelta;
+        pBlock->nSum += nDelta;
+        for(int k=iBlock+1;k<=(int)m_blockSums.GetCount();k += k & -k)
+        {
+            m_blockSums[k-1] += nDelta;
+        }
     }
 }
\ No newline at end of file
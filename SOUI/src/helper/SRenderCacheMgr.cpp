@@ -0,0 +1,136 @@
+﻿#include "souistd.h"
+#include "helper/SRenderCacheMgr.h"
+
+namespace SOUI
+{
+    //默认的缓存预算: 64M
+    static const size_t KDefCacheBudget = 64*1024*1024;
+
+    SRenderCacheMgr::SRenderCacheMgr(void):m_nBudget(KDefCacheBudget)
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    SRenderCacheMgr::~SRenderCacheMgr(void)
+    {
+        SASSERT(m_lstLru.IsEmpty());
+    }
+
+    void SRenderCacheMgr::SetBudget(size_t nBytes)
+    {
+        SAutoLock lock(m_cs);
+        m_nBudget = nBytes;
+        EvictToBudget(NULL);
+    }
+
+    SRenderCacheMgr::CacheStats SRenderCacheMgr::GetStats() const
+    {
+        SAutoLock lock(m_cs);
+        return m_stats;
+    }
+
+    void SRenderCacheMgr::ResetStats()
+    {
+        SAutoLock lock(m_cs);
+        m_stats.nHits = m_stats.nMisses = m_stats.nCreates = m_stats.nEvictions = 0;
+        m_stats.nPeakBytes = m_stats.nBytes;
+    }
+
+    void SRenderCacheMgr::ReleaseCaches(ISwndContainer *pContainer)
+    {
+        SAutoLock lock(m_cs);
+        DWORD dwThreadId = GetCurrentThreadId();
+        //列表项中的窗口的容器是SItemPanel，按宿主窗口匹配
+        HWND hHost = pContainer?pContainer->GetHostHwnd():NULL;
+        SPOSITION pos = m_lstLru.GetHeadPosition();
+        while(pos)
+        {
+            SPOSITION posCur = pos;
+            const CacheEntry & entry = m_lstLru.GetNext(pos);
+            if(entry.dwThreadId != dwThreadId) continue;
+            SWindow *pWnd = entry.pWnd;
+            if(!pContainer || pWnd->GetContainer()->GetHostHwnd() == hHost)
+            {
+                m_stats.nBytes -= m_lstLru.GetAt(posCur).nBytes;
+                m_mapEntry.RemoveKey(pWnd);
+                m_lstLru.RemoveAt(posCur);
+                pWnd->_DropCacheRT();
+            }
+        }
+        m_stats.nCaches = (DWORD)m_lstLru.GetCount();
+    }
+
+    void SRenderCacheMgr::OnCacheCreated(SWindow *pWnd,size_t nBytes)
+    {
+        SAutoLock lock(m_cs);
+        SASSERT(!m_mapEntry.Lookup(pWnd));
+        CacheEntry entry = {pWnd,nBytes,GetCurrentThreadId()};
+        m_mapEntry[pWnd] = m_lstLru.AddTail(entry);
+        m_stats.nCreates ++;
+        m_stats.nCaches = (DWORD)m_lstLru.GetCount();
+        m_stats.nBytes += nBytes;
+        if(m_stats.nBytes > m_stats.nPeakBytes) m_stats.nPeakBytes = m_stats.nBytes;
+        EvictToBudget(pWnd);
+    }
+
+    void SRenderCacheMgr::OnCacheResized(SWindow *pWnd,size_t nBytes)
+    {
+        SAutoLock lock(m_cs);
+        const SMap<SWindow*,SPOSITION>::CPair *p = m_mapEntry.Lookup(pWnd);
+        if(!p) return;
+        CacheEntry & entry = m_lstLru.GetAt(p->m_value);
+        m_stats.nBytes = m_stats.nBytes - entry.nBytes + nBytes;
+        entry.nBytes = nBytes;
+        if(m_stats.nBytes > m_stats.nPeakBytes) m_stats.nPeakBytes = m_stats.nBytes;
+        EvictToBudget(pWnd);
+    }
+
+    void SRenderCacheMgr::OnCachePainted(SWindow *pWnd,bool bHit)
+    {
+        SAutoLock lock(m_cs);
+        if(bHit) m_stats.nHits ++;
+        else m_stats.nMisses ++;
+        const SMap<SWindow*,SPOSITION>::CPair *p = m_mapEntry.Lookup(pWnd);
+        if(p) m_lstLru.MoveToTail(p->m_value);
+    }
+
+    void SRenderCacheMgr::OnCacheReleased(SWindow *pWnd)
+    {
+        SAutoLock lock(m_cs);
+        const SMap<SWindow*,SPOSITION>::CPair *p = m_mapEntry.Lookup(pWnd);
+        if(!p) return;
+        SPOSITION pos = p->m_value;
+        m_stats.nBytes -= m_lstLru.GetAt(pos).nBytes;
+        m_lstLru.RemoveAt(pos);
+        m_mapEntry.RemoveKey(pWnd);
+        m_stats.nCaches = (DWORD)m_lstLru.GetCount();
+    }
+
+    void SRenderCacheMgr::EvictToBudget(SWindow *pExclude)
+    {
+        if(m_nBudget == 0) return;
+        DWORD dwThreadId = GetCurrentThreadId();
+        SPOSITION pos = m_lstLru.GetHeadPosition();
+        while(pos && m_stats.nBytes > m_nBudget)
+        {
+            SPOSITION posCur = pos;
+            const CacheEntry & entry = m_lstLru.GetNext(pos);
+            //正在绘制的窗口不淘汰，即使它自己超出了预算
+            if(entry.pWnd == pExclude) continue;
+            //其它线程的窗口不能在这里访问，由它自己的线程在创建缓存时淘汰
+            if(entry.dwThreadId != dwThreadId) continue;
+            EvictEntry(posCur);
+        }
+    }
+
+    void SRenderCacheMgr::EvictEntry(SPOSITION pos)
+    {
+        CacheEntry entry = m_lstLru.GetAt(pos);
+        m_stats.nBytes -= entry.nBytes;
+        m_stats.nEvictions ++;
+        m_lstLru.RemoveAt(pos);
+        m_mapEntry.RemoveKey(entry.pWnd);
+        m_stats.nCaches = (DWORD)m_lstLru.GetCount();
+        entry.pWnd->_DropCacheRT();
+    }
+}
@@ -3,6 +3,7 @@
 #include "res.mgr/SResProvider.h"
 
 #include "helper/SplitString.h"
+#include "helper/SAutoBuf.h"
 
 namespace SOUI
 {
@@ -212,6 +213,33 @@ namespace SOUI
         }
     }
 
+    IBitmap * SResProviderMgr::LoadImage( LPCTSTR pszType,LPCTSTR pszResName,SIZE szDecode )
+    {
+        if(szDecode.cx<=0 || szDecode.cy<=0) return LoadImage(pszType,pszResName);
+        if(!pszType) return NULL;
+
+        size_t szBuf = GetRawBufferSize(pszType,pszResName);
+        if(szBuf == 0) return NULL;
+        SAutoBuf buf(szBuf);
+        if(!GetRawBuffer(pszType,pszResName,buf,szBuf)) return NULL;
+
+        SAutoRefPtr<IImgX> pImgX;
+        GETRENDERFACTORY->GetImgDecoderFactory()->CreateImgX(&pImgX);
+        if(!pImgX) return NULL;
+        pImgX->SetDecodeSize(szDecode.cx,szDecode.cy);
+        if(0==pImgX->LoadFromMemory(buf,szBuf)) return NULL;
+
+        IBitmap *pImg=NULL;
+        GETRENDERFACTORY->CreateBitmap(&pImg);
+        if(!pImg) return NULL;
+        if(FAILED(pImg->Init(pImgX->GetFrame(0))))
+        {
+            pImg->Release();
+            pImg=NULL;
+        }
+        return pImg;
+    }
+
     HBITMAP SResProviderMgr::LoadBitmap( LPCTSTR pszResName ,BOOL bFromFile /*= FALSE*/)
     {
         SAutoLock lock(m_cs);
@@ -324,6 +352,15 @@ namespace SOUI
         else return NULL;
     }
 
+    IBitmap * SResProviderMgr::LoadImage2(const SStringW & strImgID,SIZE szDecode)
+    {
+        SStringT strImgID2 = S_CW2T(strImgID);
+        SStringTList strLst;
+        int nSegs = ParseResID(strImgID2,strLst);
+        if(nSegs == 2) return LoadImage(strLst[0],strLst[1],szDecode);
+        else return NULL;
+    }
+
     HICON SResProviderMgr::LoadIcon2(const SStringW & strIconID)
     {
         SStringT strIconID2 = S_CW2T(strIconID);
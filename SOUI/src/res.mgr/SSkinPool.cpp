@@ -60,7 +60,7 @@ int SSkinPool::LoadSkins(pugi::xml_node xmlNode)
         if(pSkin)
         {
             pSkin->InitFromXml(xmlSkin);
-			SkinKey key = {strSkinName,pSkin->GetScale()};
+			SkinKey key(strSkinName,pSkin->GetScale());
 			SASSERT(!HasKey(key));
             AddKeyObject(key,pSkin);
             nLoaded++;
@@ -82,7 +82,8 @@ int SSkinPool::LoadSkins(pugi::xml_node xmlNode)
 
 ISkinObj* SSkinPool::GetSkin(const SStringW & strSkinName,int nScale)
 {
-	SkinKey key ={strSkinName,nScale};
+	SkinKey key(strSkinName,nScale,false);
+	if(!key.atom) return NULL;	//名字没有驻留，一定不在池中
 
     if(!HasKey(key))
     {
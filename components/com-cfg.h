@@ -95,6 +95,7 @@ namespace SOUI
 	namespace RENDER_SKIA
 	{
 		BOOL SCreateInstance(IObjRef **);
+		BOOL SCreateHeadlessInstance(IObjRef **);
 	}
 	namespace SCRIPT_LUA
 	{
@@ -157,6 +158,11 @@ namespace SOUI
 		{
 			return RENDER_SKIA::SCreateInstance(ppObj);
 		}
+		//不依赖GDI的skia渲染, 用于离屏绘制
+		BOOL CreateRender_SkiaHeadless(IObjRef **ppObj)
+		{
+			return RENDER_SKIA::SCreateHeadlessInstance(ppObj);
+		}
 		BOOL CreateScrpit_Lua(IObjRef **ppObj)
 		{
 			return SCRIPT_LUA::SCreateInstance(ppObj);
@@ -237,6 +243,11 @@ namespace SOUI {
 		{
 			return renderLoader.CreateInstance(m_strDllPath + COM_RENDER_SKIA, ppObj);
 		}
+		//不依赖GDI的skia渲染, 用于离屏绘制
+		BOOL CreateRender_SkiaHeadless(IObjRef **ppObj)
+		{
+			return renderHeadlessLoader.CreateInstance(m_strDllPath + COM_RENDER_SKIA, ppObj, "SCreateHeadlessInstance");
+		}
 		BOOL CreateScrpit_Lua(IObjRef **ppObj)
 		{
 			return scriptLoader.CreateInstance(m_strDllPath + COM_SCRIPT_LUA, ppObj);
@@ -269,6 +280,7 @@ namespace SOUI {
 		//SComLoader实现从DLL的指定函数创建符号SOUI要求的类COM组件。
 		SComLoader imgDecLoader;
 		SComLoader renderLoader;
+		SComLoader renderHeadlessLoader;
 		SComLoader transLoader;
 		SComLoader scriptLoader;
 		SComLoader zipResLoader;
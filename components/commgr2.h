@@ -153,6 +153,7 @@ namespace SOUI
     namespace RENDER_SKIA
     {
         BOOL SCreateInstance(IObjRef **);
+        BOOL SCreateHeadlessInstance(IObjRef **);
     }
     namespace SCRIPT_LUA
     {
@@ -226,6 +227,11 @@ public:
     {
         return RENDER_SKIA::SCreateInstance(ppObj);
     }
+    //不依赖GDI的skia渲染, 用于离屏绘制
+    BOOL CreateRender_SkiaHeadless(IObjRef **ppObj)
+    {
+        return RENDER_SKIA::SCreateHeadlessInstance(ppObj);
+    }
 #endif
 
 #if(SCOM_MASK&scom_mask_script_lua)
@@ -326,6 +332,11 @@ public:
     {
         return renderLoader.CreateInstance(m_strDllPath+COM_RENDER_SKIA,ppObj);
     }
+    //不依赖GDI的skia渲染, 用于离屏绘制
+    BOOL CreateRender_SkiaHeadless(IObjRef **ppObj)
+    {
+        return renderHeadlessLoader.CreateInstance(m_strDllPath+COM_RENDER_SKIA,ppObj,"SCreateHeadlessInstance");
+    }
     BOOL CreateScrpit_Lua(IObjRef **ppObj)
     {
         return scriptLoader.CreateInstance(m_strDllPath+COM_SCRIPT_LUA,ppObj);
@@ -363,6 +374,7 @@ protected:
     //SComLoader实现从DLL的指定函数创建符号SOUI要求的类COM组件。
     SComLoader imgDecLoader;
     SComLoader renderLoader;
+    SComLoader renderHeadlessLoader;
     SComLoader transLoader;
     SComLoader scriptLoader;
     SComLoader zipResLoader;
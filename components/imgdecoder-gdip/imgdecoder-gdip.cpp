@@ -8,6 +8,7 @@
 
 #include "imgdecoder-gdip.h"
 #include <interface/SRender-i.h>
+#include <helper/SPremultiply.hpp>
 
 using namespace Gdiplus;
 
@@ -35,24 +36,7 @@ namespace SOUI
         int bufSize = nWid*nHei*4;
         m_pdata=new BYTE[bufSize];
         
-        BYTE *pDst = m_pdata;
-        const BYTE *pSrc = pdata;
-        int pixel_count = nWid * nHei;
-        for (int i=0; i < pixel_count; ++i) {
-            BYTE a = pSrc[3];
-            if (a) 
-            {
-                pDst[0] = (pSrc[0] *a)/255;
-                pDst[1] = (pSrc[1] *a)/255;
-                pDst[2] = (pSrc[2] *a)/255;
-                pDst[3] = a;
-            }else
-            {
-                memset(pDst,0,4);
-            }
-            pDst += 4;
-            pSrc += 4;
-        }
+        SPremultiply::Premultiply(m_pdata,pdata,nWid * nHei);
 
         m_nWid=(nWid);
         m_nHei=(nHei);
@@ -7,6 +7,7 @@
 #include <pnginfo.h>
 
 #include "decoder-apng.h"
+#include <helper/SBoxDownscaler.hpp>
 #include <assert.h>
 #include <tchar.h>
 
@@ -33,17 +34,6 @@ struct IPngReader_Mem : public IPngReader
     }
 };
 
-struct IPngReader_File: public IPngReader
-{
-    FILE *f;
-    IPngReader_File(FILE *_f):f(_f){}
-    
-    png_size_t read(png_bytep data, png_size_t length)
-    {
-        return fread(data,1,length,f);
-    }
-};
-
 void 
 mypng_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
 {
@@ -57,34 +47,115 @@ mypng_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
    }
 }
 
-APNGDATA * loadPng(IPngReader *pSrc)
+static png_uint_32 png_read_be32(const unsigned char *p)
+{
+    return ((png_uint_32)p[0]<<24) | ((png_uint_32)p[1]<<16) | ((png_uint_32)p[2]<<8) | p[3];
+}
+
+static unsigned short apng_calc_delay(png_uint_16 delay_num,png_uint_16 delay_den)
+{
+    if (delay_den==0 || delay_den==100)
+        return delay_num;
+    else
+        if (delay_den==10)
+            return delay_num*10;
+        else
+            if (delay_den==1000)
+                return delay_num/10;
+            else
+                return delay_num*100/delay_den;
+}
+
+struct APNGSTREAM_IMPL : APNGSTREAM
+{
+    const char *  pBuf;
+    size_t        nLen;
+    IPngReader_Mem *pReader;
+
+    png_structp png_ptr_read;
+    png_infop   info_ptr_read;
+
+    png_uint_32 bytesPerRow;
+    png_uint_32 bytesPerFrame;
+    png_bytep   dataFrame;  //当前帧的原始数据,不含偏移. 普通PNG直接解码到输出, 按需分配
+    png_bytep   curFrame;   //合成画布
+    png_bytep   outFrame;   //当前帧输出
+    png_bytep   prevFrame;  //上一帧输出,用于PNG_DISPOSE_OP_PREVIOUS
+    png_bytep   scaleRow;   //缩小解码时逐行读取的行缓冲,按需分配
+    png_bytepp  rowPointers;
+
+    bool        bAPNG;
+    int         iNextFrame; //下一个待解码的帧号
+};
+
+//直接扫描fcTL块获得各帧延时，避免为了延时信息解码全部帧
+static void apng_scan_delays(APNGSTREAM_IMPL *s)
 {
-	png_bytep  dataFrame;
-	png_uint_32 bytesPerRow;
-	png_uint_32 bytesPerFrame;
-    png_bytepp rowPointers;
-	png_byte   sig[8];
-	
-	png_structp png_ptr_read;
-	png_infop info_ptr_read;
-	
-    pSrc->read(sig,8);
-    if(!png_check_sig(sig,8))
+    s->pDelay = (unsigned short*)malloc(sizeof(unsigned short)*s->nFrames);
+    memset(s->pDelay,0,sizeof(unsigned short)*s->nFrames);
+
+    const unsigned char *p = (const unsigned char*)s->pBuf + 8;
+    const unsigned char *pEnd = (const unsigned char*)s->pBuf + s->nLen;
+    int iFrame = 0;
+    while(p + 12 <= pEnd && iFrame < s->nFrames)
     {
-        return NULL;
+        png_uint_32 len = png_read_be32(p);
+        const unsigned char *type = p+4;
+        const unsigned char *data = p+8;
+        if(len > (png_uint_32)(pEnd - data)) break;
+        if(memcmp(type,"fcTL",4)==0 && len>=26)
+        {
+            png_uint_16 delay_num = (data[20]<<8)|data[21];
+            png_uint_16 delay_den = (data[22]<<8)|data[23];
+            s->pDelay[iFrame++] = apng_calc_delay(delay_num,delay_den);
+        }else if(memcmp(type,"IEND",4)==0)
+        {
+            break;
+        }
+        p = data + len + 4;//skip crc
     }
-    
-    png_ptr_read = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+}
 
-    info_ptr_read = png_create_info_struct(png_ptr_read);
-    
-	if (setjmp(png_jmpbuf(png_ptr_read)))
+static void apng_stream_end(APNGSTREAM_IMPL *s)
+{
+    if(s->png_ptr_read)
     {
-        png_destroy_read_struct(&png_ptr_read, &info_ptr_read, NULL);
-        return NULL;
+        png_destroy_read_struct(&s->png_ptr_read, &s->info_ptr_read, NULL);
+        s->png_ptr_read = NULL;
+        s->info_ptr_read = NULL;
+    }
+    if(s->pReader)
+    {
+        delete s->pReader;
+        s->pReader = NULL;
     }
-        
-    png_set_read_fn(png_ptr_read,pSrc,mypng_read_data);
+}
+
+//从头开始读取PNG头信息，打开流或者回绕时调用
+static bool apng_stream_begin(APNGSTREAM_IMPL *s)
+{
+    png_byte   sig[8];
+    apng_stream_end(s);
+
+    s->pReader = new IPngReader_Mem(s->pBuf,s->nLen);
+    if(s->pReader->read(sig,8)!=8 || !png_check_sig(sig,8))
+    {
+        return false;
+    }
+
+    s->png_ptr_read = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if(!s->png_ptr_read) return false;
+    s->info_ptr_read = png_create_info_struct(s->png_ptr_read);
+
+    if (setjmp(png_jmpbuf(s->png_ptr_read)))
+    {
+        apng_stream_end(s);
+        return false;
+    }
+    png_structp png_ptr_read = s->png_ptr_read;
+    png_infop info_ptr_read = s->info_ptr_read;
+
+    png_set_read_fn(png_ptr_read,s->pReader,mypng_read_data);
     png_set_sig_bytes(png_ptr_read, 8);
  
     if ((png_ptr_read->bit_depth < 8) ||
@@ -97,172 +168,298 @@ APNGDATA * loadPng(IPngReader *pSrc)
     png_set_gray_to_rgb(png_ptr_read);
     png_set_strip_16(png_ptr_read);
    
-	png_read_info(png_ptr_read, info_ptr_read);
+    png_read_info(png_ptr_read, info_ptr_read);
     png_read_update_info(png_ptr_read, info_ptr_read);
-    
-    bytesPerRow = png_ptr_read->width * 4;
-    bytesPerFrame = bytesPerRow * png_ptr_read->height;
-    
-    APNGDATA * apng = (APNGDATA*) malloc(sizeof(APNGDATA));
-    memset(apng,0,sizeof(APNGDATA));
-    apng->nWid  = png_ptr_read->width;
-    apng->nHei = png_ptr_read->height;
-    
-    //图像帧数据
-    dataFrame = (png_bytep)malloc(bytesPerRow * apng->nHei);
-    memset(dataFrame,0,bytesPerFrame);
-    //获得扫描行指针
-    rowPointers = (png_bytepp)malloc(sizeof(png_bytep)* apng->nHei);
-    for(int i=0;i<apng->nHei;i++)
-        rowPointers[i] = dataFrame + bytesPerRow * i;
-
-	if (!png_get_valid(png_ptr_read, info_ptr_read, PNG_INFO_acTL))
-	{//load png doesn't has this trunk.
-        
-        png_read_image(png_ptr_read,rowPointers);
-                
-        apng->pdata =dataFrame;
-        apng->nFrames =1;
-	}else
-	{//load apng
-        apng->nFrames  = png_get_num_frames(png_ptr_read, info_ptr_read);//获取总帧数
-
-        png_bytep data = (png_bytep)malloc( bytesPerFrame * apng->nFrames);//为每一帧分配内存
-        png_bytep curFrame = (png_bytep)malloc(bytesPerFrame);
-        memset(curFrame,0,bytesPerFrame);
-               
-        apng->nLoops = png_get_num_plays(png_ptr_read, info_ptr_read);
-        apng->pDelay = (unsigned short*)malloc(sizeof(unsigned short)*apng->nFrames);
-        
-        for(int iFrame = 0;iFrame<apng->nFrames;iFrame++)
+
+    if(!s->rowPointers)
+    {//首次打开，分配画布
+        s->nWid = png_ptr_read->width;
+        s->nHei = png_ptr_read->height;
+        s->bytesPerRow = png_ptr_read->width * 4;
+        s->bytesPerFrame = s->bytesPerRow * png_ptr_read->height;
+        s->bAPNG = png_get_valid(png_ptr_read, info_ptr_read, PNG_INFO_acTL)!=0;
+        if(s->bAPNG)
         {
-            //读帧信息头
-            png_read_frame_head(png_ptr_read, info_ptr_read);
-            
-            //计算出帧延时信息
-            if (png_get_valid(png_ptr_read, info_ptr_read, PNG_INFO_fcTL))
-            {
-                png_uint_16 delay_num = info_ptr_read->next_frame_delay_num,
-                            delay_den = info_ptr_read->next_frame_delay_den;
-            
-                if (delay_den==0 || delay_den==100)
-                    apng->pDelay[iFrame] = delay_num;
-                else
-                    if (delay_den==10)
-                        apng->pDelay[iFrame] = delay_num*10;
-                    else
-                        if (delay_den==1000)
-                            apng->pDelay[iFrame] = delay_num/10;
-                        else
-                            apng->pDelay[iFrame] = delay_num*100/delay_den;
-            }else
-            {
-                apng->pDelay[iFrame] = 0;
-            }
-            //读取PNG帧到dataFrame中，不含偏移数据
-            png_read_image(png_ptr_read, rowPointers);
-            {//将当前帧数据绘制到当前显示帧中:1)获得绘制的背景；2)计算出绘制位置; 3)使用指定的绘制方式与背景混合
+            s->nFrames = png_get_num_frames(png_ptr_read, info_ptr_read);
+            s->nLoops = png_get_num_plays(png_ptr_read, info_ptr_read);
+            apng_scan_delays(s);
+
+            s->curFrame = (png_bytep)malloc(s->bytesPerFrame);
+            s->outFrame = (png_bytep)malloc(s->bytesPerFrame);
+            s->prevFrame = (png_bytep)malloc(s->bytesPerFrame);
+        }else
+        {
+            s->nFrames = 1;
+        }
+        s->rowPointers = (png_bytepp)malloc(sizeof(png_bytep)* s->nHei);
+        if(s->bAPNG)
+        {
+            s->dataFrame = (png_bytep)malloc(s->bytesPerFrame);
+            memset(s->dataFrame,0,s->bytesPerFrame);
+            //获得扫描行指针
+            for(int i=0;i<s->nHei;i++)
+                s->rowPointers[i] = s->dataFrame + s->bytesPerRow * i;
+        }
+    }
+    if(s->bAPNG)
+    {
+        memset(s->curFrame,0,s->bytesPerFrame);
+        memset(s->prevFrame,0,s->bytesPerFrame);
+    }
+    s->iNextFrame = 0;
+    return true;
+}
+
+//解码下一帧，pOut为NULL时只更新合成画布. pScaler不为NULL时输出缩小后的图片
+static bool apng_stream_next(APNGSTREAM_IMPL *s, unsigned char *pOut, png_uint_32 cbStride, SOUI::SBoxDownscaler *pScaler)
+{
+    if(!s->png_ptr_read) return false;
+    png_structp png_ptr_read = s->png_ptr_read;
+    png_infop info_ptr_read = s->info_ptr_read;
+    png_uint_32 bytesPerRow = s->bytesPerRow;
+    png_uint_32 bytesPerFrame = s->bytesPerFrame;
 
+    if (setjmp(png_jmpbuf(png_ptr_read)))
+    {
+        apng_stream_end(s);
+        return false;
+    }
 
-                //1)计算出绘制位置
-                png_bytep lineDst=curFrame+info_ptr_read->next_frame_y_offset*bytesPerRow + 4 * info_ptr_read->next_frame_x_offset;
-                png_bytep lineSour=dataFrame;
-                //2)使用指定的绘制方式与背景混合
-                switch(info_ptr_read->next_frame_blend_op)
+    if(!s->bAPNG)
+    {//load png doesn't has this trunk. 直接解码到输出缓冲区
+        png_bytep pDst = pOut;
+        if(pOut && pScaler)
+        {
+            if(png_get_interlace_type(png_ptr_read,info_ptr_read) == PNG_INTERLACE_NONE)
+            {//逐行解码并缩小, 不需要完整尺寸的缓冲区
+                if(!s->scaleRow) s->scaleRow = (png_bytep)malloc(bytesPerRow);
+                for(int i=0;i<s->nHei;i++)
                 {
-                case PNG_BLEND_OP_OVER:
-                    {
-                        for(unsigned int y=0;y<info_ptr_read->next_frame_height;y++)
-                        {
-                            png_bytep lineDst1=lineDst;
-                            png_bytep lineSour1=lineSour;
-                            for(unsigned int x=0;x<info_ptr_read->next_frame_width;x++)
-                            {
-                                png_byte alpha = lineSour1[3];
-                                *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
-                                *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
-                                *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
-                                *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
-                            }
-                            lineDst += bytesPerRow;
-                            lineSour+= bytesPerRow;
-                        }
-                    }
-                    break;
-                case PNG_BLEND_OP_SOURCE:
-                    {
-                        for(unsigned int  y=0;y<info_ptr_read->next_frame_height;y++)
-                        {
-                            memcpy(lineDst,lineSour,info_ptr_read->next_frame_width*4);
-                            lineDst += bytesPerRow;
-                            lineSour+= bytesPerRow;
-                        }
-                    }
-                    break;
-                default:
-                    SASSERT(FALSE);
-                    break;
+                    png_read_row(png_ptr_read,s->scaleRow,NULL);
+                    pScaler->PushRow(s->scaleRow,pOut,cbStride);
                 }
-                
-                png_bytep targetFrame = data + bytesPerFrame * iFrame;
-                memcpy(targetFrame,curFrame,bytesPerFrame);
+                s->iNextFrame++;
+                return true;
+            }
+            pDst = NULL;//交错存储的PNG需要先解码完整图片
+        }
+        if(!pDst)
+        {
+            if(!s->dataFrame) s->dataFrame = (png_bytep)malloc(bytesPerFrame);
+            pDst = s->dataFrame;
+            cbStride = bytesPerRow;
+        }
+        for(int i=0;i<s->nHei;i++)
+            s->rowPointers[i] = pDst + cbStride * i;
+        png_read_image(png_ptr_read,s->rowPointers);
+        if(pOut && pScaler)
+        {
+            for(int i=0;i<s->nHei;i++)
+                pScaler->PushRow(s->rowPointers[i],pOut,cbStride);
+        }
+        s->iNextFrame++;
+        return true;
+    }
 
-                lineDst=curFrame+info_ptr_read->next_frame_y_offset*bytesPerRow + 4 * info_ptr_read->next_frame_x_offset;
+    //读帧信息头
+    png_read_frame_head(png_ptr_read, info_ptr_read);
+    //读取PNG帧到dataFrame中，不含偏移数据
+    png_read_image(png_ptr_read, s->rowPointers);
+    {//将当前帧数据绘制到当前显示帧中:1)获得绘制的背景；2)计算出绘制位置; 3)使用指定的绘制方式与背景混合
+        png_bytep curFrame = s->curFrame;
 
-                //3)处理当前帧绘制区域
-                switch(info_ptr_read->next_frame_dispose_op)
+        //1)计算出绘制位置
+        png_bytep lineDst=curFrame+info_ptr_read->next_frame_y_offset*bytesPerRow + 4 * info_ptr_read->next_frame_x_offset;
+        png_bytep lineSour=s->dataFrame;
+        //2)使用指定的绘制方式与背景混合
+        switch(info_ptr_read->next_frame_blend_op)
+        {
+        case PNG_BLEND_OP_OVER:
+            {
+                for(unsigned int y=0;y<info_ptr_read->next_frame_height;y++)
                 {
-                case PNG_DISPOSE_OP_BACKGROUND://clear background
+                    png_bytep lineDst1=lineDst;
+                    png_bytep lineSour1=lineSour;
+                    for(unsigned int x=0;x<info_ptr_read->next_frame_width;x++)
                     {
-                        for(unsigned int y=0;y<info_ptr_read->next_frame_height;y++)
-                        {
-                            memset(lineDst,0,info_ptr_read->next_frame_width*4);
-                            lineDst += bytesPerRow;
-                        }
-
-                    }
-                    break;
-                case PNG_DISPOSE_OP_PREVIOUS://copy previous frame
-                    if(iFrame>0)
-                    {
-                        memcpy(curFrame,targetFrame-bytesPerFrame,bytesPerFrame);
+                        png_byte alpha = lineSour1[3];
+                        *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
+                        *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
+                        *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
+                        *lineDst1++ = ((*lineDst1)*(255-alpha)+(*lineSour1++)*alpha)>>8;
                     }
-                    break;
-                case PNG_DISPOSE_OP_NONE://using current frame, doing nothing
-                    break;
-                default:
-                    SASSERT(0);
-                    break;
+                    lineDst += bytesPerRow;
+                    lineSour+= bytesPerRow;
                 }
             }
+            break;
+        case PNG_BLEND_OP_SOURCE:
+            {
+                for(unsigned int  y=0;y<info_ptr_read->next_frame_height;y++)
+                {
+                    memcpy(lineDst,lineSour,info_ptr_read->next_frame_width*4);
+                    lineDst += bytesPerRow;
+                    lineSour+= bytesPerRow;
+                }
+            }
+            break;
+        default:
+            SASSERT(FALSE);
+            break;
+        }
+
+        memcpy(s->outFrame,curFrame,bytesPerFrame);
+        if(pOut && pScaler)
+        {
+            for(int y=0;y<s->nHei;y++)
+                pScaler->PushRow(curFrame+bytesPerRow*y,pOut,cbStride);
+        }else if(pOut)
+        {
+            if(cbStride == bytesPerRow)
+            {
+                memcpy(pOut,curFrame,bytesPerFrame);
+            }else
+            {
+                for(int y=0;y<s->nHei;y++)
+                    memcpy(pOut+cbStride*y,curFrame+bytesPerRow*y,bytesPerRow);
+            }
+        }
+
+        lineDst=curFrame+info_ptr_read->next_frame_y_offset*bytesPerRow + 4 * info_ptr_read->next_frame_x_offset;
+
+        //3)处理当前帧绘制区域
+        switch(info_ptr_read->next_frame_dispose_op)
+        {
+        case PNG_DISPOSE_OP_BACKGROUND://clear background
+            {
+                for(unsigned int y=0;y<info_ptr_read->next_frame_height;y++)
+                {
+                    memset(lineDst,0,info_ptr_read->next_frame_width*4);
+                    lineDst += bytesPerRow;
+                }
 
+            }
+            break;
+        case PNG_DISPOSE_OP_PREVIOUS://copy previous frame
+            if(s->iNextFrame>0)
+            {
+                memcpy(curFrame,s->prevFrame,bytesPerFrame);
+            }
+            break;
+        case PNG_DISPOSE_OP_NONE://using current frame, doing nothing
+            break;
+        default:
+            SASSERT(0);
+            break;
         }
-        free(curFrame);
-        free(dataFrame);
-        apng->pdata =data;
-	}
-    free(rowPointers);
-
-	png_read_end(png_ptr_read,info_ptr_read);
-	
-    png_destroy_read_struct(&png_ptr_read, &info_ptr_read, NULL);
-    return apng;    
+        //当前帧输出成为下一帧的“上一帧”
+        png_bytep tmp = s->prevFrame;
+        s->prevFrame = s->outFrame;
+        s->outFrame = tmp;
+    }
+    s->iNextFrame++;
+    return true;
+}
+
+APNGSTREAM * APNG_OpenStream(const char * pBuf, size_t nLen)
+{
+    APNGSTREAM_IMPL *s = (APNGSTREAM_IMPL*)malloc(sizeof(APNGSTREAM_IMPL));
+    memset(s,0,sizeof(APNGSTREAM_IMPL));
+    s->pBuf = pBuf;
+    s->nLen = nLen;
+    if(!apng_stream_begin(s))
+    {
+        APNG_CloseStream(s);
+        return NULL;
+    }
+    return s;
+}
+
+int APNG_StreamReadFrame(APNGSTREAM *stream, int iFrame, unsigned char *pOut, unsigned int cbStride, int nScale)
+{
+    APNGSTREAM_IMPL *s = static_cast<APNGSTREAM_IMPL*>(stream);
+    if(iFrame<0 || iFrame>=s->nFrames) return 0;
+    if(nScale < 1) nScale = 1;
+    if(nScale > SOUI::SBoxDownscaler::MAX_SCALE) return 0;
+    png_uint_32 bytesPerRow = (s->nWid + nScale - 1)/nScale * 4;
+    if(cbStride == 0) cbStride = bytesPerRow;
+    if(cbStride < bytesPerRow) return 0;
+    if(iFrame < s->iNextFrame || !s->png_ptr_read)
+    {//合成依赖之前的帧，只能回到流头部重新解码
+        if(!apng_stream_begin(s)) return 0;
+    }
+    SOUI::SBoxDownscaler scaler(s->nWid,s->nHei,nScale);
+    while(s->iNextFrame <= iFrame)
+    {
+        if(!apng_stream_next(s, s->iNextFrame==iFrame?pOut:NULL, cbStride, nScale>1?&scaler:NULL))
+            return 0;
+    }
+    return 1;
+}
+
+void APNG_CloseStream(APNGSTREAM *stream)
+{
+    APNGSTREAM_IMPL *s = static_cast<APNGSTREAM_IMPL*>(stream);
+    if(!s) return;
+    apng_stream_end(s);
+    if(s->pDelay) free(s->pDelay);
+    if(s->dataFrame) free(s->dataFrame);
+    if(s->curFrame) free(s->curFrame);
+    if(s->outFrame) free(s->outFrame);
+    if(s->prevFrame) free(s->prevFrame);
+    if(s->scaleRow) free(s->scaleRow);
+    if(s->rowPointers) free(s->rowPointers);
+    free(s);
 }
 
 APNGDATA * LoadAPNG_from_file( const wchar_t * pszFileName )
 {
     FILE *f = _wfopen(pszFileName,L"rb");
     if(!f) return NULL;
-    IPngReader_File file(f);
-    APNGDATA *pRet = loadPng(&file);
+    fseek(f,0,SEEK_END);
+    long nLen = ftell(f);
+    fseek(f,0,SEEK_SET);
+    APNGDATA *pRet = NULL;
+    if(nLen>0)
+    {
+        char *pBuf = (char*)malloc(nLen);
+        if(fread(pBuf,1,nLen,f)==(size_t)nLen)
+            pRet = LoadAPNG_from_memory(pBuf,nLen);
+        free(pBuf);
+    }
     fclose(f);
     return pRet;
 }
 
 APNGDATA * LoadAPNG_from_memory(const char * pBuf, size_t nLen )
 {
-    IPngReader_Mem mem(pBuf,nLen);
-    return loadPng(&mem);
+    APNGSTREAM *stream = APNG_OpenStream(pBuf,nLen);
+    if(!stream) return NULL;
+
+    size_t bytesPerFrame = stream->nWid * stream->nHei * 4;
+    APNGDATA * apng = (APNGDATA*) malloc(sizeof(APNGDATA));
+    memset(apng,0,sizeof(APNGDATA));
+    apng->nWid = stream->nWid;
+    apng->nHei = stream->nHei;
+    apng->nFrames = stream->nFrames;
+    apng->nLoops = stream->nLoops;
+    apng->pdata = (unsigned char*)malloc(bytesPerFrame*apng->nFrames);//为每一帧分配内存
+    if(stream->pDelay)
+    {
+        apng->pDelay = (unsigned short*)malloc(sizeof(unsigned short)*apng->nFrames);
+        memcpy(apng->pDelay,stream->pDelay,sizeof(unsigned short)*apng->nFrames);
+    }
+    for(int i=0;i<apng->nFrames;i++)
+    {
+        if(!APNG_StreamReadFrame(stream,i,apng->pdata+bytesPerFrame*i))
+        {
+            APNG_Destroy(apng);
+            apng = NULL;
+            break;
+        }
+    }
+    APNG_CloseStream(stream);
+    return apng;
 }
 
 void APNG_Destroy( APNGDATA *apng )
@@ -15,3 +15,22 @@ APNGDATA * LoadAPNG_from_file(const wchar_t * pszFileName);
 APNGDATA * LoadAPNG_from_memory(const char * pBuf, size_t nLen);
 
 void APNG_Destroy(APNGDATA *apng);
+
+//按需逐帧解码的APNG流，只保留合成当前帧所需的几个画布，不一次性解码全部帧
+struct APNGSTREAM
+{
+    unsigned short *pDelay; //各帧延时，打开流时从fcTL块扫描得到，不需要解码
+    int   nWid,nHei;
+    int   nFrames;
+    int   nLoops;
+};
+
+//打开APNG流, pBuf在APNG_CloseStream前必须保持有效
+APNGSTREAM * APNG_OpenStream(const char * pBuf, size_t nLen);
+
+//解码第iFrame帧到pOut(RGBA, 行宽cbStride, 0表示输出宽度*4), 向前解码时自动回绕到流头部. 成功返回1
+//普通PNG直接解码到pOut, 不经过中间缓冲区
+//nScale>1时输出按nScale倍缩小(宽高向上取整), 非交错的普通PNG逐行缩小, 不需要完整尺寸的缓冲区
+int APNG_StreamReadFrame(APNGSTREAM *stream, int iFrame, unsigned char *pOut, unsigned int cbStride = 0, int nScale = 1);
+
+void APNG_CloseStream(APNGSTREAM *stream);
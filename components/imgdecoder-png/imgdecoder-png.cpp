@@ -4,24 +4,28 @@
 #include "imgdecoder-png.h"
 #include "decoder-apng.h"
 #include <png.h>
+#include <helper/SBoxDownscaler.hpp>
+#include <helper/SPremultiply.hpp>
 
 namespace SOUI
 {
     //////////////////////////////////////////////////////////////////////////
     //  SImgFrame_PNG
     SImgFrame_PNG::SImgFrame_PNG()
-        :m_pdata(NULL)
-        ,m_nWid(0)
+        :m_nWid(0)
         ,m_nHei(0)
         ,m_nFrameDelay(0)
+        ,m_pOwner(NULL)
+        ,m_iFrame(0)
     {
 
     }
 
 
-    void SImgFrame_PNG::Attach( const BYTE * pdata,int nWid,int nHei,int nDelay )
+    void SImgFrame_PNG::AttachStream( SImgX_PNG *pOwner,int iFrame,int nWid,int nHei,int nDelay )
     {
-        m_pdata=(pdata);
+        m_pOwner=pOwner;
+        m_iFrame=iFrame;
         m_nWid=(nWid);
         m_nHei=(nHei);
         m_nFrameDelay=(nDelay);
@@ -29,7 +33,7 @@ namespace SOUI
 
     BOOL SImgFrame_PNG::GetSize( UINT *pWid,UINT *pHei )
     {
-        if(!m_pdata) return FALSE;
+        if(!m_pOwner) return FALSE;
         *pWid = m_nWid;
         *pHei = m_nHei;
         return TRUE;
@@ -37,9 +41,9 @@ namespace SOUI
 
     BOOL SImgFrame_PNG::CopyPixels( /* [unique][in] */ const RECT *prc, /* [in] */ UINT cbStride, /* [in] */ UINT cbBufferSize, /* [size_is][out] */ BYTE *pbBuffer )
     {
-        if(!m_pdata || cbBufferSize != m_nHei * m_nWid *4) return FALSE;
-        memcpy(pbBuffer,m_pdata,cbBufferSize);
-        return TRUE;
+        if(cbBufferSize != m_nHei * m_nWid *4) return FALSE;
+        if(!m_pOwner) return FALSE;
+        return m_pOwner->_CopyFrame(m_iFrame,cbBufferSize,pbBuffer);
     }
 
     
@@ -47,14 +51,35 @@ namespace SOUI
     // SImgX_PNG
     int SImgX_PNG::LoadFromMemory( void *pBuf,size_t bufLen )
     {
-        APNGDATA * pdata =LoadAPNG_from_memory((char*)pBuf,bufLen);
-        return _DoDecode(pdata);
+        return _DoLoad((char*)pBuf,bufLen,FALSE);
+    }
+
+    int SImgX_PNG::LoadFromSharedMemory( IObjRef *pOwner,const void *pBuf,size_t bufLen )
+    {
+        if(!pOwner) return LoadFromMemory((void*)pBuf,bufLen);
+        return _DoLoad((char*)pBuf,bufLen,FALSE,pOwner);
     }
 
     int SImgX_PNG::LoadFromFile( LPCWSTR pszFileName )
     {
-        APNGDATA * pdata =LoadAPNG_from_file(pszFileName);
-        return _DoDecode(pdata);
+        FILE *f = _wfopen(pszFileName,L"rb");
+        if(!f) return 0;
+        fseek(f,0,SEEK_END);
+        long nLen = ftell(f);
+        fseek(f,0,SEEK_SET);
+        char *pBuf = NULL;
+        if(nLen>0)
+        {
+            pBuf = (char*)malloc(nLen);
+            if(pBuf && fread(pBuf,1,nLen,f)!=(size_t)nLen)
+            {
+                free(pBuf);
+                pBuf = NULL;
+            }
+        }
+        fclose(f);
+        if(!pBuf) return 0;
+        return _DoLoad(pBuf,nLen,TRUE);
     }
 
     int SImgX_PNG::LoadFromFile( LPCSTR pszFileName )
@@ -68,57 +93,226 @@ namespace SOUI
     SImgX_PNG::SImgX_PNG( BOOL bPremultiplied )
         :m_bPremultiplied(bPremultiplied)
         ,m_pImgArray(NULL)
-        ,m_pngData(NULL)
+        ,m_pngStream(NULL)
+        ,m_pSrcBuf(NULL)
+        ,m_pSrcOwner(NULL)
+        ,m_nScale(1)
+        ,m_nFrameWid(0)
+        ,m_nFrameHei(0)
+        ,m_dwStamp(0)
+        ,m_iPrefetch(-1)
     {
-
+        memset(m_frameCache,0,sizeof(m_frameCache));
+        m_szDecode.cx = m_szDecode.cy = 0;
+        InitializeCriticalSection(&m_cs);
     }
 
     SImgX_PNG::~SImgX_PNG( void )
     {
+        _Reset();
+        DeleteCriticalSection(&m_cs);
+    }
+
+    void SImgX_PNG::SetDecodeSize(UINT cx,UINT cy)
+    {
+        m_szDecode.cx = cx;
+        m_szDecode.cy = cy;
+    }
+
+    //预解码任务持有引用，析构时不会有任务，重新加载前需要等待当前任务结束
+    void SImgX_PNG::_WaitPrefetch()
+    {
+        while(InterlockedCompareExchange(&m_iPrefetch,-1,-1)!=-1)
+            Sleep(0);
+    }
+
+    void SImgX_PNG::_Reset()
+    {
+        _WaitPrefetch();
+        EnterCriticalSection(&m_cs);
         if(m_pImgArray) delete []m_pImgArray;
         m_pImgArray = NULL;
-        if(m_pngData) APNG_Destroy(m_pngData);
+        if(m_pngStream) APNG_CloseStream(m_pngStream);
+        m_pngStream = NULL;
+        if(m_pSrcOwner) m_pSrcOwner->Release();
+        else if(m_pSrcBuf) free(m_pSrcBuf);
+        m_pSrcBuf = NULL;
+        m_pSrcOwner = NULL;
+        for(int i=0;i<FRAME_CACHE_SIZE;i++)
+        {
+            if(m_frameCache[i].pBuf) free(m_frameCache[i].pBuf);
+        }
+        memset(m_frameCache,0,sizeof(m_frameCache));
+        LeaveCriticalSection(&m_cs);
     }
 
-    int SImgX_PNG::_DoDecode(APNGDATA *pData)
+    void SImgX_PNG::_DoPremultiply(BYTE *p,int nPixels)
     {
-        if(!pData) return 0;
-        m_pngData = pData;
+        //swap rgba to bgra and do premultiply
+        SPremultiply::PremultiplySwapRB(p,p,nPixels);
+    }
 
-        int nWid = m_pngData->nWid;
-        int nHei = m_pngData->nHei;
+    int SImgX_PNG::_DoLoad(char *pBuf,size_t nLen,BOOL bOwnBuf,IObjRef *pSrcOwner)
+    {
+        _Reset();
+        APNGSTREAM *pStream = APNG_OpenStream(pBuf,nLen);
+        if(!pStream)
+        {
+            if(bOwnBuf) free(pBuf);
+            return 0;
+        }
+        if(pSrcOwner)
+        {//共享数据由持有者保证不变, 直接引用
+            pSrcOwner->AddRef();
+            m_pSrcOwner = pSrcOwner;
+        }else if(!bOwnBuf)
+        {//延迟解码期间需要保留原始数据, 压缩数据通常远小于像素数据
+            APNG_CloseStream(pStream);
+            char *pCopy = (char*)malloc(nLen);
+            if(!pCopy) return 0;
+            memcpy(pCopy,pBuf,nLen);
+            pBuf = pCopy;
+            pStream = APNG_OpenStream(pBuf,nLen);
+            if(!pStream)
+            {
+                free(pBuf);
+                return 0;
+            }
+        }
+        m_pSrcBuf = pBuf;
+        return _DoDecodeStream(pStream);
+    }
 
-        //swap rgba to bgra and do premultiply
-        BYTE *p=m_pngData->pdata;
-        int pixel_count = nWid * nHei * m_pngData->nFrames;
-        for (int i=0; i < pixel_count; ++i) {
-            BYTE a = p[3];
-            BYTE t = p[0];
-            if (a) 
+    int SImgX_PNG::_DoDecodeStream(APNGSTREAM *pStream)
+    {
+        m_pngStream = pStream;
+        m_nScale = 1;
+        if(m_pngStream->nFrames == 1)
+        {//动画每帧都需要合成, 只缩小单帧图片
+            m_nScale = SBoxDownscaler::CalcScale(m_pngStream->nWid,m_pngStream->nHei,m_szDecode.cx,m_szDecode.cy);
+        }
+        m_nFrameWid = (m_pngStream->nWid + m_nScale - 1)/m_nScale;
+        m_nFrameHei = (m_pngStream->nHei + m_nScale - 1)/m_nScale;
+        m_pImgArray = new SImgFrame_PNG[m_pngStream->nFrames];
+        for(int i=0;i<m_pngStream->nFrames;i++)
+        {
+            m_pImgArray[i].AttachStream(this,i,m_nFrameWid,m_nFrameHei,m_pngStream->pDelay?m_pngStream->pDelay[i]:0);
+        }
+        for(int i=0;i<FRAME_CACHE_SIZE;i++)
+        {
+            m_frameCache[i].iFrame = -1;
+        }
+        return m_pngStream->nFrames;
+    }
+
+    //调用者需要持有m_cs
+    const BYTE * SImgX_PNG::_GetCachedFrame(int iFrame)
+    {
+        int iSlot = 0;
+        for(int i=0;i<FRAME_CACHE_SIZE;i++)
+        {
+            if(m_frameCache[i].iFrame == iFrame)
             {
-                p[0] = (p[2] *a)/255;
-                p[1] = (p[1] * a)/255;
-                p[2] =  (t   * a)/255;
+                m_frameCache[i].dwStamp = ++m_dwStamp;
+                return m_frameCache[i].pBuf;
+            }
+            if(m_frameCache[i].dwStamp < m_frameCache[iSlot].dwStamp)
+                iSlot = i;
+        }
+        //淘汰最久未使用的帧
+        FRAMECACHE & cache = m_frameCache[iSlot];
+        int nPixels = m_nFrameWid * m_nFrameHei;
+        cache.iFrame = -1;
+        if(!cache.pBuf) cache.pBuf = (BYTE*)malloc(nPixels*4);
+        if(!cache.pBuf) return NULL;
+        if(!APNG_StreamReadFrame(m_pngStream,iFrame,cache.pBuf,0,m_nScale))
+            return NULL;
+        _DoPremultiply(cache.pBuf,nPixels);
+        cache.iFrame = iFrame;
+        cache.dwStamp = ++m_dwStamp;
+        return cache.pBuf;
+    }
+
+    BOOL SImgX_PNG::_CopyFrame(int iFrame,UINT cbBufferSize,BYTE *pbBuffer)
+    {
+        EnterCriticalSection(&m_cs);
+        const BYTE *pFrame = m_pngStream?_GetCachedFrame(iFrame):NULL;
+        if(pFrame) memcpy(pbBuffer,pFrame,cbBufferSize);
+        LeaveCriticalSection(&m_cs);
+        if(!pFrame) return FALSE;
+        if(GetFrameCount()>1) _PrefetchFrame((iFrame+1)%GetFrameCount());
+        return TRUE;
+    }
+
+    BOOL SImgX_PNG::DecodeInto(UINT iFrame,UINT cbStride,UINT cbBufferSize,BYTE *pbBuffer)
+    {
+        if(iFrame >= GetFrameCount()) return FALSE;
+        UINT cbRow = m_nFrameWid * 4;
+        UINT nHei = m_nFrameHei;
+        if(cbStride < cbRow || cbBufferSize < cbStride*(nHei-1)+cbRow) return FALSE;
+
+        BOOL bRet = FALSE;
+        EnterCriticalSection(&m_cs);
+        const BYTE *pCached = NULL;
+        for(int i=0;i<FRAME_CACHE_SIZE;i++)
+        {
+            if(m_frameCache[i].iFrame == (int)iFrame)
+            {
+                pCached = m_frameCache[i].pBuf;
+                break;
+            }
+        }
+        if(pCached)
+        {//已经解码过的帧直接复制
+            for(UINT y=0;y<nHei;y++)
+                memcpy(pbBuffer+cbStride*y,pCached+cbRow*y,cbRow);
+            bRet = TRUE;
+        }else if(APNG_StreamReadFrame(m_pngStream,iFrame,pbBuffer,cbStride,m_nScale))
+        {//直接解码到目标缓冲区, 然后就地预乘
+            if(cbStride == cbRow)
+            {
+                _DoPremultiply(pbBuffer,m_nFrameWid*nHei);
             }else
             {
-                memset(p,0,4);
+                for(UINT y=0;y<nHei;y++)
+                    _DoPremultiply(pbBuffer+cbStride*y,m_nFrameWid);
             }
-            p += 4;
+            bRet = TRUE;
         }
+        LeaveCriticalSection(&m_cs);
+        return bRet;
+    }
 
-        p=m_pngData->pdata;
-        m_pImgArray = new SImgFrame_PNG[m_pngData->nFrames];
-        for(int i=0;i<m_pngData->nFrames;i++)
+    void SImgX_PNG::_PrefetchFrame(int iFrame)
+    {
+        if(InterlockedCompareExchange(&m_iPrefetch,iFrame,-1)!=-1)
+            return;//上一次预解码还没有完成
+        AddRef();
+        InterlockedIncrement(&SImgDecoderFactory_PNG::s_nPrefetching);
+        if(!QueueUserWorkItem(_PrefetchProc,this,WT_EXECUTEDEFAULT))
         {
-            m_pImgArray[i].Attach(p,nWid,nHei,m_pngData->pDelay?m_pngData->pDelay[i]:0);
-            p += nWid*nHei*4;
+            InterlockedDecrement(&SImgDecoderFactory_PNG::s_nPrefetching);
+            InterlockedExchange(&m_iPrefetch,-1);
+            Release();
         }
-        return m_pngData->nFrames;
+    }
+
+    DWORD WINAPI SImgX_PNG::_PrefetchProc(LPVOID pParam)
+    {
+        SImgX_PNG *pThis = (SImgX_PNG*)pParam;
+        EnterCriticalSection(&pThis->m_cs);
+        if(pThis->m_pngStream) pThis->_GetCachedFrame(pThis->m_iPrefetch);
+        LeaveCriticalSection(&pThis->m_cs);
+        InterlockedExchange(&pThis->m_iPrefetch,-1);
+        pThis->Release();
+        //最后才减少计数, 工厂析构(模块卸载前)等待计数归零
+        InterlockedDecrement(&SImgDecoderFactory_PNG::s_nPrefetching);
+        return 0;
     }
 
     UINT SImgX_PNG::GetFrameCount()
     {
-        return m_pngData?m_pngData->nFrames:0;
+        return m_pngStream?m_pngStream->nFrames:0;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -129,9 +323,13 @@ namespace SOUI
 
     }
 
+    volatile LONG SImgDecoderFactory_PNG::s_nPrefetching = 0;
+
     SImgDecoderFactory_PNG::~SImgDecoderFactory_PNG()
     {
-
+        //线程池中的预解码任务还在执行模块代码, 卸载模块前需要等待它们结束
+        while(InterlockedCompareExchange(&s_nPrefetching,0,0)!=0)
+            Sleep(1);
     }
 
     BOOL SImgDecoderFactory_PNG::CreateImgX( IImgX **ppImgDecoder )
@@ -214,18 +412,7 @@ namespace SOUI
 
         /* 将原数据格式从预乘的rgba格式调整为不预乘的bgra格式 */  
         png_bytep image = (png_bytep) new png_byte[width*height*bytes_per_pixel];  
-        png_bytep dst=image;
-        png_bytep src = (png_bytep)pData;
-        for(png_uint_32 y=0;y<height;y++) for(png_uint_32 x=0;x<width;x++)
-        {
-            png_byte a = src[3];
-            dst[2] = (png_byte)((int)src[0]*a/255);
-            dst[1] = (png_byte)((int)src[1]*a/255);
-            dst[0] = (png_byte)((int)src[2]*a/255);
-            dst[3]=a;
-            dst += 4;
-            src += 4;
-        }
+        SPremultiply::PremultiplySwapRB(image,(png_bytep)pData,width*height);
         
         if (height > PNG_UINT_32_MAX/(sizeof (png_bytep)))  
             png_error (png_ptr, "Image is too tall to process in memory");  
@@ -10,16 +10,18 @@
 #include <interface/SImgDecoder-i.h>
 #include <interface/SRender-i.h>
 
-struct APNGDATA;
+struct APNGSTREAM;
 
 namespace SOUI
 {
-    
+    class SImgX_PNG;
+
     class SImgFrame_PNG : public IImgFrame
     {
     public:
         SImgFrame_PNG();
-        void Attach(const BYTE * pdata,int nWid,int nHei,int nDelay);
+        //像素数据在CopyPixels时由pOwner按需解码
+        void AttachStream(SImgX_PNG *pOwner,int iFrame,int nWid,int nHei,int nDelay);
 
         virtual BOOL GetSize(UINT *pWid,UINT *pHei);
         virtual BOOL CopyPixels( 
@@ -31,33 +33,78 @@ namespace SOUI
     protected:
         int     m_nFrameDelay;
         int     m_nWid, m_nHei;
-        const BYTE   *m_pdata;
+        SImgX_PNG    *m_pOwner;
+        int           m_iFrame;
     };
     
+    /**
+    * @class     SImgX_PNG
+    * @brief     PNG/APNG解码器
+    * 
+    * Describe   加载时只解析文件头，像素延迟到DecodeInto或CopyPixels时解码。
+    *            DecodeInto直接解码到调用者的缓冲区；CopyPixels使用一个很小的帧窗口
+    *            (当前帧及下一帧)，多帧APNG的下一帧由线程池预先解码。
+    *            单帧图片可以通过SetDecodeSize在解码时按整数倍缩小。
+    *            每个对象有独立的解码进度，多个对象可以通过LoadFromSharedMemory共享同一份压缩数据。
+    */
     class SImgX_PNG : public TObjRefImpl<IImgX>
     {
         friend class SImgDecoderFactory_PNG;
+        friend class SImgFrame_PNG;
     public:
 
         int LoadFromMemory(void *pBuf,size_t bufLen);
         int LoadFromFile(LPCWSTR pszFileName);
         int LoadFromFile(LPCSTR pszFileName);
+        virtual int LoadFromSharedMemory(IObjRef *pOwner,const void *pBuf,size_t bufLen);
 
         IImgFrame * GetFrame(UINT iFrame){
             if(iFrame >= GetFrameCount()) return NULL;
             return m_pImgArray+iFrame;
         }
         virtual UINT GetFrameCount();
+
+        virtual BOOL DecodeInto(UINT iFrame,UINT cbStride,UINT cbBufferSize,BYTE *pbBuffer);
+        virtual void SetDecodeSize(UINT cx,UINT cy);
     protected:
         SImgX_PNG(BOOL bPremultiplied);
         ~SImgX_PNG(void);
         
-        int _DoDecode(APNGDATA *pData);
+        enum{FRAME_CACHE_SIZE=2};
+
+        struct FRAMECACHE
+        {
+            int    iFrame;
+            DWORD  dwStamp;
+            BYTE * pBuf;
+        };
+
+        int _DoLoad(char *pBuf,size_t nLen,BOOL bOwnBuf,IObjRef *pSrcOwner=NULL);
+        int _DoDecodeStream(APNGSTREAM *pStream);
+        void _Reset();
+        void _WaitPrefetch();
+
+        BOOL _CopyFrame(int iFrame,UINT cbBufferSize,BYTE *pbBuffer);
+        const BYTE * _GetCachedFrame(int iFrame);
+        void _PrefetchFrame(int iFrame);
+        static DWORD WINAPI _PrefetchProc(LPVOID pParam);
+
+        static void _DoPremultiply(BYTE *p,int nPixels);
 
         BOOL m_bPremultiplied;
         
-        APNGDATA       *    m_pngData;
         SImgFrame_PNG  *    m_pImgArray;
+
+        APNGSTREAM     *    m_pngStream;    //流式解码状态
+        char           *    m_pSrcBuf;      //延迟解码使用的原始数据
+        IObjRef        *    m_pSrcOwner;    //m_pSrcBuf的共享持有者,为NULL时m_pSrcBuf由当前对象释放
+        SIZE                m_szDecode;     //期望的显示大小,{0,0}表示原始大小
+        int                 m_nScale;       //解码时的缩小倍数,只用于单帧图片
+        int                 m_nFrameWid,m_nFrameHei;//缩小后的帧大小
+        FRAMECACHE          m_frameCache[FRAME_CACHE_SIZE];
+        DWORD               m_dwStamp;
+        volatile LONG       m_iPrefetch;    //正在预解码的帧,-1表示没有
+        CRITICAL_SECTION    m_cs;
     };
 
     #define DESC_IMGDECODER L"apng"
@@ -71,6 +118,8 @@ namespace SOUI
         virtual HRESULT SaveImage(IBitmap *pImg, LPCWSTR pszFileName, const LPVOID pFormat);
         virtual BOOL CreateImgX(IImgX **ppImgDecoder);
         LPCWSTR GetDescription() const;
+    protected:
+        static volatile LONG s_nPrefetching;  //线程池中还没有结束的预解码任务数
     };
     
     //////////////////////////////////////////////////////////////////////////
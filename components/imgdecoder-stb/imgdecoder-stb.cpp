@@ -5,12 +5,14 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include <helper/SBoxDownscaler.hpp>
+#include <helper/SPremultiply.hpp>
 
 namespace SOUI
 {
     //////////////////////////////////////////////////////////////////////////
     //  SImgFrame_STB
-    SImgFrame_STB::SImgFrame_STB(BYTE *data,int w,int h):m_data(data),m_nWid(w),m_nHei(h)
+    SImgFrame_STB::SImgFrame_STB(SImgX_STB *pOwner,int w,int h):m_pOwner(pOwner),m_data(NULL),m_nWid(w),m_nHei(h)
     {
 
     }
@@ -30,6 +32,12 @@ namespace SOUI
     BOOL SImgFrame_STB::CopyPixels( /* [unique][in] */ const RECT *prc, /* [in] */ UINT cbStride, /* [in] */ UINT cbBufferSize, /* [size_is][out] */ BYTE *pbBuffer )
     {
         if(cbBufferSize != m_nHei * m_nWid *4) return FALSE;
+        if(!m_data)
+        {
+            m_data = m_pOwner->_Decode();
+            if(!m_data) return FALSE;
+            SImgX_STB::_DoPromultiply(m_data,m_data,m_nWid*m_nHei);
+        }
         memcpy(pbBuffer,m_data,cbBufferSize);
         return TRUE;
     }
@@ -39,80 +47,155 @@ namespace SOUI
     // SImgX_STB
     int SImgX_STB::LoadFromMemory( void *pBuf,size_t bufLen )
     {
-        if(m_pImg) delete m_pImg;
-        m_pImg = NULL;
+        _Reset();
+        if(!pBuf) return 0;
+
+        //延迟解码期间需要保留原始数据, 压缩数据通常远小于像素数据
+        BYTE *pCopy = (BYTE*)malloc(bufLen);
+        memcpy(pCopy,pBuf,bufLen);
+        return _DoLoad(pCopy,bufLen,TRUE);
+    }
 
+    int SImgX_STB::LoadFromFile( LPCWSTR pszFileName )
+    {
+        _Reset();
+
+        FILE *f=_wfopen(pszFileName,L"rb");
+        if(!f) return 0;
+        fseek(f,0,SEEK_END);
+        long nLen = ftell(f);
+        fseek(f,0,SEEK_SET);
+        BYTE *pBuf = NULL;
+        if(nLen>0)
+        {
+            pBuf = (BYTE*)malloc(nLen);
+            if(fread(pBuf,1,nLen,f)!=(size_t)nLen)
+            {
+                free(pBuf);
+                pBuf = NULL;
+            }
+        }
+        fclose(f);
         if(!pBuf) return 0;
+        return _DoLoad(pBuf,nLen,TRUE);
+    }
+
+    int SImgX_STB::LoadFromFile( LPCSTR pszFileName )
+    {
+        wchar_t wszFileName[MAX_PATH+1];
+        MultiByteToWideChar(CP_ACP,0,pszFileName,-1,wszFileName,MAX_PATH);
+        if(GetLastError()==ERROR_INSUFFICIENT_BUFFER) return 0;
+        return LoadFromFile(wszFileName);
+    }
 
+    int SImgX_STB::_DoLoad( BYTE *pBuf,size_t bufLen,BOOL bOwnBuf )
+    {
+        //只解析文件头获得图片大小
         int w=0,h=0;
-        unsigned char *data = stbi_load_from_memory((stbi_uc const *)pBuf,bufLen,&w,&h,NULL,4);
-        if(!data)
+        if(!stbi_info_from_memory((stbi_uc const *)pBuf,bufLen,&w,&h,NULL))
         {
+            if(bOwnBuf) free(pBuf);
             return 0;
         }
-        _DoPromultiply(data,w,h);
-        m_pImg = new SImgFrame_STB(data,w,h);
+        m_pSrcBuf = pBuf;
+        m_nSrcLen = bufLen;
+        m_nScale = SBoxDownscaler::CalcScale(w,h,m_szDecode.cx,m_szDecode.cy);
+        m_pImg = new SImgFrame_STB(this,(w+m_nScale-1)/m_nScale,(h+m_nScale-1)/m_nScale);
         return 1;
     }
 
-    int SImgX_STB::LoadFromFile( LPCWSTR pszFileName )
+    void SImgX_STB::SetDecodeSize(UINT cx,UINT cy)
+    {
+        m_szDecode.cx = cx;
+        m_szDecode.cy = cy;
+    }
+
+    void SImgX_STB::_Reset()
     {
         if(m_pImg) delete m_pImg;
         m_pImg = NULL;
+        if(m_pSrcBuf) free(m_pSrcBuf);
+        m_pSrcBuf = NULL;
+        m_nSrcLen = 0;
+    }
 
-        FILE *f=_wfopen(pszFileName,L"rb");
-        if(!f) return 0;
+    BYTE * SImgX_STB::_Decode()
+    {
+        if(!m_pSrcBuf || !m_pImg) return NULL;
         int w=0,h=0;
-        unsigned char *data = stbi_load_from_file(f,&w,&h,NULL,4);
-        fclose(f);
-        if(!data)
+        unsigned char *data = stbi_load_from_memory((stbi_uc const *)m_pSrcBuf,m_nSrcLen,&w,&h,NULL,4);
+        if(!data) return NULL;
+        if(m_nScale == 1)
         {
-            return 0;
+            if(w != m_pImg->m_nWid || h != m_pImg->m_nHei)
+            {
+                stbi_image_free(data);
+                data = NULL;
+            }
+            return data;
         }
-        _DoPromultiply(data,w,h);
-        m_pImg = new SImgFrame_STB(data,w,h);
-        return 1;
+        //stb不支持JPEG的DCT缩放, 解码完整图片后马上缩小并释放原图
+        SBoxDownscaler scaler(w,h,m_nScale);
+        BYTE *pRet = NULL;
+        if(scaler.GetWidth() == m_pImg->m_nWid && scaler.GetHeight() == m_pImg->m_nHei)
+        {
+            UINT cbRow = scaler.GetWidth()*4;
+            pRet = (BYTE*)malloc(cbRow*scaler.GetHeight());
+            for(int y=0;y<h;y++)
+                scaler.PushRow(data+w*4*y,pRet,cbRow);
+        }
+        stbi_image_free(data);
+        return pRet;
     }
 
-    int SImgX_STB::LoadFromFile( LPCSTR pszFileName )
+    BOOL SImgX_STB::DecodeInto( UINT iFrame,UINT cbStride,UINT cbBufferSize,BYTE *pbBuffer )
     {
-        wchar_t wszFileName[MAX_PATH+1];
-        MultiByteToWideChar(CP_ACP,0,pszFileName,-1,wszFileName,MAX_PATH);
-        if(GetLastError()==ERROR_INSUFFICIENT_BUFFER) return 0;
-        return LoadFromFile(wszFileName);
+        if(iFrame >= GetFrameCount()) return FALSE;
+        UINT nWid = m_pImg->m_nWid;
+        UINT nHei = m_pImg->m_nHei;
+        UINT cbRow = nWid*4;
+        if(cbStride < cbRow || cbBufferSize < cbStride*(nHei-1)+cbRow) return FALSE;
+
+        if(m_pImg->m_data)
+        {//已经解码过的像素直接复制
+            for(UINT y=0;y<nHei;y++)
+                memcpy(pbBuffer+cbStride*y,m_pImg->m_data+cbRow*y,cbRow);
+            return TRUE;
+        }
+        BYTE *data = _Decode();
+        if(!data) return FALSE;
+        //转换格式的同时写入目标缓冲区, 不再保留一份解码后的像素
+        if(cbStride == cbRow)
+        {
+            _DoPromultiply(pbBuffer,data,nWid*nHei);
+        }else
+        {
+            for(UINT y=0;y<nHei;y++)
+                _DoPromultiply(pbBuffer+cbStride*y,data+cbRow*y,nWid);
+        }
+        stbi_image_free(data);
+        return TRUE;
     }
 
     SImgX_STB::SImgX_STB(BOOL bPremultiple)
         :m_pImg(NULL)
         ,m_bPremultiple(bPremultiple)
+        ,m_pSrcBuf(NULL)
+        ,m_nSrcLen(0)
+        ,m_nScale(1)
     {
-
+        m_szDecode.cx = m_szDecode.cy = 0;
     }
 
     SImgX_STB::~SImgX_STB( void )
     {
-        if(m_pImg) delete m_pImg;
+        _Reset();
     }
 
-    void SImgX_STB::_DoPromultiply( BYTE *pdata,int nWid,int nHei )
+    void SImgX_STB::_DoPromultiply( BYTE *pdst,const BYTE *psrc,int nPixels )
     {
         //swap rgba to bgra and do premultiply
-        BYTE *p=pdata;
-        int pixel_count = nWid * nHei;
-        for (int i=0; i < pixel_count; ++i) {
-            stbi_uc a = p[3];
-            stbi_uc t = p[0];
-            if (a) 
-            {
-                p[0] = (p[2] *a)/255;
-                p[1] = (p[1] * a)/255;
-                p[2] =  (t   * a)/255;
-            }else
-            {
-                memset(p,0,4);
-            }
-            p += 4;
-        }    
+        SPremultiply::PremultiplySwapRB(pdst,psrc,nPixels);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -10,11 +10,13 @@
 
 namespace SOUI
 {
-    
+    class SImgX_STB;
+
     class SImgFrame_STB : public IImgFrame
     {
+        friend class SImgX_STB;
     public:
-        SImgFrame_STB(BYTE *data,int w,int h);
+        SImgFrame_STB(SImgX_STB *pOwner,int w,int h);
         ~SImgFrame_STB();
 
         virtual BOOL GetSize(UINT *pWid,UINT *pHei);
@@ -26,13 +28,15 @@ namespace SOUI
         virtual int GetDelay(){return 0;}
 
     protected:
-        unsigned char * m_data;
+        SImgX_STB *     m_pOwner;
+        unsigned char * m_data;     //预乘后的像素, 在CopyPixels时才解码
         int      m_nWid,m_nHei;
     };
     
     class SImgX_STB : public TObjRefImpl<IImgX>
     {
         friend class SImgDecoderFactory_STB;
+        friend class SImgFrame_STB;
     public:
 
         int LoadFromMemory(void *pBuf,size_t bufLen);
@@ -44,14 +48,27 @@ namespace SOUI
             return m_pImg;
         }
         virtual UINT GetFrameCount(){return m_pImg?1:0;}
+
+        virtual BOOL DecodeInto(UINT iFrame,UINT cbStride,UINT cbBufferSize,BYTE *pbBuffer);
+        virtual void SetDecodeSize(UINT cx,UINT cy);
     protected:
         SImgX_STB(BOOL bPremultiple);
         ~SImgX_STB(void);
         
-        void _DoPromultiply(BYTE *pdata,int nWid,int nHei);
+        int _DoLoad(BYTE *pBuf,size_t bufLen,BOOL bOwnBuf);
+        void _Reset();
+        //解码原始数据, 返回按m_nScale缩小后的RGBA像素, 由调用者free
+        BYTE * _Decode();
+
+        //rgba转换为预乘的bgra, pdst可以和psrc相同
+        static void _DoPromultiply(BYTE *pdst,const BYTE *psrc,int nPixels);
 
         BOOL m_bPremultiple;
         SImgFrame_STB *     m_pImg;
+        BYTE *              m_pSrcBuf;  //原始数据, 像素延迟到使用时解码
+        size_t              m_nSrcLen;
+        SIZE                m_szDecode; //期望的显示大小,{0,0}表示原始大小
+        int                 m_nScale;   //解码时的缩小倍数
     };
 
     #define DESC_IMGDECODER L"stb"
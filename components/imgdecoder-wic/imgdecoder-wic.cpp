@@ -3,6 +3,7 @@
 
 #include "stdafx.h"
 #include "imgdecoder-wic.h"
+#include <helper/SBoxDownscaler.hpp>
 
 #pragma  comment(lib,"windowscodecs.lib")
 
@@ -56,6 +57,7 @@ namespace SOUI
     ,m_uImgCount(0)
     ,m_bPremultiplied(bPremultiplied)
     {
+        m_szDecode.cx = m_szDecode.cy = 0;
     }
 
     SImgX_WIC::~SImgX_WIC(void)
@@ -140,7 +142,19 @@ namespace SOUI
 //                     }
 //                     PropVariantClear(&propValue);
 //                 }
-                converter->Initialize(frame,
+                SAutoRefPtr<IWICBitmapSource> src(frame);
+                UINT nWid=0,nHei=0;
+                if(m_uImgCount == 1 && m_szDecode.cx>0 && m_szDecode.cy>0 && SUCCEEDED(frame->GetSize(&nWid,&nHei)))
+                {//单帧图片按整数倍缩小, JPEG解码器可以直接在DCT阶段缩放
+                    int nScale = SBoxDownscaler::CalcScale(nWid,nHei,m_szDecode.cx,m_szDecode.cy);
+                    SAutoRefPtr<IWICBitmapScaler> scaler;
+                    if(nScale>1 && SUCCEEDED(factory->CreateBitmapScaler(&scaler))
+                        && SUCCEEDED(scaler->Initialize(frame,(nWid+nScale-1)/nScale,(nHei+nScale-1)/nScale,WICBitmapInterpolationModeFant)))
+                    {
+                        src = scaler;
+                    }
+                }
+                converter->Initialize(src,
                     m_bPremultiplied?GUID_WICPixelFormat32bppPBGRA:GUID_WICPixelFormat32bppBGRA,
                     WICBitmapDitherTypeNone,NULL,
                     0.f,WICBitmapPaletteTypeCustom);
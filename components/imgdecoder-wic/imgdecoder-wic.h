@@ -46,6 +46,7 @@ namespace SOUI
             return m_pImgArray+iFrame;
         }
         virtual UINT GetFrameCount(){return m_uImgCount;}
+        virtual void SetDecodeSize(UINT cx,UINT cy){m_szDecode.cx=cx;m_szDecode.cy=cy;}
     protected:
         SImgX_WIC(BOOL bPremultiplied);
         ~SImgX_WIC(void);
@@ -55,6 +56,7 @@ namespace SOUI
         SImgFrame_WIC *     m_pImgArray;
         UINT				m_uImgCount;
         BOOL                m_bPremultiplied;
+        SIZE                m_szDecode;     //期望的显示大小,{0,0}表示原始大小
 
     };
 
@@ -77,6 +77,7 @@ namespace SOUI
 
     HRESULT SBitmap_GDI::Init( int nWid,int nHei ,const LPVOID pBits/*=NULL*/)
     {
+        UpdateVersion();
         if(m_hBmp) DeleteObject(m_hBmp);
         LPVOID pBmpBits=NULL;
         m_hBmp = CreateGDIBitmap(nWid,nHei,&pBmpBits);
@@ -100,6 +101,7 @@ namespace SOUI
         UINT nWid,nHei;
         pFrame->GetSize(&nWid,&nHei);
 
+        UpdateVersion();
         if(m_hBmp) DeleteObject(m_hBmp);
         void * pBits=NULL;
         m_hBmp = CreateGDIBitmap(nWid,nHei,&pBits);
@@ -135,14 +137,19 @@ namespace SOUI
         pFrame->GetSize(&nWid,&nHei);
         m_sz.cx=nWid,m_sz.cy=nHei;
         
+        UpdateVersion();
         if(m_hBmp) DeleteObject(m_hBmp);
         void * pBits=NULL;
         m_hBmp = CreateGDIBitmap(m_sz.cx,m_sz.cy,&pBits);
 
         if(!m_hBmp) return E_OUTOFMEMORY;
         const int stride = m_sz.cx*4;
-        pFrame->CopyPixels(NULL, stride, stride * m_sz.cy,
-            reinterpret_cast<BYTE*>(pBits));
+        //优先直接解码到位图中, 避免解码器保留一份像素再复制
+        if(!imgDecoder->DecodeInto(0, stride, stride * m_sz.cy, reinterpret_cast<BYTE*>(pBits)))
+        {
+            pFrame->CopyPixels(NULL, stride, stride * m_sz.cy,
+                reinterpret_cast<BYTE*>(pBits));
+        }
 
         return S_OK;
     }
@@ -164,6 +171,7 @@ namespace SOUI
 
     LPVOID SBitmap_GDI::LockPixelBits()
     {
+        UpdateVersion();
         BITMAP bm;
         GetObject(m_hBmp,sizeof(bm),&bm);
         return bm.bmBits;
@@ -171,7 +179,7 @@ namespace SOUI
 
     void SBitmap_GDI::UnlockPixelBits( LPVOID pBuf)
     {
-
+        UpdateVersion();
     }
 
     const LPVOID SBitmap_GDI::GetPixelBits() const
@@ -892,6 +900,7 @@ namespace SOUI
         case OT_BITMAP: 
             pRet=m_curBmp;
             m_curBmp=(SBitmap_GDI*)pObj;
+            m_curBmp->MarkSurface();
             ::SelectObject(m_hdc,m_curBmp->GetBitmap());
             break;
         case OT_PEN:
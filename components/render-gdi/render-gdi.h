@@ -212,7 +212,7 @@ namespace SOUI
 		SOUI_CLASS_NAME(SBitmap_GDI,L"bitmap")
     public:
         SBitmap_GDI(IRenderFactory *pRenderFac)
-            :TGdiRenderObjImpl<IBitmap>(pRenderFac),m_hBmp(0)
+            :TGdiRenderObjImpl<IBitmap>(pRenderFac),m_hBmp(0),m_bSurface(false),m_dwVersion(1)
         {
             m_sz.cx=m_sz.cy=0;
         }
@@ -231,15 +231,23 @@ namespace SOUI
         virtual LPVOID  LockPixelBits();
         virtual void    UnlockPixelBits(LPVOID pBuf);
         virtual const LPVOID GetPixelBits() const;
+        virtual DWORD GetContentVersion() const {return m_bSurface?0:m_dwVersion;}
         
         HBITMAP  GetBitmap(){return m_hBmp;}
 
+        //位图被选入渲染目标后内容随时可能改变, 不再提供版本号
+        void MarkSurface(){m_bSurface=true;}
+
         static HBITMAP CreateGDIBitmap(int nWid,int nHei,void ** ppBits);
     protected:
 
         HRESULT ImgFromDecoder(IImgX *imgDecoder);
+        //像素被修改后更新内容版本号
+        void UpdateVersion(){if(++m_dwVersion == 0) m_dwVersion = 1;}
         SIZE        m_sz;
         HBITMAP     m_hBmp;     //标准的32位位图，和m_bitmap共享内存
+        bool        m_bSurface;
+        DWORD       m_dwVersion;    //内容版本号, 不为0
     };
 
     //////////////////////////////////////////////////////////////////////////
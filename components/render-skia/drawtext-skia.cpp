@@ -44,49 +44,180 @@ SkRect DrawText_Skia(SkCanvas* canvas,const wchar_t *text,int len,SkRect box, Sk
     return layout.draw(canvas);
 }
 
+SkRect DrawText_Skia(SkCanvas* canvas,const SOUI::SStringW & strText,SkRect box, SkPaint& paint,UINT uFormat,SkTextLayoutCache *pCache,SkTextBatch *pBatch)
+{
+	if(!pCache)
+	{
+		SkTextLayoutEx layout;
+		layout.init(strText,strText.GetLength(),box,paint,uFormat);
+		return layout.draw(canvas,pBatch);
+	}
+	SkTextLayoutEx *pLayout = pCache->get(strText,box,paint,uFormat);
+	return pLayout->draw(canvas,pBatch);
+}
+
+static bool HasSurrogate(const wchar_t *text, size_t length)
+{
+    for(size_t i=0;i<length;i++)
+    {
+        if(text[i]>=0xD800 && text[i]<=0xDFFF)
+            return true;
+    }
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SkTextBatch
+SkTextBatch::SkTextBatch():m_canvas(NULL),m_nRuns(0),m_nDraws(0)
+{
+}
+
+void SkTextBatch::beginRun(SkCanvas *canvas, const SkPaint &paint)
+{
+    SkPaint paintRun(paint);
+    paintRun.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    paintRun.setTextAlign(SkPaint::kLeft_Align);
+    if(canvas != m_canvas || !(paintRun == m_paint))
+    {//画笔状态改变, 提交已经合并的文本
+        flush();
+        m_canvas = canvas;
+        m_paint = paintRun;
+    }
+}
+
+bool SkTextBatch::addText(SkCanvas *canvas, const wchar_t *text, size_t length, SkScalar x, SkScalar y, const SkPaint &paint)
+{
+    SkTypeface *pfont = paint.getTypeface();
+    if(!pfont || HasSurrogate(text,length))
+        return false;
+    SkTDArray<uint16_t> glyphs;
+    glyphs.setCount(length);
+    int nValids = pfont->charsToGlyphs(text,SkTypeface::kUTF16_Encoding,glyphs.begin(),length);
+    if(nValids != (int)length)
+        return false;
+    SkPaint paintGlyph(paint);
+    paintGlyph.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    SkTDArray<SkScalar> advances;
+    advances.setCount(length);
+    paintGlyph.getTextWidths(glyphs.begin(),length*sizeof(uint16_t),advances.begin());
+    return addGlyphs(canvas,glyphs.begin(),advances.begin(),(int)length,x,y,paint);
+}
+
+bool SkTextBatch::addGlyphs(SkCanvas *canvas, const uint16_t *glyphs, const SkScalar *advances, int count, SkScalar x, SkScalar y, const SkPaint &paint)
+{
+    //drawPosText不绘制下划线及删除线
+    if(paint.getFlags() & (SkPaint::kUnderlineText_Flag|SkPaint::kStrikeThruText_Flag))
+        return false;
+    beginRun(canvas,paint);
+
+    SkScalar fWid = 0.0f;
+    for(int i=0;i<count;i++)
+        fWid += advances[i];
+    switch(paint.getTextAlign())
+    {
+    case SkPaint::kCenter_Align:
+        x -= fWid/2.0f;
+        break;
+    case SkPaint::kRight_Align:
+        x -= fWid;
+        break;
+    }
+
+    m_glyphs.append(count,glyphs);
+    SkPoint *pos = m_pos.append(count);
+    for(int i=0;i<count;i++)
+    {
+        pos[i].set(x,y);
+        x += advances[i];
+    }
+    m_nRuns++;
+    return true;
+}
+
+void SkTextBatch::addLine(SkCanvas *canvas, SkScalar x0, SkScalar y0, SkScalar x1, SkScalar y1, const SkPaint &paint)
+{
+    beginRun(canvas,paint);
+    SkPoint *pts = m_lines.append(2);
+    pts[0].set(x0,y0);
+    pts[1].set(x1,y1);
+    m_nRuns++;
+}
+
+void SkTextBatch::flush()
+{
+    if(m_canvas)
+    {
+        if(!m_glyphs.isEmpty())
+        {
+            m_canvas->drawPosText(m_glyphs.begin(),m_glyphs.count()*sizeof(uint16_t),m_pos.begin(),m_paint);
+            m_nDraws++;
+        }
+        if(!m_lines.isEmpty())
+        {
+            m_canvas->drawPoints(SkCanvas::kLines_PointMode,m_lines.count(),m_lines.begin(),m_paint);
+            m_nDraws++;
+        }
+    }
+    m_glyphs.rewind();
+    m_pos.rewind();
+    m_lines.rewind();
+}
+
 //////////////////////////////////////////////////////////////////////////
-void SkTextLayoutEx::init( const wchar_t text[], size_t length,SkRect rc,  SkPaint &paint,UINT uFormat )
+void SkTextLayoutEx::init( const wchar_t text[], size_t length,SkRect rc,  const SkPaint &paint,UINT uFormat )
 {
+    m_prefix.reset();
+    m_text.setCount(length);
     if(uFormat & DT_NOPREFIX)
     {
-        m_text.setCount(length);
         memcpy(m_text.begin(),text,length*sizeof(wchar_t));
     }else
-    {
-        m_prefix.reset();
-        SkTDArray<wchar_t> tmp;
-        tmp.setCount(length);
-        memcpy(tmp.begin(),text,length*sizeof(wchar_t));
-        for(int i=0;i<tmp.count();i++)
+    {//一次扫描去掉前缀符, 同时记录前缀字符在结果文本中的位置
+        wchar_t *pDst = m_text.begin();
+        int nLen = 0;
+        for(size_t i=0;i<length;i++)
         {
-            if(tmp[i]==L'&' && i+1 < tmp.count())
+            if(text[i]==L'&' && i+1 < length)
             {
-				if(tmp[i+1]==L'&')
-				{
-					tmp.remove(i,1);
-				}else
-				{
-					tmp.remove(i,1);
-					m_prefix.push(i);
-				}
+                i++;
+                if(text[i]!=L'&')
+                    m_prefix.push(nLen);
             }
+            pDst[nLen++] = text[i];
         }
-        m_text=tmp;
+        m_text.setCount(nLen);
     }
 
-    m_paint=&paint;
+    m_paint=paint;
     m_rcBound=rc;
     m_uFormat=uFormat;
+    m_nGlyphState=0;
+    m_batch=NULL;
     buildLines();
 }
 
+void SkTextLayoutEx::attach(SkRect rc, const SkPaint &paint, UINT uFormat)
+{
+    m_paint=paint;
+    m_rcBound=rc;
+    m_uFormat=uFormat;
+}
+
+SkScalar SkTextLayoutEx::getLineWidth(int iLine)
+{
+    LineInfo &line = m_lines[iLine];
+    if(line.fWidth < 0.0f)
+        line.fWidth = measureText(&m_paint,m_text.begin()+line.nOffset,line.nLen);
+    return line.fWidth;
+}
+
 void SkTextLayoutEx::buildLines()
 {
     m_lines.reset();
 
     if(m_uFormat & DT_SINGLELINE)
     {
-		LineInfo info = { 0,m_text.count() };
+		LineInfo info = { 0,m_text.count(),-1.0f,-1,0.0f };
         m_lines.push(info);
     }else
     {
@@ -99,10 +230,10 @@ void SkTextLayoutEx::buildLines()
         while(lineHead<m_text.count())
         {
 			int endLen = 0;
-            size_t line_len = breakTextEx(m_paint,text, stop - text, maxWid,endLen);
+            size_t line_len = breakTextEx(&m_paint,text, stop - text, maxWid,endLen);
 			if (line_len + endLen == 0)
 				break;
-			LineInfo info = { lineHead,(int)line_len };
+			LineInfo info = { lineHead,(int)line_len,-1.0f,-1,0.0f };
 			m_lines.push(info);
 			text += line_len+endLen;
             lineHead += line_len+endLen;
@@ -110,13 +241,15 @@ void SkTextLayoutEx::buildLines()
     }
 }
 
-SkScalar SkTextLayoutEx::drawLine( SkCanvas *canvas, SkScalar x, SkScalar y, int iBegin,int iEnd )
+SkScalar SkTextLayoutEx::drawLine( SkCanvas *canvas, SkScalar x, SkScalar y, int iLine )
 {
+    int iBegin = m_lines[iLine].nOffset;
+    int iEnd = iBegin + m_lines[iLine].nLen;
     const wchar_t *text=m_text.begin()+iBegin;
 
     if(!(m_uFormat & DT_CALCRECT))
     {
-        drawText(canvas,text,(iEnd-iBegin),x,y,*m_paint);
+        drawText(canvas,text,(iEnd-iBegin),x,y,m_paint);
         int i=0;
         while(i<m_prefix.count())
         {
@@ -126,10 +259,10 @@ SkScalar SkTextLayoutEx::drawLine( SkCanvas *canvas, SkScalar x, SkScalar y, int
         }
         
         SkScalar xBase = x;
-        if(m_paint->getTextAlign() != SkPaint::kLeft_Align)
+        if(m_paint.getTextAlign() != SkPaint::kLeft_Align)
         {
-            SkScalar nTextWidth = measureText(m_paint,text,(iEnd-iBegin));
-            switch(m_paint->getTextAlign())
+            SkScalar nTextWidth = getLineWidth(iLine);
+            switch(m_paint.getTextAlign())
             {
             case SkPaint::kCenter_Align:
                 xBase = x - nTextWidth/2.0f;
@@ -142,58 +275,69 @@ SkScalar SkTextLayoutEx::drawLine( SkCanvas *canvas, SkScalar x, SkScalar y, int
         
         while(i<m_prefix.count() && m_prefix[i]<iEnd)
         {
-            SkScalar x1 = m_paint->measureText(text,(m_prefix[i]-iBegin)*sizeof(wchar_t));
-            SkScalar x2 = m_paint->measureText(text,(m_prefix[i]-iBegin+1)*sizeof(wchar_t));
-            canvas->drawLine(xBase+x1,y+1,xBase+x2,y+1,*m_paint); //绘制下划线
+            SkScalar x1 = m_paint.measureText(text,(m_prefix[i]-iBegin)*sizeof(wchar_t));
+            SkScalar x2 = m_paint.measureText(text,(m_prefix[i]-iBegin+1)*sizeof(wchar_t));
+            if(m_batch)
+                m_batch->addLine(canvas,xBase+x1,y+1,xBase+x2,y+1,m_paint);
+            else
+                canvas->drawLine(xBase+x1,y+1,xBase+x2,y+1,m_paint); //绘制下划线
             i++;
         }
     }
-    return measureText(m_paint,text,(iEnd-iBegin));
+    return getLineWidth(iLine);
 }
 
-SkScalar SkTextLayoutEx::drawLineEndWithEllipsis( SkCanvas *canvas, SkScalar x, SkScalar y, int iBegin,int iEnd,SkScalar maxWidth )
+SkScalar SkTextLayoutEx::drawLineEndWithEllipsis( SkCanvas *canvas, SkScalar x, SkScalar y, int iLine,SkScalar maxWidth )
 {
-    SkScalar widReq=measureText(m_paint,m_text.begin()+iBegin,(iEnd-iBegin));
+    SkScalar widReq=getLineWidth(iLine);
     if(widReq<=m_rcBound.width())
     {
-        return drawLine(canvas,x,y,iBegin,iEnd);
+        return drawLine(canvas,x,y,iLine);
     }else
     {
-        SkScalar fWidEllipsis = measureText(m_paint,CH_ELLIPSIS,3);
-        maxWidth-=fWidEllipsis;
-        
-        int i=0;
-        const wchar_t *text=m_text.begin()+iBegin;
-        SkScalar fWid=0.0f;
-        while(i<(iEnd-iBegin))
+        SkScalar fWidEllipsis = measureText(&m_paint,CH_ELLIPSIS,3);
+        LineInfo &line = m_lines[iLine];
+        const wchar_t *text=m_text.begin()+line.nOffset;
+        if(line.nEllipsis<0)
         {
-            SkScalar fWord = measureText(m_paint,text+i,1);
-            if(fWid + fWord > maxWidth) break;
-            fWid += fWord;
-            i++;
+            maxWidth-=fWidEllipsis;
+
+            int i=0;
+            SkScalar fWid=0.0f;
+            while(i<line.nLen)
+            {
+                SkScalar fWord = measureText(&m_paint,text+i,1);
+                if(fWid + fWord > maxWidth) break;
+                fWid += fWord;
+                i++;
+            }
+            line.nEllipsis = i;
+            line.fEllipsisWid = fWid;
         }
+        int i = line.nEllipsis;
+        SkScalar fWid = line.fEllipsisWid;
         if(!(m_uFormat & DT_CALCRECT))
         {
             wchar_t *pbuf=new wchar_t[i+3];
             memcpy(pbuf,text,i*sizeof(wchar_t));
             memcpy(pbuf+i,CH_ELLIPSIS,3*sizeof(wchar_t));
-            drawText(canvas,pbuf,(i+3),x,y,*m_paint);
+            drawText(canvas,pbuf,(i+3),x,y,m_paint);
             delete []pbuf;
         }
         return fWid+fWidEllipsis;
     }
 }
 
-SkRect SkTextLayoutEx::draw( SkCanvas* canvas )
+SkRect SkTextLayoutEx::draw( SkCanvas* canvas, SkTextBatch *pBatch )
 {
     SkPaint::FontMetrics metrics;
-    m_paint->getFontMetrics(&metrics);
+    m_paint.getFontMetrics(&metrics);
     float lineSpan = metrics.fBottom-metrics.fTop;
 
     SkRect rcDraw = m_rcBound;
 
     float  x;
-    switch (m_paint->getTextAlign()) 
+    switch (m_paint.getTextAlign()) 
     {
     case SkPaint::kCenter_Align:
         x = SkScalarHalf(m_rcBound.width());
@@ -207,15 +351,10 @@ SkRect SkTextLayoutEx::draw( SkCanvas* canvas )
     }
     x += m_rcBound.fLeft;
 
-    canvas->save();
-
-    canvas->clipRect(m_rcBound);
-
     float height = m_rcBound.height();
     float y=m_rcBound.fTop - metrics.fTop;
     if(m_uFormat & DT_SINGLELINE)
-    {//单行显示
-        rcDraw.fBottom = rcDraw.fTop + lineSpan;
+    {
         if(m_uFormat & DT_VCENTER) 
         {
             y += (height - lineSpan)/2.0f;
@@ -224,12 +363,34 @@ SkRect SkTextLayoutEx::draw( SkCanvas* canvas )
 		{
 			y += (height - lineSpan);
 		}
+    }
+
+    m_batch = NULL;
+    bool bClip = true;
+    if(pBatch && !(m_uFormat & DT_CALCRECT))
+    {//完全落在限制矩形内的文本不需要剪裁, 可以和其它文本合并绘制
+        bClip = needClip(y,metrics);
+        if(bClip)
+            pBatch->flush();
+        else
+            m_batch = pBatch;
+    }
+
+    if(bClip)
+    {
+        canvas->save();
+        canvas->clipRect(m_rcBound);
+    }
+
+    if(m_uFormat & DT_SINGLELINE)
+    {//单行显示
+        rcDraw.fBottom = rcDraw.fTop + lineSpan;
         if(m_uFormat & DT_ELLIPSIS)
         {//只支持在行尾增加省略号
-            rcDraw.fRight = rcDraw.fLeft + drawLineEndWithEllipsis(canvas,x,y,0,m_text.count(),m_rcBound.width());
+            rcDraw.fRight = rcDraw.fLeft + drawLineEndWithEllipsis(canvas,x,y,0,m_rcBound.width());
         }else
         {
-            rcDraw.fRight = rcDraw.fLeft + drawLine(canvas,x,y,0,m_text.count());
+            rcDraw.fRight = rcDraw.fLeft + drawLine(canvas,x,y,0);
         }
     }else
     {//多行显示
@@ -239,24 +400,20 @@ SkRect SkTextLayoutEx::draw( SkCanvas* canvas )
         {
             if(y + lineSpan + metrics.fTop >= m_rcBound.fBottom) 
                 break;  //the last visible line
-            int iBegin=m_lines[iLine].nOffset;
-            int iEnd = iBegin + m_lines[iLine].nLen;
-            SkScalar lineWid = drawLine(canvas,x,y,iBegin,iEnd);
+            SkScalar lineWid = drawLine(canvas,x,y,iLine);
             maxLineWid = MAX(maxLineWid,lineWid);
             y += lineSpan;
             iLine ++;
         }
         if(iLine<m_lines.count())
         {//draw the last visible line
-			int iBegin = m_lines[iLine].nOffset;
-			int iEnd = iBegin + m_lines[iLine].nLen;
             SkScalar lineWid;
             if(m_uFormat & DT_ELLIPSIS)
             {//只支持在行尾增加省略号
-                lineWid=drawLineEndWithEllipsis(canvas,x,y,iBegin,iEnd,m_rcBound.width());
+                lineWid=drawLineEndWithEllipsis(canvas,x,y,iLine,m_rcBound.width());
             }else
             {
-                lineWid=drawLine(canvas,x,y,iBegin,iEnd);
+                lineWid=drawLine(canvas,x,y,iLine);
             }
             maxLineWid = MAX(maxLineWid,lineWid);
             y += lineSpan;
@@ -264,12 +421,69 @@ SkRect SkTextLayoutEx::draw( SkCanvas* canvas )
         rcDraw.fRight = rcDraw.fLeft + maxLineWid;
         rcDraw.fBottom = y + metrics.fTop;
     }
-    canvas->restore();
+    if(bClip)
+        canvas->restore();
+    m_batch = NULL;
     return rcDraw;
 }
 
+bool SkTextLayoutEx::needClip(SkScalar y, const SkPaint::FontMetrics & metrics)
+{
+    SkScalar lineSpan = metrics.fBottom-metrics.fTop;
+    int nLines = m_lines.count();
+    if(y + metrics.fTop < m_rcBound.fTop)
+        return true;
+    if(y + metrics.fTop + lineSpan*nLines > m_rcBound.fBottom)
+        return true;
+    if((m_uFormat & DT_SINGLELINE) && (m_uFormat & DT_ELLIPSIS))
+        return false;   //省略号保证不超出宽度
+    for(int i=0;i<nLines;i++)
+    {
+        if(getLineWidth(i) > m_rcBound.width())
+            return true;
+    }
+    return false;
+}
+
+bool SkTextLayoutEx::prepareGlyphs()
+{
+    if(m_nGlyphState == 0)
+    {
+        m_nGlyphState = -1;
+        SkTypeface *pfont = m_paint.getTypeface();
+        int nLen = m_text.count();
+        if(pfont && nLen>0 && !HasSurrogate(m_text.begin(),nLen))
+        {
+            m_glyphs.setCount(nLen);
+            int nValids = pfont->charsToGlyphs(m_text.begin(),SkTypeface::kUTF16_Encoding,m_glyphs.begin(),nLen);
+            if(nValids == nLen)
+            {
+                SkPaint paint(m_paint);
+                paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+                m_advances.setCount(nLen);
+                paint.getTextWidths(m_glyphs.begin(),nLen*sizeof(uint16_t),m_advances.begin());
+                m_nGlyphState = 1;
+            }
+        }
+    }
+    return m_nGlyphState == 1;
+}
+
 void SkTextLayoutEx::drawText(SkCanvas *canvas,const wchar_t* text, size_t length, SkScalar x, SkScalar y,  SkPaint& paint)
 {
+	if(m_batch)
+	{//排版文本使用缓存的字形, 省略号等临时文本现场转换
+		int iOffset = (int)(text - m_text.begin());
+		if(iOffset>=0 && iOffset + (int)length <= m_text.count())
+		{
+			if(prepareGlyphs() && m_batch->addGlyphs(canvas,m_glyphs.begin()+iOffset,m_advances.begin()+iOffset,(int)length,x,y,paint))
+				return;
+		}else if(m_batch->addText(canvas,text,length,x,y,paint))
+		{
+			return;
+		}
+		m_batch->flush();
+	}
 	SkTypeface *pfont = paint.getTypeface();
 	uint16_t* glyphs = new uint16_t[length];
 	int nValids=pfont->charsToGlyphs(text,SkTypeface::kUTF16_Encoding,glyphs,length);
@@ -296,3 +510,89 @@ SkScalar SkTextLayoutEx::measureText( SkPaint *paint,const wchar_t* text, size_t
 {
 	return paint->measureText(text,length*sizeof(wchar_t));
 }
+
+//////////////////////////////////////////////////////////////////////////
+// SkTextLayoutCache
+SkTextLayoutCache::SkTextLayoutCache(int nCapacity):m_nCapacity(nCapacity)
+{
+}
+
+SkTextLayoutCache::~SkTextLayoutCache()
+{
+    clear();
+}
+
+ULONG SkTextLayoutCache::LayoutKeyTraits::Hash(INARGTYPE key)
+{
+    ULONG uHash = 5381;
+    LPCWSTR pszText = key.strText;
+    int nLen = key.strText.GetLength();
+    for(int i=0;i<nLen;i++)
+        uHash = (uHash<<5) + uHash + pszText[i];
+    uint32_t uWidth;
+    memcpy(&uWidth,&key.fWidth,sizeof(uWidth));
+    uHash = (uHash<<5) + uHash + (ULONG)uWidth;
+    uHash = (uHash<<5) + uHash + (ULONG)key.uFormat;
+    return uHash;
+}
+
+bool SkTextLayoutCache::LayoutKeyTraits::CompareElements(INARGTYPE key1, INARGTYPE key2)
+{
+    //按位比较宽度, 与Hash保持一致
+    return memcmp(&key1.fWidth,&key2.fWidth,sizeof(SkScalar)) == 0
+        && key1.uFormat == key2.uFormat
+        && key1.strText == key2.strText;
+}
+
+SkTextLayoutEx * SkTextLayoutCache::get(const SOUI::SStringW & strText, SkRect rc, const SkPaint &paint, UINT uFormat)
+{
+    //只有影响分行及省略号位置的标志才参与比较, 对齐等标志在attach时更新
+    LayoutKey key;
+    key.strText = strText;
+    key.uFormat = uFormat & (DT_NOPREFIX|DT_SINGLELINE|DT_ELLIPSIS);
+    key.fWidth = rc.width();
+    if(!(uFormat & DT_SINGLELINE))
+    {
+        if((uFormat & DT_CALCRECT) && rc.width() < 1.0f)
+        {//不限宽度
+            key.uFormat |= DT_CALCRECT;
+            key.fWidth = 0.0f;
+        }
+    }else if(!(uFormat & DT_ELLIPSIS))
+    {//单行无省略号时排版与宽度无关
+        key.fWidth = 0.0f;
+    }
+
+    SOUI::SPOSITION pos = NULL;
+    if(m_index.Lookup(key,pos))
+    {
+        m_lru.MoveToHead(pos);
+        LayoutEntry *pEntry = m_lru.GetAt(pos);
+        pEntry->layout.attach(rc,paint,uFormat);
+        return &pEntry->layout;
+    }
+
+    LayoutEntry *pEntry = new LayoutEntry;
+    pEntry->key = key;
+    pEntry->layout.init(strText,strText.GetLength(),rc,paint,uFormat);
+    m_index[key] = m_lru.AddHead(pEntry);
+
+    if(m_lru.GetCount() > m_nCapacity)
+    {//淘汰最久未使用的排版
+        LayoutEntry *pOld = m_lru.RemoveTail();
+        m_index.RemoveKey(pOld->key);
+        delete pOld;
+    }
+    return &pEntry->layout;
+}
+
+void SkTextLayoutCache::clear()
+{
+    SOUI::SPOSITION pos = m_lru.GetHeadPosition();
+    while(pos)
+    {
+        delete m_lru.GetNext(pos);
+    }
+    m_lru.RemoveAll();
+    m_index.RemoveAll();
+}
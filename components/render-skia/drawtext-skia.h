@@ -3,21 +3,67 @@
 #include <core/SkPaint.h>
 #include <core/SkCanvas.h>
 #include <core/sktdarray.h>
+#include <string/tstring.h>
+#include <souicoll.h>
+
+//文本批量绘制: 把连续的文本转换为定位字形, 画笔状态相同的合并为一次drawPosText提交
+//注意: 批中的文本在flush前不会真正绘制, 画布状态改变前必须调用flush
+class SkTextBatch {
+public:
+    SkTextBatch();
+
+    //返回false表示不能合并(缺字或者需要绘制下划线/删除线), 调用者需要自己绘制
+    bool addText(SkCanvas *canvas, const wchar_t *text, size_t length, SkScalar x, SkScalar y, const SkPaint &paint);
+    bool addGlyphs(SkCanvas *canvas, const uint16_t *glyphs, const SkScalar *advances, int count, SkScalar x, SkScalar y, const SkPaint &paint);
+    //前缀符下划线
+    void addLine(SkCanvas *canvas, SkScalar x0, SkScalar y0, SkScalar x1, SkScalar y1, const SkPaint &paint);
+
+    void flush();
+
+    bool isEmpty() const {return m_glyphs.isEmpty() && m_lines.isEmpty();}
+
+    int getRunCount() const {return m_nRuns;}
+    int getDrawCount() const {return m_nDraws;}
+    //合并节省的绘制调用次数
+    int getSavedDrawCount() const {return m_nRuns - m_nDraws;}
+    void resetStats() {m_nRuns = m_nDraws = 0;}
+
+private:
+    void beginRun(SkCanvas *canvas, const SkPaint &paint);
+
+    SkCanvas *          m_canvas;   //当前批的目标画布
+    SkPaint             m_paint;    //当前批的画笔, 字形编码, 左对齐
+    SkTDArray<uint16_t> m_glyphs;
+    SkTDArray<SkPoint>  m_pos;
+    SkTDArray<SkPoint>  m_lines;    //下划线端点, 两点一组
+    int m_nRuns;
+    int m_nDraws;
+};
 
 class SkTextLayoutEx {
 public:
-    //not support for DT_PREFIXONLY
-    void init(const wchar_t text[], size_t length,SkRect rc,  SkPaint &paint,UINT uFormat);
+    //not support for DT_PREFIXONLY, 排版保存画笔的副本, 调用后paint可以释放
+    void init(const wchar_t text[], size_t length,SkRect rc, const SkPaint &paint,UINT uFormat);
+
+    //复用已经完成的排版, rc的宽度及影响排版的标志必须与init时一致
+    void attach(SkRect rc, const SkPaint &paint, UINT uFormat);
+
+    //pBatch不为空时, 不需要剪裁的文本提交到批中绘制
+    SkRect draw(SkCanvas* canvas, SkTextBatch *pBatch = NULL);
 
-    SkRect draw(SkCanvas* canvas);
+    SkScalar getLineWidth(int iLine);
 
 private:
-    SkScalar drawLineEndWithEllipsis(SkCanvas *canvas, SkScalar x, SkScalar y, int iBegin,int iEnd,SkScalar maxWidth);
+    SkScalar drawLineEndWithEllipsis(SkCanvas *canvas, SkScalar x, SkScalar y, int iLine,SkScalar maxWidth);
 
-    SkScalar drawLine(SkCanvas *canvas, SkScalar x, SkScalar y, int iBegin,int iEnd);
+    SkScalar drawLine(SkCanvas *canvas, SkScalar x, SkScalar y, int iLine);
 
     void buildLines();
 
+    bool needClip(SkScalar y, const SkPaint::FontMetrics & metrics);
+
+    bool prepareGlyphs();
+
 	void drawText(SkCanvas *canvas,const wchar_t* text, size_t length, SkScalar x, SkScalar y,  SkPaint& paint);
 	SkScalar measureText( SkPaint *paint,const wchar_t* text, size_t length);
 
@@ -27,12 +73,55 @@ private:
 	struct LineInfo {
 		int nOffset;
 		int nLen;
+		SkScalar fWidth;        //行宽度, <0表示还没有测量
+		int nEllipsis;          //加省略号时保留的字符数, <0表示还没有计算
+		SkScalar fEllipsisWid;  //保留字符的宽度
 	};
     SkTDArray<LineInfo> m_lines;      //分行索引
+    SkTDArray<uint16_t> m_glyphs;     //字形索引, 和m_text一一对应
+    SkTDArray<SkScalar> m_advances;   //字形宽度
+    int             m_nGlyphState;  //0:还没有转换, 1:可用, -1:不能按字形绘制
+    SkTextBatch *   m_batch;
     UINT            m_uFormat;    //显示标志
     SkRect          m_rcBound;    //限制矩形
-    SkPaint  *m_paint;
+    SkPaint         m_paint;      //画笔副本, 缓存的排版可能在调用者的画笔销毁后使用
 };
 
+//文本排版缓存, 由字体对象持有, 字体销毁或修改时失效
+class SkTextLayoutCache {
+public:
+    SkTextLayoutCache(int nCapacity = 256);
+    ~SkTextLayoutCache();
+
+    //返回排版结果, 对象由缓存管理, 在下一次调用get或clear前有效
+    SkTextLayoutEx * get(const SOUI::SStringW & strText, SkRect rc, const SkPaint &paint, UINT uFormat);
+
+    void clear();
+
+private:
+    struct LayoutKey {
+        SOUI::SStringW strText;
+        SkScalar fWidth;    //排版宽度, 与init时使用的宽度完全一致, 不做取整
+        UINT uFormat;
+    };
+
+    class LayoutKeyTraits : public SOUI::CElementTraitsBase<LayoutKey>
+    {
+    public:
+        static ULONG Hash(INARGTYPE key);
+        static bool CompareElements(INARGTYPE key1, INARGTYPE key2);
+    };
+
+    struct LayoutEntry {
+        LayoutKey key;
+        SkTextLayoutEx layout;
+    };
+
+    SOUI::SList<LayoutEntry*> m_lru;    //最近使用的排在前面
+    SOUI::SMap<LayoutKey,SOUI::SPOSITION,LayoutKeyTraits> m_index;
+    int m_nCapacity;
+};
 
 SkRect DrawText_Skia(SkCanvas* canvas,const wchar_t *text,int len,SkRect box, SkPaint& paint,UINT uFormat);
+
+SkRect DrawText_Skia(SkCanvas* canvas,const SOUI::SStringW & strText,SkRect box, SkPaint& paint,UINT uFormat,SkTextLayoutCache *pCache,SkTextBatch *pBatch = NULL);
@@ -166,7 +166,7 @@ namespace SOUI
 	//////////////////////////////////////////////////////////////////////////
 	// SRenderFactory_Skia
 
-	SRenderFactory_Skia::SRenderFactory_Skia()
+	SRenderFactory_Skia::SRenderFactory_Skia(BOOL bHeadless):m_bHeadless(bHeadless)
 	{
 		SkGraphics::Init();
 		SkGraphics::SetFontCacheCountLimit(500);//cache up to 500 font resource.
@@ -255,8 +255,10 @@ namespace SOUI
         ,m_curColor(0xFF000000)//默认黑色
         ,m_hGetDC(0)
         ,m_uGetDCFlag(0)
+        ,m_hGetDCBmp(NULL)
 		,m_bAntiAlias(true)
 		,m_xferMode(kSrcOver_Mode)
+		,m_bPatchCache(false)
 	{
         m_ptOrg.fX=m_ptOrg.fY=0.0f;
         m_pRenderFactory = pRenderFactory;
@@ -289,6 +291,7 @@ namespace SOUI
 	
 	SRenderTarget_Skia::~SRenderTarget_Skia()
 	{
+		FlushText();//位图可能在RT销毁后继续使用, 提交还没有绘制的文本
 		if(m_SkCanvas) delete m_SkCanvas;
 	}
 
@@ -325,6 +328,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::Resize( SIZE sz )
 	{
+    	FlushText();
     	m_curBmp->Init(sz.cx,sz.cy);
         delete m_SkCanvas;
         m_SkCanvas = new SkCanvas(m_curBmp->GetSkBitmap());
@@ -333,6 +337,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::PushClipRect( LPCRECT pRect ,UINT mode/*=RGN_AND*/)
 	{
+        FlushText();
         SkRect skrc=toSkRect(pRect);
         skrc.offset(m_ptOrg);
         
@@ -344,6 +349,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::PushClipRegion( IRegion *pRegion ,UINT mode/*=RGN_AND*/)
 	{
+        FlushText();
         SRegion_Skia * rgn_skia=(SRegion_Skia*)pRegion;
         SkRegion rgn=rgn_skia->GetRegion();
         rgn.translate((int)m_ptOrg.fX,(int)m_ptOrg.fY);
@@ -357,12 +363,14 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::PopClip()
     {
+        FlushText();
         m_SkCanvas->restore();
         return S_OK;
     }
 
     HRESULT SRenderTarget_Skia::ExcludeClipRect( LPCRECT pRc )
     {
+        FlushText();
         SkRect skrc=toSkRect(pRc);
         skrc.offset(m_ptOrg);
         m_SkCanvas->clipRect(skrc,SkRegion::kDifference_Op);
@@ -371,6 +379,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::IntersectClipRect( LPCRECT pRc )
     {
+        FlushText();
         SkRect skrc=toSkRect(pRc);
         skrc.offset(m_ptOrg);
         m_SkCanvas->clipRect(skrc,SkRegion::kIntersect_Op);
@@ -379,6 +388,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::SaveClip( int *pnState )
     {
+        FlushText();
         int nState=m_SkCanvas->save();
         if(pnState) *pnState=nState;
         return S_OK;
@@ -386,6 +396,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::RestoreClip( int nState/*=-1*/ )
     {
+        FlushText();
         m_SkCanvas->restoreToCount(nState);
         return S_OK;
     }
@@ -419,11 +430,13 @@ namespace SOUI
     
 	HRESULT SRenderTarget_Skia::BitBlt( LPCRECT pRcDest,IRenderTarget *pRTSour,int xSrc,int ySrc,DWORD dwRop/*=SRCCOPY*/)
 	{
+        FlushText();
         SkPaint paint=m_paint;
         paint.setStyle(SkPaint::kFill_Style);
 		SetPaintXferMode(paint,dwRop);
 
         SRenderTarget_Skia *pRtSourSkia=(SRenderTarget_Skia*)pRTSour;
+        pRtSourSkia->FlushText();
         const SkBitmap  &  bmpSrc=pRtSourSkia->m_curBmp->GetSkBitmap();
         POINT ptSourViewport;
         pRtSourSkia->GetViewportOrg(&ptSourViewport);
@@ -472,7 +485,7 @@ namespace SOUI
 			txtPaint.setTextAlign(SkPaint::kLeft_Align);
         SkRect skrc=toSkRect(pRc);
         skrc.offset(m_ptOrg);
-        skrc=DrawText_Skia(m_SkCanvas,strW,strW.GetLength(),skrc,txtPaint,uFormat);
+        skrc=DrawText_Skia(m_SkCanvas,strW,skrc,txtPaint,uFormat,&pFont->GetLayoutCache(),&m_textBatch);
         if(uFormat & DT_CALCRECT)
         {
             pRc->left=(int)skrc.fLeft;
@@ -488,8 +501,10 @@ namespace SOUI
         SkPaint     txtPaint = m_paint;
         txtPaint.setTypeface(m_curFont->GetFont());
 		txtPaint.setTextSize(SkIntToScalar(abs(m_curFont->TextSize())));
+		if(cchLen<0) cchLen= _tcslen(pszText);
         SStringW strW=S_CT2W(SStringT(pszText,cchLen));
-        psz->cx = (int)txtPaint.measureText(strW,strW.GetLength()*sizeof(wchar_t));
+        SkTextLayoutEx *pLayout = m_curFont->GetLayoutCache().get(strW,SkRect::MakeEmpty(),txtPaint,DT_SINGLELINE|DT_NOPREFIX);
+        psz->cx = (int)pLayout->getLineWidth(0);
         
         SkPaint::FontMetrics metrics;
         txtPaint.getFontMetrics(&metrics);
@@ -499,6 +514,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::DrawRectangle(LPCRECT pRect)
 	{
+		FlushText();
 		SkPaint paint=m_paint;
 		paint.setColor(SColor(m_curPen->GetColor()).toARGB());
 		SLineDashEffect skDash(m_curPen->GetStyle());
@@ -527,6 +543,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::FillRectangle(LPCRECT pRect)
 	{
+		FlushText();
 		SkPaint paint=m_paint;
 		if(m_curBrush->IsBitmap())
 		{
@@ -548,6 +565,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawRoundRect( LPCRECT pRect,POINT pt )
     {
+        FlushText();
         SkPaint paint=m_paint;
 		SetPaintXferMode(paint,m_xferMode);
         paint.setColor(SColor(m_curPen->GetColor()).toARGB());
@@ -571,6 +589,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::FillRoundRect( LPCRECT pRect,POINT pt )
     {
+        FlushText();
         SkPaint paint=m_paint;
 
         if(m_curBrush->IsBitmap())
@@ -594,6 +613,7 @@ namespace SOUI
     
     HRESULT SRenderTarget_Skia::FillSolidRoundRect(LPCRECT pRect,POINT pt,COLORREF cr)
     {
+        FlushText();
         SkPaint paint=m_paint;
 
         paint.setFilterBitmap(false);
@@ -611,6 +631,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawLines(LPPOINT pPt,size_t nCount)
     {
+        FlushText();
         SkPoint *pts=new SkPoint[nCount];
         for(size_t i=0; i<nCount; i++ )
         {
@@ -646,6 +667,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::TextOut( int x, int y, LPCTSTR lpszString, int nCount)
 	{
+		FlushText();
 		if(nCount<0) nCount= _tcslen(lpszString);
 		SStringW strW=S_CT2W(SStringT(lpszString,nCount));
         SkPaint     txtPaint =m_paint;
@@ -667,7 +689,9 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawIconEx( int xLeft, int yTop, HICON hIcon, int cxWidth,int cyWidth,UINT diFlags )
     {
+        FlushText();
         HDC hdc=GetDC(0);
+        if(!hdc) return E_NOTIMPL;//无头模式下没有GDI位图
 		
         ICONINFO ii={0};
         ::GetIconInfo(hIcon,&ii);
@@ -696,6 +720,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawBitmap(LPCRECT pRcDest,IBitmap *pBitmap,int xSrc,int ySrc,BYTE byAlpha/*=0xFF*/ )
     {
+        FlushText();
         SBitmap_Skia *pBmp = (SBitmap_Skia*)pBitmap;
         const SkBitmap & bmp=pBmp->GetSkBitmap();
 
@@ -720,6 +745,7 @@ namespace SOUI
     
     HRESULT SRenderTarget_Skia::AlphaBlend( LPCRECT pRcDest,IRenderTarget *pRTSrc,LPCRECT pRcSrc,BYTE byAlpha )
     {
+        FlushText();
         IBitmap *pBmp=(IBitmap*) pRTSrc->GetCurrentObject(OT_BITMAP);
         if(!pBmp) return S_FALSE;
         RECT rcSrc = *pRcSrc;
@@ -738,6 +764,19 @@ namespace SOUI
     }
 
     HRESULT SRenderTarget_Skia::DrawBitmapEx( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha/*=0xFF*/ )
+    {
+        FlushText();
+        if(LOWORD(expendMode) == EM_TILE && pRcSrc && RectWid(pRcSrc)>0 && RectHei(pRcSrc)>0
+            && CanUsePatchCache(pBitmap,pRcDest))
+        {
+            int nTiles = ((RectWid(pRcDest)+RectWid(pRcSrc)-1)/RectWid(pRcSrc)) * ((RectHei(pRcDest)+RectHei(pRcSrc)-1)/RectHei(pRcSrc));
+            if(nTiles >= 4)
+                return DrawPatchCache(pRcDest,pBitmap,pRcSrc,NULL,expendMode,byAlpha);
+        }
+        return _DrawBitmapEx(pRcDest,pBitmap,pRcSrc,expendMode,byAlpha);
+    }
+
+    HRESULT SRenderTarget_Skia::_DrawBitmapEx( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha )
     {
         UINT expendModeLow = LOWORD(expendMode);
 
@@ -788,6 +827,55 @@ namespace SOUI
 
 
     HRESULT SRenderTarget_Skia::DrawBitmap9Patch( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha/*=0xFF*/ )
+    {
+        FlushText();
+        if(CanUsePatchCache(pBitmap,pRcDest))
+            return DrawPatchCache(pRcDest,pBitmap,pRcSrc,pRcSourMargin,expendMode,byAlpha);
+        return _DrawBitmap9Patch(pRcDest,pBitmap,pRcSrc,pRcSourMargin,expendMode,byAlpha);
+    }
+
+    bool SRenderTarget_Skia::CanUsePatchCache(IBitmap *pBitmap,LPCRECT pRcDest) const
+    {
+        if(!m_bPatchCache || !pBitmap) return false;
+        if(((SBitmap_Skia*)pBitmap)->IsSurface()) return false;
+        //分块绘制和整体绘制结果一致的前提: 分块互不重叠, 混合模式为SrcOver, 没有变换及蒙板
+        if(m_xferMode != kSrcOver_Mode || m_paint.getMaskFilter()) return false;
+        if(!m_SkCanvas->getTotalMatrix().isIdentity()) return false;
+        int nWid = RectWid(pRcDest), nHei = RectHei(pRcDest);
+        return nWid > 0 && nHei > 0 && nWid*nHei <= SBitmap_Skia::MAX_PATCH_PIXELS;
+    }
+
+    HRESULT SRenderTarget_Skia::DrawPatchCache(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha)
+    {
+        SBitmap_Skia *pBmp = (SBitmap_Skia*)pBitmap;
+        SBitmap_Skia::PATCHKEY key;
+        memset(&key,0,sizeof(key));
+        key.rcSrc = *pRcSrc;
+        if(pRcSourMargin) key.rcMargin = *pRcSourMargin;
+        key.szDest.cx = RectWid(pRcDest);
+        key.szDest.cy = RectHei(pRcDest);
+        key.expendMode = expendMode;
+
+        SAutoRefPtr<IBitmap> pPatch;
+        if(!pBmp->GetPatchCache(key,&pPatch))
+        {//在透明位图上按原方式合成一次
+            SAutoRefPtr<IRenderTarget> pRT;
+            m_pRenderFactory->CreateRenderTarget(&pRT,key.szDest.cx,key.szDest.cy);
+            SRenderTarget_Skia *pRTSkia = (SRenderTarget_Skia*)(IRenderTarget*)pRT;
+            RECT rcDest = {0,0,key.szDest.cx,key.szDest.cy};
+            HRESULT hr;
+            if(!pRcSourMargin)
+                hr = pRTSkia->_DrawBitmapEx(&rcDest,pBitmap,pRcSrc,expendMode,0xFF);
+            else
+                hr = pRTSkia->_DrawBitmap9Patch(&rcDest,pBitmap,pRcSrc,pRcSourMargin,expendMode,0xFF);
+            if(hr != S_OK) return hr;
+            pPatch = (IBitmap*)pRT->GetCurrentObject(OT_BITMAP);
+            pBmp->SetPatchCache(key,pPatch);
+        }
+        return DrawBitmap(pRcDest,pPatch,0,0,byAlpha);
+    }
+
+    HRESULT SRenderTarget_Skia::_DrawBitmap9Patch( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha )
     {
         int xDest[4] = {pRcDest->left,pRcDest->left+pRcSourMargin->left,pRcDest->right-pRcSourMargin->right,pRcDest->right};
         int xSrc[4] = {pRcSrc->left,pRcSrc->left+pRcSourMargin->left,pRcSrc->right-pRcSourMargin->right,pRcSrc->right};
@@ -853,7 +941,7 @@ namespace SOUI
                 if(xSrc[x] == xSrc[x+1]) continue;
                 RECT rcSrc = {xSrc[x],ySrc[y],xSrc[x+1],ySrc[y+1]};
                 RECT rcDest ={xDest[x],yDest[y],xDest[x+1],yDest[y+1]};
-                DrawBitmapEx(&rcDest,pBitmap,&rcSrc,mode[y][x],byAlpha);
+                _DrawBitmapEx(&rcDest,pBitmap,&rcSrc,mode[y][x],byAlpha);
             }
         }
         
@@ -866,6 +954,7 @@ namespace SOUI
 		switch(uType)
 		{
 		case OT_BITMAP: 
+			FlushText();//位图可能被外部直接读取
 			pRet=m_curBmp;
 			break;
 		case OT_PEN:
@@ -904,8 +993,10 @@ namespace SOUI
         switch(pObj->ObjectType())
         {
         case OT_BITMAP: 
+            FlushText();
             pRet=m_curBmp;
             m_curBmp=(SBitmap_Skia*)pObj;
+            m_curBmp->MarkSurface();
             //重新生成clip
             SASSERT(m_SkCanvas);
             delete m_SkCanvas;
@@ -965,9 +1056,20 @@ namespace SOUI
 
     HDC SRenderTarget_Skia::GetDC( UINT uFlag )
     {
+        FlushText();
         if(m_hGetDC) return m_hGetDC;
         
         HBITMAP bmp=m_curBmp->GetGdiBitmap();//bmp可能为NULL
+        if(!bmp && static_cast<SRenderFactory_Skia*>((IRenderFactory*)m_pRenderFactory)->IsHeadless())
+        {//无头模式的位图没有GDI对象, 复制到临时的DIB中, 调用者不需要区分
+            const SkBitmap & skBmp = m_curBmp->GetSkBitmap();
+            void * pBits = NULL;
+            m_hGetDCBmp = SBitmap_Skia::CreateGDIBitmap(skBmp.width(),skBmp.height(),&pBits);
+            if(!m_hGetDCBmp) return NULL;
+            for(int y=0;y<skBmp.height();y++)
+                memcpy((BYTE*)pBits+y*skBmp.width()*4,skBmp.getAddr32(0,y),skBmp.width()*4);
+            bmp = m_hGetDCBmp;
+        }
         HDC hdc_desk = ::GetDC(NULL);
         m_hGetDC = CreateCompatibleDC(hdc_desk);
         ::ReleaseDC(NULL,hdc_desk);
@@ -1039,11 +1141,26 @@ namespace SOUI
             DeleteDC(hdc);
             m_hGetDC = 0;
             m_uGetDCFlag =0;
+            if(m_hGetDCBmp)
+            {//把GDI绘制的结果复制回无头模式的位图
+                const SkBitmap & skBmp = m_curBmp->GetSkBitmap();
+                DIBSECTION ds;
+                if(::GetObject(m_hGetDCBmp,sizeof(ds),&ds) == sizeof(ds))
+                {
+                    ::GdiFlush();
+                    for(int y=0;y<skBmp.height();y++)
+                        memcpy(skBmp.getAddr32(0,y),(BYTE*)ds.dsBm.bmBits+y*skBmp.width()*4,skBmp.width()*4);
+                    skBmp.notifyPixelsChanged();
+                }
+                DeleteObject(m_hGetDCBmp);
+                m_hGetDCBmp = NULL;
+            }
         }
     }
     
     HRESULT SRenderTarget_Skia::GradientFillEx( LPCRECT pRect,const POINT* pts,COLORREF *colors,float *pos,int nCount,BYTE byAlpha/*=0xFF*/ )
     {
+        FlushText();
         SkRect skrc = toSkRect(pRect);
         skrc.offset(m_ptOrg);
         SkPoint *skPts = new SkPoint[nCount];
@@ -1073,6 +1190,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::GradientFill2(LPCRECT pRect,GradientType type,COLORREF crStart,COLORREF crCenter,COLORREF crEnd,float fLinearAngle,float fCenterX,float fCenterY,int nRadius,BYTE byAlpha/*=0xff*/)
 	{
+		FlushText();
 		SkRect skrc = toSkRect(pRect);
 		skrc.offset(m_ptOrg);
 
@@ -1165,6 +1283,7 @@ namespace SOUI
     
     HRESULT SRenderTarget_Skia::GradientFill( LPCRECT pRect,BOOL bVert,COLORREF crBegin,COLORREF crEnd,BYTE byAlpha/*=0xFF*/ )
     {
+        FlushText();
         SkRect skrc = toSkRect(pRect);
         skrc.offset(m_ptOrg);
 
@@ -1196,6 +1315,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::FillSolidRect( LPCRECT pRect,COLORREF cr )
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setStyle(SkPaint::kFill_Style);
         paint.setColor(SColor(cr).toARGB());
@@ -1208,6 +1328,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::ClearRect( LPCRECT pRect,COLORREF cr )
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setStyle(SkPaint::kFill_Style);
         paint.setColor(SColor(cr).toARGB());
@@ -1221,6 +1342,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::InvertRect(LPCRECT pRect)
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setStyle(SkPaint::kFill_Style);
         paint.setXfermode(new ProcXfermode(ProcXfermode::Rop2_Invert));
@@ -1232,6 +1354,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawEllipse( LPCRECT pRect )
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setColor(SColor(m_curPen->GetColor()).toARGB());
         SLineDashEffect skDash(m_curPen->GetStyle());
@@ -1253,6 +1376,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::FillEllipse( LPCRECT pRect )
     {
+        FlushText();
         SkPaint paint=m_paint;
         if(m_curBrush->IsBitmap())
         {
@@ -1273,6 +1397,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::FillSolidEllipse(LPCRECT pRect,COLORREF cr)
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setFilterBitmap(false);
         paint.setColor(SColor(cr).toARGB());
@@ -1286,6 +1411,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawArc( LPCRECT pRect,float startAngle,float sweepAngle,bool useCenter )
     {
+        FlushText();
         SkPaint paint=m_paint;
         paint.setColor(SColor(m_curPen->GetColor()).toARGB());
         SLineDashEffect skDash(m_curPen->GetStyle());
@@ -1309,6 +1435,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::FillArc( LPCRECT pRect,float startAngle,float sweepAngle )
     {
+        FlushText();
         SkPaint paint=m_paint;
         if(m_curBrush->IsBitmap())
         {
@@ -1328,6 +1455,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::SetTransform(const float matrix[9], float oldMatrix[9])
     {
+        FlushText();
         SASSERT(matrix);
         if(oldMatrix) GetTransform(oldMatrix);
         SkMatrix m;
@@ -1360,6 +1488,7 @@ namespace SOUI
 
 	COLORREF SRenderTarget_Skia::GetPixel( int x, int y )
 	{
+		FlushText();
 		if(!m_curBmp) return CR_INVALID;
 		const COLORREF *pBits = (const COLORREF*)m_curBmp->GetPixelBits();
 		POINT pt;
@@ -1374,6 +1503,7 @@ namespace SOUI
 
 	COLORREF SRenderTarget_Skia::SetPixel( int x, int y, COLORREF cr )
 	{
+		FlushText();
 		if(!m_curBmp) return CR_INVALID;
 		COLORREF *pBits = (COLORREF*)m_curBmp->LockPixelBits();
 		POINT pt;
@@ -1395,6 +1525,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::PushClipPath(const IPath * path, UINT mode, bool doAntiAlias /*= false*/)
 	{
+		FlushText();
 		const SPath_Skia * path2 = (const SPath_Skia *)path;
 		m_SkCanvas->clipPath(path2->m_skPath,SRegion_Skia::RGNMODE2SkRgnOP(mode),doAntiAlias);
 		return S_OK;
@@ -1402,6 +1533,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::DrawPath(const IPath * path, IPathEffect * pathEffect)
 	{
+		FlushText();
 		const SPath_Skia * path2 = (const SPath_Skia *)path;
 
 		SkPaint paint=m_paint;
@@ -1435,6 +1567,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::FillPath(const IPath * path)
 	{
+		FlushText();
 		const SPath_Skia * path2 = (const SPath_Skia *)path;
 
 		SkPaint paint=m_paint;
@@ -1459,6 +1592,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::PushLayer(const RECT * pRect,BYTE byAlpha)
 	{
+		FlushText();
 		int nLayerId = -1;
 		SkRect skBound = toSkRect(pRect);
 		if(byAlpha==0xFF)
@@ -1471,6 +1605,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::PopLayer()
 	{
+		FlushText();
 		if(m_lstLayerId.IsEmpty())
 			return E_INVALIDARG;
 		int nLayerID = m_lstLayerId.RemoveTail();
@@ -1557,13 +1692,14 @@ namespace SOUI
     //////////////////////////////////////////////////////////////////////////
 	// SBitmap_Skia
     static int s_cBmp = 0;
-    SBitmap_Skia::SBitmap_Skia( IRenderFactory *pRenderFac ) :TSkiaRenderObjImpl<IBitmap>(pRenderFac),m_hBmp(0)
+    SBitmap_Skia::SBitmap_Skia( IRenderFactory *pRenderFac ) :TSkiaRenderObjImpl<IBitmap>(pRenderFac),m_hBmp(0),m_dwPatchStamp(0),m_bSurface(false),m_dwVersion(1)
     {
 //         STRACE(L"bitmap new; objects = %d",++s_cBmp);
     }
 
     SBitmap_Skia::~SBitmap_Skia()
     {
+        ClearPatchCache();
         m_bitmap.reset();
         if(m_hBmp) DeleteObject(m_hBmp);
 //         STRACE(L"bitmap delete objects = %d",--s_cBmp);
@@ -1588,15 +1724,30 @@ namespace SOUI
         return hBmp;
     }
 
+    void * SBitmap_Skia::AllocPixels(int nWid,int nHei)
+    {
+        ClearPatchCache();
+        m_bitmap.reset();
+        if(m_hBmp) DeleteObject(m_hBmp);
+        m_hBmp = NULL;
+        m_bitmap.setInfo(SkImageInfo::Make(nWid,nHei,kN32_SkColorType,kPremul_SkAlphaType));
+
+        if(static_cast<SRenderFactory_Skia*>(GetRenderFactory())->IsHeadless())
+        {//像素由skia管理
+            if(!m_bitmap.tryAllocPixels()) return NULL;
+            return m_bitmap.getPixels();
+        }
+        void * pBits=NULL;
+        m_hBmp = CreateGDIBitmap(nWid,nHei,&pBits);
+        if(!m_hBmp) return NULL;
+        m_bitmap.setPixels(pBits);
+        return pBits;
+    }
+
 	HRESULT SBitmap_Skia::Init( int nWid,int nHei ,const LPVOID pBits/*=NULL*/)
 	{
-		m_bitmap.reset();
-		m_bitmap.setInfo(SkImageInfo::Make(nWid,nHei,kN32_SkColorType,kPremul_SkAlphaType));
-        if(m_hBmp) DeleteObject(m_hBmp);
-    		
-		LPVOID pBmpBits=NULL;
-		m_hBmp=CreateGDIBitmap(nWid,nHei,&pBmpBits);
-		if(!m_hBmp) return E_OUTOFMEMORY;
+		LPVOID pBmpBits=AllocPixels(nWid,nHei);
+		if(!pBmpBits) return E_OUTOFMEMORY;
         if(pBits)
         {
             memcpy(pBmpBits,pBits,nWid*nHei*4);
@@ -1604,7 +1755,6 @@ namespace SOUI
         {
             memset(pBmpBits,0,nWid*nHei*4);
         }
-		m_bitmap.setPixels(pBmpBits);
 		return S_OK;
 	}
 
@@ -1613,14 +1763,7 @@ namespace SOUI
         UINT uWid=0,uHei =0;
         pFrame->GetSize(&uWid,&uHei);
 
-        if(m_hBmp) DeleteObject(m_hBmp);
-        m_bitmap.reset();
-        m_bitmap.setInfo(SkImageInfo::Make(uWid, uHei,kN32_SkColorType,kPremul_SkAlphaType));
-        void * pBits=NULL;
-        m_hBmp = CreateGDIBitmap(uWid,uHei,&pBits);
-
-        if(!m_hBmp) return E_OUTOFMEMORY;
-        m_bitmap.setPixels(pBits);
+        if(!AllocPixels(uWid,uHei)) return E_OUTOFMEMORY;
 
         const int stride = m_bitmap.rowBytes();
         pFrame->CopyPixels(NULL, stride, stride * uHei,
@@ -1650,18 +1793,16 @@ namespace SOUI
         UINT uWid=0,uHei =0;
         pFrame->GetSize(&uWid,&uHei);
 
-        if(m_hBmp) DeleteObject(m_hBmp);
-        m_bitmap.reset();
-        m_bitmap.setInfo(SkImageInfo::Make(uWid, uHei,kN32_SkColorType,kPremul_SkAlphaType));
-        void * pBits=NULL;
-        m_hBmp = CreateGDIBitmap(uWid,uHei,&pBits);
-        
-        if(!m_hBmp) return E_OUTOFMEMORY;
-        m_bitmap.setPixels(pBits);
+        void * pBits = AllocPixels(uWid,uHei);
+        if(!pBits) return E_OUTOFMEMORY;
         
         const int stride = m_bitmap.rowBytes();
-        pFrame->CopyPixels(NULL, stride, stride * uHei,
-            reinterpret_cast<BYTE*>(m_bitmap.getPixels()));
+        //优先直接解码到位图中, 避免解码器保留一份像素再复制
+        if(!imgDecoder->DecodeInto(0, stride, stride * uHei, reinterpret_cast<BYTE*>(pBits)))
+        {
+            pFrame->CopyPixels(NULL, stride, stride * uHei,
+                reinterpret_cast<BYTE*>(m_bitmap.getPixels()));
+        }
         return S_OK;
     }
 
@@ -1683,11 +1824,19 @@ namespace SOUI
 
     LPVOID SBitmap_Skia::LockPixelBits()
     {
+        ClearPatchCache();
         return m_bitmap.getPixels();
     }
 
     void SBitmap_Skia::UnlockPixelBits( LPVOID pBuf)
     {
+		ClearPatchCache();
+		if(!m_hBmp)
+		{//无头模式, 像素由skia管理
+			if(pBuf != m_bitmap.getPixels())
+				memcpy(m_bitmap.getPixels(),pBuf,Width()*Height()*4);
+			return;
+		}
 		BITMAP bm;
 		GetObject(m_hBmp,sizeof(bm),&bm);
 		memcpy(bm.bmBits,pBuf,Width()*Height()*4);
@@ -1699,6 +1848,70 @@ namespace SOUI
         return m_bitmap.getPixels();
     }
 
+    static SCriticalSection s_csPatchCache; //保护所有位图的合成结果缓存
+    static int s_nPatchCacheBytes = 0;      //所有位图的合成结果占用的字节数
+
+    static int PatchBytes(const SBitmap_Skia::PATCHKEY & key)
+    {
+        return key.szDest.cx*key.szDest.cy*4;
+    }
+
+    BOOL SBitmap_Skia::GetPatchCache(const PATCHKEY & key,IBitmap **ppBmp)
+    {
+        SAutoLock lock(s_csPatchCache);
+        for(int i=0;i<PATCH_CACHE_SIZE;i++)
+        {
+            if(m_patchCache[i].pBmp && memcmp(&m_patchCache[i].key,&key,sizeof(key))==0)
+            {
+                m_patchCache[i].dwStamp = ++m_dwPatchStamp;
+                *ppBmp = m_patchCache[i].pBmp;
+                (*ppBmp)->AddRef();
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    void SBitmap_Skia::SetPatchCache(const PATCHKEY & key,IBitmap *pBmp)
+    {
+        SAutoLock lock(s_csPatchCache);
+        int iSlot = 0;
+        for(int i=0;i<PATCH_CACHE_SIZE;i++)
+        {
+            if(!m_patchCache[i].pBmp || memcmp(&m_patchCache[i].key,&key,sizeof(key))==0)
+            {//空位或者其它线程已经缓存了相同的结果
+                iSlot = i;
+                break;
+            }
+            if(m_patchCache[i].dwStamp < m_patchCache[iSlot].dwStamp)
+                iSlot = i;
+        }
+        _FreePatchSlot(m_patchCache[iSlot]);
+        if(s_nPatchCacheBytes + PatchBytes(key) > PATCH_CACHE_BUDGET)
+            return;
+        s_nPatchCacheBytes += PatchBytes(key);
+        m_patchCache[iSlot].key = key;
+        m_patchCache[iSlot].pBmp = pBmp;
+        m_patchCache[iSlot].dwStamp = ++m_dwPatchStamp;
+    }
+
+    void SBitmap_Skia::ClearPatchCache()
+    {
+        SAutoLock lock(s_csPatchCache);
+        if(++m_dwVersion == 0) m_dwVersion = 1;
+        for(int i=0;i<PATCH_CACHE_SIZE;i++)
+        {
+            _FreePatchSlot(m_patchCache[i]);
+        }
+    }
+
+    void SBitmap_Skia::_FreePatchSlot(PATCHCACHE & slot)
+    {
+        if(!slot.pBmp) return;
+        s_nPatchCacheBytes -= PatchBytes(slot.key);
+        slot.pBmp = NULL;
+    }
+
     //////////////////////////////////////////////////////////////////////////
     static int s_cRgn =0;
 	SRegion_Skia::SRegion_Skia( IRenderFactory *pRenderFac )
@@ -1916,6 +2129,7 @@ namespace SOUI
 		if(plf->lfWeight == FW_BOLD) style |= SkTypeface::kBold;
 		m_skFont->unref();
 		m_skFont=SkTypeface::CreateFromName(strFace,(SkTypeface::Style)style);
+		m_layoutCache.clear();
 
 		return TRUE;
 	}
@@ -1927,6 +2141,12 @@ namespace SOUI
             *ppRenderFactory = new SRenderFactory_Skia;
             return TRUE;
         }
+
+        BOOL SCreateHeadlessInstance( IObjRef ** ppRenderFactory )
+        {
+            *ppRenderFactory = new SRenderFactory_Skia(TRUE);
+            return TRUE;
+        }
     }
 
 
@@ -11,7 +11,9 @@
 #include <string/strcpcvt.h>
 #include <interface/SRender-i.h>
 #include <souicoll.h>
+#include <helper/SCriticalSection.h>
 #include <Shlwapi.h>
+#include "drawtext-skia.h"
 
 namespace SOUI
 {
@@ -20,7 +22,8 @@ namespace SOUI
 	class SRenderFactory_Skia : public TObjRefImpl<IRenderFactory>
 	{
 	public:
-		SRenderFactory_Skia();
+		//bHeadless: 位图只分配内存, 不创建GDI位图, 用于没有显示环境的离屏绘制
+		SRenderFactory_Skia(BOOL bHeadless = FALSE);
         
 		~SRenderFactory_Skia();
         
@@ -41,9 +44,11 @@ namespace SOUI
 		virtual HRESULT CreateBlurMaskFilter(float radius, IMaskFilter::SkBlurStyle style,IMaskFilter::SkBlurFlags flag,IMaskFilter ** ppMaskFilter);
 		virtual HRESULT CreateEmbossMaskFilter(float direction[3], float ambient, float specular, float blurRadius,IMaskFilter ** ppMaskFilter);
 
+		BOOL IsHeadless() const {return m_bHeadless;}
 
 	protected:
         SAutoRefPtr<IImgDecoderFactory> m_imgDecoderFactory;
+		BOOL m_bHeadless;
 	};
 
     
@@ -126,6 +131,7 @@ namespace SOUI
 
         SkTypeface *GetFont()const {return m_skFont;}
 		SkMaskFilter *GetBlurFilter() {return m_blurFilter;}
+		SkTextLayoutCache & GetLayoutCache() {return m_layoutCache;}
 
 		virtual void OnInitFinished(pugi::xml_node xmlNode); 
 		SOUI_ATTRS_BEGIN()
@@ -143,6 +149,7 @@ namespace SOUI
 		SkBlurStyle m_blurStyle;
 		SkScalar	m_blurRadius;
 		SkMaskFilter *m_blurFilter;
+		SkTextLayoutCache m_layoutCache;	//使用该字体的文本排版缓存
 	};
 
 	class SBrush_Skia : public TSkiaRenderObjImpl<IBrush>
@@ -202,16 +209,60 @@ namespace SOUI
         virtual LPVOID  LockPixelBits();
         virtual void    UnlockPixelBits(LPVOID pBuf);
         virtual const LPVOID  GetPixelBits() const;
+        virtual DWORD GetContentVersion() const {return m_bSurface?0:m_dwVersion;}
         
 		const SkBitmap & GetSkBitmap() const{return m_bitmap;}
 		HBITMAP  GetGdiBitmap(){return m_hBmp;}
+
+	    //创建32位DIB, 像素地址由ppBits返回
+	    static HBITMAP CreateGDIBitmap(int nWid,int nHei,void ** ppBits);
+
+        enum{
+            PATCH_CACHE_SIZE = 8,               //每个位图缓存的合成结果数量
+            MAX_PATCH_PIXELS = 512*512,         //超过该面积的目标不缓存
+            PATCH_CACHE_BUDGET = 16*1024*1024,  //所有位图的合成结果占用的总字节数上限
+        };
+
+        //九宫格及平铺绘制的合成参数
+        struct PATCHKEY
+        {
+            RECT rcSrc;
+            RECT rcMargin;
+            SIZE szDest;
+            UINT expendMode;
+        };
+
+        //查询合成结果缓存, 找到时返回TRUE, *ppBmp增加了引用计数
+        //皮肤位图在多个界面线程间共享, 缓存的读写由一个全局锁保护
+        BOOL GetPatchCache(const PATCHKEY & key,IBitmap **ppBmp);
+        //超出全局预算时不缓存
+        void SetPatchCache(const PATCHKEY & key,IBitmap *pBmp);
+        //位图内容改变后合成结果失效, 同时更新内容版本号
+        void ClearPatchCache();
+        //位图被选入渲染目标后内容随时可能改变, 不再缓存
+        void MarkSurface(){m_bSurface=true;ClearPatchCache();}
+        bool IsSurface() const{return m_bSurface;}
 	protected:
-	    HBITMAP CreateGDIBitmap(int nWid,int nHei,void ** ppBits);
+	    //重新分配像素, 无头模式下不创建GDI位图. 返回像素地址, 失败返回NULL
+	    void * AllocPixels(int nWid,int nHei);
 	    
         HRESULT ImgFromDecoder(IImgX *imgDecoder);
 
 		SkBitmap    m_bitmap;   //skia 管理的BITMAP
-		HBITMAP     m_hBmp;     //标准的32位位图，和m_bitmap共享内存
+		HBITMAP     m_hBmp;     //标准的32位位图，和m_bitmap共享内存. 无头模式下为NULL
+
+        struct PATCHCACHE
+        {
+            PATCHKEY key;
+            DWORD    dwStamp;
+            SAutoRefPtr<IBitmap> pBmp;
+        };
+        void _FreePatchSlot(PATCHCACHE & slot);
+
+        PATCHCACHE  m_patchCache[PATCH_CACHE_SIZE];
+        DWORD       m_dwPatchStamp;
+        bool        m_bSurface;
+        DWORD       m_dwVersion;    //内容版本号, 不为0
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -511,7 +562,10 @@ namespace SOUI
 
 		virtual BOOL SetAntiAlias(BOOL bAntiAlign);
     public:
-        SkCanvas *GetCanvas(){return m_SkCanvas;}
+        SkCanvas *GetCanvas(){FlushText();return m_SkCanvas;}
+
+		//文本合并绘制的统计信息
+		const SkTextBatch & GetTextBatch() const {return m_textBatch;}
 
 		virtual SStringW GetAttribute(const SStringW & strAttr) const
 		{
@@ -522,11 +576,22 @@ namespace SOUI
 
 		SOUI_ATTRS_BEGIN()
 			ATTR_BOOL(L"antiAlias",m_bAntiAlias,FALSE)
+			ATTR_BOOL(L"patchCache",m_bPatchCache,FALSE)
 		SOUI_ATTRS_END()
 	
 	protected:
 		bool SetPaintXferMode(SkPaint & paint,int nRopMode);
 
+		HRESULT _DrawBitmapEx(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha);
+		HRESULT _DrawBitmap9Patch(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha);
+
+		//九宫格及平铺绘制先合成到和目标一样大的位图, 以后直接绘制合成结果. pRcSourMargin为NULL表示平铺
+		bool CanUsePatchCache(IBitmap *pBitmap,LPCRECT pRcDest) const;
+		HRESULT DrawPatchCache(LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha);
+
+		//画布状态改变或者其它绘制前提交批中的文本, 保证绘制顺序
+		void FlushText(){m_textBatch.flush();}
+
     protected:
 		SkCanvas *m_SkCanvas;
         SColor            m_curColor;
@@ -548,15 +613,21 @@ namespace SOUI
 
         HDC m_hGetDC;
         UINT m_uGetDCFlag;
+        HBITMAP m_hGetDCBmp;    //无头模式下GetDC临时创建的DIB, ReleaseDC时把像素复制回位图
 		
 		bool			m_bAntiAlias;
 		SList<int>		m_lstLayerId;	//list to save layer ids
 		int				m_xferMode;
+		SkTextBatch		m_textBatch;	//DrawText合并绘制
+		bool			m_bPatchCache;	//九宫格及平铺绘制使用合成结果缓存
 	};
 	
 	namespace RENDER_SKIA
     {
         SOUI_COM_C BOOL SOUI_COM_API SCreateInstance(IObjRef ** ppRenderFactory);
+        //创建位图不使用GDI对象的渲染工厂, 用于没有显示环境的离屏绘制
+        //注意: 字体及GetDC(临时复制到DIB)等仍然调用Win32 API, 只能在Windows上编译运行
+        SOUI_COM_C BOOL SOUI_COM_API SCreateHeadlessInstance(IObjRef ** ppRenderFactory);
     }
 }
 
@@ -137,9 +137,7 @@ BOOL SImagePlayer::_PlayFile( LPCTSTR pszFileName, BOOL bGif )
             pGifSkin->Release();
             return FALSE;
         }
-        SkinKey skey;
-        skey.scale = GetScale();
-        skey.strName = key;
+        SkinKey skey(key,GetScale());
         pBuiltinSkinPool->AddKeyObject(skey,pGifSkin);//skinskinpool
         m_aniSkin = pGifSkin;
     }
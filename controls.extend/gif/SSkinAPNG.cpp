@@ -3,23 +3,144 @@
 #include <helper/SplitString.h>
 #include <interface/SImgDecoder-i.h>
 #include <interface/SRender-i.h>
+#include <helper/SCriticalSection.h>
 
 
 namespace SOUI
 {
+	//ÿݻź֡λͼֽޣŵƤÿλ֡ʱ
+	static const size_t KMaxScaledCacheBytes = 8*1024*1024;
+
+	//APNGѹݣͬԴƤÿƤʹԼĽ֡λͼ
+	class SApngSrcData : public TObjRefImpl<IObjRef>
+	{
+	public:
+		SApngSrcData(const SStringT & strKey,LPBYTE pBuf,size_t szBuf)
+			:m_strKey(strKey),m_pBuf(pBuf),m_szBuf(szBuf),m_szScaledBytes(0)
+		{
+		}
+
+		~SApngSrcData()
+		{
+			SPOSITION pos = m_mapScaled.GetStartPosition();
+			while(pos)
+			{
+				delete m_mapScaled.GetNextValue(pos);
+			}
+			delete []m_pBuf;
+		}
+
+		//һź֡λͼصλͼҪͷ
+		IBitmap * GetScaledFrame(int nScale,int iFrame)
+		{
+			SAutoLock lock(m_csScaled);
+			SMap<int,SCALEDFRAMES*>::CPair *p = m_mapScaled.Lookup(nScale);
+			if(!p || iFrame >= (int)p->m_value->GetCount()) return NULL;
+			IBitmap *pBmp = p->m_value->GetAt(iFrame);
+			if(pBmp) pBmp->AddRef();
+			return pBmp;
+		}
+
+		//ź֡λͼֽʱ
+		BOOL SetScaledFrame(int nScale,int iFrame,int nFrames,IBitmap *pBmp)
+		{
+			size_t szBytes = (size_t)pBmp->Width()*pBmp->Height()*4;
+			SAutoLock lock(m_csScaled);
+			if(m_szScaledBytes + szBytes > KMaxScaledCacheBytes) return FALSE;
+			SMap<int,SCALEDFRAMES*>::CPair *p = m_mapScaled.Lookup(nScale);
+			SCALEDFRAMES *pFrames = p?p->m_value:NULL;
+			if(!pFrames)
+			{
+				pFrames = new SCALEDFRAMES;
+				pFrames->SetCount(nFrames);
+				m_mapScaled[nScale] = pFrames;
+			}
+			if(iFrame >= (int)pFrames->GetCount() || pFrames->GetAt(iFrame)) return FALSE;
+			pFrames->GetAt(iFrame) = pBmp;
+			m_szScaledBytes += szBytes;
+			return TRUE;
+		}
+
+		//üѾ(ͷ)ʱFALSE
+		BOOL TryAddRef()
+		{
+			for(;;)
+			{
+				LONG nRef = m_cRef;
+				if(nRef == 0) return FALSE;
+				if(InterlockedCompareExchange(&m_cRef,nRef+1,nRef) == nRef) return TRUE;
+			}
+		}
+
+		//̳߳ͷһ
+		virtual void OnFinalRelease();
+
+		SStringT m_strKey;
+		LPBYTE   m_pBuf;
+		size_t   m_szBuf;
+
+	protected:
+		typedef SArray<SAutoRefPtr<IBitmap> > SCALEDFRAMES;
+		SMap<int,SCALEDFRAMES*> m_mapScaled;   //ű->ź֡λͼλͼٸд
+		size_t                  m_szScaledBytes;
+		SCriticalSection        m_csScaled;
+	};
+
+	//ãͷʱӱƳ
+	static SMap<SStringT,SApngSrcData*> s_mapSrcData;
+	static SCriticalSection s_csSrcData;
+
+	void SApngSrcData::OnFinalRelease()
+	{
+		if(!m_strKey.IsEmpty())
+		{
+			SAutoLock lock(s_csSrcData);
+			SMap<SStringT,SApngSrcData*>::CPair *p = s_mapSrcData.Lookup(m_strKey);
+			if(p && p->m_value == this) s_mapSrcData.RemoveKey(m_strKey);
+		}
+		delete this;
+	}
+
+	SApngSrcData * SSkinAPNG::_AcquireSrcData(const SStringT & strSrcKey)
+	{
+		SAutoLock lock(s_csSrcData);
+		SMap<SStringT,SApngSrcData*>::CPair *p = s_mapSrcData.Lookup(strSrcKey);
+		if(p && p->m_value->TryAddRef()) return p->m_value;
+		return NULL;
+	}
+
+	SApngSrcData * SSkinAPNG::_CreateSrcData(const SStringT & strSrcKey,LPBYTE pBuf,size_t szBuf)
+	{
+		SApngSrcData *pSrcData = new SApngSrcData(strSrcKey,pBuf,szBuf);
+		if(!strSrcKey.IsEmpty())
+		{
+			SAutoLock lock(s_csSrcData);
+			s_mapSrcData[strSrcKey] = pSrcData;
+		}
+		return pSrcData;
+	}
 
 	SSkinAPNG::~SSkinAPNG()
 	{
 		if(m_pFrames) delete [] m_pFrames;
 	}
 
-	SSkinAPNG::SSkinAPNG() :m_pFrames(NULL)
+	SSkinAPNG::SSkinAPNG() :m_pFrames(NULL),m_nScale(100),m_iFrameBmp(-1),m_bFrameBmpShared(FALSE)
 	{
 
 	}
 
     HRESULT SSkinAPNG::OnAttrSrc( const SStringW &strValue,BOOL bLoading )
     {
+        SStringT strKey = S_CW2T(strValue);
+        SAutoRefPtr<SApngSrcData> srcData;
+        srcData.Attach(_AcquireSrcData(strKey));
+        if(srcData)
+        {
+            _InitImgFrame(srcData);
+            return S_OK;
+        }
+
         SStringTList strLst;
         size_t nSegs=ParseResID(S_CW2T(strValue),strLst);
         LPBYTE pBuf=NULL;
@@ -44,8 +165,8 @@ namespace SOUI
         }
         if(pBuf)
         {
-            LoadFromMemory(pBuf,szBuf);
-            delete []pBuf;
+            srcData.Attach(_CreateSrcData(strKey,pBuf,szBuf));
+            _InitImgFrame(srcData);
         }
         return S_OK;
     }
@@ -54,46 +175,135 @@ namespace SOUI
 
 int SSkinAPNG::LoadFromFile( LPCTSTR pszFileName )
 {
-    CAutoRefPtr<IImgX> imgX;
-    GETRENDERFACTORY->GetImgDecoderFactory()->CreateImgX(&imgX);
-    imgX->LoadFromFile(pszFileName);
-    return _InitImgFrame(imgX);
+    SStringT strKey = SStringT(_T("file:")) + pszFileName;
+    strKey.MakeLower();
+    SAutoRefPtr<SApngSrcData> srcData;
+    srcData.Attach(_AcquireSrcData(strKey));
+    if(srcData) return _InitImgFrame(srcData);
+
+    FILE *f = _tfopen(pszFileName,_T("rb"));
+    if(!f) return _InitImgFrame(NULL);
+    fseek(f,0,SEEK_END);
+    long nLen = ftell(f);
+    fseek(f,0,SEEK_SET);
+    LPBYTE pBuf = NULL;
+    if(nLen>0)
+    {
+        pBuf = new BYTE[nLen];
+        if(fread(pBuf,1,nLen,f)!=(size_t)nLen)
+        {
+            delete []pBuf;
+            pBuf = NULL;
+        }
+    }
+    fclose(f);
+    if(!pBuf) return _InitImgFrame(NULL);
+    srcData.Attach(_CreateSrcData(strKey,pBuf,nLen));
+    return _InitImgFrame(srcData);
 }
 
 int SSkinAPNG::LoadFromMemory( LPVOID pBuf,size_t dwSize )
-{
-    CAutoRefPtr<IImgX> imgX;
-    GETRENDERFACTORY->GetImgDecoderFactory()->CreateImgX(&imgX);
-    imgX->LoadFromMemory(pBuf,dwSize);
-    return _InitImgFrame(imgX);
+{//ߵݲһݹźƤʹ
+    LPBYTE pCopy = new BYTE[dwSize];
+    memcpy(pCopy,pBuf,dwSize);
+    SAutoRefPtr<SApngSrcData> srcData;
+    srcData.Attach(_CreateSrcData(SStringT(),pCopy,dwSize));
+    return _InitImgFrame(srcData);
 }
 
-int SSkinAPNG::_InitImgFrame( IImgX *pImgX )
+int SSkinAPNG::_InitImgFrame( SApngSrcData *pSrcData )
 {
     if(m_pFrames) delete []m_pFrames;
     m_pFrames = NULL;
     m_nFrames =0;
     m_iFrame = 0;
-    if(!pImgX) return 0;
+    m_pFrameBmp = NULL;
+    m_iFrameBmp = -1;
+    m_bFrameBmpShared = FALSE;
+    m_pSrcBmp = NULL;
+    m_imgX = NULL;
+    m_srcData = pSrcData;
+    if(!pSrcData) return 0;
 
-    m_nFrames = pImgX->GetFrameCount();
+    //ÿƤжĽȣΪʲͬ֡½
+    GETRENDERFACTORY->GetImgDecoderFactory()->CreateImgX(&m_imgX);
+    if(!m_imgX->LoadFromSharedMemory(pSrcData,pSrcData->m_pBuf,pSrcData->m_szBuf))
+    {
+        m_imgX = NULL;
+        return 0;
+    }
+
+    m_nFrames = m_imgX->GetFrameCount();
     m_pFrames = new SAniFrame[m_nFrames];
     for(int i=0;i<m_nFrames;i++)
     {
-        GETRENDERFACTORY->CreateBitmap(&m_pFrames[i].pBmp);
-        m_pFrames[i].pBmp->Init(pImgX->GetFrame(i));
-        m_pFrames[i].nDelay=pImgX->GetFrame(i)->GetDelay();
+        m_pFrames[i].nDelay=m_imgX->GetFrame(i)->GetDelay();
     }
+    UINT uWid=0,uHei=0;
+    if(m_nFrames>0) m_imgX->GetFrame(0)->GetSize(&uWid,&uHei);
+    m_szFrame.cx = uWid;
+    m_szFrame.cy = uHei;
     return m_nFrames;
 }
 
+IBitmap * SSkinAPNG::_GetFrameBmp(int iFrame) const
+{
+    if(!m_imgX || iFrame<0 || iFrame>=m_nFrames) return NULL;
+    if(m_iFrameBmp == iFrame) return m_pFrameBmp;
+
+    IImgFrame *pFrame = m_imgX->GetFrame(iFrame);
+    UINT uWid=0,uHei=0;
+    pFrame->GetSize(&uWid,&uHei);
+    if(uWid == (UINT)m_szFrame.cx && uHei == (UINT)m_szFrame.cy)
+    {
+        if(m_pFrameBmp && !m_bFrameBmpShared && m_pFrameBmp->Width()==uWid && m_pFrameBmp->Height()==uHei)
+        {//ûʹʱõǰ֡λͼÿ֡·
+            LPBYTE pBits = (LPBYTE)m_pFrameBmp->LockPixelBits();
+            pFrame->CopyPixels(NULL,uWid*4,uWid*uHei*4,pBits);
+            m_pFrameBmp->UnlockPixelBits(pBits);
+        }else
+        {
+            m_pFrameBmp = NULL;
+            m_bFrameBmpShared = FALSE;
+            GETRENDERFACTORY->CreateBitmap(&m_pFrameBmp);
+            m_pFrameBmp->Init(pFrame);
+        }
+    }else
+    {//źƤͬһűƤŽÿһֻ֡һ
+        SAutoRefPtr<IBitmap> bmpScaled;
+        bmpScaled.Attach(m_srcData->GetScaledFrame(m_nScale,iFrame));
+        if(!bmpScaled)
+        {
+            if(!m_pSrcBmp || m_pSrcBmp->Width()!=uWid || m_pSrcBmp->Height()!=uHei)
+            {
+                m_pSrcBmp = NULL;
+                GETRENDERFACTORY->CreateBitmap(&m_pSrcBmp);
+                m_pSrcBmp->Init(uWid,uHei,NULL);
+            }
+            LPBYTE pBits = (LPBYTE)m_pSrcBmp->LockPixelBits();
+            BOOL bCopied = pBits && pFrame->CopyPixels(NULL,uWid*4,uWid*uHei*4,pBits);
+            m_pSrcBmp->UnlockPixelBits(pBits);
+            if(!bCopied) return NULL;
+            m_pSrcBmp->Scale(&bmpScaled, m_szFrame.cx, m_szFrame.cy, kHigh_FilterLevel);
+            if(!bmpScaled) return NULL;
+            m_srcData->SetScaledFrame(m_nScale,iFrame,m_nFrames,bmpScaled);
+        }
+        m_pFrameBmp = bmpScaled;
+        m_bFrameBmpShared = TRUE;
+    }
+    m_iFrameBmp = iFrame;
+    return m_pFrameBmp;
+}
+
 void SSkinAPNG::_DrawByIndex2(IRenderTarget *pRT, LPCRECT rcDraw, int dwState,BYTE byAlpha/*=0xFF*/) const
 {
+	IBitmap *pBmp = _GetFrameBmp(m_iFrame);
+	if(!pBmp) return;
 	CRect rcSrc(CPoint(0,0),GetSkinSize());
 	if(m_rcMargin.IsRectNull())
-		pRT->DrawBitmapEx(rcDraw,m_pFrames[m_iFrame].pBmp,rcSrc,GetExpandCode(),byAlpha);
+		pRT->DrawBitmapEx(rcDraw,pBmp,rcSrc,GetExpandCode(),byAlpha);
 	else
-		pRT->DrawBitmap9Patch(rcDraw,m_pFrames[m_iFrame].pBmp,rcSrc,m_rcMargin,GetExpandCode(),byAlpha);
+		pRT->DrawBitmap9Patch(rcDraw,pBmp,rcSrc,m_rcMargin,GetExpandCode(),byAlpha);
 }
 
 long SSkinAPNG::GetFrameDelay(int iFrame/*=-1*/) const
@@ -112,7 +322,7 @@ SIZE SSkinAPNG::GetSkinSize() const
 	SIZE sz={0};
 	if(m_nFrames>0 && m_pFrames)
 	{
-		sz=m_pFrames[0].pBmp->Size();
+		sz=m_szFrame;
 	}
 	return sz;
 }
@@ -120,10 +330,12 @@ SIZE SSkinAPNG::GetSkinSize() const
 IBitmap * SSkinAPNG::GetFrameImage(int iFrame/*=-1*/)
 {
 	if(iFrame==-1) iFrame=m_iFrame;
-	long nRet=-1;
 	if(m_nFrames>1 && iFrame>=0 && iFrame<m_nFrames)
 	{
-		return m_pFrames[iFrame].pBmp;
+		IBitmap *pBmp = _GetFrameBmp(iFrame);
+		//߿ܳзصλͼ֡ʱٸд
+		if(pBmp) m_bFrameBmpShared = TRUE;
+		return pBmp;
 	}else
 	{
 		return NULL;
@@ -140,16 +352,11 @@ void SSkinAPNG::_Scale(ISkinObj *pObj, int nScale)
 {
 	SSkinAni::_Scale(pObj,nScale);
 	SSkinAPNG * pClone = sobj_cast<SSkinAPNG>(pObj);
-	pClone->m_pFrames = new SAniFrame[m_nFrames];
-
-	CSize szSkin = GetSkinSize();
-	szSkin.cx = MulDiv(szSkin.cx, nScale, 100);
-	szSkin.cy = MulDiv(szSkin.cy, nScale, 100);
-	for(int i=0;i<m_nFrames;i++)
-	{
-		m_pFrames[i].pBmp->Scale(&pClone->m_pFrames[i].pBmp, szSkin.cx, szSkin.cy, kHigh_FilterLevel);
-		pClone->m_pFrames[i].nDelay = m_pFrames[i].nDelay;
-	}
+	//ѹݣʹԼĽÿһ֡ڻʱ
+	pClone->_InitImgFrame(m_srcData);
+	pClone->m_nScale = MulDiv(m_nScale, nScale, 100);
+	pClone->m_szFrame.cx = MulDiv(m_szFrame.cx, nScale, 100);
+	pClone->m_szFrame.cy = MulDiv(m_szFrame.cy, nScale, 100);
 }
 
 
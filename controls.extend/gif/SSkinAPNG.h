@@ -17,6 +17,7 @@ purpose:	
 
 namespace SOUI
 {
+    class SApngSrcData;
 
     /**
     * @class     SSkinAPNG
@@ -100,9 +101,27 @@ namespace SOUI
     protected:
         HRESULT OnAttrSrc(const SStringW &strValue,BOOL bLoading);
         
-        int _InitImgFrame(IImgX *pImgX);
+        int _InitImgFrame(SApngSrcData *pSrcData);
+
+        //ָֻ֡ǰ֡λͼ
+        IBitmap * _GetFrameBmp(int iFrame) const;
+
+        //ҹѹݣصĶҪͷ
+        static SApngSrcData * _AcquireSrcData(const SStringT & strSrcKey);
+
+        //ѹݲӹpBufstrSrcKeyΪʱ빲
+        static SApngSrcData * _CreateSrcData(const SStringT & strSrcKey,LPBYTE pBuf,size_t szBuf);
 
 	protected:
-		SAniFrame * m_pFrames;
+		SAniFrame * m_pFrames;      //ֻ֡ʱλͼ
+        SAutoRefPtr<SApngSrcData> m_srcData;  //ѹݣͬԴAPNGƤ乲
+        SAutoRefPtr<IImgX> m_imgX;  //ǰƤռĽ
+        CSize       m_szFrame;      //֡СԭͼСͬʱҪ
+        int         m_nScale;       //ԭͼűź֡ڹл
+
+        mutable SAutoRefPtr<IBitmap> m_pFrameBmp;
+        mutable int m_iFrameBmp;
+        mutable BOOL m_bFrameBmpShared; //m_pFrameBmpGetFrameImageĵ߻ŻУܾ͵ظд
+        mutable SAutoRefPtr<IBitmap> m_pSrcBmp; //ǰ֡λͼֻڲʹãԷд
     };
 }//end of name space SOUI
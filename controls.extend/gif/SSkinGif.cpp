@@ -92,6 +92,7 @@ int SSkinGif::LoadFromMemory( LPVOID pBuf,size_t dwSize )
 
 int SSkinGif::LoadFrame(int i, Gdiplus::Bitmap * pImage) const
 {
+    if (i == m_iLoadedFrame) return 0;
     if (m_pFrames && i < m_nFrames)
     {		
 		pImage->SelectActiveFrame(&FrameDimensionTime, i);
@@ -105,6 +106,7 @@ int SSkinGif::LoadFrame(int i, Gdiplus::Bitmap * pImage) const
 		bmp.LockBits(&rc, 0, PixelFormat32bppPARGB, &data);
 		m_pCurFrameBmp->Init(data.Width, data.Height, data.Scan0);
 		bmp.UnlockBits(&data);
+		m_iLoadedFrame = i;
 
 		return 0;
     }
@@ -145,6 +147,8 @@ int SSkinGif::LoadFromGdipImage( Gdiplus::Bitmap * pImage )
         free(pPropertyItem);
     }
 
+	m_pCurFrameBmp = NULL;
+	m_iLoadedFrame = -1;
 	GETRENDERFACTORY->CreateBitmap((IBitmap**)&m_pCurFrameBmp);
 	LoadFrame(0, pImage);
 
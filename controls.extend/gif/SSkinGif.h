@@ -22,13 +22,15 @@ namespace SOUI
     * @class     SSkinGif
     * @brief     GIFͼƬؼʾ
     * 
-    * Describe
+    * Describe    ֡GDI+ڻʱ룬ֻǰ֡λͼ
+    *             ÿƤԼGDI+ͼƬͬԴGIFSSkinAPNGѹݣ
+    *             GDI+ͼƬĵǰ֡Ƕ״̬Ƥ֮乲
     */
     class SSkinGif : public SSkinAni
     {
         SOUI_CLASS_NAME(SSkinGif, L"gif")
     public:
-        SSkinGif():m_pFrames(NULL), m_pImg(NULL)
+        SSkinGif():m_pFrames(NULL), m_pImg(NULL), m_iLoadedFrame(-1)
         {
         }
 
@@ -88,6 +90,7 @@ namespace SOUI
 
 		SAniFrame			*m_pFrames;
 		SAutoRefPtr<IBitmap> m_pCurFrameBmp;
+		mutable int			m_iLoadedFrame;	//m_pCurFrameBmpѾ֡ػͬһ֡ʱظ
 		Gdiplus::Bitmap		*m_pImg;
     };
 }//end of name space SOUI
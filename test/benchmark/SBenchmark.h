@@ -0,0 +1,98 @@
+﻿/**
+* Copyright (C) 2014-2050 
+* All rights reserved.
+* 
+* @file       SBenchmark.h
+* @brief      
+* @version    v1.0      
+* @author     SOUI group   
+* @date       2026/10/17
+* 
+* Describe    性能测试框架: 用SBENCHMARK定义用例, 用例内部用SBenchTimer计时并用SBenchReport输出结果
+*/
+
+#pragma once
+#include <windows.h>
+#include <stdio.h>
+
+namespace SOUI
+{
+    //高精度计时器
+    class SBenchTimer
+    {
+    public:
+        SBenchTimer()
+        {
+            QueryPerformanceFrequency(&m_freq);
+            Restart();
+        }
+
+        void Restart()
+        {
+            QueryPerformanceCounter(&m_start);
+        }
+
+        //从上次Restart到现在经过的秒数
+        double Elapsed() const
+        {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            return (double)(now.QuadPart - m_start.QuadPart)/m_freq.QuadPart;
+        }
+    protected:
+        LARGE_INTEGER m_freq;
+        LARGE_INTEGER m_start;
+    };
+
+    typedef void (*FunBenchmark)();
+
+    //性能测试用例, 由SBENCHMARK宏定义的静态对象注册
+    struct SBenchCase
+    {
+        SBenchCase(const char *pszName,FunBenchmark fun);
+
+        const char  *   pszName;
+        FunBenchmark    fun;
+        SBenchCase  *   pNext;
+
+        static SBenchCase * s_pHead;
+        static SBenchCase * s_pTail;
+    };
+
+    /**
+    * SBenchReport
+    * @brief    输出一行测试结果
+    * @param    const char * pszCase --  测试项目
+    * @param    const char * pszParam --  测试参数, 如数据规模
+    * @param    __int64 nOps --  操作次数
+    * @param    double dSeconds --  总耗时(秒)
+    * @return   void
+    * Describe  输出每次操作的平均耗时及每秒操作次数
+    */
+    void SBenchReport(const char *pszCase,const char *pszParam,__int64 nOps,double dSeconds);
+
+    //测试用的伪随机数, 保证每次运行的数据相同
+    class SBenchRandom
+    {
+    public:
+        SBenchRandom(unsigned int uSeed=1):m_uSeed(uSeed){}
+
+        unsigned int Next()
+        {
+            m_uSeed = m_uSeed*1103515245 + 12345;
+            return (m_uSeed>>8) ^ (m_uSeed<<16);
+        }
+
+        int Next(int nRange)
+        {
+            return nRange>0?(int)(Next()%(unsigned int)nRange):0;
+        }
+    protected:
+        unsigned int m_uSeed;
+    };
+}
+
+#define SBENCHMARK(name) \
+    static void SBench_##name(); \
+    static SOUI::SBenchCase s_benchCase_##name(#name,SBench_##name); \
+    static void SBench_##name()
@@ -0,0 +1,61 @@
+﻿#include <souicoll.h>
+#include "SBenchmark.h"
+#include <vector>
+
+using namespace SOUI;
+
+namespace
+{
+    //查找结果写到这里, 防止查找被优化掉
+    volatile int s_nSink = 0;
+
+    template<class TMap>
+    void BenchMap(const char *pszMap,const std::vector<int> & keys,const std::vector<int> & probes)
+    {
+        char szCase[64],szParam[64];
+        sprintf(szParam,"%d keys",(int)keys.size());
+
+        SBenchTimer timer;
+        TMap map;
+        for(size_t i=0;i<keys.size();i++)
+            map[keys[i]] = (int)i;
+        sprintf(szCase,"%s insert",pszMap);
+        SBenchReport(szCase,szParam,(__int64)keys.size(),timer.Elapsed());
+
+        timer.Restart();
+        int nSum = 0;
+        for(size_t i=0;i<probes.size();i++)
+        {
+            int v = 0;
+            if(map.Lookup(probes[i],v)) nSum += v;
+        }
+        s_nSink = nSum;
+        sprintf(szCase,"%s lookup",pszMap);
+        SBenchReport(szCase,szParam,(__int64)probes.size(),timer.Elapsed());
+
+        timer.Restart();
+        for(size_t i=0;i<keys.size();i++)
+            map.RemoveKey(keys[i]);
+        sprintf(szCase,"%s remove",pszMap);
+        SBenchReport(szCase,szParam,(__int64)keys.size(),timer.Elapsed());
+    }
+}
+
+//SFlatMap和SMap的插入、查找(一半命中)及删除耗时
+SBENCHMARK(FlatMap)
+{
+    const int kLookups = 4000000;
+    const int kSizes[] = {64,4096,262144};
+    SBenchRandom rnd;
+    for(int iSize=0;iSize<(int)ARRAYSIZE(kSizes);iSize++)
+    {
+        std::vector<int> keys(kSizes[iSize]),probes(kLookups);
+        for(size_t i=0;i<keys.size();i++)
+            keys[i] = (int)rnd.Next(0x7fffffff);
+        for(size_t i=0;i<probes.size();i++)
+            probes[i] = (i&1)?keys[rnd.Next((int)keys.size())]:(int)rnd.Next(0x7fffffff);
+
+        BenchMap<SMap<int,int> >("SMap",keys,probes);
+        BenchMap<SFlatMap<int,int> >("SFlatMap",keys,probes);
+    }
+}
@@ -0,0 +1,86 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_render_skia
+#include <commgr2.h>
+#include "SBenchmark.h"
+
+using namespace SOUI;
+
+namespace
+{
+    //生成一个典型的表单布局: 每行一个标签, 一个编辑提示文本, 一个复选框和两个按钮
+    SStringW BuildLayout(int nRows)
+    {
+        SStringW strXml = L"<SOUI width=\"800\" height=\"600\"><root layout=\"vbox\" colorBkgnd=\"#ffffff\">";
+        for(int i=0;i<nRows;i++)
+        {
+            strXml += SStringW().Format(
+                L"<window name=\"row_%d\" size=\"-2,30\" layout=\"hbox\" gravity=\"center\" interval=\"4\">"
+                L"<text name=\"lbl_%d\" size=\"120,-1\" colorText=\"#333333\" font=\"size:12\">label %d</text>"
+                L"<text name=\"tip_%d\" size=\"0,-1\" weight=\"1\" colorText=\"#999999\" dotted=\"1\">please input item %d</text>"
+                L"<check name=\"chk_%d\" size=\"-1,-1\" checked=\"0\">enable</check>"
+                L"<button name=\"btn_ok_%d\" size=\"60,24\" tip=\"apply row %d\">OK</button>"
+                L"<button name=\"btn_cancel_%d\" size=\"60,24\" visible=\"1\">Cancel</button>"
+                L"</window>",
+                i,i,i,i,i,i,i,i,i);
+        }
+        strXml += L"</root></SOUI>";
+        return strXml;
+    }
+
+    //加载nRounds次布局, 输出耗时及字符串从堆上分配的次数
+    void LoadLayouts(SHostWnd & host,const SStringW & strXml,int nRounds,const char *pszCase,const char *pszParam)
+    {
+        TStringAllocStats stats1,stats2;
+        _tstr_GetAllocStats(&stats1);
+        SBenchTimer timer;
+        for(int i=0;i<nRounds;i++)
+        {
+            pugi::xml_document xmlDoc;
+            xmlDoc.load_buffer(strXml.c_str(),strXml.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+            host.InitFromXml(xmlDoc.child(L"SOUI"));
+        }
+        double dSeconds = timer.Elapsed();
+        _tstr_GetAllocStats(&stats2);
+        SBenchReport(pszCase,pszParam,nRounds,dSeconds);
+        printf("  %-36s %-16s %14.1f heap/load %13.1f slabs/load\n","",pszParam,
+            (double)(stats2.nHeapAllocs-stats1.nHeapAllocs)/nRounds,
+            (double)(stats2.nPoolSlabs-stats1.nPoolSlabs)/nRounds);
+    }
+}
+
+//布局加载时的字符串分配: 关闭短字符串池时每个属性名/值都从堆上分配,
+//打开后只有池扩容(16K一块)和长字符串才访问堆
+SBENCHMARK(LayoutStringAlloc)
+{
+    const int kRounds = 20;
+
+    SComMgr2 comMgr;
+    SAutoRefPtr<IRenderFactory> renderFac;
+    if(!comMgr.CreateRender_SkiaHeadless((IObjRef**)&renderFac))
+    {
+        printf("  render-skia is not available\n");
+        return;
+    }
+    {
+        SApplication app(renderFac,GetModuleHandle(NULL));
+        SHostWnd host;
+        host.Create(NULL,WS_POPUP,0,0,0,800,600);
+
+        const int kRows[] = {10,100};
+        for(int i=0;i<(int)ARRAYSIZE(kRows);i++)
+        {
+            char szParam[32];
+            sprintf(szParam,"rows=%d",kRows[i]);
+            SStringW strXml = BuildLayout(kRows[i]);
+
+            bool bOld = _tstr_EnablePool(false);
+            LoadLayouts(host,strXml,kRounds,"heap strings",szParam);
+            _tstr_EnablePool(true);
+            //先加载一次让池中有足够的空闲块, 测量稳定状态
+            LoadLayouts(host,strXml,1,"pooled strings (cold)",szParam);
+            LoadLayouts(host,strXml,kRounds,"pooled strings",szParam);
+            _tstr_EnablePool(bOld);
+        }
+        host.DestroyWindow();
+    }
+}
@@ -0,0 +1,86 @@
+﻿#include "souistd.h"
+#include "helper/SListViewItemLocator.h"
+#include "helper/SAdapterBase.h"
+#include "SBenchmark.h"
+
+using namespace SOUI;
+
+namespace
+{
+    class SBenchLvAdapter : public SAdapterBase
+    {
+    public:
+        SBenchLvAdapter(int nCount):m_nCount(nCount){}
+
+        virtual int getCount(){return m_nCount;}
+        virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate){}
+
+        int m_nCount;
+    };
+}
+
+//可变高度表项定位: 10^3到10^7个表项下各操作的耗时, 中间插入/删除不应随表项数量线性增长
+SBENCHMARK(ListViewLocatorFlex)
+{
+    const int kQueryOps = 200000;
+    const int kEditOps = 20000;
+    for(int nItems = 1000; nItems <= 10000000; nItems *= 10)
+    {
+        char szParam[32];
+        sprintf(szParam,"items=%d",nItems);
+        SBenchRandom rnd;
+        SBenchTimer timer;
+
+        SAutoRefPtr<SBenchLvAdapter> adapter;
+        adapter.Attach(new SBenchLvAdapter(nItems));
+        SAutoRefPtr<SListViewItemLocatorFlex> locator;
+        locator.Attach(new SListViewItemLocatorFlex(SLayoutSize(20.0f),SLayoutSize(1.0f)));
+        timer.Restart();
+        locator->SetAdapter(adapter);
+        SBenchReport("SetAdapter",szParam,1,timer.Elapsed());
+
+        timer.Restart();
+        for(int i=0;i<kQueryOps;i++)
+        {
+            locator->SetItemHeight(rnd.Next(nItems),10+rnd.Next(40));
+        }
+        SBenchReport("SetItemHeight",szParam,kQueryOps,timer.Elapsed());
+
+        int nCheck = 0;
+        timer.Restart();
+        for(int i=0;i<kQueryOps;i++)
+        {
+            nCheck += locator->Item2Position(rnd.Next(nItems));
+        }
+        SBenchReport("Item2Position",szParam,kQueryOps,timer.Elapsed());
+
+        int nTotalHei = locator->GetTotalHeight();
+        timer.Restart();
+        for(int i=0;i<kQueryOps;i++)
+        {
+            nCheck += locator->Position2Item(rnd.Next(nTotalHei));
+        }
+        SBenchReport("Position2Item",szParam,kQueryOps,timer.Elapsed());
+
+        timer.Restart();
+        for(int i=0;i<kEditOps;i++)
+        {
+            adapter->m_nCount++;
+            locator->OnItemRangeInserted(rnd.Next(adapter->m_nCount),1);
+        }
+        SBenchReport("OnItemRangeInserted(middle)",szParam,kEditOps,timer.Elapsed());
+
+        timer.Restart();
+        for(int i=0;i<kEditOps;i++)
+        {
+            locator->OnItemRangeRemoved(rnd.Next(adapter->m_nCount),1);
+            adapter->m_nCount--;
+        }
+        SBenchReport("OnItemRangeRemoved(middle)",szParam,kEditOps,timer.Elapsed());
+
+        timer.Restart();
+        locator->OnDataSetChanged();
+        SBenchReport("OnDataSetChanged",szParam,1,timer.Elapsed());
+        if(nCheck == 0x7fffffff) printf("%d\n",nCheck);//避免查询被优化掉
+    }
+}
@@ -0,0 +1,45 @@
+﻿#include <helper/SPremultiply.hpp>
+#include "SBenchmark.h"
+#include <vector>
+
+using namespace SOUI;
+
+namespace
+{
+    class SPremultiplyBench : public SPremultiply
+    {
+    public:
+        static void Scalar(unsigned char *pDst,const unsigned char *pSrc,int nPixels,bool bSwapRB)
+        {
+            _Premultiply_C(pDst,pSrc,nPixels,bSwapRB);
+        }
+    };
+}
+
+//预乘吞吐量: 逐像素计算和SSE2实现处理一帧1080p图像的耗时
+SBENCHMARK(Premultiply)
+{
+    const int kWid = 1920, kHei = 1080, kRounds = 20;
+    const int nPixels = kWid*kHei;
+    std::vector<unsigned char> src(nPixels*4),dst(nPixels*4);
+    SBenchRandom rnd;
+    for(size_t i=0;i<src.size();i++)
+        src[i] = (unsigned char)rnd.Next(256);
+
+    for(int bSwap=0;bSwap<2;bSwap++)
+    {
+        const char *pszParam = bSwap?"swapRB 1080p":"1080p";
+        SBenchTimer timer;
+        for(int i=0;i<kRounds;i++)
+            SPremultiplyBench::Scalar(&dst[0],&src[0],nPixels,bSwap!=0);
+        SBenchReport("scalar (per pixel)",pszParam,(__int64)nPixels*kRounds,timer.Elapsed());
+
+        timer.Restart();
+        for(int i=0;i<kRounds;i++)
+        {
+            if(bSwap) SPremultiply::PremultiplySwapRB(&dst[0],&src[0],nPixels);
+            else SPremultiply::Premultiply(&dst[0],&src[0],nPixels);
+        }
+        SBenchReport(SPremultiply::HasSSE2()?"SSE2 (per pixel)":"no SSE2 (per pixel)",pszParam,(__int64)nPixels*kRounds,timer.Elapsed());
+    }
+}
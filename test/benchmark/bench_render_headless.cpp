@@ -0,0 +1,44 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_render_skia
+#include <commgr2.h>
+#include "SBenchmark.h"
+
+using namespace SOUI;
+
+namespace
+{
+    void RenderOffscreen(IRenderFactory *pFactory,const char *pszCase,int nSize,int nRounds)
+    {
+        char szParam[32];
+        sprintf(szParam,"%dx%d",nSize,nSize);
+        SBenchTimer timer;
+        for(int i=0;i<nRounds;i++)
+        {
+            SAutoRefPtr<IRenderTarget> pRT;
+            pFactory->CreateRenderTarget(&pRT,nSize,nSize);
+            CRect rc(0,0,nSize,nSize);
+            pRT->GradientFill(&rc,TRUE,RGBA(255,0,0,255),RGBA(0,0,255,255));
+            rc.DeflateRect(nSize/4,nSize/4);
+            pRT->FillSolidEllipse(&rc,RGBA(0,128,0,200));
+        }
+        SBenchReport(pszCase,szParam,nRounds,timer.Elapsed());
+    }
+}
+
+//离屏绘制: 无头模式和DIB模式创建渲染目标并绘制的耗时
+SBENCHMARK(RenderSkiaHeadless)
+{
+    SComMgr2 comMgr;
+    SAutoRefPtr<IRenderFactory> factory,factoryHeadless;
+    if(!comMgr.CreateRender_Skia((IObjRef**)&factory) || !comMgr.CreateRender_SkiaHeadless((IObjRef**)&factoryHeadless))
+    {
+        printf("  render-skia is not available\n");
+        return;
+    }
+    for(int nSize = 64; nSize <= 1024; nSize *= 4)
+    {
+        int nRounds = 64*1024*1024/(nSize*nSize) + 10;
+        RenderOffscreen(factory,"dib",nSize,nRounds);
+        RenderOffscreen(factoryHeadless,"headless",nSize,nRounds);
+    }
+}
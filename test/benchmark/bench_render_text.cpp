@@ -0,0 +1,91 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_render_skia
+#include <commgr2.h>
+#include "SBenchmark.h"
+
+using namespace SOUI;
+
+namespace
+{
+    //创建离屏绘制用的skia渲染及字体, comMgr需要比创建的对象存活更久
+    BOOL CreateSkiaRT(SComMgr2 & comMgr,int nWid,int nHei,IRenderTarget **ppRT,IFont **ppFont)
+    {
+        SAutoRefPtr<IRenderFactory> renderFac;
+        if(!comMgr.CreateRender_SkiaHeadless((IObjRef**)&renderFac))
+            return FALSE;
+        if(!renderFac->CreateRenderTarget(ppRT,nWid,nHei))
+            return FALSE;
+        LOGFONT lf={0};
+        lf.lfHeight = -12;
+        lf.lfWeight = FW_NORMAL;
+        _tcscpy(lf.lfFaceName,_T("Arial"));
+        if(!renderFac->CreateFont(ppFont,lf))
+            return FALSE;
+        (*ppRT)->SelectObject(*ppFont);
+        return TRUE;
+    }
+}
+
+//skia文本绘制: 列表类界面每帧重绘同一批短文本, 排版缓存命中后只剩下字形提交;
+//每帧文本都不相同时测量缓存未命中(排版+淘汰)的开销
+SBENCHMARK(RenderSkiaDrawText)
+{
+    const int kFrames = 200;
+    const int kLabels = 100;
+
+    SComMgr2 comMgr;
+    SAutoRefPtr<IRenderTarget> pRT;
+    SAutoRefPtr<IFont> pFont;
+    if(!CreateSkiaRT(comMgr,800,kLabels*20,&pRT,&pFont))
+    {
+        printf("  render-skia is not available\n");
+        return;
+    }
+
+    SArray<SStringT> lstLabels;
+    for(int i=0;i<kLabels;i++)
+    {
+        SStringT str;
+        str.Format(_T("List item %d - some descriptive text"),i);
+        lstLabels.Add(str);
+    }
+
+    const UINT kFormats[] = {DT_SINGLELINE|DT_VCENTER|DT_LEFT, DT_SINGLELINE|DT_VCENTER|DT_END_ELLIPSIS, DT_WORDBREAK};
+    const char *kFormatNames[] = {"singleline", "ellipsis", "wordbreak"};
+    for(int iFmt=0;iFmt<ARRAYSIZE(kFormats);iFmt++)
+    {
+        int nWid = kFormats[iFmt]&DT_END_ELLIPSIS?120:800;
+        SBenchTimer timer;
+        for(int iFrame=0;iFrame<kFrames;iFrame++)
+        {
+            for(int i=0;i<kLabels;i++)
+            {
+                CRect rc(0,i*20,nWid,i*20+20);
+                pRT->DrawText(lstLabels[i],-1,&rc,kFormats[iFmt]);
+            }
+        }
+        SBenchReport("DrawText cached",kFormatNames[iFmt],(__int64)kFrames*kLabels,timer.Elapsed());
+
+        timer.Restart();
+        for(int iFrame=0;iFrame<kFrames;iFrame++)
+        {
+            for(int i=0;i<kLabels;i++)
+            {
+                SStringT str;
+                str.Format(_T("Frame %d item %d"),iFrame,i);
+                CRect rc(0,i*20,nWid,i*20+20);
+                pRT->DrawText(str,-1,&rc,kFormats[iFmt]);
+            }
+        }
+        SBenchReport("DrawText uncached",kFormatNames[iFmt],(__int64)kFrames*kLabels,timer.Elapsed());
+    }
+
+    SBenchTimer timer;
+    const int kMeasures = 100000;
+    for(int i=0;i<kMeasures;i++)
+    {
+        SIZE sz;
+        pRT->MeasureText(lstLabels[i%kLabels],-1,&sz);
+    }
+    SBenchReport("MeasureText cached","labels=100",kMeasures,timer.Elapsed());
+}
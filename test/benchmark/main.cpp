@@ -0,0 +1,40 @@
+﻿#include "SBenchmark.h"
+#include <string.h>
+
+namespace SOUI
+{
+    SBenchCase * SBenchCase::s_pHead = NULL;
+    SBenchCase * SBenchCase::s_pTail = NULL;
+
+    SBenchCase::SBenchCase(const char *pszName,FunBenchmark fun)
+        :pszName(pszName),fun(fun),pNext(NULL)
+    {
+        if(s_pTail) s_pTail->pNext = this;
+        else s_pHead = this;
+        s_pTail = this;
+    }
+
+    void SBenchReport(const char *pszCase,const char *pszParam,__int64 nOps,double dSeconds)
+    {
+        double dNsPerOp = nOps>0?dSeconds*1e9/nOps:0.0;
+        double dOpsPerSec = dSeconds>0?nOps/dSeconds:0.0;
+        printf("  %-36s %-16s %14.1f ns/op %16.0f op/s\n",pszCase,pszParam,dNsPerOp,dOpsPerSec);
+    }
+}
+
+using namespace SOUI;
+
+//用法: soui-benchmark [filter], 只运行名称中包含filter的用例
+int main(int argc, char* argv[])
+{
+    const char *pszFilter = argc>1?argv[1]:NULL;
+    for(SBenchCase *pCase = SBenchCase::s_pHead; pCase; pCase = pCase->pNext)
+    {
+        if(pszFilter && !strstr(pCase->pszName,pszFilter)) continue;
+        printf("[%s]\n",pCase->pszName);
+        SBenchTimer timer;
+        pCase->fun();
+        printf("  total %.3f s\n\n",timer.Elapsed());
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_render_skia
+#include <commgr2.h>
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //创建窗口对象的用例需要SApplication, 整个测试进程共用一个, 使用无头渲染
+    class STestAppEnvironment : public ::testing::Environment
+    {
+    public:
+        STestAppEnvironment():m_pApp(NULL)
+        {
+        }
+
+        virtual void SetUp()
+        {
+            SAutoRefPtr<IRenderFactory> pRenderFactory;
+            m_comMgr.CreateRender_SkiaHeadless((IObjRef**)&pRenderFactory);
+            ASSERT_TRUE(pRenderFactory);
+            m_pApp = new SApplication(pRenderFactory,GetModuleHandle(NULL));
+        }
+
+        virtual void TearDown()
+        {
+            delete m_pApp;
+            m_pApp = NULL;
+        }
+
+    private:
+        SComMgr2      m_comMgr;
+        SApplication *m_pApp;
+    };
+
+    ::testing::Environment * const s_appEnv = ::testing::AddGlobalTestEnvironment(new STestAppEnvironment);
+}
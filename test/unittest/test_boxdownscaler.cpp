@@ -0,0 +1,114 @@
+﻿#include <helper/SBoxDownscaler.hpp>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace SOUI;
+
+namespace
+{
+    //参考实现: 对完整的源图逐个目标像素求alpha加权平均
+    void ReferenceResize(const std::vector<unsigned char> & src,int nWid,int nHei,int nScale,std::vector<unsigned char> & dst)
+    {
+        int nDstWid = (nWid + nScale - 1)/nScale;
+        int nDstHei = (nHei + nScale - 1)/nScale;
+        dst.assign(nDstWid*nDstHei*4,0);
+        for(int dy=0;dy<nDstHei;dy++)
+        {
+            for(int dx=0;dx<nDstWid;dx++)
+            {
+                unsigned int sum[4]={0},nCount=0;
+                for(int y=dy*nScale;y<nHei && y<(dy+1)*nScale;y++)
+                {
+                    for(int x=dx*nScale;x<nWid && x<(dx+1)*nScale;x++)
+                    {
+                        const unsigned char *p = &src[(y*nWid+x)*4];
+                        for(int c=0;c<3;c++) sum[c] += p[c]*p[3];
+                        sum[3] += p[3];
+                        nCount++;
+                    }
+                }
+                unsigned char *pOut = &dst[(dy*nDstWid+dx)*4];
+                if(sum[3]==0) continue;
+                for(int c=0;c<3;c++) pOut[c] = (unsigned char)(sum[c]/sum[3]);
+                pOut[3] = (unsigned char)(sum[3]/nCount);
+            }
+        }
+    }
+
+    //按行推入源图, 返回写出的目标行数
+    int StreamResize(const std::vector<unsigned char> & src,int nWid,int nHei,int nScale,std::vector<unsigned char> & dst)
+    {
+        SBoxDownscaler scaler(nWid,nHei,nScale);
+        unsigned int cbStride = scaler.GetWidth()*4;
+        dst.assign(cbStride*scaler.GetHeight(),0xcd);
+        int nRows = 0;
+        for(int y=0;y<nHei;y++)
+        {
+            if(scaler.PushRow(&src[y*nWid*4],&dst[0],cbStride)) nRows++;
+        }
+        return nRows;
+    }
+}
+
+//随机图片, 尺寸不是倍数的整数倍时最后一行及一列只平均剩余的像素
+TEST(SBoxDownscaler, MatchesReference)
+{
+    srand(34);
+    const int kSizes[][2]={{1,1},{7,5},{16,16},{33,17},{50,3}};
+    for(size_t i=0;i<sizeof(kSizes)/sizeof(kSizes[0]);i++)
+    {
+        int nWid = kSizes[i][0], nHei = kSizes[i][1];
+        std::vector<unsigned char> src(nWid*nHei*4);
+        for(size_t k=0;k<src.size();k++)
+            src[k] = (unsigned char)(rand() & 0xff);
+        //部分像素全透明, 覆盖alpha为0的情况
+        for(int k=0;k<nWid*nHei;k+=3)
+            src[k*4+3] = 0;
+        for(int nScale=1;nScale<=5;nScale++)
+        {
+            std::vector<unsigned char> ref,out;
+            ReferenceResize(src,nWid,nHei,nScale,ref);
+            int nRows = StreamResize(src,nWid,nHei,nScale,out);
+            EXPECT_EQ((nHei + nScale - 1)/nScale,nRows);
+            ASSERT_EQ(ref.size(),out.size());
+            for(size_t k=0;k<ref.size();k++)
+            {
+                ASSERT_EQ(ref[k],out[k]) << nWid << "x" << nHei << " scale=" << nScale << " byte=" << k;
+            }
+        }
+    }
+}
+
+//全透明的块输出0, 多余的输入行被忽略
+TEST(SBoxDownscaler, TransparentBlockAndExtraRows)
+{
+    std::vector<unsigned char> src(4*4*4,0);
+    for(int k=0;k<16;k++)
+    {
+        src[k*4+0] = 200;
+        src[k*4+3] = (k%4)<2?0:255; //左半透明, 右半不透明
+    }
+    SBoxDownscaler scaler(4,4,2);
+    unsigned char dst[2*2*4];
+    memset(dst,0xcd,sizeof(dst));
+    for(int y=0;y<4;y++)
+        scaler.PushRow(&src[y*16],dst,8);
+    EXPECT_FALSE(scaler.PushRow(&src[0],dst,8));
+    const unsigned char kLeft[4]={0,0,0,0};
+    const unsigned char kRight[4]={200,0,0,255};
+    EXPECT_EQ(0,memcmp(dst,kLeft,4));
+    EXPECT_EQ(0,memcmp(dst+4,kRight,4));
+    EXPECT_EQ(0,memcmp(dst+8,kLeft,4));
+    EXPECT_EQ(0,memcmp(dst+12,kRight,4));
+}
+
+//缩小后不小于期望大小, 并受MAX_SCALE限制
+TEST(SBoxDownscaler, CalcScale)
+{
+    EXPECT_EQ(1,SBoxDownscaler::CalcScale(100,100,0,0));
+    EXPECT_EQ(1,SBoxDownscaler::CalcScale(100,100,200,200));
+    EXPECT_EQ(4,SBoxDownscaler::CalcScale(400,300,100,75));
+    EXPECT_EQ(3,SBoxDownscaler::CalcScale(400,300,100,99));
+    EXPECT_EQ(SBoxDownscaler::MAX_SCALE,SBoxDownscaler::CalcScale(10000,10000,1,1));
+}
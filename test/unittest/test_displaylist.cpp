@@ -0,0 +1,202 @@
+﻿#include "souistd.h"
+#include "helper/SDisplayList.h"
+#define SCOM_MASK scom_mask_render_skia|scom_mask_render_gdi
+#include <commgr2.h>
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    const int kWid = 64;
+    const int kHei = 48;
+
+    enum RENDER{RENDER_SKIA,RENDER_GDI};
+
+    //4x4的两色位图
+    void InitChecker(IBitmap *pBmp,DWORD cr1,DWORD cr2)
+    {
+        DWORD pixels[4*4];
+        for(int i=0;i<16;i++)
+            pixels[i] = ((i/4 + i%4)&1)?cr1:cr2;
+        pBmp->Init(4,4,pixels);
+    }
+
+    //不含文字的测试场景, 避免字体差异
+    void DrawScene(IRenderTarget *pRT,IBitmap *pBmp)
+    {
+        CRect rcAll(0,0,kWid,kHei);
+        pRT->FillSolidRect(&rcAll,RGBA(255,255,255,255));
+        CRect rc1(2,2,30,20);
+        pRT->FillSolidRect(&rc1,RGBA(255,0,0,255));
+
+        CRect rcClip(20,10,50,40);
+        pRT->PushClipRect(&rcClip);
+        CRect rc2(10,5,60,45);
+        pRT->FillSolidRect(&rc2,RGBA(0,0,255,255));
+        pRT->PopClip();
+
+        POINT ptOld;
+        pRT->OffsetViewportOrg(4,24,&ptOld);
+        CRect rcSrc(0,0,4,4),rcDst(0,0,16,16);
+        pRT->DrawBitmapEx(&rcDst,pBmp,&rcSrc,EM_STRETCH,0xFF);
+        pRT->SetViewportOrg(ptOld);
+    }
+
+    class DisplayListTest : public ::testing::TestWithParam<int>
+    {
+    protected:
+        virtual void SetUp()
+        {
+            if(GetParam() == RENDER_SKIA)
+                m_comMgr.CreateRender_SkiaHeadless((IObjRef**)&m_factory);
+            else
+                m_comMgr.CreateRender_GDI((IObjRef**)&m_factory);
+        }
+
+        void CreateRT(IRenderTarget **ppRT)
+        {
+            m_factory->CreateRenderTarget(ppRT,kWid,kHei);
+        }
+
+        //在pRTRef上录制, 返回录制结果
+        SDisplayList * Record(IRenderTarget *pRTRef,IBitmap *pBmp)
+        {
+            CRect rcBound(0,0,kWid,kHei);
+            SDisplayListRecorder *pRecorder = new SDisplayListRecorder(pRTRef,&rcBound);
+            DrawScene(pRecorder,pBmp);
+            SDisplayList *pList = NULL;
+            if(pRecorder->IsValid())
+            {
+                pList = pRecorder->GetDisplayList();
+                pList->AddRef();
+            }
+            pRecorder->Release();
+            return pList;
+        }
+
+        void Replay(SDisplayList *pList,IRenderTarget *pRT)
+        {
+            CRect rcAll(0,0,kWid,kHei);
+            pRT->ClearRect(&rcAll,0);
+            CRect rcBound(0,0,kWid,kHei);
+            pList->Replay(pRT,0xFF,&rcBound);
+        }
+
+        static const DWORD * Bits(IRenderTarget *pRT)
+        {
+            IBitmap *pBmp = (IBitmap*)pRT->GetCurrentObject(OT_BITMAP);
+            return (const DWORD*)pBmp->GetPixelBits();
+        }
+
+        SComMgr2 m_comMgr;
+        SAutoRefPtr<IRenderFactory> m_factory;
+    };
+}
+
+//回放结果必须和直接绘制逐像素一致
+TEST_P(DisplayListTest, ReplayMatchesDirectPaint)
+{
+    ASSERT_TRUE(m_factory);
+    SAutoRefPtr<IBitmap> bmp;
+    m_factory->CreateBitmap(&bmp);
+    InitChecker(bmp,0xff000000,0xff00ff00);
+
+    SAutoRefPtr<IRenderTarget> rtDirect,rtReplay;
+    CreateRT(&rtDirect);
+    CreateRT(&rtReplay);
+    DrawScene(rtDirect,bmp);
+
+    SAutoRefPtr<SDisplayList> pList;
+    pList.Attach(Record(rtReplay,bmp));
+    ASSERT_TRUE(pList);
+    EXPECT_FALSE(pList->IsEmpty());
+    //回放两次, 第一次回放不能改变列表或目标RT的状态
+    Replay(pList,rtReplay);
+    Replay(pList,rtReplay);
+
+    POINT pt;
+    rtReplay->GetViewportOrg(&pt);
+    EXPECT_EQ(0,pt.x);
+    EXPECT_EQ(0,pt.y);
+
+    const DWORD *pDirect = Bits(rtDirect);
+    const DWORD *pReplay = Bits(rtReplay);
+    for(int i=0;i<kWid*kHei;i++)
+    {
+        ASSERT_EQ(pDirect[i],pReplay[i]) << "x=" << i%kWid << " y=" << i/kWid;
+    }
+}
+
+//普通位图按版本号引用: 像素改变后列表过期, 其它位图的改变不影响
+TEST_P(DisplayListTest, BitmapChangeMakesListStale)
+{
+    ASSERT_TRUE(m_factory);
+    SAutoRefPtr<IBitmap> bmp,bmpOther;
+    m_factory->CreateBitmap(&bmp);
+    m_factory->CreateBitmap(&bmpOther);
+    InitChecker(bmp,0xff000000,0xff00ff00);
+    InitChecker(bmpOther,0xff000000,0xff00ff00);
+    EXPECT_NE(0u,bmp->GetContentVersion());
+
+    SAutoRefPtr<IRenderTarget> rt;
+    CreateRT(&rt);
+    SAutoRefPtr<SDisplayList> pList;
+    pList.Attach(Record(rt,bmp));
+    ASSERT_TRUE(pList);
+    EXPECT_FALSE(pList->IsStale());
+
+    LPVOID pBits = bmpOther->LockPixelBits();
+    bmpOther->UnlockPixelBits(pBits);
+    EXPECT_FALSE(pList->IsStale());
+
+    DWORD dwVer = bmp->GetContentVersion();
+    pBits = bmp->LockPixelBits();
+    ((DWORD*)pBits)[0] = 0xffff0000;
+    bmp->UnlockPixelBits(pBits);
+    EXPECT_NE(dwVer,bmp->GetContentVersion());
+    EXPECT_TRUE(pList->IsStale());
+}
+
+//渲染目标的位图没有版本号, 录制时复制, 之后对源RT的绘制不影响回放
+TEST_P(DisplayListTest, SurfaceBitmapIsSnapshotted)
+{
+    ASSERT_TRUE(m_factory);
+    SAutoRefPtr<IRenderTarget> rtSrc,rt;
+    m_factory->CreateRenderTarget(&rtSrc,4,4);
+    CreateRT(&rt);
+    CRect rcSrc(0,0,4,4);
+    rtSrc->FillSolidRect(&rcSrc,RGBA(255,0,0,255));
+    IBitmap *pSurface = (IBitmap*)rtSrc->GetCurrentObject(OT_BITMAP);
+    EXPECT_EQ(0u,pSurface->GetContentVersion());
+
+    SAutoRefPtr<SDisplayList> pList;
+    pList.Attach(Record(rt,pSurface));
+    ASSERT_TRUE(pList);
+    EXPECT_FALSE(pList->IsStale());
+
+    rtSrc->FillSolidRect(&rcSrc,RGBA(0,0,255,255));
+    Replay(pList,rt);
+    //位图绘制在(4,24)-(20,40), 取其中心点
+    const DWORD *pBits = Bits(rt);
+    EXPECT_EQ(0x00ff0000u,pBits[32*kWid+12] & 0x00ffffff);
+}
+
+//依赖目标像素的调用无法录制
+TEST_P(DisplayListTest, PixelReadInvalidatesRecording)
+{
+    ASSERT_TRUE(m_factory);
+    SAutoRefPtr<IRenderTarget> rt;
+    CreateRT(&rt);
+    CRect rcBound(0,0,kWid,kHei);
+    SDisplayListRecorder *pRecorder = new SDisplayListRecorder(rt,&rcBound);
+    CRect rc(0,0,8,8);
+    pRecorder->FillSolidRect(&rc,RGBA(255,0,0,255));
+    EXPECT_TRUE(pRecorder->IsValid());
+    pRecorder->GetPixel(1,1);
+    EXPECT_FALSE(pRecorder->IsValid());
+    pRecorder->Release();
+}
+
+INSTANTIATE_TEST_CASE_P(Renders, DisplayListTest,
+    ::testing::Values((int)RENDER_SKIA,(int)RENDER_GDI));
@@ -0,0 +1,210 @@
+﻿#include "souistd.h"
+#include "event/SEventSet.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //测试专用的事件ID和名字, 不会和控件注册的事件集合相同
+    enum
+    {
+        kEvtA = 0x7f000001,
+        kEvtB = 0x7f000002,
+        kEvtC = 0x7f000003,
+    };
+
+    class EventSetTester : public SEventSet
+    {
+    public:
+        using SEventSet::GetEventObject;
+
+        const void * IdSet() const {return m_pIdSet;}
+        UINT EventObjects() const {return (UINT)m_evtArr.GetCount();}
+    };
+
+    class Counter
+    {
+    public:
+        Counter():m_nCalls(0){}
+        bool OnEvent(EventArgs *pEvt)
+        {
+            m_nCalls ++;
+            return true;
+        }
+        int m_nCalls;
+    };
+
+    //ID在运行时指定的事件
+    class TestEvent : public EventArgs
+    {
+    public:
+        TestEvent(DWORD dwEventID):EventArgs(NULL),m_dwEventID(dwEventID){}
+        virtual int GetID() const {return (int)m_dwEventID;}
+        virtual LPCWSTR GetName() const {return L"test_event";}
+
+        DWORD m_dwEventID;
+    };
+
+    void Fire(SEventSet & set,DWORD dwEventID)
+    {
+        TestEvent evt(dwEventID);
+        set.FireEvent(evt);
+    }
+}
+
+TEST(EventSetTest, SameEventsShareIdSet)
+{
+    EventSetTester a,b,c,d;
+    a.addEvent(kEvtA,L"test_evt_a");
+    a.addEvent(kEvtB,L"test_evt_b");
+    b.addEvent(kEvtA,L"test_evt_a");
+    b.addEvent(kEvtB,L"test_evt_b");
+    //集合按事件ID排序后驻留, 注册顺序不同也共享
+    c.addEvent(kEvtB,L"test_evt_b");
+    c.addEvent(kEvtA,L"test_evt_a");
+    d.addEvent(kEvtA,L"test_evt_a");
+
+    ASSERT_TRUE(a.IdSet() != NULL);
+    EXPECT_EQ(a.IdSet(),b.IdSet());
+    EXPECT_EQ(a.IdSet(),c.IdSet());
+    EXPECT_NE(a.IdSet(),d.IdSet());
+
+    //重复注册不改变集合
+    const void *pSet = a.IdSet();
+    a.addEvent(kEvtB,L"test_evt_b");
+    EXPECT_EQ(pSet,a.IdSet());
+
+    //删除事件后回到已有的集合
+    a.removeEvent(kEvtB);
+    EXPECT_EQ(d.IdSet(),a.IdSet());
+    EXPECT_FALSE(a.isEventPresent(kEvtB));
+    EXPECT_TRUE(a.isEventPresent(kEvtA));
+    EXPECT_EQ(pSet,b.IdSet());
+
+    a.removeEvent(kEvtA);
+    EXPECT_TRUE(a.IdSet() == NULL);
+    EXPECT_FALSE(a.isEventPresent(kEvtA));
+
+    b.removeAllEvents();
+    EXPECT_TRUE(b.IdSet() == NULL);
+    EXPECT_TRUE(c.isEventPresent(kEvtB));
+}
+
+TEST(EventSetTest, TransitionCacheChecksName)
+{
+    EventSetTester a,b,c;
+    a.addEvent(kEvtC,L"test_evt_c1");
+    //相同ID不同名字, 不能走到缓存的集合
+    b.addEvent(kEvtC,L"test_evt_c2");
+    c.addEvent(kEvtC,L"test_evt_c1");
+
+    EXPECT_NE(a.IdSet(),b.IdSet());
+    EXPECT_EQ(a.IdSet(),c.IdSet());
+
+    Counter counter;
+    ASSERT_TRUE(b.subscribeEvent(kEvtC,Subscriber(&Counter::OnEvent,&counter)));
+    SEvent *pEvent = b.GetEventObject(kEvtC);
+    ASSERT_TRUE(pEvent != NULL);
+    EXPECT_TRUE(pEvent->GetName() == L"test_evt_c2");
+    EXPECT_TRUE(c.GetEventObject(kEvtC,TRUE)->GetName() == L"test_evt_c1");
+}
+
+TEST(EventSetTest, EventObjectCreatedOnDemand)
+{
+    EventSetTester set;
+    set.addEvent(kEvtA,L"test_evt_a");
+    set.addEvent(kEvtB,L"test_evt_b");
+    EXPECT_EQ(0u,set.EventObjects());
+    EXPECT_TRUE(set.GetEventObject(kEvtA) == NULL);
+    //没有注册的事件不创建
+    EXPECT_TRUE(set.GetEventObject(kEvtC,TRUE) == NULL);
+    EXPECT_EQ(0u,set.EventObjects());
+
+    //没有订阅者时触发事件不创建SEvent
+    Fire(set,kEvtA);
+    EXPECT_EQ(0u,set.EventObjects());
+
+    Counter counter;
+    EXPECT_TRUE(set.subscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    EXPECT_EQ(1u,set.EventObjects());
+    SEvent *pEvent = set.GetEventObject(kEvtA);
+    ASSERT_TRUE(pEvent != NULL);
+    EXPECT_EQ((DWORD)kEvtA,pEvent->GetID());
+    EXPECT_TRUE(pEvent->GetName() == L"test_evt_a");
+    EXPECT_TRUE(set.GetEventObject(kEvtB) == NULL);
+
+    //SEvent只有订阅者的事件触发才会调用
+    Fire(set,kEvtB);
+    EXPECT_EQ(0,counter.m_nCalls);
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+
+    //删除事件同时删除SEvent, 重新注册后没有订阅者
+    set.removeEvent(kEvtA);
+    EXPECT_EQ(0u,set.EventObjects());
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+    set.addEvent(kEvtA,L"test_evt_a");
+    EXPECT_TRUE(set.GetEventObject(kEvtA) == NULL);
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+}
+
+TEST(EventSetTest, SubscribeBeforeAdd)
+{
+    EventSetTester set;
+    Counter counter;
+    EXPECT_FALSE(set.subscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    EXPECT_FALSE(set.unsubscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    EXPECT_EQ(0u,set.EventObjects());
+
+    set.addEvent(kEvtA,L"test_evt_a");
+    EXPECT_TRUE(set.subscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    EXPECT_FALSE(set.subscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+
+    EXPECT_TRUE(set.unsubscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter)));
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+}
+
+TEST(EventSetTest, MutedSetDoesNotFire)
+{
+    EventSetTester set;
+    set.addEvent(kEvtA,L"test_evt_a");
+    Counter counter;
+    set.subscribeEvent(kEvtA,Subscriber(&Counter::OnEvent,&counter));
+
+    set.setMutedState(true);
+    set.setMutedState(true);
+    EXPECT_TRUE(set.isMuted());
+    Fire(set,kEvtA);
+    set.setMutedState(false);
+    EXPECT_TRUE(set.isMuted());
+    Fire(set,kEvtA);
+    EXPECT_EQ(0,counter.m_nCalls);
+
+    set.setMutedState(false);
+    EXPECT_FALSE(set.isMuted());
+    Fire(set,kEvtA);
+    EXPECT_EQ(1,counter.m_nCalls);
+}
+
+TEST(EventSetTest, ScriptHandler)
+{
+    EventSetTester set;
+    EXPECT_FALSE(set.setEventScriptHandler(L"test_evt_a","onA"));
+
+    set.addEvent(kEvtA,L"test_evt_a");
+    set.addEvent(kEvtB,L"test_evt_b");
+    //没有驻留过的名字不会是事件名
+    EXPECT_FALSE(set.setEventScriptHandler(L"test_evt_never_registered","onX"));
+    EXPECT_EQ(0u,set.EventObjects());
+
+    EXPECT_TRUE(set.setEventScriptHandler(L"test_evt_b","onB"));
+    EXPECT_EQ(1u,set.EventObjects());
+    EXPECT_TRUE(set.getEventScriptHandler(L"test_evt_b") == "onB");
+    EXPECT_TRUE(set.getEventScriptHandler(L"test_evt_a").IsEmpty());
+}
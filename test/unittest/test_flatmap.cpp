@@ -0,0 +1,88 @@
+﻿#include <souicoll.h>
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //所有键的哈希值相同, 用于构造最长的探测距离
+    class SCollideTraits : public CElementTraits<int>
+    {
+    public:
+        static ULONG Hash(const int & element)
+        {
+            (element);
+            return 7;
+        }
+    };
+
+    //每个键的探测距离都超过255
+    const int KCollideKeys = 1000;
+}
+
+TEST(SFlatMap, InsertLookupRemove)
+{
+    SFlatMap<int,int> map;
+    for(int i=0;i<10000;i++)
+        map[i*3] = i;
+    EXPECT_EQ(10000u,map.GetCount());
+    for(int i=0;i<10000;i++)
+    {
+        int v = -1;
+        ASSERT_TRUE(map.Lookup(i*3,v));
+        EXPECT_EQ(i,v);
+        EXPECT_TRUE(map.Lookup(i*3+1) == NULL);
+    }
+    for(int i=0;i<10000;i+=2)
+        EXPECT_TRUE(map.RemoveKey(i*3));
+    EXPECT_EQ(5000u,map.GetCount());
+    for(int i=0;i<10000;i++)
+        EXPECT_EQ(i%2==1,map.Lookup(i*3) != NULL);
+}
+
+TEST(SFlatMap, CollidingKeys)
+{
+    SFlatMap<int,int,SCollideTraits> map;
+    for(int i=0;i<KCollideKeys;i++)
+        map.SetAt(i,i*2);
+    ASSERT_EQ((size_t)KCollideKeys,map.GetCount());
+    for(int i=0;i<KCollideKeys;i++)
+    {
+        const SFlatMap<int,int,SCollideTraits>::CPair *p = map.Lookup(i);
+        ASSERT_TRUE(p != NULL);
+        EXPECT_EQ(i*2,p->m_value);
+    }
+
+    //从中间删除后, 后面的键仍然可以找到
+    for(int i=0;i<KCollideKeys;i+=3)
+        EXPECT_TRUE(map.RemoveKey(i));
+    for(int i=0;i<KCollideKeys;i++)
+        EXPECT_EQ(i%3!=0,map.Lookup(i) != NULL);
+
+    //遍历访问到所有剩余的键
+    size_t nVisited = 0;
+    SPOSITION pos = map.GetStartPosition();
+    while(pos)
+    {
+        const SFlatMap<int,int,SCollideTraits>::CPair *p = map.GetNext(pos);
+        EXPECT_NE(0,p->m_key%3);
+        EXPECT_EQ(p->m_key*2,p->m_value);
+        nVisited++;
+    }
+    EXPECT_EQ(map.GetCount(),nVisited);
+}
+
+TEST(SFlatMap, CopyKeepsCollidingKeys)
+{
+    SFlatMap<int,int,SCollideTraits> map;
+    for(int i=0;i<KCollideKeys;i++)
+        map[i] = i;
+    SFlatMap<int,int,SCollideTraits> copy(map);
+    ASSERT_EQ(map.GetCount(),copy.GetCount());
+    for(int i=0;i<KCollideKeys;i++)
+    {
+        int v = -1;
+        ASSERT_TRUE(copy.Lookup(i,v));
+        EXPECT_EQ(i,v);
+    }
+}
@@ -0,0 +1,219 @@
+﻿#include "souistd.h"
+#include "core/SWndContainerImpl.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //没有宿主窗口的窗口容器, 只用来建立窗口树
+    class STestContainer : public SwndContainerImpl
+    {
+    public:
+        virtual BOOL OnFireEvent(EventArgs &evt) {return FALSE;}
+        virtual CRect GetContainerRect() const {return GetWindowRect();}
+        virtual IRenderTarget * OnGetRenderTarget(const CRect & rc,GrtFlag gdcFlags) {return NULL;}
+        virtual void OnReleaseRenderTarget(IRenderTarget *pRT,const CRect &rc,GrtFlag gdcFlags) {}
+        virtual void OnRedraw(const CRect &rc) {}
+        virtual HWND GetHostHwnd() {return NULL;}
+        virtual const SStringW & GetTranslatorContext() const {return m_strTrCtx;}
+        virtual BOOL IsTranslucent() const {return FALSE;}
+        virtual BOOL IsSendWheel2Hover() const {return FALSE;}
+        virtual BOOL UpdateWindow() {return TRUE;}
+        virtual void UpdateTooltip() {}
+        virtual SMessageLoop * GetMsgLoop() {return NULL;}
+        virtual IScriptModule * GetScriptModule() {return NULL;}
+        virtual int GetScale() const {return 100;}
+        virtual void EnableIME(BOOL bEnable) {}
+
+    protected:
+        SStringW m_strTrCtx;
+    };
+
+    //固定种子的随机数, 失败时可以重现
+    class SRandom
+    {
+    public:
+        SRandom(unsigned int nSeed):m_nState(nSeed){}
+        int Next(int nRange)
+        {
+            m_nState = m_nState * 1103515245 + 12345;
+            return nRange > 0 ? (int)((m_nState >> 8) % (unsigned int)nRange) : 0;
+        }
+    private:
+        unsigned int m_nState;
+    };
+
+    enum
+    {
+        kWidth = 400,
+        kHeight = 300,
+        kCellSize = 32,
+    };
+
+    class HitTestGridTest : public ::testing::TestWithParam<int>
+    {
+    protected:
+        HitTestGridTest():m_rnd(GetParam()){}
+
+        virtual void SetUp()
+        {
+            m_pRoot = new STestContainer;
+            CRect rcRoot(0,0,kWidth,kHeight);
+            m_pRoot->Move(&rcRoot);
+            m_pRoot->EnableHitTestGrid(kCellSize);
+            m_arrWnds.Add(m_pRoot->GetSwnd());
+        }
+
+        virtual void TearDown()
+        {
+            m_pRoot->SSendMessage(WM_DESTROY);
+            m_pRoot->Release();
+        }
+
+        //随机取一个还存在的窗口
+        SWindow * RandomWnd(BOOL bIncludeRoot)
+        {
+            for(;;)
+            {
+                int idx = m_rnd.Next((int)m_arrWnds.GetCount());
+                if(!bIncludeRoot && idx == 0) continue;
+                SWindow *pWnd = SWindowMgr::GetWindow(m_arrWnds[idx]);
+                if(pWnd) return pWnd;
+            }
+        }
+
+        //在父窗口内随机取一个位置, 允许超出父窗口
+        CRect RandomRect(SWindow *pParent)
+        {
+            CRect rcParent = pParent->GetWindowRect();
+            int cx = 4 + m_rnd.Next(rcParent.Width()*2/3 + 8);
+            int cy = 4 + m_rnd.Next(rcParent.Height()*2/3 + 8);
+            int x = rcParent.left - 10 + m_rnd.Next(rcParent.Width() + 20);
+            int y = rcParent.top - 10 + m_rnd.Next(rcParent.Height() + 20);
+            return CRect(x,y,x+cx,y+cy);
+        }
+
+        void SetRandomXform(SWindow *pWnd)
+        {
+            SMatrix mtx;
+            switch(m_rnd.Next(3))
+            {
+            case 0: mtx.rotate((float)(m_rnd.Next(90)-45)); break;
+            case 1: mtx.scale(0.5f + m_rnd.Next(10)/10.0f,0.5f + m_rnd.Next(10)/10.0f); break;
+            default: mtx.translate((float)(m_rnd.Next(20)-10),(float)(m_rnd.Next(20)-10)); break;
+            }
+            pWnd->SetMatrix(mtx);
+        }
+
+        void SetRandomRgn(SWindow *pWnd)
+        {
+            CRect rcWnd = pWnd->GetWindowRect();
+            SAutoRefPtr<IRegion> rgn;
+            GETRENDERFACTORY->CreateRegion(&rgn);
+            //窗口区域使用窗口坐标, 左上角为原点
+            CRect rcRgn(0,0,rcWnd.Width(),rcWnd.Height());
+            rgn->CombineEllipse(&rcRgn,RGN_COPY);
+            pWnd->SetWindowRgn(rgn,FALSE);
+        }
+
+        SWindow * AddRandomWnd()
+        {
+            SWindow *pParent = RandomWnd(TRUE);
+            SWindow *pWnd = new SWindow;
+            pParent->InsertChild(pWnd);
+            int nFlag = m_rnd.Next(100);
+            if(nFlag < 10)
+                pWnd->SetAttribute(L"margin",L"3",TRUE);
+            CRect rc = RandomRect(pParent);
+            pWnd->Move(&rc);
+            if(nFlag >= 10 && nFlag < 20)
+                pWnd->SetAttribute(L"msgTransparent",L"1",TRUE);
+            else if(nFlag >= 20 && nFlag < 26)
+                pWnd->SetVisible(FALSE);
+            else if(nFlag >= 26 && nFlag < 31)
+                SetRandomXform(pWnd);
+            else if(nFlag >= 31 && nFlag < 35)
+                SetRandomRgn(pWnd);
+            m_arrWnds.Add(pWnd->GetSwnd());
+            return pWnd;
+        }
+
+        //网格索引和遍历窗口树的结果逐点比较
+        void ExpectSameHits(const char *pszStage)
+        {
+            for(int y=-4;y<kHeight+4;y+=3)
+            for(int x=-4;x<kWidth+4;x+=3)
+            for(int i=0;i<2;i++)
+            {
+                bool bIncludeMsgTransparent = i == 1;
+                CPoint ptTree(x,y),ptGrid(x,y);
+                SWND swndTree = m_pRoot->SWindow::SwndFromPoint(ptTree,bIncludeMsgTransparent);
+                SWND swndGrid = m_pRoot->SwndFromPoint(ptGrid,bIncludeMsgTransparent);
+                ASSERT_EQ(swndTree,swndGrid) << pszStage << " seed " << GetParam()
+                    << " pt (" << x << "," << y << ") msgTransparent " << bIncludeMsgTransparent;
+                ASSERT_EQ(ptTree.x,ptGrid.x) << pszStage << " pt (" << x << "," << y << ")";
+                ASSERT_EQ(ptTree.y,ptGrid.y) << pszStage << " pt (" << x << "," << y << ")";
+            }
+        }
+
+        SRandom          m_rnd;
+        STestContainer * m_pRoot;
+        SArray<SWND>     m_arrWnds;
+    };
+}
+
+TEST_P(HitTestGridTest, MatchesTreeWalk)
+{
+    for(int i=0;i<150;i++)
+        AddRandomWnd();
+    ExpectSameHits("build");
+    if(HasFatalFailure()) return;
+
+    const SHitTestGrid::HitStats & stats = m_pRoot->GetHitTestGrid()->GetStats();
+    EXPECT_GT(stats.nQueries,0u);
+    EXPECT_EQ(1u,stats.nRebuilds);
+
+    //移动窗口只更新该窗口的登记
+    for(int i=0;i<40;i++)
+    {
+        SWindow *pWnd = RandomWnd(FALSE);
+        CRect rc = RandomRect(pWnd->GetParent());
+        pWnd->Move(&rc);
+    }
+    ExpectSameHits("move");
+    if(HasFatalFailure()) return;
+
+    for(int i=0;i<15;i++)
+    {
+        SWindow *pWnd = RandomWnd(FALSE);
+        pWnd->SetVisible(!pWnd->IsVisible(FALSE));
+    }
+    ExpectSameHits("visibility");
+    if(HasFatalFailure()) return;
+
+    for(int i=0;i<15;i++)
+    {
+        SWindow *pWnd = RandomWnd(FALSE);
+        switch(m_rnd.Next(4))
+        {
+        case 0: SetRandomXform(pWnd); break;
+        case 1: pWnd->SetMatrix(SMatrix()); break;
+        case 2: SetRandomRgn(pWnd); break;
+        default: pWnd->SetWindowRgn(NULL,FALSE); break;
+        }
+    }
+    ExpectSameHits("xform");
+    if(HasFatalFailure()) return;
+
+    for(int i=0;i<10;i++)
+    {
+        SWindow *pWnd = RandomWnd(FALSE);
+        pWnd->GetParent()->DestroyChild(pWnd);
+    }
+    for(int i=0;i<30;i++)
+        AddRandomWnd();
+    ExpectSameHits("insert and destroy");
+}
+
+INSTANTIATE_TEST_CASE_P(Seeds, HitTestGridTest, ::testing::Values(1,2,3,4,5,6));
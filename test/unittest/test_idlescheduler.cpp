@@ -0,0 +1,334 @@
+﻿#include "souistd.h"
+#include "core/SMsgLoop.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //每次调用记录一次, 调用nUnits次后完成
+    class RecordTask : public IIdleTask
+    {
+    public:
+        RecordTask(int id,SArray<int> *pOrder,int nUnits)
+            :m_id(id),m_pOrder(pOrder),m_nUnits(nUnits),m_nCalls(0)
+        {
+        }
+
+        virtual BOOL RunIdle(const SIdleDeadline & deadline)
+        {
+            m_pOrder->Add(m_id);
+            return ++m_nCalls < m_nUnits;
+        }
+
+        int m_id;
+        SArray<int> *m_pOrder;
+        int m_nUnits;
+        int m_nCalls;
+    };
+
+    //一直工作到截止时间, 记录截止时间的状态
+    class BusyTask : public IIdleTask
+    {
+    public:
+        BusyTask(SArray<int> *pOrder = NULL,int id = 0,int nUnits = 0x7fffffff)
+            :m_pOrder(pOrder),m_id(id),m_nUnits(nUnits),m_nCalls(0)
+            ,m_dwRemaining(0),m_dwElapsed(0),m_bTimeout(FALSE)
+        {
+        }
+
+        virtual BOOL RunIdle(const SIdleDeadline & deadline)
+        {
+            if(m_pOrder) m_pOrder->Add(m_id);
+            m_bTimeout = deadline.DidTimeout();
+            m_dwRemaining = deadline.TimeRemaining();
+            DWORD dwStart = GetTickCount();
+            while(!deadline.ShouldYield())
+                ;
+            m_dwElapsed = GetTickCount() - dwStart;
+            return ++m_nCalls < m_nUnits;
+        }
+
+        SArray<int> *m_pOrder;
+        int m_id;
+        int m_nUnits;
+        int m_nCalls;
+        DWORD m_dwRemaining;
+        DWORD m_dwElapsed;
+        BOOL  m_bTimeout;
+    };
+
+    void ExpectOrder(const SArray<int> & order,const int *pExpect,int nExpect)
+    {
+        ASSERT_EQ((size_t)nExpect,order.GetCount());
+        for(int i=0;i<nExpect;i++)
+            EXPECT_EQ(pExpect[i],order[i]) << "call " << i;
+    }
+}
+
+TEST(IdleSchedulerTest, AddRemove)
+{
+    SArray<int> order;
+    RecordTask task(0,&order,1);
+    SIdleScheduler sched;
+    EXPECT_FALSE(sched.HasTask());
+    EXPECT_TRUE(sched.AddTask(&task));
+    EXPECT_FALSE(sched.AddTask(&task));
+    EXPECT_TRUE(sched.HasTask());
+    EXPECT_TRUE(sched.RemoveTask(&task));
+    EXPECT_FALSE(sched.RemoveTask(&task));
+    EXPECT_FALSE(sched.RunIdle());
+    EXPECT_EQ(0u,order.GetCount());
+}
+
+TEST(IdleSchedulerTest, RoundRobin)
+{
+    SArray<int> order;
+    RecordTask t0(0,&order,3),t1(1,&order,1),t2(2,&order,3);
+    SIdleScheduler sched;
+    sched.SetSliceTime(1000);
+    sched.AddTask(&t0);
+    sched.AddTask(&t1);
+    sched.AddTask(&t2);
+
+    //一个时间片内轮流调用, 完成的任务被移出
+    EXPECT_FALSE(sched.RunIdle());
+    const int kExpect[] = {0,1,2,0,2,0,2};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+    EXPECT_FALSE(sched.HasTask());
+    EXPECT_EQ(1u,sched.GetStats().nSlices);
+    EXPECT_EQ(7u,sched.GetStats().nRuns);
+}
+
+TEST(IdleSchedulerTest, NextSliceStartsAfterLastTask)
+{
+    SArray<int> order;
+    BusyTask t0(&order,0),t1(&order,1),t2(&order,2);
+    SIdleScheduler sched;
+    sched.SetSliceTime(10);
+    sched.AddTask(&t0);
+    sched.AddTask(&t1);
+    sched.AddTask(&t2);
+
+    //每个任务用完整个时间片, 下个时间片从下一个任务开始
+    for(int i=0;i<4;i++)
+        EXPECT_TRUE(sched.RunIdle());
+    const int kExpect[] = {0,1,2,0};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+
+    //移除当前任务之前的任务不影响轮转
+    EXPECT_TRUE(sched.RemoveTask(&t0));
+    EXPECT_TRUE(sched.RunIdle());
+    EXPECT_EQ(1,order[order.GetCount()-1]);
+}
+
+TEST(IdleSchedulerTest, Deadline)
+{
+    const DWORD kSlice = 30;
+    BusyTask task(NULL,0,1);
+    SIdleScheduler sched;
+    sched.SetSliceTime(kSlice);
+    sched.AddTask(&task);
+
+    EXPECT_FALSE(sched.RunIdle());
+    EXPECT_FALSE(task.m_bTimeout);
+    EXPECT_LE(task.m_dwRemaining,kSlice);
+    EXPECT_GT(task.m_dwRemaining,0u);
+    //GetTickCount精度约16毫秒
+    EXPECT_GE(task.m_dwElapsed + 16,kSlice);
+    EXPECT_LT(task.m_dwElapsed,kSlice + 200);
+
+    const SIdleScheduler::IdleStats & stats = sched.GetStats();
+    EXPECT_EQ(1u,stats.nSlices);
+    EXPECT_EQ(1u,stats.nRuns);
+    EXPECT_EQ(0u,stats.nInputYields);
+    EXPECT_EQ((ULONGLONG)kSlice*1000,stats.ullGranted);
+    EXPECT_GE(stats.ullUsed + 16000,(ULONGLONG)kSlice*1000);
+
+    sched.ResetStats();
+    EXPECT_EQ(0u,sched.GetStats().nSlices);
+}
+
+TEST(IdleSchedulerTest, Timeout)
+{
+    SArray<int> order;
+    BusyTask task(&order,0);
+    SIdleScheduler sched;
+    DWORD dwTimeoutAt = 0;
+    EXPECT_FALSE(sched.GetNextTimeout(dwTimeoutAt));
+
+    DWORD dwAdd = GetTickCount();
+    sched.AddTask(&task,20);
+    ASSERT_TRUE(sched.GetNextTimeout(dwTimeoutAt));
+    //GetTickCount可能在两次调用之间跳变
+    EXPECT_GE(dwTimeoutAt - dwAdd,20u);
+    EXPECT_LE(dwTimeoutAt - dwAdd,20u + 16);
+
+    //没有超时不调用
+    sched.RunExpired();
+    EXPECT_EQ(0u,order.GetCount());
+
+    Sleep(40);
+    sched.RunExpired();
+    ASSERT_EQ(1u,order.GetCount());
+    EXPECT_TRUE(task.m_bTimeout);
+    EXPECT_EQ(0u,task.m_dwRemaining);
+    EXPECT_EQ(1u,sched.GetStats().nTimeouts);
+
+    //超时只保证调用一次, 之后任务只在空闲时执行
+    EXPECT_FALSE(sched.GetNextTimeout(dwTimeoutAt));
+    Sleep(40);
+    sched.RunExpired();
+    EXPECT_EQ(1u,order.GetCount());
+    EXPECT_TRUE(sched.HasTask());
+}
+
+TEST(IdleSchedulerTest, NextTimeoutIsEarliest)
+{
+    SArray<int> order;
+    RecordTask t0(0,&order,1),t1(1,&order,1),t2(2,&order,1);
+    SIdleScheduler sched;
+    DWORD dwNow = GetTickCount();
+    sched.AddTask(&t0,500);
+    sched.AddTask(&t1,100);
+    sched.AddTask(&t2);
+    DWORD dwTimeoutAt = 0;
+    ASSERT_TRUE(sched.GetNextTimeout(dwTimeoutAt));
+    EXPECT_GE(dwTimeoutAt - dwNow,100u);
+    EXPECT_LE(dwTimeoutAt - dwNow,100u + 16);
+
+    //在空闲时执行过的任务不再参与超时
+    sched.SetSliceTime(1000);
+    EXPECT_FALSE(sched.RunIdle());
+    EXPECT_FALSE(sched.GetNextTimeout(dwTimeoutAt));
+}
+
+namespace
+{
+    class TestLoop : public SMessageLoop
+    {
+    public:
+        TestLoop():m_bRunScheduler(TRUE),m_nOnIdle(0),m_nIdleTrue(0)
+        {
+        }
+
+        virtual BOOL OnIdle(int nIdleCount)
+        {
+            m_nOnIdle ++;
+            BOOL bRet = m_bRunScheduler?SMessageLoop::OnIdle(nIdleCount):FALSE;
+            if(bRet) m_nIdleTrue ++;
+            return bRet;
+        }
+
+        BOOL m_bRunScheduler;
+        int  m_nOnIdle;
+        int  m_nIdleTrue;
+    };
+
+    class CountIdleHandler : public IIdleHandler
+    {
+    public:
+        CountIdleHandler():m_nCalls(0){}
+        virtual BOOL OnIdle()
+        {
+            m_nCalls ++;
+            return TRUE;
+        }
+        int m_nCalls;
+    };
+
+    //完成后退出消息循环
+    class QuitTask : public BusyTask
+    {
+    public:
+        QuitTask(SMessageLoop *pLoop,int nUnits):BusyTask(NULL,0,nUnits),m_pLoop(pLoop)
+        {
+        }
+
+        virtual BOOL RunIdle(const SIdleDeadline & deadline)
+        {
+            BOOL bMore = BusyTask::RunIdle(deadline);
+            if(!bMore)
+            {
+                m_pLoop->Quit();
+                PostQuitMessage(0);
+            }
+            return bMore;
+        }
+
+        SMessageLoop *m_pLoop;
+    };
+
+    void CALLBACK WatchdogProc(HWND,UINT,UINT_PTR,DWORD)
+    {
+        PostQuitMessage(1);
+    }
+
+    struct LoopParam
+    {
+        SMessageLoop *pLoop;
+        int nRet;
+    };
+
+    DWORD WINAPI LoopProc(LPVOID p)
+    {
+        LoopParam *param = (LoopParam*)p;
+        //出错时不会一直阻塞
+        UINT_PTR uWatchdog = SetTimer(NULL,0,3000,WatchdogProc);
+        param->nRet = param->pLoop->Run();
+        KillTimer(NULL,uWatchdog);
+        return 0;
+    }
+
+    //在新线程中运行消息循环, 不受测试线程消息队列的影响
+    int RunLoopInThread(SMessageLoop *pLoop)
+    {
+        LoopParam param = {pLoop,-1};
+        HANDLE hThread = CreateThread(NULL,0,LoopProc,&param,0,NULL);
+        if(!hThread) return -1;
+        WaitForSingleObject(hThread,INFINITE);
+        CloseHandle(hThread);
+        return param.nRet;
+    }
+}
+
+TEST(IdleSchedulerTest, LoopRunsOneSlicePerIdle)
+{
+    TestLoop loop;
+    CountIdleHandler handler;
+    loop.AddIdleHandler(&handler);
+    loop.GetIdleScheduler().SetSliceTime(10);
+    QuitTask task(&loop,3);
+    EXPECT_TRUE(loop.AddIdleTask(&task));
+
+    RunLoopInThread(&loop);
+
+    //每个时间片后OnIdle返回FALSE, 由投递的消息继续空闲处理
+    EXPECT_EQ(3,task.m_nCalls);
+    EXPECT_EQ(3,loop.m_nOnIdle);
+    EXPECT_EQ(0,loop.m_nIdleTrue);
+    //继续空闲处理不是新的空闲期, idle handler只调用一次
+    EXPECT_EQ(1,handler.m_nCalls);
+    EXPECT_EQ(3u,loop.GetIdleScheduler().GetStats().nSlices);
+}
+
+TEST(IdleSchedulerTest, LoopTimerRunsExpiredTask)
+{
+    TestLoop loop;
+    //不执行空闲任务, 任务只能因为超时被调用
+    loop.m_bRunScheduler = FALSE;
+    QuitTask task(&loop,1);
+    EXPECT_TRUE(loop.AddIdleTask(&task,30));
+
+    DWORD dwStart = GetTickCount();
+    int nRet = RunLoopInThread(&loop);
+    DWORD dwElapsed = GetTickCount() - dwStart;
+
+    //队列中没有消息, 由定时器唤醒消息循环, 不是看门狗
+    EXPECT_NE(1,nRet);
+    EXPECT_EQ(1,task.m_nCalls);
+    EXPECT_TRUE(task.m_bTimeout);
+    EXPECT_GE(dwElapsed + 16,30u);
+    EXPECT_LT(dwElapsed,1000u);
+    EXPECT_EQ(1u,loop.GetIdleScheduler().GetStats().nTimeouts);
+}
@@ -0,0 +1,111 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_imgdecoder_png|scom_mask_imgdecoder_stb
+#include <commgr2.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+using namespace SOUI;
+
+namespace
+{
+    //3x2的RGBA图片, 第一行为不透明的红绿蓝, 第二行为全透明白色, 半透明(128,64,32,128)及不透明(10,20,30)
+    const unsigned char kPng[] = {
+        0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a,0x00,0x00,0x00,0x0d,0x49,0x48,0x44,0x52,
+        0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x02,0x08,0x06,0x00,0x00,0x00,0x9d,0x74,0x66,
+        0x1a,0x00,0x00,0x00,0x1c,0x49,0x44,0x41,0x54,0x78,0xda,0x63,0xf8,0xcf,0xc0,0xf0,
+        0x1f,0x0c,0x19,0xfe,0x03,0x49,0x20,0x6e,0x70,0x50,0x68,0xe0,0x12,0x91,0xfb,0x0f,
+        0x00,0x9d,0x26,0x0b,0x93,0xec,0xf6,0x75,0xfc,0x00,0x00,0x00,0x00,0x49,0x45,0x4e,
+        0x44,0xae,0x42,0x60,0x82,
+    };
+    const UINT kWid = 3;
+    const UINT kHei = 2;
+
+    DWORD BGRA(BYTE r,BYTE g,BYTE b,BYTE a)
+    {
+        return ((DWORD)a<<24)|((DWORD)r<<16)|((DWORD)g<<8)|b;
+    }
+
+    class ImgDecoderTest : public ::testing::TestWithParam<LPCTSTR>
+    {
+    protected:
+        virtual void SetUp()
+        {
+            SComMgr2 comMgr(GetParam());
+            comMgr.CreateImgDecoder((IObjRef**)&m_factory);
+        }
+
+        BOOL Load(IImgX **ppImg)
+        {
+            if(!m_factory || !m_factory->CreateImgX(ppImg)) return FALSE;
+            return (*ppImg)->LoadFromMemory((void*)kPng,sizeof(kPng)) > 0;
+        }
+
+        SAutoRefPtr<IImgDecoderFactory> m_factory;
+    };
+}
+
+//DecodeInto按调用者的stride写入预乘的BGRA像素, 行尾的填充字节保持不变
+TEST_P(ImgDecoderTest, DecodeIntoPaddedStride)
+{
+    SAutoRefPtr<IImgX> img;
+    ASSERT_TRUE(Load(&img));
+    const UINT cbStride = kWid*4 + 8;
+    std::vector<BYTE> buf(cbStride*kHei,0xcd);
+    ASSERT_TRUE(img->DecodeInto(0,cbStride,(UINT)buf.size(),&buf[0]));
+
+    const DWORD *pRow0 = (const DWORD*)&buf[0];
+    const DWORD *pRow1 = (const DWORD*)&buf[cbStride];
+    EXPECT_EQ(BGRA(255,0,0,255),pRow0[0]);
+    EXPECT_EQ(BGRA(0,255,0,255),pRow0[1]);
+    EXPECT_EQ(BGRA(0,0,255,255),pRow0[2]);
+    EXPECT_EQ(0u,pRow1[0]);
+    EXPECT_EQ(BGRA(10,20,30,255),pRow1[2]);
+    //半透明像素的颜色按alpha预乘, 允许1的舍入误差
+    DWORD crHalf = pRow1[1];
+    EXPECT_EQ(128u,crHalf>>24);
+    EXPECT_NEAR(128*128/255,(int)((crHalf>>16)&0xff),1);
+    EXPECT_NEAR(64*128/255,(int)((crHalf>>8)&0xff),1);
+    EXPECT_NEAR(32*128/255,(int)(crHalf&0xff),1);
+    for(UINT i=kWid*4;i<cbStride;i++)
+    {
+        EXPECT_EQ(0xcd,buf[i]) << "padding " << i;
+    }
+}
+
+//DecodeInto与CopyPixels的结果必须一致, 包括帧已经被缓存后的复制路径
+TEST_P(ImgDecoderTest, DecodeIntoMatchesCopyPixels)
+{
+    SAutoRefPtr<IImgX> img;
+    ASSERT_TRUE(Load(&img));
+    const UINT cbRow = kWid*4;
+    std::vector<BYTE> bufDecode(cbRow*kHei),bufCopy(cbRow*kHei),bufCached(cbRow*kHei);
+    ASSERT_TRUE(img->DecodeInto(0,cbRow,(UINT)bufDecode.size(),&bufDecode[0]));
+
+    IImgFrame *pFrame = img->GetFrame(0);
+    ASSERT_TRUE(pFrame != NULL);
+    UINT nWid=0,nHei=0;
+    pFrame->GetSize(&nWid,&nHei);
+    ASSERT_EQ(kWid,nWid);
+    ASSERT_EQ(kHei,nHei);
+    ASSERT_TRUE(pFrame->CopyPixels(NULL,cbRow,(UINT)bufCopy.size(),&bufCopy[0]));
+    EXPECT_EQ(0,memcmp(&bufDecode[0],&bufCopy[0],bufCopy.size()));
+
+    ASSERT_TRUE(img->DecodeInto(0,cbRow,(UINT)bufCached.size(),&bufCached[0]));
+    EXPECT_EQ(0,memcmp(&bufDecode[0],&bufCached[0],bufCached.size()));
+}
+
+//非法参数返回FALSE, 调用者据此回退到CopyPixels
+TEST_P(ImgDecoderTest, DecodeIntoRejectsBadArguments)
+{
+    SAutoRefPtr<IImgX> img;
+    ASSERT_TRUE(Load(&img));
+    const UINT cbRow = kWid*4;
+    std::vector<BYTE> buf(cbRow*kHei);
+    EXPECT_FALSE(img->DecodeInto(img->GetFrameCount(),cbRow,(UINT)buf.size(),&buf[0]));
+    EXPECT_FALSE(img->DecodeInto(0,cbRow-4,(UINT)buf.size(),&buf[0]));
+    EXPECT_FALSE(img->DecodeInto(0,cbRow,(UINT)buf.size()-1,&buf[0]));
+}
+
+INSTANTIATE_TEST_CASE_P(Decoders, ImgDecoderTest,
+    ::testing::Values(_T("imgdecoder-png"),_T("imgdecoder-stb")));
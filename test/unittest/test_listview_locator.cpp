@@ -0,0 +1,143 @@
+﻿#include "souistd.h"
+#include "helper/SListViewItemLocator.h"
+#include "helper/SAdapterBase.h"
+#include <gtest/gtest.h>
+#include <vector>
+#include <stdlib.h>
+
+using namespace SOUI;
+
+namespace
+{
+    class STestLvAdapter : public SAdapterBase
+    {
+    public:
+        STestLvAdapter(int nCount):m_nCount(nCount){}
+
+        virtual int getCount(){return m_nCount;}
+        virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate){}
+
+        int m_nCount;
+    };
+
+    const int kDefHei = 20;
+    const int kDivider = 1;
+
+    //和逐项累加的结果比较
+    void VerifyLocator(SListViewItemLocatorFlex *pLocator,const std::vector<int> & heights)
+    {
+        int nPos = 0;
+        for(size_t i=0;i<heights.size();i++)
+        {
+            ASSERT_EQ(nPos,pLocator->Item2Position((int)i));
+            ASSERT_EQ(heights[i],pLocator->GetItemHeight((int)i));
+            ASSERT_EQ((int)i,pLocator->Position2Item(nPos));
+            ASSERT_EQ((int)i,pLocator->Position2Item(nPos+heights[i]-1));
+            nPos += heights[i] + kDivider;
+        }
+        ASSERT_EQ(heights.empty()?0:nPos-kDivider,pLocator->GetTotalHeight());
+    }
+}
+
+TEST(SListViewItemLocatorFlex, RandomEdits)
+{
+    SAutoRefPtr<STestLvAdapter> adapter;
+    adapter.Attach(new STestLvAdapter(700));
+    SAutoRefPtr<SListViewItemLocatorFlex> locator;
+    locator.Attach(new SListViewItemLocatorFlex(SLayoutSize((float)kDefHei),SLayoutSize((float)kDivider)));
+    locator->SetAdapter(adapter);
+    std::vector<int> heights(700,kDefHei);
+
+    srand(1);
+    for(int i=0;i<20000;i++)
+    {
+        int nItems = (int)heights.size();
+        int nOp = rand()%8;
+        //偶尔插入/删除跨越多个块的大段表项
+        int nRange = (rand()%8==0)?rand()%1500+1:rand()%3+1;
+        if(nOp<3 && nItems>0)
+        {
+            int iItem = rand()%nItems;
+            int nHei = rand()%50+1;
+            locator->SetItemHeight(iItem,nHei);
+            heights[iItem] = nHei;
+        }else if(nOp<5)
+        {
+            int iItem = rand()%(nItems+1);
+            heights.insert(heights.begin()+iItem,nRange,kDefHei);
+            adapter->m_nCount = (int)heights.size();
+            locator->OnItemRangeInserted(iItem,nRange);
+        }else if(nOp<7 && nItems>0)
+        {
+            int iItem = rand()%nItems;
+            nRange = smin(nRange,nItems-iItem);
+            heights.erase(heights.begin()+iItem,heights.begin()+iItem+nRange);
+            adapter->m_nCount = (int)heights.size();
+            locator->OnItemRangeRemoved(iItem,nRange);
+        }else if(nItems>2)
+        {
+            nRange = rand()%smin(nItems/2,600)+1;
+            int iFrom = rand()%(nItems-nRange+1);
+            int iTo = rand()%(nItems-nRange+1);
+            std::vector<int> moved(heights.begin()+iFrom,heights.begin()+iFrom+nRange);
+            heights.erase(heights.begin()+iFrom,heights.begin()+iFrom+nRange);
+            heights.insert(heights.begin()+iTo,moved.begin(),moved.end());
+            locator->OnItemRangeMoved(iFrom,iTo,nRange);
+        }
+        if(i%500==0)
+        {
+            VerifyLocator(locator,heights);
+            if(HasFatalFailure()) return;
+        }
+    }
+    VerifyLocator(locator,heights);
+}
+
+TEST(SListViewItemLocatorFlex, DataSetChangedKeepsHeights)
+{
+    SAutoRefPtr<STestLvAdapter> adapter;
+    adapter.Attach(new STestLvAdapter(1000));
+    SAutoRefPtr<SListViewItemLocatorFlex> locator;
+    locator.Attach(new SListViewItemLocatorFlex(SLayoutSize((float)kDefHei),SLayoutSize((float)kDivider)));
+    locator->SetAdapter(adapter);
+    std::vector<int> heights(1000,kDefHei);
+    srand(2);
+    for(int i=0;i<300;i++)
+    {
+        int iItem = rand()%1000;
+        heights[iItem] = rand()%50+1;
+        locator->SetItemHeight(iItem,heights[iItem]);
+    }
+
+    //数量不变时保留全部高度
+    locator->OnDataSetChanged();
+    VerifyLocator(locator,heights);
+    if(HasFatalFailure()) return;
+
+    //增加的表项追加在尾部, 使用默认高度
+    adapter->m_nCount = 2500;
+    heights.resize(2500,kDefHei);
+    locator->OnDataSetChanged();
+    VerifyLocator(locator,heights);
+    if(HasFatalFailure()) return;
+    locator->SetItemHeight(2400,33);
+    heights[2400] = 33;
+
+    //减少的表项从尾部截断
+    adapter->m_nCount = 600;
+    heights.resize(600);
+    locator->OnDataSetChanged();
+    VerifyLocator(locator,heights);
+    if(HasFatalFailure()) return;
+
+    //内容变化的表项恢复为默认高度
+    locator->OnItemRangeChanged(10,20);
+    for(int i=10;i<30;i++) heights[i] = kDefHei;
+    VerifyLocator(locator,heights);
+    if(HasFatalFailure()) return;
+
+    adapter->m_nCount = 0;
+    locator->OnDataSetChanged();
+    EXPECT_EQ(0,locator->GetTotalHeight());
+    EXPECT_EQ(-1,locator->Position2Item(0));
+}
@@ -0,0 +1,206 @@
+﻿#include "souistd.h"
+#include "event/SNotifyCenter.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    volatile LONG g_nEvtDestroyed = 0;
+
+    SEVENT_BEGIN_EX(EventTestNotify, 0x7f100001, on_test_notify, EVT_EXP)
+        int nValue;
+        ~EventTestNotify(){InterlockedIncrement(&g_nEvtDestroyed);}
+    SEVENT_END()
+
+    SEVENT_BEGIN_EX(EventTestProgress, 0x7f100002, on_test_progress, EVT_EXP)
+        int nValue;
+        ~EventTestProgress(){InterlockedIncrement(&g_nEvtDestroyed);}
+    SEVENT_END()
+
+    struct EvtRecord
+    {
+        int nEventID;
+        int nValue;
+    };
+
+    class EvtRecorder
+    {
+    public:
+        bool OnNotify(EventTestNotify *e)
+        {
+            EvtRecord rec = {e->GetID(),e->nValue};
+            m_records.Add(rec);
+            return true;
+        }
+        bool OnProgress(EventTestProgress *e)
+        {
+            EvtRecord rec = {e->GetID(),e->nValue};
+            m_records.Add(rec);
+            return true;
+        }
+        SArray<EvtRecord> m_records;
+    };
+
+    template<class T>
+    void FireAsync(SNotifyCenter *pCenter,int nValue)
+    {
+        T *e = new T(NULL);
+        e->nValue = nValue;
+        pCenter->FireEventAsync(e);
+        e->Release();
+    }
+
+    void PumpMessages()
+    {
+        MSG msg;
+        while(PeekMessage(&msg,NULL,0,0,PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+
+    class NotifyCenterTest : public ::testing::Test
+    {
+    protected:
+        virtual void SetUp()
+        {
+            g_nEvtDestroyed = 0;
+            //通知中心是单例, 每个用例在测试线程中创建一个
+            m_pCenter = new SNotifyCenter;
+            m_pCenter->addEvent(EVENTID(EventTestNotify));
+            m_pCenter->addEvent(EVENTID(EventTestProgress));
+            m_pCenter->subscribeEvent(&EvtRecorder::OnNotify,&m_recorder);
+            m_pCenter->subscribeEvent(&EvtRecorder::OnProgress,&m_recorder);
+        }
+
+        virtual void TearDown()
+        {
+            delete m_pCenter;
+        }
+
+        SNotifyCenter *m_pCenter;
+        EvtRecorder    m_recorder;
+    };
+
+    struct ProducerParam
+    {
+        SNotifyCenter *pCenter;
+        int iThread;
+        int nEvents;
+    };
+
+    DWORD WINAPI ProducerProc(LPVOID p)
+    {
+        ProducerParam *param = (ProducerParam*)p;
+        for(int i=0;i<param->nEvents;i++)
+            FireAsync<EventTestNotify>(param->pCenter,param->iThread*100000+i);
+        return 0;
+    }
+}
+
+TEST_F(NotifyCenterTest, DeliversInPostOrder)
+{
+    for(int i=0;i<10;i++)
+        FireAsync<EventTestNotify>(m_pCenter,i);
+    //异步事件在消息循环中派发
+    EXPECT_EQ(0u,m_recorder.m_records.GetCount());
+    PumpMessages();
+
+    ASSERT_EQ(10u,m_recorder.m_records.GetCount());
+    for(int i=0;i<10;i++)
+        EXPECT_EQ(i,m_recorder.m_records[i].nValue);
+    EXPECT_EQ(10,g_nEvtDestroyed);
+}
+
+TEST_F(NotifyCenterTest, MultipleProducers)
+{
+    const int kThreads = 4;
+    const int kEvents = 2000;
+    ProducerParam params[kThreads];
+    HANDLE hThreads[kThreads];
+    for(int i=0;i<kThreads;i++)
+    {
+        ProducerParam param = {m_pCenter,i,kEvents};
+        params[i] = param;
+        hThreads[i] = CreateThread(NULL,0,ProducerProc,&params[i],0,NULL);
+        ASSERT_TRUE(hThreads[i] != NULL);
+    }
+    //生产者运行的同时派发
+    while(WaitForMultipleObjects(kThreads,hThreads,TRUE,1) == WAIT_TIMEOUT)
+        PumpMessages();
+    for(int i=0;i<kThreads;i++)
+        CloseHandle(hThreads[i]);
+    PumpMessages();
+
+    ASSERT_EQ((size_t)kThreads*kEvents,m_recorder.m_records.GetCount());
+    //每个生产者的事件保持投递顺序
+    int nNext[kThreads] = {0};
+    for(UINT i=0;i<m_recorder.m_records.GetCount();i++)
+    {
+        int nValue = m_recorder.m_records[i].nValue;
+        int iThread = nValue/100000;
+        ASSERT_TRUE(iThread >= 0 && iThread < kThreads);
+        ASSERT_EQ(nNext[iThread],nValue%100000) << "thread " << iThread;
+        nNext[iThread]++;
+    }
+    EXPECT_EQ(kThreads*kEvents,g_nEvtDestroyed);
+}
+
+TEST_F(NotifyCenterTest, CoalescingKeepsNewest)
+{
+    m_pCenter->SetEventCoalescing(EventTestProgress::EventID,TRUE);
+    FireAsync<EventTestProgress>(m_pCenter,1);
+    FireAsync<EventTestNotify>(m_pCenter,10);
+    FireAsync<EventTestProgress>(m_pCenter,2);
+    FireAsync<EventTestProgress>(m_pCenter,3);
+    FireAsync<EventTestNotify>(m_pCenter,11);
+    PumpMessages();
+
+    //合并的事件在最后一个的位置派发, 其它事件不受影响
+    const EvtRecord kExpect[] = {
+        {EventTestNotify::EventID,10},
+        {EventTestProgress::EventID,3},
+        {EventTestNotify::EventID,11},
+    };
+    ASSERT_EQ(sizeof(kExpect)/sizeof(kExpect[0]),m_recorder.m_records.GetCount());
+    for(UINT i=0;i<m_recorder.m_records.GetCount();i++)
+    {
+        EXPECT_EQ(kExpect[i].nEventID,m_recorder.m_records[i].nEventID) << "event " << i;
+        EXPECT_EQ(kExpect[i].nValue,m_recorder.m_records[i].nValue) << "event " << i;
+    }
+    //被合并掉的事件也被释放
+    EXPECT_EQ(5,g_nEvtDestroyed);
+
+    //关闭合并后逐个派发
+    m_recorder.m_records.RemoveAll();
+    m_pCenter->SetEventCoalescing(EventTestProgress::EventID,FALSE);
+    FireAsync<EventTestProgress>(m_pCenter,4);
+    FireAsync<EventTestProgress>(m_pCenter,5);
+    PumpMessages();
+    ASSERT_EQ(2u,m_recorder.m_records.GetCount());
+    EXPECT_EQ(4,m_recorder.m_records[0].nValue);
+    EXPECT_EQ(5,m_recorder.m_records[1].nValue);
+}
+
+TEST_F(NotifyCenterTest, UnregisteredEventIsReleased)
+{
+    m_pCenter->removeEvent(EventTestNotify::EventID);
+    FireAsync<EventTestNotify>(m_pCenter,1);
+    PumpMessages();
+    EXPECT_EQ(0u,m_recorder.m_records.GetCount());
+    EXPECT_EQ(1,g_nEvtDestroyed);
+}
+
+TEST_F(NotifyCenterTest, PendingEventsReleasedOnDestroy)
+{
+    FireAsync<EventTestNotify>(m_pCenter,1);
+    FireAsync<EventTestNotify>(m_pCenter,2);
+    delete m_pCenter;
+    m_pCenter = NULL;
+    EXPECT_EQ(2,g_nEvtDestroyed);
+    //清除投递给已经销毁的接收窗口的消息
+    PumpMessages();
+    EXPECT_EQ(0u,m_recorder.m_records.GetCount());
+}
@@ -0,0 +1,339 @@
+﻿#include "souistd.h"
+#include "core/SWndContainerImpl.h"
+#include "core/SSkin.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //没有宿主窗口的窗口容器, 只用来建立窗口树
+    class STestContainer : public SwndContainerImpl
+    {
+    public:
+        virtual BOOL OnFireEvent(EventArgs &evt) {return FALSE;}
+        virtual CRect GetContainerRect() const {return GetWindowRect();}
+        virtual IRenderTarget * OnGetRenderTarget(const CRect & rc,GrtFlag gdcFlags) {return NULL;}
+        virtual void OnReleaseRenderTarget(IRenderTarget *pRT,const CRect &rc,GrtFlag gdcFlags) {}
+        virtual void OnRedraw(const CRect &rc) {}
+        virtual HWND GetHostHwnd() {return NULL;}
+        virtual const SStringW & GetTranslatorContext() const {return m_strTrCtx;}
+        virtual BOOL IsTranslucent() const {return FALSE;}
+        virtual BOOL IsSendWheel2Hover() const {return FALSE;}
+        virtual BOOL UpdateWindow() {return TRUE;}
+        virtual void UpdateTooltip() {}
+        virtual SMessageLoop * GetMsgLoop() {return NULL;}
+        virtual IScriptModule * GetScriptModule() {return NULL;}
+        virtual int GetScale() const {return 100;}
+        virtual void EnableIME(BOOL bEnable) {}
+
+        using SWindow::_GetOccludedChildren;
+
+    protected:
+        SStringW m_strTrCtx;
+    };
+
+    //可以直接设置背景皮肤的窗口
+    class STestWnd : public SWindow
+    {
+    public:
+        void SetBkgndSkin(ISkinObj *pSkin) {m_pBgSkin = pSkin;}
+        UINT GetZorder() const {return m_uZorder;}
+    };
+
+    class OcclusionTest : public ::testing::Test
+    {
+    protected:
+        virtual void SetUp()
+        {
+            m_pRoot = new STestContainer;
+            CRect rcRoot(0,0,400,300);
+            m_pRoot->Move(&rcRoot);
+        }
+
+        virtual void TearDown()
+        {
+            m_pRoot->SSendMessage(WM_DESTROY);
+            m_pRoot->Release();
+        }
+
+        //后插入的窗口在上面
+        STestWnd * AddWnd(int l,int t,int r,int b,LPCWSTR pszBkgnd = NULL)
+        {
+            STestWnd *pWnd = new STestWnd;
+            m_pRoot->InsertChild(pWnd);
+            if(pszBkgnd) pWnd->SetAttribute(L"colorBkgnd",pszBkgnd,TRUE);
+            CRect rc(l,t,r,b);
+            pWnd->Move(&rc);
+            return pWnd;
+        }
+
+        void GetOccluded(SArray<SWindow*> & arrOccluded,IRegion *pRgn = NULL,UINT iBeginZorder = 0,UINT iEndZorder = ZORDER_MAX)
+        {
+            m_pRoot->BuildWndTreeZorder();
+            m_pRoot->_GetOccludedChildren(pRgn,iBeginZorder,iEndZorder,arrOccluded);
+        }
+
+        BOOL IsOccluded(SWindow *pWnd,IRegion *pRgn = NULL)
+        {
+            SArray<SWindow*> arrOccluded;
+            GetOccluded(arrOccluded,pRgn);
+            for(size_t i = 0; i < arrOccluded.GetCount(); i++)
+            {
+                if(arrOccluded[i] == pWnd) return TRUE;
+            }
+            return FALSE;
+        }
+
+        //用纯色皮肤做背景
+        void SetColorSkin(STestWnd *pWnd,LPCWSTR pszNormal,LPCWSTR pszAttr = NULL,LPCWSTR pszValue = NULL)
+        {
+            SAutoRefPtr<SSkinColorRect> pSkin;
+            pSkin.Attach(new SSkinColorRect);
+            pSkin->SetAttribute(L"normal",pszNormal,TRUE);
+            if(pszAttr) pSkin->SetAttribute(pszAttr,pszValue,TRUE);
+            pWnd->SetBkgndSkin(pSkin);
+        }
+
+        //用4x4的图片做背景, crHole为(1,1)点的颜色
+        SAutoRefPtr<SSkinImgList> SetImageSkin(STestWnd *pWnd,COLORREF crHole)
+        {
+            DWORD pixels[16];
+            for(int i = 0; i < 16; i++) pixels[i] = 0xFF336699;
+            pixels[5] = crHole;
+            SAutoRefPtr<IBitmap> pBmp;
+            GETRENDERFACTORY->CreateBitmap(&pBmp);
+            pBmp->Init(4,4,pixels);
+
+            SAutoRefPtr<SSkinImgList> pSkin;
+            pSkin.Attach(new SSkinImgList);
+            pSkin->SetImage(pBmp);
+            pWnd->SetBkgndSkin(pSkin);
+            return pSkin;
+        }
+
+        STestContainer *m_pRoot;
+    };
+}
+
+TEST_F(OcclusionTest, OpaqueBkgndColorOccludes)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(10,10,130,130,L"#00ff00ff");
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, AlphaBkgndColorDoesNotOcclude)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(10,10,130,130,L"#00ff0080");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //没有背景色的窗口什么也不画
+    AddWnd(10,10,130,130);
+    EXPECT_FALSE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, NoBlendBackgroundOccludes)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = AddWnd(10,10,130,130);
+    EXPECT_FALSE(IsOccluded(pBottom));
+    //不混合背景的窗口保证自己画满客户区
+    pTop->SetAttribute(L"blendBackground",L"0",TRUE);
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, ColorRectSkin)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = AddWnd(10,10,130,130);
+
+    SetColorSkin(pTop,L"#0000ffff");
+    EXPECT_TRUE(IsOccluded(pBottom));
+
+    //皮肤颜色半透明
+    SetColorSkin(pTop,L"#0000ff80");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //皮肤整体透明度
+    SetColorSkin(pTop,L"#0000ffff",L"alpha",L"128");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //圆角外面没有绘制
+    SetColorSkin(pTop,L"#0000ffff",L"cornerRadius",L"4");
+    EXPECT_FALSE(IsOccluded(pBottom));
+    SetColorSkin(pTop,L"#0000ffff",L"cornerPercent",L"0.2");
+    EXPECT_FALSE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, ImageSkin)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = AddWnd(10,10,130,130);
+
+    SAutoRefPtr<SSkinImgList> pSkin = SetImageSkin(pTop,0xFF336699);
+    EXPECT_TRUE(IsOccluded(pBottom));
+
+    //不拉伸时图片不能画满客户区
+    pSkin->SetAttribute(L"autoFit",L"0",TRUE);
+    EXPECT_FALSE(IsOccluded(pBottom));
+    pSkin->SetAttribute(L"autoFit",L"1",TRUE);
+    pSkin->SetAttribute(L"tile",L"1",TRUE);
+    EXPECT_TRUE(IsOccluded(pBottom));
+
+    pSkin->SetAttribute(L"alpha",L"254",TRUE);
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //有一个像素透明
+    SetImageSkin(pTop,0x00000000);
+    EXPECT_FALSE(IsOccluded(pBottom));
+    SetImageSkin(pTop,0xFE336699);
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //换成不透明的图片后重新检查
+    pSkin = SetImageSkin(pTop,0x00000000);
+    EXPECT_FALSE(IsOccluded(pBottom));
+    DWORD pixels[16];
+    for(int i = 0; i < 16; i++) pixels[i] = 0xFF000000;
+    SAutoRefPtr<IBitmap> pBmp;
+    GETRENDERFACTORY->CreateBitmap(&pBmp);
+    pBmp->Init(4,4,pixels);
+    pSkin->SetImage(pBmp);
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, SiblingsCoverTogether)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(0,0,200,70,L"#00ff00ff");
+    AddWnd(0,70,200,200,L"#0000ffff");
+    //任何一个都不能单独覆盖, 合起来可以
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, SiblingsWithGap)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(0,0,200,70,L"#00ff00ff");
+    AddWnd(0,71,200,200,L"#0000ffff");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //中间的缝被一个半透明窗口盖住也不行
+    AddWnd(0,60,200,80,L"#0000ff80");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //补上不透明的窗口后可以
+    AddWnd(0,69,200,72,L"#000000ff");
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, CoverWithMatrixOrClipDoesNotOcclude)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = AddWnd(10,10,130,130,L"#00ff00ff");
+    ASSERT_TRUE(IsOccluded(pBottom));
+
+    //有变换时实际位置和窗口矩形不一致
+    pTop->SetMatrix(SMatrix().scale(0.5f,0.5f));
+    EXPECT_FALSE(IsOccluded(pBottom));
+    pTop->SetMatrix(SMatrix());
+    ASSERT_TRUE(IsOccluded(pBottom));
+
+    //窗口区域只画了一部分
+    SAutoRefPtr<IRegion> rgn;
+    GETRENDERFACTORY->CreateRegion(&rgn);
+    CRect rcEllipse(10,10,130,130);
+    rgn->CombineEllipse(&rcEllipse,RGN_COPY);
+    pTop->SetWindowRgn(rgn,FALSE);
+    EXPECT_FALSE(IsOccluded(pBottom));
+    pTop->SetWindowRgn(NULL,FALSE);
+    ASSERT_TRUE(IsOccluded(pBottom));
+
+    pTop->SetVisible(FALSE);
+    EXPECT_FALSE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, TransformedWindowIsNotOccluded)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(10,10,130,130,L"#00ff00ff");
+    pBottom->SetMatrix(SMatrix().rotate(30));
+    EXPECT_FALSE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, OnlyClientRectCovers)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = new STestWnd;
+    m_pRoot->InsertChild(pTop);
+    pTop->SetAttribute(L"colorBkgnd",L"#00ff00ff",TRUE);
+    pTop->SetAttribute(L"margin",L"5",TRUE);
+    CRect rcTop(18,18,122,122);
+    pTop->Move(&rcTop);
+    //非客户区不一定画满, 客户区比下面的窗口小
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    rcTop.SetRect(15,15,125,125);
+    pTop->Move(&rcTop);
+    EXPECT_TRUE(IsOccluded(pBottom));
+}
+
+TEST_F(OcclusionTest, PaintRegionLimitsCheck)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    AddWnd(10,10,130,70,L"#00ff00ff");
+    EXPECT_FALSE(IsOccluded(pBottom));
+
+    //只重绘上半部分时, 下面的窗口在重绘范围内的部分被盖住
+    SAutoRefPtr<IRegion> rgn;
+    GETRENDERFACTORY->CreateRegion(&rgn);
+    CRect rcPaint(0,0,200,60);
+    rgn->CombineRect(&rcPaint,RGN_COPY);
+    EXPECT_TRUE(IsOccluded(pBottom,rgn));
+
+    rcPaint.SetRect(0,0,200,80);
+    rgn->CombineRect(&rcPaint,RGN_COPY);
+    EXPECT_FALSE(IsOccluded(pBottom,rgn));
+}
+
+TEST_F(OcclusionTest, ZorderRange)
+{
+    STestWnd *pBottom = AddWnd(20,20,120,120,L"#ff0000ff");
+    STestWnd *pTop = AddWnd(10,10,130,130,L"#00ff00ff");
+
+    SArray<SWindow*> arrOccluded;
+    GetOccluded(arrOccluded,NULL,0,ZORDER_MAX);
+    ASSERT_EQ(1u,arrOccluded.GetCount());
+    EXPECT_EQ(pBottom,arrOccluded[0]);
+
+    //上面的窗口不在绘制范围内时不会被画, 不能遮挡
+    arrOccluded.RemoveAll();
+    GetOccluded(arrOccluded,NULL,0,pTop->GetZorder());
+    EXPECT_EQ(0u,arrOccluded.GetCount());
+
+    //上面的窗口在开始zorder之前时, 它不是这次绘制的内容
+    arrOccluded.RemoveAll();
+    GetOccluded(arrOccluded,NULL,pTop->GetZorder()+1,ZORDER_MAX);
+    EXPECT_EQ(0u,arrOccluded.GetCount());
+
+    arrOccluded.RemoveAll();
+    GetOccluded(arrOccluded,NULL,pTop->GetZorder(),ZORDER_MAX);
+    ASSERT_EQ(1u,arrOccluded.GetCount());
+    EXPECT_EQ(pBottom,arrOccluded[0]);
+}
+
+TEST_F(OcclusionTest, OutputIsTopDown)
+{
+    STestWnd *pWnd1 = AddWnd(20,20,60,60,L"#ff0000ff");
+    STestWnd *pWnd2 = AddWnd(100,20,140,60,L"#ff0000ff");
+    STestWnd *pWnd3 = AddWnd(30,30,50,50,L"#ff000080");
+    AddWnd(0,0,200,100,L"#00ff00ff");
+
+    SArray<SWindow*> arrOccluded;
+    GetOccluded(arrOccluded);
+    ASSERT_EQ(3u,arrOccluded.GetCount());
+    EXPECT_EQ(pWnd3,arrOccluded[0]);
+    EXPECT_EQ(pWnd2,arrOccluded[1]);
+    EXPECT_EQ(pWnd1,arrOccluded[2]);
+}
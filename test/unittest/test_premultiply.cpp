@@ -0,0 +1,114 @@
+﻿#include <helper/SPremultiply.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace SOUI;
+
+namespace
+{
+    //公开两种实现用于比较
+    class SPremultiplyTester : public SPremultiply
+    {
+    public:
+        static void Scalar(unsigned char *pDst,const unsigned char *pSrc,int nPixels,bool bSwapRB)
+        {
+            _Premultiply_C(pDst,pSrc,nPixels,bSwapRB);
+        }
+
+#ifdef SPREMULTIPLY_SSE2
+        static int SSE2(unsigned char *pDst,const unsigned char *pSrc,int nPixels,bool bSwapRB)
+        {
+            return _Premultiply_SSE2(pDst,pSrc,nPixels,bSwapRB);
+        }
+#endif
+    };
+
+    //覆盖所有的(颜色,alpha)组合: 像素k的alpha为k>>8, 三个颜色通道取k&255的不同变换
+    void FillAllCombinations(std::vector<unsigned char> & buf)
+    {
+        buf.resize(256*256*4);
+        for(int k=0;k<256*256;k++)
+        {
+            unsigned char c = (unsigned char)(k & 0xff);
+            buf[k*4+0] = c;
+            buf[k*4+1] = (unsigned char)(255-c);
+            buf[k*4+2] = (unsigned char)(c*7+13);
+            buf[k*4+3] = (unsigned char)(k>>8);
+        }
+    }
+
+    void VerifyReference(const std::vector<unsigned char> & src,const std::vector<unsigned char> & dst,bool bSwapRB)
+    {
+        for(size_t i=0;i<src.size();i+=4)
+        {
+            int a = src[i+3];
+            ASSERT_EQ(a,dst[i+3]) << "pixel " << i/4;
+            ASSERT_EQ(src[i+(bSwapRB?2:0)]*a/255,dst[i+0]) << "pixel " << i/4;
+            ASSERT_EQ(src[i+1]*a/255,dst[i+1]) << "pixel " << i/4;
+            ASSERT_EQ(src[i+(bSwapRB?0:2)]*a/255,dst[i+2]) << "pixel " << i/4;
+        }
+    }
+}
+
+TEST(SPremultiply, ScalarMatchesReference)
+{
+    std::vector<unsigned char> src,dst;
+    FillAllCombinations(src);
+    for(int bSwap=0;bSwap<2;bSwap++)
+    {
+        dst.assign(src.size(),0xcd);
+        SPremultiplyTester::Scalar(&dst[0],&src[0],(int)src.size()/4,bSwap!=0);
+        VerifyReference(src,dst,bSwap!=0);
+    }
+}
+
+#ifdef SPREMULTIPLY_SSE2
+//SSE2实现对所有输入都必须和逐像素计算逐字节一致
+TEST(SPremultiply, SSE2MatchesScalarExhaustive)
+{
+    if(!SPremultiply::HasSSE2()) return;
+    std::vector<unsigned char> src,dstC,dstSSE;
+    FillAllCombinations(src);
+    int nPixels = (int)src.size()/4;
+    for(int bSwap=0;bSwap<2;bSwap++)
+    {
+        dstC.assign(src.size(),0xcd);
+        dstSSE.assign(src.size(),0xcd);
+        SPremultiplyTester::Scalar(&dstC[0],&src[0],nPixels,bSwap!=0);
+        ASSERT_EQ(nPixels,SPremultiplyTester::SSE2(&dstSSE[0],&src[0],nPixels,bSwap!=0));
+        ASSERT_EQ(0,memcmp(&dstC[0],&dstSSE[0],src.size())) << "swap=" << bSwap;
+    }
+}
+#endif
+
+//不是4的倍数的像素数及不对齐的地址, 尾部像素由逐像素计算处理
+TEST(SPremultiply, UnalignedAndTail)
+{
+    std::vector<unsigned char> src;
+    FillAllCombinations(src);
+    std::vector<unsigned char> dst(src.size()+4);
+    const int kCounts[] = {0,1,3,4,5,7,9,1023};
+    for(int iCount=0;iCount<(int)(sizeof(kCounts)/sizeof(kCounts[0]));iCount++)
+    {
+        for(int iOffset=1;iOffset<4;iOffset++)
+        {
+            int nPixels = kCounts[iCount];
+            std::vector<unsigned char> part(src.begin()+iOffset*4*97,src.begin()+iOffset*4*97+nPixels*4);
+            std::vector<unsigned char> srcBuf(part.size()+1);
+            if(!part.empty()) memcpy(&srcBuf[1],&part[0],part.size());
+            SPremultiply::PremultiplySwapRB(&dst[1],&srcBuf[1],nPixels);
+            std::vector<unsigned char> out(dst.begin()+1,dst.begin()+1+nPixels*4);
+            VerifyReference(part,out,true);
+        }
+    }
+}
+
+//输出和输入可以是同一块内存
+TEST(SPremultiply, InPlace)
+{
+    std::vector<unsigned char> src,buf;
+    FillAllCombinations(src);
+    buf = src;
+    SPremultiply::Premultiply(&buf[0],&buf[0],(int)buf.size()/4);
+    VerifyReference(src,buf,false);
+}
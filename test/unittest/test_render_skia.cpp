@@ -0,0 +1,113 @@
+﻿#include "souistd.h"
+#define SCOM_MASK scom_mask_render_skia
+#include <commgr2.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+using namespace SOUI;
+
+namespace
+{
+    const int kWid = 96;
+    const int kHei = 64;
+
+    //绘制一组覆盖常用接口的图元: 填充, 渐变, 椭圆, 线条, 剪裁, 九宫格及平铺
+    void DrawScene(IRenderFactory *pFactory,IRenderTarget *pRT)
+    {
+        CRect rcAll(0,0,kWid,kHei);
+        pRT->FillSolidRect(&rcAll,RGBA(255,255,255,255));
+        CRect rc1(4,4,44,30);
+        pRT->GradientFill(&rc1,TRUE,RGBA(255,0,0,255),RGBA(0,0,255,255));
+        CRect rc2(50,4,92,30);
+        pRT->FillSolidEllipse(&rc2,RGBA(0,128,0,200));
+
+        SAutoRefPtr<IPen> pen;
+        pRT->CreatePen(PS_SOLID,RGBA(0,0,0,255),2,&pen);
+        pRT->SelectObject(pen);
+        POINT pts[3]={{4,60},{48,34},{92,60}};
+        pRT->DrawLines(pts,3);
+
+        CRect rcClip(60,36,80,56);
+        pRT->PushClipRect(&rcClip);
+        CRect rc3(50,30,92,62);
+        pRT->FillSolidRect(&rc3,RGBA(255,200,0,128));
+        pRT->PopClip();
+
+        //8x8的棋盘格位图
+        SAutoRefPtr<IBitmap> bmp;
+        pFactory->CreateBitmap(&bmp);
+        DWORD pixels[8*8];
+        for(int i=0;i<64;i++)
+            pixels[i] = ((i/8 + i%8)&1)?0xff000000:0xff808080;
+        bmp->Init(8,8,pixels);
+        CRect rcSrc(0,0,8,8),rcMargin(2,2,2,2);
+        CRect rc4(4,34,28,58);
+        pRT->DrawBitmap9Patch(&rc4,bmp,&rcSrc,&rcMargin,EM_STRETCH);
+        CRect rc5(30,40,58,62);
+        pRT->DrawBitmapEx(&rc5,bmp,&rcSrc,EM_TILE,200);
+    }
+
+    class RenderSkiaTest : public ::testing::Test
+    {
+    protected:
+        virtual void SetUp()
+        {
+            m_comMgr.CreateRender_Skia((IObjRef**)&m_factory);
+            m_comMgr.CreateRender_SkiaHeadless((IObjRef**)&m_factoryHeadless);
+        }
+
+        IBitmap * Render(IRenderFactory *pFactory,IRenderTarget **ppRT)
+        {
+            pFactory->CreateRenderTarget(ppRT,kWid,kHei);
+            DrawScene(pFactory,*ppRT);
+            return (IBitmap*)(*ppRT)->GetCurrentObject(OT_BITMAP);
+        }
+
+        SComMgr2 m_comMgr;
+        SAutoRefPtr<IRenderFactory> m_factory;
+        SAutoRefPtr<IRenderFactory> m_factoryHeadless;
+    };
+}
+
+//以DIB模式的绘制结果为基准图, 无头模式必须逐像素一致
+TEST_F(RenderSkiaTest, HeadlessMatchesDibGolden)
+{
+    ASSERT_TRUE(m_factory && m_factoryHeadless);
+    SAutoRefPtr<IRenderTarget> rtGolden,rtHeadless;
+    IBitmap *pGolden = Render(m_factory,&rtGolden);
+    IBitmap *pHeadless = Render(m_factoryHeadless,&rtHeadless);
+    ASSERT_EQ(pGolden->Width(),pHeadless->Width());
+    ASSERT_EQ(pGolden->Height(),pHeadless->Height());
+
+    const DWORD *pGoldenBits = (const DWORD*)pGolden->GetPixelBits();
+    const DWORD *pHeadlessBits = (const DWORD*)pHeadless->GetPixelBits();
+    for(int i=0;i<kWid*kHei;i++)
+    {
+        ASSERT_EQ(pGoldenBits[i],pHeadlessBits[i]) << "x=" << i%kWid << " y=" << i/kWid;
+    }
+
+    //几个确定的像素: 背景为白色, 剪裁区外的填充不可见
+    EXPECT_EQ(0xffffffff,pHeadlessBits[0]);
+    EXPECT_EQ(0xffffffff,pHeadlessBits[(kHei-1)*kWid+kWid-1]);
+    EXPECT_EQ(0xffffffff,pHeadlessBits[32*kWid+91]);
+}
+
+//无头模式的GetDC返回内存DC, GDI绘制的结果在ReleaseDC后写回位图
+TEST_F(RenderSkiaTest, HeadlessGetDC)
+{
+    ASSERT_TRUE(m_factoryHeadless);
+    SAutoRefPtr<IRenderTarget> pRT;
+    IBitmap *pBmp = Render(m_factoryHeadless,&pRT);
+
+    HDC hdc = pRT->GetDC(0);
+    ASSERT_TRUE(hdc != NULL);
+    HBRUSH br = ::CreateSolidBrush(RGB(0,0,255));
+    RECT rc = {0,0,4,4};
+    ::FillRect(hdc,&rc,br);
+    ::DeleteObject(br);
+    pRT->ReleaseDC(hdc);
+
+    const DWORD *pBits = (const DWORD*)pBmp->GetPixelBits();
+    EXPECT_EQ(0x000000ffu,pBits[0] & 0x00ffffff);
+    EXPECT_EQ(0x00ffffffu,pBits[5] & 0x00ffffff);
+}
@@ -0,0 +1,171 @@
+﻿#include "souistd.h"
+#include "helper/SRenderCacheMgr.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    //独立的管理器实例, 公开通知接口, 不影响SApplication中的全局管理器
+    class SRenderCacheMgrTester : public SRenderCacheMgr
+    {
+    public:
+        ~SRenderCacheMgrTester()
+        {
+            ReleaseCaches();
+        }
+
+        using SRenderCacheMgr::OnCacheCreated;
+        using SRenderCacheMgr::OnCacheResized;
+        using SRenderCacheMgr::OnCachePainted;
+        using SRenderCacheMgr::OnCacheReleased;
+
+        bool IsCached(SWindow *pWnd) const
+        {
+            SAutoLock lock(m_cs);
+            return m_mapEntry.Lookup(pWnd) != NULL;
+        }
+    };
+
+    class RenderCacheMgrTest : public ::testing::Test
+    {
+    protected:
+        virtual void SetUp()
+        {
+            for(int i=0;i<kWnds;i++)
+                m_wnds[i].Attach(new SWindow);
+        }
+
+        enum{kWnds=5};
+        SAutoRefPtr<SWindow> m_wnds[kWnds];
+    };
+
+    struct OtherThreadParam
+    {
+        SRenderCacheMgrTester *pMgr;
+        SWindow *pWnd;
+        size_t   nBytes;
+    };
+
+    DWORD WINAPI CreateCacheProc(LPVOID pParam)
+    {
+        OtherThreadParam *p = (OtherThreadParam*)pParam;
+        p->pMgr->OnCacheCreated(p->pWnd,p->nBytes);
+        return 0;
+    }
+}
+
+//超出预算时淘汰最久没有绘制的缓存
+TEST_F(RenderCacheMgrTest, EvictsLeastRecentlyPainted)
+{
+    SRenderCacheMgrTester mgr;
+    mgr.SetBudget(300);
+    mgr.OnCacheCreated(m_wnds[0],100);
+    mgr.OnCacheCreated(m_wnds[1],100);
+    mgr.OnCacheCreated(m_wnds[2],100);
+    EXPECT_EQ(0u,mgr.GetStats().nEvictions);
+
+    //绘制过的窗口移到表尾, 第二个窗口变成最久未绘制的
+    mgr.OnCachePainted(m_wnds[0],true);
+    mgr.OnCacheCreated(m_wnds[3],100);
+
+    SRenderCacheMgr::CacheStats stats = mgr.GetStats();
+    EXPECT_TRUE(mgr.IsCached(m_wnds[0]));
+    EXPECT_FALSE(mgr.IsCached(m_wnds[1]));
+    EXPECT_TRUE(mgr.IsCached(m_wnds[2]));
+    EXPECT_TRUE(mgr.IsCached(m_wnds[3]));
+    EXPECT_EQ(1u,stats.nEvictions);
+    EXPECT_EQ(3u,stats.nCaches);
+    EXPECT_EQ(300u,stats.nBytes);
+    EXPECT_EQ(400u,stats.nPeakBytes);
+    EXPECT_EQ(4u,stats.nCreates);
+    EXPECT_EQ(1u,stats.nHits);
+}
+
+//新建的缓存即使自己超出预算也保留, 其它缓存被淘汰
+TEST_F(RenderCacheMgrTest, NewCacheIsNeverEvicted)
+{
+    SRenderCacheMgrTester mgr;
+    mgr.SetBudget(100);
+    mgr.OnCacheCreated(m_wnds[0],50);
+    mgr.OnCacheCreated(m_wnds[1],200);
+    EXPECT_FALSE(mgr.IsCached(m_wnds[0]));
+    EXPECT_TRUE(mgr.IsCached(m_wnds[1]));
+    EXPECT_EQ(200u,mgr.GetStats().nBytes);
+
+    //尺寸变大同样不淘汰自己
+    mgr.OnCacheCreated(m_wnds[2],10);
+    EXPECT_FALSE(mgr.IsCached(m_wnds[1]));
+    mgr.OnCacheResized(m_wnds[2],500);
+    EXPECT_TRUE(mgr.IsCached(m_wnds[2]));
+    EXPECT_EQ(500u,mgr.GetStats().nBytes);
+}
+
+//减小预算立即淘汰, 预算为0表示不限制
+TEST_F(RenderCacheMgrTest, SetBudget)
+{
+    SRenderCacheMgrTester mgr;
+    mgr.SetBudget(0);
+    for(int i=0;i<kWnds;i++)
+        mgr.OnCacheCreated(m_wnds[i],100);
+    EXPECT_EQ(5u,mgr.GetStats().nCaches);
+    EXPECT_EQ(0u,mgr.GetStats().nEvictions);
+
+    mgr.SetBudget(250);
+    SRenderCacheMgr::CacheStats stats = mgr.GetStats();
+    EXPECT_EQ(2u,stats.nCaches);
+    EXPECT_EQ(200u,stats.nBytes);
+    EXPECT_EQ(3u,stats.nEvictions);
+    EXPECT_TRUE(mgr.IsCached(m_wnds[3]));
+    EXPECT_TRUE(mgr.IsCached(m_wnds[4]));
+}
+
+//主动释放不计入淘汰数, ResetStats保留当前占用
+TEST_F(RenderCacheMgrTest, ReleaseAndResetStats)
+{
+    SRenderCacheMgrTester mgr;
+    mgr.SetBudget(1000);
+    mgr.OnCacheCreated(m_wnds[0],100);
+    mgr.OnCacheCreated(m_wnds[1],200);
+    mgr.OnCachePainted(m_wnds[1],false);
+    mgr.OnCacheReleased(m_wnds[0]);
+    mgr.OnCacheReleased(m_wnds[0]);
+
+    SRenderCacheMgr::CacheStats stats = mgr.GetStats();
+    EXPECT_EQ(0u,stats.nEvictions);
+    EXPECT_EQ(1u,stats.nCaches);
+    EXPECT_EQ(200u,stats.nBytes);
+    EXPECT_EQ(1u,stats.nMisses);
+
+    mgr.ResetStats();
+    stats = mgr.GetStats();
+    EXPECT_EQ(0u,stats.nCreates);
+    EXPECT_EQ(0u,stats.nMisses);
+    EXPECT_EQ(200u,stats.nPeakBytes);
+    EXPECT_EQ(200u,stats.nBytes);
+}
+
+//其它线程创建的缓存只计入预算, 不在当前线程淘汰
+TEST_F(RenderCacheMgrTest, OtherThreadCachesAreNotEvicted)
+{
+    SRenderCacheMgrTester mgr;
+    mgr.SetBudget(150);
+    OtherThreadParam param = {&mgr,m_wnds[0],100};
+    HANDLE hThread = CreateThread(NULL,0,CreateCacheProc,&param,0,NULL);
+    ASSERT_TRUE(hThread != NULL);
+    WaitForSingleObject(hThread,INFINITE);
+    CloseHandle(hThread);
+
+    mgr.OnCacheCreated(m_wnds[1],100);
+    mgr.OnCacheCreated(m_wnds[2],100);
+    EXPECT_TRUE(mgr.IsCached(m_wnds[0]));
+    EXPECT_FALSE(mgr.IsCached(m_wnds[1]));
+    EXPECT_TRUE(mgr.IsCached(m_wnds[2]));
+
+    //ReleaseCaches只释放当前线程的缓存
+    mgr.ReleaseCaches();
+    EXPECT_TRUE(mgr.IsCached(m_wnds[0]));
+    EXPECT_EQ(100u,mgr.GetStats().nBytes);
+    mgr.OnCacheReleased(m_wnds[0]);
+    EXPECT_EQ(0u,mgr.GetStats().nCaches);
+}
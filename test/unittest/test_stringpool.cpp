@@ -0,0 +1,136 @@
+﻿#include "souistd.h"
+#include "core/SObjectFactory.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    const int kThreads = 4;
+    const int kNames = 200;
+
+    struct InternParam
+    {
+        SATOM atoms[kNames];
+    };
+
+    //多个线程同时驻留同一组名字
+    DWORD WINAPI InternProc(LPVOID pParam)
+    {
+        InternParam *p = (InternParam*)pParam;
+        for(int i=0;i<kNames;i++)
+        {
+            SStringW strName = SStringW().Format(L"test.pool.thread.%d",i);
+            p->atoms[i] = SStringPool::Intern(strName);
+        }
+        return 0;
+    }
+}
+
+//相同的字符串得到相同的原子, 大小写不同的原子共享小写形式
+TEST(SStringPool, InternAndFold)
+{
+    SATOM a1 = SStringPool::Intern(L"test.pool.Intern");
+    SATOM a2 = SStringPool::Intern(L"test.pool.Intern");
+    SATOM a3 = SStringPool::Intern(L"test.pool.intern");
+    ASSERT_TRUE(a1 != NULL);
+    EXPECT_EQ(a1,a2);
+    EXPECT_NE(a1,a3);
+    EXPECT_EQ(a3,SStringPool::GetFolded(a1));
+    EXPECT_EQ(a3,SStringPool::GetFolded(a3));
+    EXPECT_TRUE(SStringPool::EqualNoCase(a1,a3));
+    EXPECT_STREQ(L"test.pool.Intern",SStringPool::GetName(a1));
+    EXPECT_EQ(CElementTraits<SStringW>::Hash(SStringW(L"test.pool.Intern")),a1->nHash);
+
+    //指定长度时只驻留前缀
+    SATOM a4 = SStringPool::Intern(L"test.pool.interned",16);
+    EXPECT_EQ(a3,a4);
+    EXPECT_EQ(NULL,SStringPool::Intern(NULL));
+}
+
+//Find不创建原子
+TEST(SStringPool, FindDoesNotGrow)
+{
+    int nCount = SStringPool::GetCount();
+    EXPECT_EQ(NULL,SStringPool::Find(L"test.pool.never.interned"));
+    EXPECT_EQ(nCount,SStringPool::GetCount());
+
+    SATOM atom = SStringPool::Intern(L"test.pool.find");
+    EXPECT_EQ(atom,SStringPool::Find(L"test.pool.find"));
+    EXPECT_EQ(NULL,SStringPool::Find(L"test.pool.FIND"));
+}
+
+//超过内部栈缓冲区的长字符串也能正确生成小写形式
+TEST(SStringPool, LongName)
+{
+    SStringW strUpper,strLower;
+    for(int i=0;i<300;i++)
+    {
+        strUpper += (wchar_t)(L'A' + i%26);
+        strLower += (wchar_t)(L'a' + i%26);
+    }
+    SATOM aUpper = SStringPool::Intern(strUpper,strUpper.GetLength());
+    SATOM aLower = SStringPool::Find(strLower,strLower.GetLength());
+    ASSERT_TRUE(aUpper != NULL);
+    EXPECT_EQ(aLower,SStringPool::GetFolded(aUpper));
+    EXPECT_EQ(300,aUpper->nLen);
+}
+
+//并发驻留的结果一致
+TEST(SStringPool, ConcurrentIntern)
+{
+    InternParam params[kThreads];
+    HANDLE hThreads[kThreads];
+    for(int i=0;i<kThreads;i++)
+    {
+        hThreads[i] = CreateThread(NULL,0,InternProc,&params[i],0,NULL);
+        ASSERT_TRUE(hThreads[i] != NULL);
+    }
+    WaitForMultipleObjects(kThreads,hThreads,TRUE,INFINITE);
+    for(int i=0;i<kThreads;i++)
+        CloseHandle(hThreads[i]);
+
+    for(int i=0;i<kNames;i++)
+    {
+        ASSERT_TRUE(params[0].atoms[i] != NULL);
+        for(int t=1;t<kThreads;t++)
+        {
+            ASSERT_EQ(params[0].atoms[i],params[t].atoms[i]) << "name " << i;
+        }
+    }
+}
+
+//查询用的SObjectInfo不驻留名字, 和注册的key仍然相等
+TEST(SStringPool, ObjectInfoLookup)
+{
+    int nCount = SStringPool::GetCount();
+    SObjectInfo query(L"Test.Pool.Class",Window);
+    EXPECT_EQ(NULL,query.mAtom);
+    EXPECT_EQ(nCount,SStringPool::GetCount());
+
+    SObjectInfo key(L"test.pool.class",Window,true);
+    ASSERT_TRUE(key.mAtom != NULL);
+    EXPECT_TRUE(key == query);
+    EXPECT_TRUE(query == key);
+    EXPECT_EQ(key.Hash(),query.Hash());
+    EXPECT_FALSE(key == SObjectInfo(L"test.pool.class",Skin));
+
+    query.Intern();
+    EXPECT_EQ(key.mAtom,query.mAtom);
+}
+
+//用未注册的类名创建对象不会让驻留表增长
+TEST(SStringPool, UnknownClassDoesNotGrow)
+{
+    SWindow *pWnd = SApplication::getSingleton().CreateWindowByName(L"Button");
+    ASSERT_TRUE(pWnd != NULL);
+    pWnd->Release();
+
+    int nCount = SStringPool::GetCount();
+    for(int i=0;i<100;i++)
+    {
+        SStringW strName = SStringW().Format(L"testpoolunknown%d",i);
+        EXPECT_TRUE(SApplication::getSingleton().CreateWindowByName(strName) == NULL);
+    }
+    EXPECT_EQ(nCount,SStringPool::GetCount());
+}
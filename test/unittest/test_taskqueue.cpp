@@ -0,0 +1,349 @@
+﻿#include "souistd.h"
+#include "event/STaskQueue.h"
+#include <gtest/gtest.h>
+
+using namespace SOUI;
+
+namespace
+{
+    class STaskQueueTester : public STaskQueue
+    {
+    public:
+        //通道头部的任务闭包是否分配在堆上
+        BOOL IsHeadOnHeap(int nLane)
+        {
+            SAutoLock lock(m_cs);
+            SLane & lane = m_lanes[nLane];
+            SASSERT(lane.nCount > 0);
+            return lane.pHead->tasks[lane.iHead].pfnRelocate == NULL;
+        }
+
+        int GetLaneCount(int nLane)
+        {
+            SAutoLock lock(m_cs);
+            return m_lanes[nLane].nCount;
+        }
+    };
+
+    struct RecordFn
+    {
+        SArray<int> *pOrder;
+        int id;
+        void operator()() const {pOrder->Add(id);}
+    };
+
+    RecordFn MakeRecord(SArray<int> *pOrder,int id)
+    {
+        RecordFn fn = {pOrder,id};
+        return fn;
+    }
+
+    struct BigFn
+    {
+        int *pCount;
+        BYTE byPad[STaskQueue::KInlineSize + 36];
+        void operator()() const {++*pCount;}
+    };
+
+    //统计存活的闭包对象, 检查搬移和销毁是否配对
+    struct LiveFn
+    {
+        static LONG s_nLive;
+        int *pCount;
+        LiveFn(int *p):pCount(p){s_nLive++;}
+        LiveFn(const LiveFn & src):pCount(src.pCount){s_nLive++;}
+        ~LiveFn(){s_nLive--;}
+        void operator()() const {++*pCount;}
+    };
+    LONG LiveFn::s_nLive = 0;
+
+    struct SpinFn
+    {
+        DWORD dwMs;
+        int *pCount;
+        void operator()() const
+        {
+            LARGE_INTEGER freq,start,now;
+            QueryPerformanceFrequency(&freq);
+            QueryPerformanceCounter(&start);
+            do{
+                QueryPerformanceCounter(&now);
+            }while(now.QuadPart - start.QuadPart < freq.QuadPart * dwMs / 1000);
+            ++*pCount;
+        }
+    };
+
+    //执行时向指定通道再投递一个任务
+    struct RepostFn
+    {
+        STaskQueue *pQueue;
+        int nLane;
+        SArray<int> *pOrder;
+        int id;
+        void operator()() const
+        {
+            pOrder->Add(id);
+            pQueue->Post(MakeRecord(pOrder,id+100),nLane);
+        }
+    };
+
+    void ExpectOrder(const SArray<int> & order,const int *pExpect,int nExpect)
+    {
+        ASSERT_EQ((size_t)nExpect,order.GetCount());
+        for(int i=0;i<nExpect;i++)
+            EXPECT_EQ(pExpect[i],order[i]) << "task " << i;
+    }
+}
+
+TEST(TaskQueueTest, LanePriority)
+{
+    STaskQueue queue;
+    SArray<int> order;
+    EXPECT_TRUE(queue.Post(MakeRecord(&order,20),RUNONUI_IDLE));
+    EXPECT_FALSE(queue.Post(MakeRecord(&order,10),RUNONUI_NORMAL));
+    EXPECT_FALSE(queue.Post(MakeRecord(&order,0),RUNONUI_INPUT));
+    EXPECT_FALSE(queue.Post(MakeRecord(&order,11),RUNONUI_NORMAL));
+    EXPECT_FALSE(queue.Post(MakeRecord(&order,1),RUNONUI_INPUT));
+    EXPECT_EQ(5,queue.GetCount());
+
+    EXPECT_FALSE(queue.Run(1000));
+    const int kExpect[] = {0,1,10,11,20};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+    EXPECT_EQ(0,queue.GetCount());
+    //队列清空后再投递需要重新唤醒
+    EXPECT_TRUE(queue.Post(MakeRecord(&order,0),RUNONUI_INPUT));
+}
+
+TEST(TaskQueueTest, InlineAndHeapClosures)
+{
+    STaskQueueTester queue;
+    int nCount = 0;
+    SArray<int> order;
+    queue.Post(MakeRecord(&order,1),RUNONUI_NORMAL);
+    EXPECT_FALSE(queue.IsHeadOnHeap(RUNONUI_NORMAL));
+
+    BigFn big;
+    big.pCount = &nCount;
+    memset(big.byPad,0,sizeof(big.byPad));
+    ASSERT_GT(sizeof(BigFn),(size_t)STaskQueue::KInlineSize);
+    queue.Post(big,RUNONUI_INPUT);
+    EXPECT_TRUE(queue.IsHeadOnHeap(RUNONUI_INPUT));
+
+    EXPECT_FALSE(queue.Run(1000));
+    EXPECT_EQ(1,nCount);
+    EXPECT_EQ(1u,order.GetCount());
+}
+
+TEST(TaskQueueTest, ClosuresDestroyedOnce)
+{
+    int nCount = 0;
+    {
+        STaskQueue queue;
+        //超过一个内存块, 覆盖块的回收
+        for(int i=0;i<STaskQueue::KChunkTasks*2+5;i++)
+            queue.Post(LiveFn(&nCount),RUNONUI_NORMAL);
+        EXPECT_EQ(STaskQueue::KChunkTasks*2+5,LiveFn::s_nLive);
+        EXPECT_FALSE(queue.Run(1000));
+        EXPECT_EQ(STaskQueue::KChunkTasks*2+5,nCount);
+        EXPECT_EQ(0,LiveFn::s_nLive);
+
+        //没有执行的任务在队列析构时销毁
+        for(int i=0;i<10;i++)
+            queue.Post(LiveFn(&nCount),i%RUNONUI_LANES);
+        EXPECT_EQ(10,LiveFn::s_nLive);
+    }
+    EXPECT_EQ(0,LiveFn::s_nLive);
+    EXPECT_EQ(STaskQueue::KChunkTasks*2+5,nCount);
+}
+
+TEST(TaskQueueTest, InputLaneDrainsFully)
+{
+    STaskQueueTester queue;
+    int nInput = 0,nNormal = 0;
+    SpinFn input = {1,&nInput};
+    SpinFn normal = {0,&nNormal};
+    for(int i=0;i<20;i++)
+        queue.Post(input,RUNONUI_INPUT);
+    for(int i=0;i<5;i++)
+        queue.Post(normal,RUNONUI_NORMAL);
+
+    //输入通道不受预算限制, 普通通道每轮至少执行一个
+    EXPECT_TRUE(queue.Run(0));
+    EXPECT_EQ(20,nInput);
+    EXPECT_EQ(1,nNormal);
+}
+
+TEST(TaskQueueTest, InputPostedWhileRunningWaitsForNextRun)
+{
+    STaskQueueTester queue;
+    SArray<int> order;
+    RepostFn repost = {&queue,RUNONUI_INPUT,&order,1};
+    queue.Post(repost,RUNONUI_INPUT);
+
+    //任务中投递的输入任务留到下一轮, 不会无限执行
+    EXPECT_TRUE(queue.Run(1000));
+    EXPECT_EQ(1u,order.GetCount());
+    EXPECT_EQ(1,queue.GetLaneCount(RUNONUI_INPUT));
+    EXPECT_FALSE(queue.Run(1000));
+    const int kExpect[] = {1,101};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+}
+
+TEST(TaskQueueTest, BudgetStopsNormalLane)
+{
+    STaskQueueTester queue;
+    const int kTasks = 50;
+    int nCount = 0;
+    SpinFn spin = {1,&nCount};
+    for(int i=0;i<kTasks;i++)
+        queue.Post(spin,RUNONUI_NORMAL);
+
+    EXPECT_TRUE(queue.Run(5));
+    EXPECT_GE(nCount,1);
+    EXPECT_LE(nCount,6);
+
+    int nRuns = 1;
+    while(queue.Run(5))
+        nRuns++;
+    EXPECT_EQ(kTasks,nCount);
+    EXPECT_GE(nRuns,kTasks/6);
+}
+
+TEST(TaskQueueTest, IdleLaneWaitsForNormalLane)
+{
+    STaskQueueTester queue;
+    SArray<int> order;
+    queue.Post(MakeRecord(&order,20),RUNONUI_IDLE);
+    queue.Post(MakeRecord(&order,10),RUNONUI_NORMAL);
+    queue.Post(MakeRecord(&order,11),RUNONUI_NORMAL);
+
+    //预算为0时每轮只执行一个普通任务, 普通通道不空时不执行空闲任务
+    EXPECT_TRUE(queue.Run(0));
+    EXPECT_TRUE(queue.Run(0));
+    EXPECT_EQ(1,queue.GetLaneCount(RUNONUI_IDLE));
+    EXPECT_FALSE(queue.Run(0));
+    const int kExpect[] = {10,11,20};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+}
+
+TEST(TaskQueueTest, IdleLaneYieldsToNewWork)
+{
+    STaskQueueTester queue;
+    SArray<int> order;
+    RepostFn repost = {&queue,RUNONUI_NORMAL,&order,1};
+    queue.Post(repost,RUNONUI_IDLE);
+    queue.Post(MakeRecord(&order,2),RUNONUI_IDLE);
+
+    //空闲任务投递了普通任务, 剩下的空闲任务让出
+    EXPECT_TRUE(queue.Run(1000));
+    EXPECT_EQ(1u,order.GetCount());
+    EXPECT_FALSE(queue.Run(1000));
+    const int kExpect[] = {1,101,2};
+    ExpectOrder(order,kExpect,sizeof(kExpect)/sizeof(kExpect[0]));
+}
+
+namespace
+{
+    enum {kProducers = 4, kTasksPerProducer = 5000};
+
+    struct SeqCheck
+    {
+        int  nLast[kProducers];
+        int  nErrors;
+    };
+
+    //检查同一个生产者的任务按投递顺序执行
+    struct SeqFn
+    {
+        SeqCheck *pCheck;
+        int iProducer;
+        int nSeq;
+        void operator()() const
+        {
+            if(pCheck->nLast[iProducer] + 1 != nSeq) pCheck->nErrors++;
+            pCheck->nLast[iProducer] = nSeq;
+        }
+    };
+
+    struct ProducerParam
+    {
+        STaskQueue *pQueue;
+        SeqCheck   *pCheck;
+        int         iProducer;
+        volatile LONG *pWakeups;
+    };
+
+    DWORD WINAPI ProducerProc(LPVOID p)
+    {
+        ProducerParam *param = (ProducerParam*)p;
+        for(int i=0;i<kTasksPerProducer;i++)
+        {
+            SeqFn fn = {param->pCheck,param->iProducer,i};
+            if(param->pQueue->Post(fn,RUNONUI_NORMAL))
+                InterlockedIncrement(param->pWakeups);
+        }
+        return 0;
+    }
+}
+
+TEST(TaskQueueTest, MultipleProducers)
+{
+    STaskQueue queue;
+    SeqCheck check;
+    for(int i=0;i<kProducers;i++) check.nLast[i] = -1;
+    check.nErrors = 0;
+    volatile LONG nWakeups = 0;
+
+    ProducerParam params[kProducers];
+    HANDLE hThreads[kProducers];
+    for(int i=0;i<kProducers;i++)
+    {
+        ProducerParam param = {&queue,&check,i,&nWakeups};
+        params[i] = param;
+        hThreads[i] = CreateThread(NULL,0,ProducerProc,&params[i],0,NULL);
+        ASSERT_TRUE(hThreads[i] != NULL);
+    }
+    WaitForMultipleObjects(kProducers,hThreads,TRUE,INFINITE);
+    for(int i=0;i<kProducers;i++)
+        CloseHandle(hThreads[i]);
+
+    //没有消费者时只有第一次投递需要唤醒
+    EXPECT_EQ(1,nWakeups);
+    EXPECT_EQ(kProducers*kTasksPerProducer,queue.GetCount());
+    while(queue.Run(1000))
+        ;
+    EXPECT_EQ(0,check.nErrors);
+    for(int i=0;i<kProducers;i++)
+        EXPECT_EQ(kTasksPerProducer-1,check.nLast[i]);
+}
+
+TEST(TaskQueueTest, ProducersWhileRunning)
+{
+    STaskQueue queue;
+    SeqCheck check;
+    for(int i=0;i<kProducers;i++) check.nLast[i] = -1;
+    check.nErrors = 0;
+    volatile LONG nWakeups = 0;
+
+    ProducerParam params[kProducers];
+    HANDLE hThreads[kProducers];
+    for(int i=0;i<kProducers;i++)
+    {
+        ProducerParam param = {&queue,&check,i,&nWakeups};
+        params[i] = param;
+        hThreads[i] = CreateThread(NULL,0,ProducerProc,&params[i],0,NULL);
+        ASSERT_TRUE(hThreads[i] != NULL);
+    }
+    //消费者和生产者同时运行, 块在通道之间回收使用
+    while(WaitForMultipleObjects(kProducers,hThreads,TRUE,0) == WAIT_TIMEOUT)
+        queue.Run(1);
+    for(int i=0;i<kProducers;i++)
+        CloseHandle(hThreads[i]);
+    while(queue.Run(1000))
+        ;
+    EXPECT_EQ(0,queue.GetCount());
+    EXPECT_EQ(0,check.nErrors);
+    for(int i=0;i<kProducers;i++)
+        EXPECT_EQ(kTasksPerProducer-1,check.nLast[i]);
+    EXPECT_GE(nWakeups,1);
+}
@@ -0,0 +1,119 @@
+﻿/**
+* Copyright (C) 2014-2050 
+* All rights reserved.
+* 
+* @file       SBoxDownscaler.hpp
+* @brief      
+* @version    v1.0      
+* @author     SOUI group   
+* @date       2026/10/16
+* 
+* Describe    解码时按整数倍缩小图片的盒式滤波器
+*/
+
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+
+namespace SOUI
+{
+    /**
+    * @class     SBoxDownscaler
+    * @brief     按行输入RGBA像素, 每nScale*nScale个源像素平均为一个目标像素
+    * 
+    * Describe   不需要完整尺寸的源图, 解码器可以边解码边缩小。
+    *            颜色按alpha加权平均, 输出仍然是未预乘的RGBA。
+    */
+    class SBoxDownscaler
+    {
+    public:
+        enum{MAX_SCALE=32};   //保证累加值不会溢出
+
+        SBoxDownscaler(int nSrcWid,int nSrcHei,int nScale)
+            :m_nSrcWid(nSrcWid),m_nSrcHei(nSrcHei),m_nScale(nScale),m_iSrcRow(0)
+        {
+            m_nDstWid = (nSrcWid + nScale - 1)/nScale;
+            m_nDstHei = (nSrcHei + nScale - 1)/nScale;
+            m_pAcc = (unsigned int*)calloc(m_nDstWid*5,sizeof(unsigned int));
+        }
+
+        ~SBoxDownscaler()
+        {
+            free(m_pAcc);
+        }
+
+        int GetWidth() const {return m_nDstWid;}
+        int GetHeight() const {return m_nDstHei;}
+
+        /**
+         * PushRow
+         * @brief    输入一行源像素
+         * @param    const unsigned char * pSrc --  一行RGBA源像素
+         * @param    unsigned char * pDst --  目标图片的首地址
+         * @param    unsigned int cbStride --  目标图片的行宽
+         * @return   bool -- true: 写出了一行目标像素
+         */
+        bool PushRow(const unsigned char *pSrc,unsigned char *pDst,unsigned int cbStride)
+        {
+            if(m_iSrcRow >= m_nSrcHei) return false;
+            for(int x=0;x<m_nSrcWid;x++)
+            {
+                unsigned int *p = m_pAcc + (x/m_nScale)*5;
+                unsigned int a = pSrc[3];
+                p[0] += pSrc[0]*a;
+                p[1] += pSrc[1]*a;
+                p[2] += pSrc[2]*a;
+                p[3] += a;
+                p[4] ++;
+                pSrc += 4;
+            }
+            m_iSrcRow ++;
+            if(m_iSrcRow % m_nScale != 0 && m_iSrcRow != m_nSrcHei)
+                return false;
+
+            unsigned char *pOut = pDst + cbStride * ((m_iSrcRow-1)/m_nScale);
+            unsigned int *p = m_pAcc;
+            for(int x=0;x<m_nDstWid;x++)
+            {
+                if(p[3])
+                {
+                    pOut[0] = (unsigned char)(p[0]/p[3]);
+                    pOut[1] = (unsigned char)(p[1]/p[3]);
+                    pOut[2] = (unsigned char)(p[2]/p[3]);
+                    pOut[3] = (unsigned char)(p[3]/p[4]);
+                }else
+                {
+                    memset(pOut,0,4);
+                }
+                pOut += 4;
+                p += 5;
+            }
+            memset(m_pAcc,0,m_nDstWid*5*sizeof(unsigned int));
+            return true;
+        }
+
+        /**
+         * CalcScale
+         * @brief    计算缩小倍数, 缩小后的图片不小于期望大小
+         * @param    int nSrcWid,nSrcHei --  原图大小
+         * @param    int nDstWid,nDstHei --  期望大小, <=0表示不缩小
+         * @return   int -- 缩小倍数, 1表示不缩小
+         */
+        static int CalcScale(int nSrcWid,int nSrcHei,int nDstWid,int nDstHei)
+        {
+            if(nDstWid<=0 || nDstHei<=0) return 1;
+            int nScale = nSrcWid/nDstWid;
+            if(nSrcHei/nDstHei < nScale) nScale = nSrcHei/nDstHei;
+            if(nScale < 1) nScale = 1;
+            if(nScale > MAX_SCALE) nScale = MAX_SCALE;
+            return nScale;
+        }
+
+    private:
+        int m_nSrcWid,m_nSrcHei;
+        int m_nDstWid,m_nDstHei;
+        int m_nScale;
+        int m_iSrcRow;
+        unsigned int *m_pAcc;   //每个目标像素累加R*A,G*A,B*A,A及像素数
+    };
+}
@@ -0,0 +1,149 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SPremultiply.hpp
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2026/10/16
+*
+* Describe    解码器共用的预乘及R/B交换
+*/
+
+#pragma once
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SPREMULTIPLY_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace SOUI
+{
+    /**
+    * @class     SPremultiply
+    * @brief     32位像素的alpha预乘, 结果与逐像素计算 c*a/255 完全一致
+    *
+    * Describe   支持SSE2的CPU一次处理4个像素, 否则使用逐像素计算。
+    *            c*a/255 使用 (x+1+(x>>8))>>8 计算, 对0~65025范围内的x是精确的。
+    *            pDst可以和pSrc相同。
+    */
+    class SPremultiply
+    {
+    public:
+        /**
+         * Premultiply
+         * @brief    预乘, 通道顺序不变
+         * @param    unsigned char * pDst --  输出像素
+         * @param    const unsigned char * pSrc --  输入像素, 第4个字节是alpha
+         * @param    int nPixels --  像素数
+         * @return   void
+         */
+        static void Premultiply(unsigned char *pDst,const unsigned char *pSrc,int nPixels)
+        {
+            int i = 0;
+#ifdef SPREMULTIPLY_SSE2
+            if(HasSSE2()) i = _Premultiply_SSE2(pDst,pSrc,nPixels,false);
+#endif
+            _Premultiply_C(pDst+i*4,pSrc+i*4,nPixels-i,false);
+        }
+
+        /**
+         * PremultiplySwapRB
+         * @brief    预乘并交换第1,3个通道, 用于RGBA转换为预乘的BGRA
+         * @param    unsigned char * pDst --  输出像素
+         * @param    const unsigned char * pSrc --  输入像素, 第4个字节是alpha
+         * @param    int nPixels --  像素数
+         * @return   void
+         */
+        static void PremultiplySwapRB(unsigned char *pDst,const unsigned char *pSrc,int nPixels)
+        {
+            int i = 0;
+#ifdef SPREMULTIPLY_SSE2
+            if(HasSSE2()) i = _Premultiply_SSE2(pDst,pSrc,nPixels,true);
+#endif
+            _Premultiply_C(pDst+i*4,pSrc+i*4,nPixels-i,true);
+        }
+
+        static bool HasSSE2()
+        {
+#if defined(_M_X64) || defined(__x86_64__)
+            return true;
+#elif defined(_MSC_VER) && defined(SPREMULTIPLY_SSE2)
+            static int s_bSSE2 = -1;
+            if(s_bSSE2 == -1)
+            {
+                int info[4];
+                __cpuid(info,1);
+                s_bSSE2 = (info[3] & (1<<26))?1:0;
+            }
+            return s_bSSE2 == 1;
+#elif defined(__GNUC__) && defined(SPREMULTIPLY_SSE2)
+            return __builtin_cpu_supports("sse2")!=0;
+#else
+            return false;
+#endif
+        }
+
+    protected://单元测试及性能测试需要单独调用两种实现
+        static void _Premultiply_C(unsigned char *pDst,const unsigned char *pSrc,int nPixels,bool bSwapRB)
+        {
+            for(int i=0;i<nPixels;i++)
+            {
+                unsigned char a = pSrc[3];
+                unsigned char c0 = pSrc[bSwapRB?2:0];
+                unsigned char c1 = pSrc[1];
+                unsigned char c2 = pSrc[bSwapRB?0:2];
+                if(a)
+                {
+                    pDst[0] = (c0 * a)/255;
+                    pDst[1] = (c1 * a)/255;
+                    pDst[2] = (c2 * a)/255;
+                    pDst[3] = a;
+                }else
+                {
+                    memset(pDst,0,4);
+                }
+                pSrc += 4;
+                pDst += 4;
+            }
+        }
+
+#ifdef SPREMULTIPLY_SSE2
+        //处理两个像素, x为8个16位通道
+        static __m128i _Mul2Pixels(__m128i x,bool bSwapRB)
+        {
+            const __m128i maskA = _mm_set_epi16(-1,0,0,0,-1,0,0,0);
+            const __m128i alpha255 = _mm_set_epi16(255,0,0,0,255,0,0,0);
+            const __m128i one = _mm_set1_epi16(1);
+            //alpha通道乘以255, x*255/255==x
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+            a = _mm_or_si128(_mm_andnot_si128(maskA,a),alpha255);
+            if(bSwapRB)
+                x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x,_MM_SHUFFLE(3,0,1,2)),_MM_SHUFFLE(3,0,1,2));
+            x = _mm_mullo_epi16(x,a);
+            x = _mm_add_epi16(_mm_add_epi16(x,one),_mm_srli_epi16(x,8));
+            return _mm_srli_epi16(x,8);
+        }
+
+        //返回处理的像素数, 剩余不足4个的像素由调用者处理
+        static int _Premultiply_SSE2(unsigned char *pDst,const unsigned char *pSrc,int nPixels,bool bSwapRB)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            int i = 0;
+            for(;i+4<=nPixels;i+=4)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)(pSrc+i*4));
+                __m128i lo = _Mul2Pixels(_mm_unpacklo_epi8(v,zero),bSwapRB);
+                __m128i hi = _Mul2Pixels(_mm_unpackhi_epi8(v,zero),bSwapRB);
+                _mm_storeu_si128((__m128i*)(pDst+i*4),_mm_packus_epi16(lo,hi));
+            }
+            return i;
+        }
+#endif
+    };
+}
@@ -2883,6 +2883,527 @@ void SMap< K, V, KTraits, VTraits >::AssertValid() const
 }
 #endif
 
+//
+// SFlatMap: open addressing hash map with Robin Hood probing.
+// Same interface and traits as SMap, but all pairs live in one contiguous
+// slot array, so a lookup touches no linked nodes and there is no per-entry
+// allocation. Insert and remove move pairs between slots (relocated with
+// memmove, same as SArray), so SPOSITIONs and CPair pointers are invalidated
+// by SetAt/operator[] on a new key and by RemoveKey. Lookups never move pairs.
+// Each slot keeps the full 32 bit mixed hash and a 32 bit probe distance, so any
+// number of colliding keys fits and growing never has to rehash the keys.
+//
+template< typename K, typename V, class KTraits = CElementTraits< K >, class VTraits = CElementTraits< V > >
+class SFlatMap
+{
+public:
+    typedef typename KTraits::INARGTYPE KINARGTYPE;
+    typedef typename KTraits::OUTARGTYPE KOUTARGTYPE;
+    typedef typename VTraits::INARGTYPE VINARGTYPE;
+    typedef typename VTraits::OUTARGTYPE VOUTARGTYPE;
+
+    class CPair
+    {
+    public:
+        CPair( KINARGTYPE key ) :
+            m_key( key )
+        {
+        }
+        CPair( KINARGTYPE key, VINARGTYPE value ) :
+            m_key( key ),
+            m_value( value )
+        {
+        }
+
+    public:
+        const K m_key;
+        V m_value;
+    };
+
+public:
+    SFlatMap( size_t nInitElements = 0 );
+    SFlatMap( const SFlatMap& src );
+    ~SFlatMap();
+    SFlatMap& operator=( const SFlatMap& src );
+
+    void Copy( const SFlatMap& src );
+
+    size_t GetCount() const;
+    bool IsEmpty() const;
+    size_t GetCapacity() const;
+
+    bool Lookup( KINARGTYPE key, VOUTARGTYPE value ) const;
+    const CPair* Lookup( KINARGTYPE key ) const;
+    CPair* Lookup( KINARGTYPE key );
+    V& operator[]( KINARGTYPE key );
+
+    SPOSITION SetAt( KINARGTYPE key, VINARGTYPE value );
+    void SetValueAt( SPOSITION pos, VINARGTYPE value );
+
+    bool RemoveKey( KINARGTYPE key );
+    void RemoveAll();
+    void Reserve( size_t nElements );
+
+    SPOSITION GetStartPosition() const;
+    void GetNextAssoc( SPOSITION& pos, KOUTARGTYPE key, VOUTARGTYPE value ) const;
+    const CPair* GetNext( SPOSITION& pos ) const;
+    CPair* GetNext( SPOSITION& pos );
+    const K& GetNextKey( SPOSITION& pos ) const;
+    const V& GetNextValue( SPOSITION& pos ) const;
+    V& GetNextValue( SPOSITION& pos );
+    CPair* GetAt( SPOSITION pos );
+    const CPair* GetAt( SPOSITION pos ) const;
+    const K& GetKeyAt( SPOSITION pos ) const;
+    const V& GetValueAt( SPOSITION pos ) const;
+    V& GetValueAt( SPOSITION pos );
+
+    // Implementation
+private:
+    enum
+    {
+        KMinBits = 3,
+    };
+
+    struct STag
+    {
+        UINT nHash;                 // mixed hash of the key
+        UINT nDist;                 // probe distance + 1, 0 means empty
+    };
+
+    STag* m_pTags;
+    CPair* m_pPairs;
+    size_t m_nElements;
+    size_t m_nMaxElements;          // grow when exceeded, 7/8 of the slot count
+    UINT m_nBits;                   // slot count is 1<<m_nBits
+
+private:
+    static UINT MixHash( KINARGTYPE key );
+    static SPOSITION ToPos( size_t iSlot );
+    static size_t FromPos( SPOSITION pos );
+    size_t HomeSlot( UINT nHash ) const;
+    size_t FindSlot( KINARGTYPE key ) const;
+    size_t NextUsedSlot( size_t iSlot ) const;
+    size_t PlaceSlot( UINT nHash );
+    size_t InsertSlot( KINARGTYPE key );
+    void RemoveSlot( size_t iSlot );
+    bool Grow( UINT nBits );
+};
+
+template< typename K, typename V, class KTraits, class VTraits >
+SFlatMap< K, V, KTraits, VTraits >::SFlatMap( size_t nInitElements ) :
+    m_pTags( NULL ),
+    m_pPairs( NULL ),
+    m_nElements( 0 ),
+    m_nMaxElements( 0 ),
+    m_nBits( 0 )
+{
+    if( nInitElements )
+        Reserve( nInitElements );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+SFlatMap< K, V, KTraits, VTraits >::SFlatMap( const SFlatMap& src ) :
+    m_pTags( NULL ),
+    m_pPairs( NULL ),
+    m_nElements( 0 ),
+    m_nMaxElements( 0 ),
+    m_nBits( 0 )
+{
+    Copy( src );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+SFlatMap< K, V, KTraits, VTraits >::~SFlatMap()
+{
+    RemoveAll();
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+SFlatMap< K, V, KTraits, VTraits >& SFlatMap< K, V, KTraits, VTraits >::operator=( const SFlatMap& src )
+{
+    if( this != &src )
+        Copy( src );
+    return *this;
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::Copy( const SFlatMap& src )
+{
+    RemoveAll();
+    Reserve( src.GetCount() );
+    SPOSITION pos = src.GetStartPosition();
+    while( pos != NULL )
+    {
+        const CPair* pPair = src.GetNext( pos );
+        SetAt( pPair->m_key, pPair->m_value );
+    }
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline size_t SFlatMap< K, V, KTraits, VTraits >::GetCount() const
+{
+    return( m_nElements );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline bool SFlatMap< K, V, KTraits, VTraits >::IsEmpty() const
+{
+    return( m_nElements == 0 );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline size_t SFlatMap< K, V, KTraits, VTraits >::GetCapacity() const
+{
+    return( m_pTags ? ((size_t)1 << m_nBits) : 0 );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline UINT SFlatMap< K, V, KTraits, VTraits >::MixHash( KINARGTYPE key )
+{
+    // Fibonacci hashing: the default traits hash ints and pointers to themselves,
+    // spread them so the high bits can pick the home slot.
+    return( UINT( KTraits::Hash( key ) ) * 2654435769U );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline SPOSITION SFlatMap< K, V, KTraits, VTraits >::ToPos( size_t iSlot )
+{
+    return( SPOSITION( iSlot+1 ) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline size_t SFlatMap< K, V, KTraits, VTraits >::FromPos( SPOSITION pos )
+{
+    return( size_t( pos )-1 );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+inline size_t SFlatMap< K, V, KTraits, VTraits >::HomeSlot( UINT nHash ) const
+{
+    return( nHash >> (32-m_nBits) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+size_t SFlatMap< K, V, KTraits, VTraits >::FindSlot( KINARGTYPE key ) const
+{
+    if( m_nElements == 0 )
+        return( size_t( -1 ) );
+
+    UINT nHash = MixHash( key );
+    size_t nMask = ((size_t)1 << m_nBits)-1;
+    size_t iSlot = HomeSlot( nHash );
+    UINT nDist = 1;
+    for( ;; )
+    {
+        const STag& tag = m_pTags[iSlot];
+        // an empty slot, or a pair closer to its home than the key would be:
+        // the key is not in the table
+        if( tag.nDist < nDist )
+            return( size_t( -1 ) );
+        if( tag.nHash == nHash && KTraits::CompareElements( m_pPairs[iSlot].m_key, key ) )
+            return( iSlot );
+        iSlot = (iSlot+1) & nMask;
+        nDist++;
+    }
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+size_t SFlatMap< K, V, KTraits, VTraits >::NextUsedSlot( size_t iSlot ) const
+{
+    size_t nSlots = GetCapacity();
+    while( iSlot < nSlots && m_pTags[iSlot].nDist == 0 )
+        iSlot++;
+    return( iSlot );
+}
+
+// Reserve a slot for a new pair with hash nHash. Pairs between the slot and the next
+// empty slot are shifted up by one. The slot tag is set, the pair is not constructed.
+// The table must have an empty slot. A probe distance never exceeds the slot count,
+// so it always fits the tag.
+template< typename K, typename V, class KTraits, class VTraits >
+size_t SFlatMap< K, V, KTraits, VTraits >::PlaceSlot( UINT nHash )
+{
+    size_t nMask = ((size_t)1 << m_nBits)-1;
+    size_t iSlot = HomeSlot( nHash );
+    UINT nDist = 1;
+    while( m_pTags[iSlot].nDist >= nDist )
+    {
+        iSlot = (iSlot+1) & nMask;
+        nDist++;
+    }
+
+    size_t iEmpty = iSlot;
+    while( m_pTags[iEmpty].nDist != 0 )
+        iEmpty = (iEmpty+1) & nMask;
+    while( iEmpty != iSlot )
+    {
+        size_t iPrev = (iEmpty-1) & nMask;
+        memcpy( (void*)(m_pPairs+iEmpty), m_pPairs+iPrev, sizeof( CPair ) );
+        m_pTags[iEmpty].nHash = m_pTags[iPrev].nHash;
+        m_pTags[iEmpty].nDist = m_pTags[iPrev].nDist+1;
+        iEmpty = iPrev;
+    }
+    m_pTags[iSlot].nHash = nHash;
+    m_pTags[iSlot].nDist = nDist;
+    return( iSlot );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+size_t SFlatMap< K, V, KTraits, VTraits >::InsertSlot( KINARGTYPE key )
+{
+    if( m_nElements+1 > m_nMaxElements )
+    {
+        // when the table cannot grow, keep using the spare slots above the load limit
+        if( !Grow( m_pTags ? m_nBits+1 : KMinBits ) && m_nElements >= GetCapacity() )
+            SThrow( E_OUTOFMEMORY );
+    }
+    m_nElements++;
+    return( PlaceSlot( MixHash( key ) ) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::RemoveSlot( size_t iSlot )
+{
+    size_t nMask = ((size_t)1 << m_nBits)-1;
+    m_pPairs[iSlot].~CPair();
+    // backward shift deletion: pull the following displaced pairs one slot closer to home
+    size_t iNext = (iSlot+1) & nMask;
+    while( m_pTags[iNext].nDist > 1 )
+    {
+        memcpy( (void*)(m_pPairs+iSlot), m_pPairs+iNext, sizeof( CPair ) );
+        m_pTags[iSlot].nHash = m_pTags[iNext].nHash;
+        m_pTags[iSlot].nDist = m_pTags[iNext].nDist-1;
+        iSlot = iNext;
+        iNext = (iNext+1) & nMask;
+    }
+    m_pTags[iSlot].nDist = 0;
+    m_nElements--;
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+bool SFlatMap< K, V, KTraits, VTraits >::Grow( UINT nBits )
+{
+    // the home slot is taken from the high bits of a 32 bit hash
+    if( nBits >= sizeof( size_t )*8-1 || nBits >= 32 )
+        return( false );
+    size_t nSlots = (size_t)1 << nBits;
+    STag* pTags = static_cast< STag* >( soui_mem_wrapper::SouiCalloc( nSlots, sizeof( STag ) ) );
+    CPair* pPairs = static_cast< CPair* >( soui_mem_wrapper::SouiMalloc( nSlots*sizeof( CPair ) ) );
+    if( pTags == NULL || pPairs == NULL )
+    {
+        soui_mem_wrapper::SouiFree( pTags );
+        soui_mem_wrapper::SouiFree( pPairs );
+        return( false );
+    }
+
+    STag* pOldTags = m_pTags;
+    CPair* pOldPairs = m_pPairs;
+    size_t nOldSlots = GetCapacity();
+    m_pTags = pTags;
+    m_pPairs = pPairs;
+    m_nBits = nBits;
+
+    for( size_t iOld = 0; iOld < nOldSlots; iOld++ )
+    {
+        if( pOldTags[iOld].nDist == 0 )
+            continue;
+        size_t iSlot = PlaceSlot( pOldTags[iOld].nHash );
+        memcpy( (void*)(m_pPairs+iSlot), pOldPairs+iOld, sizeof( CPair ) );
+    }
+    soui_mem_wrapper::SouiFree( pOldTags );
+    soui_mem_wrapper::SouiFree( pOldPairs );
+    m_nMaxElements = nSlots - nSlots/8;
+    return( true );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::Reserve( size_t nElements )
+{
+    UINT nBits = KMinBits;
+    while( ((size_t)1 << nBits) - ((size_t)1 << nBits)/8 < nElements )
+        nBits++;
+    if( !m_pTags || nBits > m_nBits )
+        Grow( nBits );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::RemoveAll()
+{
+    size_t nSlots = GetCapacity();
+    for( size_t iSlot = 0; iSlot < nSlots; iSlot++ )
+    {
+        if( m_pTags[iSlot].nDist != 0 )
+            m_pPairs[iSlot].~CPair();
+    }
+    soui_mem_wrapper::SouiFree( m_pTags );
+    soui_mem_wrapper::SouiFree( m_pPairs );
+    m_pTags = NULL;
+    m_pPairs = NULL;
+    m_nElements = 0;
+    m_nMaxElements = 0;
+    m_nBits = 0;
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+bool SFlatMap< K, V, KTraits, VTraits >::Lookup( KINARGTYPE key, VOUTARGTYPE value ) const
+{
+    size_t iSlot = FindSlot( key );
+    if( iSlot == size_t( -1 ) )
+        return( false );
+    value = m_pPairs[iSlot].m_value;
+    return( true );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::Lookup( KINARGTYPE key ) const
+{
+    size_t iSlot = FindSlot( key );
+    return( iSlot == size_t( -1 ) ? NULL : m_pPairs+iSlot );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::Lookup( KINARGTYPE key )
+{
+    size_t iSlot = FindSlot( key );
+    return( iSlot == size_t( -1 ) ? NULL : m_pPairs+iSlot );
+}
+
+#pragma push_macro("new")
+#undef new
+
+template< typename K, typename V, class KTraits, class VTraits >
+V& SFlatMap< K, V, KTraits, VTraits >::operator[]( KINARGTYPE key )
+{
+    size_t iSlot = FindSlot( key );
+    if( iSlot == size_t( -1 ) )
+    {
+        iSlot = InsertSlot( key );
+        ::new( m_pPairs+iSlot ) CPair( key );
+    }
+    return( m_pPairs[iSlot].m_value );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+SPOSITION SFlatMap< K, V, KTraits, VTraits >::SetAt( KINARGTYPE key, VINARGTYPE value )
+{
+    size_t iSlot = FindSlot( key );
+    if( iSlot == size_t( -1 ) )
+    {
+        iSlot = InsertSlot( key );
+        ::new( m_pPairs+iSlot ) CPair( key, value );
+    }
+    else
+    {
+        m_pPairs[iSlot].m_value = value;
+    }
+    return( ToPos( iSlot ) );
+}
+
+#pragma pop_macro("new")
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::SetValueAt( SPOSITION pos, VINARGTYPE value )
+{
+    SASSERT( pos != NULL );
+    m_pPairs[FromPos( pos )].m_value = value;
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+bool SFlatMap< K, V, KTraits, VTraits >::RemoveKey( KINARGTYPE key )
+{
+    size_t iSlot = FindSlot( key );
+    if( iSlot == size_t( -1 ) )
+        return( false );
+    RemoveSlot( iSlot );
+    return( true );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+SPOSITION SFlatMap< K, V, KTraits, VTraits >::GetStartPosition() const
+{
+    if( m_nElements == 0 )
+        return( NULL );
+    return( ToPos( NextUsedSlot( 0 ) ) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::GetNext( SPOSITION& pos ) const
+{
+    SASSERT( pos != NULL );
+    size_t iSlot = FromPos( pos );
+    size_t iNext = NextUsedSlot( iSlot+1 );
+    pos = iNext < GetCapacity() ? ToPos( iNext ) : NULL;
+    return( m_pPairs+iSlot );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::GetNext( SPOSITION& pos )
+{
+    SASSERT( pos != NULL );
+    size_t iSlot = FromPos( pos );
+    size_t iNext = NextUsedSlot( iSlot+1 );
+    pos = iNext < GetCapacity() ? ToPos( iNext ) : NULL;
+    return( m_pPairs+iSlot );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+void SFlatMap< K, V, KTraits, VTraits >::GetNextAssoc( SPOSITION& pos, KOUTARGTYPE key, VOUTARGTYPE value ) const
+{
+    const CPair* pPair = GetNext( pos );
+    key = pPair->m_key;
+    value = pPair->m_value;
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const K& SFlatMap< K, V, KTraits, VTraits >::GetNextKey( SPOSITION& pos ) const
+{
+    return( GetNext( pos )->m_key );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const V& SFlatMap< K, V, KTraits, VTraits >::GetNextValue( SPOSITION& pos ) const
+{
+    return( GetNext( pos )->m_value );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+V& SFlatMap< K, V, KTraits, VTraits >::GetNextValue( SPOSITION& pos )
+{
+    return( GetNext( pos )->m_value );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::GetAt( SPOSITION pos )
+{
+    SASSERT( pos != NULL );
+    return( m_pPairs+FromPos( pos ) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const typename SFlatMap< K, V, KTraits, VTraits >::CPair* SFlatMap< K, V, KTraits, VTraits >::GetAt( SPOSITION pos ) const
+{
+    SASSERT( pos != NULL );
+    return( m_pPairs+FromPos( pos ) );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const K& SFlatMap< K, V, KTraits, VTraits >::GetKeyAt( SPOSITION pos ) const
+{
+    return( GetAt( pos )->m_key );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+const V& SFlatMap< K, V, KTraits, VTraits >::GetValueAt( SPOSITION pos ) const
+{
+    return( GetAt( pos )->m_value );
+}
+
+template< typename K, typename V, class KTraits, class VTraits >
+V& SFlatMap< K, V, KTraits, VTraits >::GetValueAt( SPOSITION pos )
+{
+    return( GetAt( pos )->m_value );
+}
+
 //
 // The red-black tree code is based on the the descriptions in
 // "Introduction to Algorithms", by Cormen, Leiserson, and Rivest
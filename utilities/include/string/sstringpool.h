@@ -0,0 +1,70 @@
+﻿#pragma  once
+
+#include "utilities-def.h"
+#include "tstring.h"
+
+namespace SOUI
+{
+    /**
+    * @struct    SAtomData
+    * @brief     驻留字符串
+    *
+    * Describe   同一个字符串在进程中只保存一份，地址在进程生命期内保持不变，
+    *            因此两个原子相等等价于字符串相等(区分大小写)。
+    *            pFold指向字符串小写形式的原子，比较两个原子的pFold可以实现忽略大小写的比较。
+    */
+    struct SAtomData
+    {
+        SAtomData *         pNext;      //哈希链
+        const SAtomData *   pFold;      //小写形式对应的原子，小写字符串指向自己
+        ULONG               nHash;      //字符串哈希，和CElementTraits<SStringW>::Hash一致
+        ULONG               nFoldHash;  //忽略大小写的哈希
+        int                 nLen;
+        wchar_t             szName[1];
+    };
+
+    typedef const SAtomData * SATOM;
+
+    /**
+    * @class     SStringPool
+    * @brief     线程安全的全局字符串驻留表
+    *
+    * Describe   用于属性名、类名、皮肤名等大量重复出现的短字符串。
+    *            原子一旦创建不会释放。
+    */
+    class UTILITIES_API SStringPool
+    {
+    public:
+        /**
+         * Intern
+         * @brief    获取字符串对应的原子，不存在时创建
+         * @param    LPCWSTR pszName --  字符串
+         * @param    int nLen --  字符串长度，-1表示以0结尾
+         * @return   SATOM -- 原子，pszName为NULL时返回NULL
+         */
+        static SATOM Intern(LPCWSTR pszName,int nLen=-1);
+
+        /**
+         * Find
+         * @brief    查找已经存在的原子
+         * @param    LPCWSTR pszName --  字符串
+         * @param    int nLen --  字符串长度，-1表示以0结尾
+         * @return   SATOM -- 原子，没有驻留时返回NULL
+         */
+        static SATOM Find(LPCWSTR pszName,int nLen=-1);
+
+        /**
+         * GetCount
+         * @brief    获取驻留的字符串数量
+         * @return   int
+         */
+        static int GetCount();
+
+        static LPCWSTR GetName(SATOM atom) {return atom?atom->szName:L"";}
+
+        static SATOM GetFolded(SATOM atom) {return atom?atom->pFold:NULL;}
+
+        static bool EqualNoCase(SATOM atom1,SATOM atom2) {return GetFolded(atom1) == GetFolded(atom2);}
+    };
+
+}//end of namespace SOUI
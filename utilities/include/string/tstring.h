@@ -20,12 +20,31 @@
 
 namespace SOUI
 {
+    struct TStringData;
+
+    // String data blocks up to a few dozen characters come from a lock-free pool of
+    // fixed size blocks instead of the heap. *pnBlockSize receives the usable block size in bytes.
+    UTILITIES_API TStringData* _tstr_AllocData(size_t nSize, size_t* pnBlockSize);
+    UTILITIES_API TStringData* _tstr_ReallocData(TStringData* pOldData, size_t nSize, size_t* pnBlockSize);
+    UTILITIES_API void _tstr_FreeData(TStringData* pData);
+
+    // Heap traffic of string data blocks, used to measure the pool.
+    struct TStringAllocStats
+    {
+        long nHeapAllocs;   // blocks taken from soui_mem_wrapper, pool slabs and reallocs included
+        long nPoolSlabs;    // pool slabs among nHeapAllocs
+    };
+    UTILITIES_API void _tstr_GetAllocStats(TStringAllocStats* pStats);
+    // Turn the pool off to compare against plain heap blocks; returns the previous state.
+    // Blocks already taken from the pool still go back to it.
+    UTILITIES_API bool _tstr_EnablePool(bool bEnable);
 
     struct TStringData
     {
         long nRefs;            // Reference count: negative == locked
         int nDataLength;    // Length of currently used data in XCHARs (not including terminating null)
         int nAllocLength;    // Length of allocated data in XCHARs (not including terminating null)
+        int nBlockClass;    // Size class of the small string pool, 0 == heap block
 
         inline void* data() const
         {
@@ -41,7 +60,7 @@ namespace SOUI
         {
             SASSERT(nRefs != 0);
             if (InterlockedDecrement(&nRefs) <= 0)
-                soui_mem_wrapper::SouiFree(this);
+                _tstr_FreeData(this);
         }
         inline bool IsShared() const
         {
@@ -1368,17 +1387,19 @@ namespace SOUI
                 return _tstr_initDataNil;
 
             int nSize = sizeof(TStringData) + (nLength + 1 + TSTRING_PADDING) * sizeof(tchar);
+            size_t nBlockSize = 0;
             TStringData* pData;
             if (pOldData == NULL)
-                pData = (TStringData*)soui_mem_wrapper::SouiMalloc(nSize);
+                pData = _tstr_AllocData(nSize, &nBlockSize);
             else
-                pData = (TStringData*)soui_mem_wrapper::SouiRealloc(pOldData, nSize);
+                pData = _tstr_ReallocData(pOldData, nSize, &nBlockSize);
             if (pData == NULL)
                 return NULL;
 
             pData->nRefs = 1;
             pData->nDataLength = nLength;
-            pData->nAllocLength = nLength;
+            // a pooled block may hold more than requested, keep the slack for later appends
+            pData->nAllocLength = (int)((nBlockSize - sizeof(TStringData)) / sizeof(tchar)) - 1 - TSTRING_PADDING;
 
             tchar* pchData = (tchar*)pData->data();
             pchData[nLength] = '\0';
@@ -0,0 +1,179 @@
+﻿#include "string/sstringpool.h"
+#include "helper/SCriticalSection.h"
+#include <soui_mem_wrapper.h>
+
+namespace SOUI
+{
+    // 驻留表: 开链哈希表，原子从8K的内存块中连续分配，进程退出前不释放
+    static const ULONG  KInitBuckets = 256;
+    static const size_t KArenaSize = 8 * 1024;
+
+    static ULONG _atom_Hash(LPCWSTR pszName, int nLen)
+    {
+        ULONG nHash = 0;
+        for (int i = 0; i < nLen; i++)
+        {
+            nHash = (nHash << 5) + nHash + pszName[i];
+        }
+        return nHash;
+    }
+
+    class SAtomTable
+    {
+    public:
+        SAtomTable() :m_ppBuckets(NULL), m_nBuckets(0), m_nCount(0), m_pArena(NULL), m_nArenaLeft(0)
+        {
+            Rehash(KInitBuckets);
+        }
+
+        SATOM Lookup(LPCWSTR pszName, int nLen, ULONG nHash) const
+        {
+            SAtomData *pAtom = m_ppBuckets[nHash & (m_nBuckets - 1)];
+            while (pAtom)
+            {
+                if (pAtom->nHash == nHash && pAtom->nLen == nLen
+                    && memcmp(pAtom->szName, pszName, nLen * sizeof(wchar_t)) == 0)
+                    return pAtom;
+                pAtom = pAtom->pNext;
+            }
+            return NULL;
+        }
+
+        SATOM Insert(LPCWSTR pszName, int nLen, ULONG nHash)
+        {
+            SATOM pRet = Lookup(pszName, nLen, nHash);
+            if (pRet) return pRet;
+
+            //先驻留小写形式，小写字符串的小写形式是它自己，递归最多一层
+            const SAtomData *pFold = NULL;
+            wchar_t szBuf[64];
+            wchar_t *pszLower = nLen < (int)ARRAYSIZE(szBuf) ? szBuf : (wchar_t*)soui_mem_wrapper::SouiMalloc(nLen * sizeof(wchar_t));
+            if (!pszLower) return NULL;
+            bool bLower = true;
+            for (int i = 0; i < nLen; i++)
+            {
+                pszLower[i] = (wchar_t)towlower(pszName[i]);
+                if (pszLower[i] != pszName[i]) bLower = false;
+            }
+            if (!bLower)
+                pFold = Insert(pszLower, nLen, _atom_Hash(pszLower, nLen));
+            if (pszLower != szBuf)
+                soui_mem_wrapper::SouiFree(pszLower);
+            if (!bLower && !pFold) return NULL;
+
+            SAtomData *pAtom = AllocAtom(nLen);
+            if (!pAtom) return NULL;
+            memcpy(pAtom->szName, pszName, nLen * sizeof(wchar_t));
+            pAtom->szName[nLen] = 0;
+            pAtom->nLen = nLen;
+            pAtom->nHash = nHash;
+            pAtom->pFold = pFold ? pFold : pAtom;
+            pAtom->nFoldHash = pAtom->pFold->nHash;
+
+            SAtomData * & pHead = m_ppBuckets[nHash & (m_nBuckets - 1)];
+            pAtom->pNext = pHead;
+            pHead = pAtom;
+            if (++m_nCount > m_nBuckets)
+                Rehash(m_nBuckets * 2);
+            return pAtom;
+        }
+
+        int GetCount() const { return (int)m_nCount; }
+
+        SCriticalSection m_cs;
+
+    protected:
+        void Rehash(ULONG nBuckets)
+        {
+            SAtomData **ppBuckets = (SAtomData**)soui_mem_wrapper::SouiCalloc(nBuckets, sizeof(SAtomData*));
+            if (!ppBuckets) return;//保持原来的桶，只是链变长
+            for (ULONG i = 0; i < m_nBuckets; i++)
+            {
+                SAtomData *pAtom = m_ppBuckets[i];
+                while (pAtom)
+                {
+                    SAtomData *pNext = pAtom->pNext;
+                    SAtomData * & pHead = ppBuckets[pAtom->nHash & (nBuckets - 1)];
+                    pAtom->pNext = pHead;
+                    pHead = pAtom;
+                    pAtom = pNext;
+                }
+            }
+            if (m_ppBuckets) soui_mem_wrapper::SouiFree(m_ppBuckets);
+            m_ppBuckets = ppBuckets;
+            m_nBuckets = nBuckets;
+        }
+
+        SAtomData * AllocAtom(int nLen)
+        {
+            size_t nSize = FIELD_OFFSET(SAtomData, szName) + (nLen + 1) * sizeof(wchar_t);
+            nSize = (nSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+            if (nSize > KArenaSize / 4)
+                return (SAtomData*)soui_mem_wrapper::SouiMalloc(nSize);
+            if (nSize > m_nArenaLeft)
+            {
+                m_pArena = (BYTE*)soui_mem_wrapper::SouiMalloc(KArenaSize);
+                if (!m_pArena)
+                {
+                    m_nArenaLeft = 0;
+                    return NULL;
+                }
+                m_nArenaLeft = KArenaSize;
+            }
+            SAtomData *pAtom = (SAtomData*)m_pArena;
+            m_pArena += nSize;
+            m_nArenaLeft -= nSize;
+            return pAtom;
+        }
+
+        SAtomData **    m_ppBuckets;
+        ULONG           m_nBuckets;
+        ULONG           m_nCount;
+        BYTE *          m_pArena;
+        size_t          m_nArenaLeft;
+    };
+
+    static SAtomTable * volatile s_pAtomTable = NULL;
+
+    //驻留表可能在其它模块的全局对象构造时就被使用，所以在第一次使用时创建
+    static SAtomTable * _atom_GetTable()
+    {
+        SAtomTable *pTable = s_pAtomTable;
+        if (pTable) return pTable;
+        pTable = new SAtomTable;
+        SAtomTable *pOld = (SAtomTable*)InterlockedCompareExchangePointer((PVOID volatile*)&s_pAtomTable, pTable, NULL);
+        if (pOld)
+        {
+            delete pTable;
+            pTable = pOld;
+        }
+        return pTable;
+    }
+
+    SATOM SStringPool::Intern(LPCWSTR pszName, int nLen)
+    {
+        if (!pszName) return NULL;
+        if (nLen < 0) nLen = (int)wcslen(pszName);
+        ULONG nHash = _atom_Hash(pszName, nLen);
+        SAtomTable *pTable = _atom_GetTable();
+        SAutoLock lock(pTable->m_cs);
+        return pTable->Insert(pszName, nLen, nHash);
+    }
+
+    SATOM SStringPool::Find(LPCWSTR pszName, int nLen)
+    {
+        if (!pszName) return NULL;
+        if (nLen < 0) nLen = (int)wcslen(pszName);
+        ULONG nHash = _atom_Hash(pszName, nLen);
+        SAtomTable *pTable = _atom_GetTable();
+        SAutoLock lock(pTable->m_cs);
+        return pTable->Lookup(pszName, nLen, nHash);
+    }
+
+    int SStringPool::GetCount()
+    {
+        SAtomTable *pTable = _atom_GetTable();
+        SAutoLock lock(pTable->m_cs);
+        return pTable->GetCount();
+    }
+}
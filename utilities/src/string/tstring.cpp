@@ -11,4 +11,130 @@ namespace SOUI
 
     TStringData* _tstr_initDataNil = (TStringData*)&_tstr_rgInitData;
     const void* _tstr_initPszNil = (const void*)(((unsigned char*)&_tstr_rgInitData) + sizeof(TStringData));
+
+    // Small string pool
+    // Attribute names, IDs and short labels are the bulk of the strings created while
+    // loading a layout. Their data blocks come from per size class free lists; the
+    // lists are Win32 SLists, so strings can still be released from any thread.
+    // Pool memory is reused but never returned to the heap.
+    static const size_t KPoolBlockSize[] = { 32, 48, 64, 80 };
+    static const int KPoolClasses = ARRAYSIZE(KPoolBlockSize);
+    static const size_t KPoolSlabSize = 16 * 1024;
+
+    static SLIST_HEADER s_poolFreeList[KPoolClasses];
+    static volatile bool s_bPoolEnabled = true;
+
+    // only heap paths are counted, a pool hit costs no extra interlocked operation
+    static volatile LONG s_nHeapAllocs = 0;
+    static volatile LONG s_nPoolSlabs = 0;
+
+    static int _tstr_PoolClass(size_t nSize)
+    {
+        for (int i = 0; i < KPoolClasses; i++)
+        {
+            if (nSize <= KPoolBlockSize[i])
+                return i;
+        }
+        return -1;
+    }
+
+    static TStringData* _tstr_PoolAlloc(int iClass)
+    {
+        PSLIST_ENTRY pEntry = InterlockedPopEntrySList(&s_poolFreeList[iClass]);
+        if (pEntry == NULL)
+        {
+            // carve a new slab into blocks; SList entries need MEMORY_ALLOCATION_ALIGNMENT
+            BYTE* pSlab = (BYTE*)soui_mem_wrapper::SouiMalloc(KPoolSlabSize + MEMORY_ALLOCATION_ALIGNMENT);
+            if (pSlab == NULL)
+                return NULL;
+            InterlockedIncrement(&s_nHeapAllocs);
+            InterlockedIncrement(&s_nPoolSlabs);
+            BYTE* pBlock = (BYTE*)(((ULONG_PTR)pSlab + MEMORY_ALLOCATION_ALIGNMENT - 1) & ~(ULONG_PTR)(MEMORY_ALLOCATION_ALIGNMENT - 1));
+            size_t nBlocks = KPoolSlabSize / KPoolBlockSize[iClass];
+            pEntry = (PSLIST_ENTRY)pBlock;
+            for (size_t i = 1; i < nBlocks; i++)
+            {
+                InterlockedPushEntrySList(&s_poolFreeList[iClass], (PSLIST_ENTRY)(pBlock + i * KPoolBlockSize[iClass]));
+            }
+        }
+        TStringData* pData = (TStringData*)pEntry;
+        pData->nBlockClass = iClass + 1;
+        return pData;
+    }
+
+    TStringData* _tstr_AllocData(size_t nSize, size_t* pnBlockSize)
+    {
+        int iClass = s_bPoolEnabled ? _tstr_PoolClass(nSize) : -1;
+        if (iClass >= 0)
+        {
+            TStringData* pData = _tstr_PoolAlloc(iClass);
+            if (pData)
+            {
+                *pnBlockSize = KPoolBlockSize[iClass];
+                return pData;
+            }
+        }
+        TStringData* pData = (TStringData*)soui_mem_wrapper::SouiMalloc(nSize);
+        if (pData)
+        {
+            InterlockedIncrement(&s_nHeapAllocs);
+            pData->nBlockClass = 0;
+            *pnBlockSize = nSize;
+        }
+        return pData;
+    }
+
+    TStringData* _tstr_ReallocData(TStringData* pOldData, size_t nSize, size_t* pnBlockSize)
+    {
+        int iOldClass = pOldData->nBlockClass - 1;
+        if (iOldClass < 0)
+        {// heap blocks stay on the heap, their exact size is not known here
+            TStringData* pData = (TStringData*)soui_mem_wrapper::SouiRealloc(pOldData, nSize);
+            if (pData)
+            {
+                InterlockedIncrement(&s_nHeapAllocs);
+                pData->nBlockClass = 0;
+                *pnBlockSize = nSize;
+            }
+            return pData;
+        }
+        if (_tstr_PoolClass(nSize) == iOldClass)
+        {
+            *pnBlockSize = KPoolBlockSize[iOldClass];
+            return pOldData;
+        }
+
+        // moving to another size class or to the heap
+        size_t nOldSize = KPoolBlockSize[iOldClass];
+        TStringData* pData = _tstr_AllocData(nSize, pnBlockSize);
+        if (pData == NULL)
+            return NULL;
+        int nBlockClass = pData->nBlockClass;
+        memcpy(pData, pOldData, nOldSize < nSize ? nOldSize : nSize);
+        pData->nBlockClass = nBlockClass;
+        _tstr_FreeData(pOldData);
+        return pData;
+    }
+
+    void _tstr_FreeData(TStringData* pData)
+    {
+        int iClass = pData->nBlockClass - 1;
+        if (iClass >= 0)
+            InterlockedPushEntrySList(&s_poolFreeList[iClass], (PSLIST_ENTRY)pData);
+        else
+            soui_mem_wrapper::SouiFree(pData);
+    }
+
+    void _tstr_GetAllocStats(TStringAllocStats* pStats)
+    {
+        pStats->nHeapAllocs = s_nHeapAllocs;
+        pStats->nPoolSlabs = s_nPoolSlabs;
+    }
+
+    bool _tstr_EnablePool(bool bEnable)
+    {
+        bool bOld = s_bPoolEnabled;
+        s_bPoolEnabled = bEnable;
+        return bOld;
+    }
 }
@@ -36,6 +36,7 @@ HEADERS += include/gdialpha.h \
            include/atl.mini/SComHelper.h \
            include/pugixml/pugiconfig.hpp \
            include/pugixml/pugixml.hpp \
+           include/string/sstringpool.h \
            include/string/strcpcvt.h \
            include/string/tstring.h \
            include/unknown/obj-ref-i.h \
@@ -54,12 +55,15 @@ HEADERS += include/gdialpha.h \
            include/helper/SEmptyable.hpp \
 		   include/helper/SSharedPtr.hpp \
 		   include/helper/SAutoBuf.h \
+		   include/helper/SBoxDownscaler.hpp \
+		   include/helper/SPremultiply.hpp \
            
 SOURCES += src/gdialpha.cpp \
            src/trace.cpp \
            src/utilities.cpp \
            src/soui_mem_wrapper.cpp\
            src/pugixml/pugixml.cpp \
+           src/string/sstringpool.cpp \
            src/string/strcpcvt.cpp \
            src/string/tstring.cpp \
            src/sobject/sobject.cpp \